@@ -20,12 +20,20 @@
 // Expected mappings from C++ atomics to hardware primitives can be found at
 // http://www.cl.cam.ac.uk/~pes20/cpp/cpp0xmappings.html .
 
+#include <sched.h>
+
 #include <atomic>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 #include "util.h"
 
+#if defined(__BIONIC__)
+#include "private/bionic_percpu.h"
+#endif
+
 // We time atomic operations separated by a volatile (not atomic!) increment.  This ensures
 // that the compiler emits memory instructions (e.g. load or store) prior to any fence or the
 // like.  That in turn ensures that the CPU has outstanding memory operations when the fence
@@ -148,3 +156,116 @@ static void BM_atomic_fetch_add_cs(benchmark::State& state) {
   sink = result;
 }
 BIONIC_BENCHMARK(BM_atomic_fetch_add_cs);
+
+// A counter that range(0) - 1 other threads keep incrementing while the benchmark thread measures
+// its own increments, either of a single atomic or of a per-CPU counter. On bionic, the per-CPU
+// counter is libc's own PerCpuCounter, which uses restartable sequences when they're available.
+namespace {
+#if defined(__BIONIC__)
+using PerCpu = PerCpuCounter<>;
+#else
+class PerCpu {
+ public:
+  void add(int64_t delta) {
+    shards_[static_cast<unsigned>(sched_getcpu()) % kShardCount].value.fetch_add(
+        delta, std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr size_t kShardCount = 32;
+  struct alignas(64) Shard {
+    std::atomic<int64_t> value;
+  };
+  Shard shards_[kShardCount] = {};
+};
+#endif
+
+struct ContendedCounter {
+  std::atomic<int64_t> single;
+  PerCpu per_cpu_counter;
+  std::atomic<bool> done;
+  std::vector<std::thread> threads;
+
+  ContendedCounter(bool per_cpu, size_t thread_count) : single(0), per_cpu_counter(), done(false) {
+    for (size_t i = 1; i < thread_count; ++i) {
+      threads.emplace_back([this, per_cpu]() {
+        while (!done) Increment(per_cpu);
+      });
+    }
+  }
+
+  ~ContendedCounter() {
+    done = true;
+    for (std::thread& thread : threads) thread.join();
+  }
+
+  void Increment(bool per_cpu) {
+    if (per_cpu) {
+      per_cpu_counter.add(1);
+    } else {
+      single.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+};
+}
+
+static void BM_atomic_fetch_add_contended(benchmark::State& state) {
+  ContendedCounter c(false, state.range(0));
+  while (state.KeepRunning()) {
+    c.Increment(false);
+  }
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_atomic_fetch_add_contended, "NUM_THREADS");
+
+static void BM_atomic_fetch_add_per_cpu_contended(benchmark::State& state) {
+  ContendedCounter c(true, state.range(0));
+  while (state.KeepRunning()) {
+    c.Increment(true);
+  }
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_atomic_fetch_add_per_cpu_contended, "NUM_THREADS");
+
+#if defined(__BIONIC__)
+// Pushes a node to libc's PerCpuFreeList and pops it again, while range(0) - 1 other threads do
+// the same with their own nodes.
+namespace {
+struct FreeListNode {
+  FreeListNode* next;
+};
+
+struct ContendedFreeList {
+  PerCpuFreeList<FreeListNode> list;
+  // Threads migrate, so nodes end up on any CPU's list: they must outlive all the threads.
+  std::vector<FreeListNode> nodes;
+  std::atomic<bool> done;
+  std::vector<std::thread> threads;
+
+  explicit ContendedFreeList(size_t thread_count) : list(), nodes(thread_count), done(false) {
+    for (FreeListNode& node : nodes) list.push(&node);
+    for (size_t i = 1; i < thread_count; ++i) {
+      threads.emplace_back([this]() {
+        while (!done) Cycle();
+      });
+    }
+  }
+
+  ~ContendedFreeList() {
+    done = true;
+    for (std::thread& thread : threads) thread.join();
+  }
+
+  void Cycle() {
+    FreeListNode* node = list.pop();
+    if (node != nullptr) list.push(node);
+  }
+};
+}
+
+static void BM_atomic_per_cpu_free_list_contended(benchmark::State& state) {
+  ContendedFreeList l(state.range(0));
+  while (state.KeepRunning()) {
+    l.Cycle();
+  }
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_atomic_per_cpu_free_list_contended, "NUM_THREADS");
+#endif
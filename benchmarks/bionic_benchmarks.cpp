@@ -526,6 +526,21 @@ std::map<std::string, args_vector_t> GetShorthand() {
 
     {"MATH_COMMON", args_vector_t{ {0}, {1}, {2}, {3} }},
     {"MATH_SINCOS_COMMON", args_vector_t{ {0}, {1}, {2}, {3}, {4}, {5}, {6}, {7} }},
+
+    // Number of threads running the benchmarked operation concurrently.
+    {"NUM_THREADS", args_vector_t{ {1}, {2}, {4}, {8}, {16} }},
+
+    // Number of otherwise idle threads alive while measuring.
+    {"NUM_IDLE_THREADS", args_vector_t{ {0}, {64}, {256}, {1024}, {2048} }},
+
+    // Number of pthread keys created besides those the benchmark uses.
+    {"NUM_PTHREAD_KEYS", args_vector_t{ {0}, {16}, {64}, {100} }},
+
+    // Number of objects allocated together.
+    {"NUM_ALLOCATIONS", args_vector_t{ {1}, {16}, {64}, {256}, {1024} }},
+
+    // Number of extra libraries to dlopen before measuring.
+    {"NUM_LIBRARIES", args_vector_t{ {0}, {50}, {100}, {200}, {400} }},
   };
 
   args_vector_t args_onebuf;
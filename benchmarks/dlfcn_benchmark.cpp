@@ -16,7 +16,15 @@
 
 #include <android-base/strings.h>
 #include <benchmark/benchmark.h>
+#include <dirent.h>
 #include <dlfcn.h>
+#include <link.h>
+
+#include <atomic>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "util.h"
 
@@ -37,3 +45,199 @@ BIONIC_TRIVIAL_BENCHMARK(BM_dladdr_libc_printf, bm_dladdr(printf));
 BIONIC_TRIVIAL_BENCHMARK(BM_dladdr_libdl_dladdr, bm_dladdr(dladdr));
 BIONIC_TRIVIAL_BENCHMARK(BM_dladdr_local_function, bm_dladdr(local_function));
 BIONIC_TRIVIAL_BENCHMARK(BM_dladdr_libbase_split, bm_dladdr(android::base::Split));
+
+#if defined(__LP64__)
+static constexpr const char* kSystemLibDir = "/system/lib64";
+#else
+static constexpr const char* kSystemLibDir = "/system/lib";
+#endif
+
+// Grows the number of libraries loaded in this process by dlopen()ing libraries from the
+// system library directory until at least `count` libraries have been opened by this helper.
+// Libraries that fail to load are skipped. The libraries are never closed, so later runs with
+// a larger count only pay for the difference.
+static size_t LoadExtraLibraries(size_t count) {
+  static std::vector<void*> handles;
+  static DIR* dir = opendir(kSystemLibDir);
+  while (dir != nullptr && handles.size() < count) {
+    dirent* de = readdir(dir);
+    if (de == nullptr) {
+      closedir(dir);
+      dir = nullptr;
+      break;
+    }
+    if (!android::base::EndsWith(de->d_name, ".so")) continue;
+    std::string path = std::string(kSystemLibDir) + "/" + de->d_name;
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle != nullptr) handles.push_back(handle);
+  }
+  return handles.size();
+}
+
+// Collects the start of the first PT_LOAD segment of every loaded library, in load order.
+static int CollectLibraryAddress(dl_phdr_info* info, size_t, void* data) {
+  auto* addresses = reinterpret_cast<std::vector<const void*>*>(data);
+  for (size_t i = 0; i < info->dlpi_phnum; ++i) {
+    if (info->dlpi_phdr[i].p_type == PT_LOAD && info->dlpi_phdr[i].p_memsz != 0) {
+      addresses->push_back(reinterpret_cast<const void*>(info->dlpi_addr +
+                                                         info->dlpi_phdr[i].p_vaddr));
+      break;
+    }
+  }
+  return 0;
+}
+
+// Measures the cost of a dladdr() lookup as the number of loaded libraries grows. The lookup
+// cycles over an address in each loaded library so that neither the front nor the back of the
+// library list is favored.
+static void BM_dladdr_vs_library_count(benchmark::State& state) {
+  LoadExtraLibraries(state.range(0));
+
+  std::vector<const void*> addresses;
+  dl_iterate_phdr(CollectLibraryAddress, &addresses);
+  if (addresses.empty()) {
+    state.SkipWithError("no loaded libraries found");
+    return;
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    Dl_info info;
+    benchmark::DoNotOptimize(dladdr(addresses[i], &info));
+    if (++i == addresses.size()) i = 0;
+  }
+  state.counters["libraries"] = addresses.size();
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_dladdr_vs_library_count, "NUM_LIBRARIES");
+
+// Measures dladdr() of an address in the most recently loaded library, which was the worst
+// case for a lookup that walks the library list from the front.
+static void BM_dladdr_last_loaded_library(benchmark::State& state) {
+  LoadExtraLibraries(state.range(0));
+
+  std::vector<const void*> addresses;
+  dl_iterate_phdr(CollectLibraryAddress, &addresses);
+  if (addresses.empty()) {
+    state.SkipWithError("no loaded libraries found");
+    return;
+  }
+
+  const void* addr = addresses.back();
+  for (auto _ : state) {
+    Dl_info info;
+    benchmark::DoNotOptimize(dladdr(addr, &info));
+  }
+  state.counters["libraries"] = addresses.size();
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_dladdr_last_loaded_library, "NUM_LIBRARIES");
+
+// Runs `fn` in the benchmark loop while state.range(0) - 1 other threads run it continuously,
+// so the reported time per iteration shows how well `fn` scales with concurrent callers.
+template <typename F>
+static void RunWithConcurrentThreads(benchmark::State& state, F fn) {
+  std::atomic<bool> done(false);
+  std::vector<std::thread> threads;
+  for (int64_t i = 1; i < state.range(0); ++i) {
+    threads.emplace_back([&]() {
+      while (!done.load(std::memory_order_relaxed)) fn();
+    });
+  }
+
+  for (auto _ : state) {
+    fn();
+  }
+
+  done = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  state.counters["threads"] = state.range(0);
+}
+
+static int CountLibrary(dl_phdr_info*, size_t, void* data) {
+  ++*reinterpret_cast<size_t*>(data);
+  return 0;
+}
+
+static void BM_dl_iterate_phdr_threads(benchmark::State& state) {
+  RunWithConcurrentThreads(state, []() {
+    size_t count = 0;
+    dl_iterate_phdr(CountLibrary, &count);
+    benchmark::DoNotOptimize(count);
+  });
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_dl_iterate_phdr_threads, "NUM_THREADS");
+
+static void __attribute__((noinline)) ThrowInt() {
+  throw 42;
+}
+
+// Each throw makes the unwinder find the throwing frame's library via dl_iterate_phdr().
+static void BM_dl_iterate_phdr_throw_catch_threads(benchmark::State& state) {
+  RunWithConcurrentThreads(state, []() {
+    try {
+      ThrowInt();
+    } catch (int value) {
+      benchmark::DoNotOptimize(value);
+    }
+  });
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_dl_iterate_phdr_throw_catch_threads, "NUM_THREADS");
+
+static void BM_dlsym_threads(benchmark::State& state) {
+  void* handle = dlopen("libc.so", RTLD_NOW | RTLD_NOLOAD);
+  if (handle == nullptr) {
+    state.SkipWithError(dlerror());
+    return;
+  }
+
+  RunWithConcurrentThreads(state, [handle]() {
+    benchmark::DoNotOptimize(dlsym(handle, "strlen"));
+  });
+  dlclose(handle);
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_dlsym_threads, "NUM_THREADS");
+
+// Looks up a libc symbol through the executable's handle, which searches the executable and
+// then its dependencies. Repeated lookups of the same name are answered by the handle's cache of
+// earlier results.
+static void BM_dlsym_main_handle_same_symbol(benchmark::State& state) {
+  void* handle = dlopen(nullptr, RTLD_NOW);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(dlsym(handle, "strlen"));
+  }
+  dlclose(handle);
+}
+BIONIC_BENCHMARK(BM_dlsym_main_handle_same_symbol);
+
+// As above, but cycles over more names than the cache holds, so most lookups miss.
+static void BM_dlsym_main_handle_many_symbols(benchmark::State& state) {
+  static constexpr const char* kNames[] = {
+    "abort", "atoi", "calloc", "close", "dup", "exit", "fclose", "fflush", "fopen", "fprintf",
+    "fread", "free", "fwrite", "getenv", "getpid", "malloc", "memchr", "memcmp", "memcpy",
+    "memmove", "memset", "open", "printf", "read", "realloc", "snprintf", "strchr", "strcmp",
+    "strcpy", "strdup", "strlen", "write",
+  };
+  void* handle = dlopen(nullptr, RTLD_NOW);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(dlsym(handle, kNames[i]));
+    if (++i == std::size(kNames)) i = 0;
+  }
+  dlclose(handle);
+}
+BIONIC_BENCHMARK(BM_dlsym_main_handle_many_symbols);
+
+static void BM_dlsym_rtld_default_threads(benchmark::State& state) {
+  RunWithConcurrentThreads(state, []() {
+    benchmark::DoNotOptimize(dlsym(RTLD_DEFAULT, "strlen"));
+  });
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_dlsym_rtld_default_threads, "NUM_THREADS");
+
+static void BM_dladdr_threads(benchmark::State& state) {
+  RunWithConcurrentThreads(state, []() {
+    benchmark::DoNotOptimize(bm_dladdr(printf));
+  });
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_dladdr_threads, "NUM_THREADS");
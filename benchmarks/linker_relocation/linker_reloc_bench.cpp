@@ -26,32 +26,139 @@
  * SUCH DAMAGE.
  */
 
+#include <dirent.h>
+#include <spawn.h>
 #include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
 
 #include "spawn_benchmark.h"
 
+extern char** environ;
+
 #if defined(__LP64__)
 static constexpr const char* kNativeTestDir = "nativetest64";
 #else
 static constexpr const char* kNativeTestDir = "nativetest";
 #endif
 
-static void BM_linker_relocation(benchmark::State& state) {
-  std::string main = test_program("linker_reloc_bench_main");
-
+static void set_test_lib_path() {
   // Translate from:
   //    /data/benchmarktest[64]/linker-reloc-bench    [exe dir]
   // to:
   //    /data/nativetest[64]/linker-reloc-bench       [dir with test libs]
-  std::string test_lib_dir = 
+  std::string test_lib_dir =
       android::base::Dirname(android::base::Dirname(android::base::GetExecutableDirectory())) +
       "/" + kNativeTestDir + "/linker-reloc-bench";
 
   setenv("LD_LIBRARY_PATH", test_lib_dir.c_str(), 1);
+}
+
+static void clear_dir(const std::string& path) {
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr) return;
+  while (dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] == '.') continue;
+    unlink((path + "/" + entry->d_name).c_str());
+  }
+  closedir(dir);
+}
+
+static void BM_linker_relocation(benchmark::State& state) {
+  std::string main = test_program("linker_reloc_bench_main");
+  set_test_lib_path();
+  unsetenv("LD_SYMBOL_CACHE_DIR");
 
   BM_spawn_test(state, (const char*[]) { main.c_str(), nullptr });
 }
 
 BENCHMARK(BM_linker_relocation)->UseRealTime()->Unit(benchmark::kMicrosecond);
 
+// Every run starts with an empty cache directory, so this measures the cost of
+// relocating everything and writing the cache files.
+static void run_with_cold_cache(benchmark::State& state, const char* cache_env) {
+  std::string main = test_program("linker_reloc_bench_main");
+  set_test_lib_path();
+
+  TemporaryDir cache_dir;
+  setenv(cache_env, cache_dir.path, 1);
+
+  BM_spawn_test(state, (const char*[]) { main.c_str(), nullptr },
+                [&]() { clear_dir(cache_dir.path); });
+
+  clear_dir(cache_dir.path);
+  unsetenv(cache_env);
+}
+
+// Every run finds the cache files written by an untimed first run.
+static void run_with_warm_cache(benchmark::State& state, const char* cache_env) {
+  std::string main = test_program("linker_reloc_bench_main");
+  set_test_lib_path();
+
+  TemporaryDir cache_dir;
+  setenv(cache_env, cache_dir.path, 1);
+
+  const char* argv[] = { main.c_str(), nullptr };
+  bool populated = false;
+  BM_spawn_test(state, argv, [&]() {
+    if (!populated) {
+      pid_t child;
+      if (posix_spawn(&child, argv[0], nullptr, nullptr, const_cast<char**>(argv), environ) == 0) {
+        TEMP_FAILURE_RETRY(waitpid(child, nullptr, 0));
+      }
+      populated = true;
+    }
+  });
+
+  clear_dir(cache_dir.path);
+  unsetenv(cache_env);
+}
+
+static void BM_linker_relocation_symbol_cache_cold(benchmark::State& state) {
+  run_with_cold_cache(state, "LD_SYMBOL_CACHE_DIR");
+}
+
+BENCHMARK(BM_linker_relocation_symbol_cache_cold)
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+static void BM_linker_relocation_symbol_cache_warm(benchmark::State& state) {
+  run_with_warm_cache(state, "LD_SYMBOL_CACHE_DIR");
+}
+
+BENCHMARK(BM_linker_relocation_symbol_cache_warm)
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+static void BM_linker_relocation_relro_cache_cold(benchmark::State& state) {
+  run_with_cold_cache(state, "LD_RELRO_CACHE_DIR");
+}
+
+BENCHMARK(BM_linker_relocation_relro_cache_cold)
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+static void BM_linker_relocation_relro_cache_warm(benchmark::State& state) {
+  run_with_warm_cache(state, "LD_RELRO_CACHE_DIR");
+}
+
+BENCHMARK(BM_linker_relocation_relro_cache_warm)
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// Runs the same program with relocations spread over the given number of loader helper threads
+// (in addition to the main thread).
+static void BM_linker_relocation_loader_threads(benchmark::State& state) {
+  std::string main = test_program("linker_reloc_bench_main");
+  set_test_lib_path();
+  unsetenv("LD_SYMBOL_CACHE_DIR");
+  setenv("LD_LOADER_THREADS", std::to_string(state.range(0)).c_str(), 1);
+
+  BM_spawn_test(state, (const char*[]) { main.c_str(), nullptr });
+
+  unsetenv("LD_LOADER_THREADS");
+}
+
+BENCHMARK(BM_linker_relocation_loader_threads)
+    ->Arg(0)->Arg(1)->Arg(3)->Arg(7)
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+
 BENCHMARK_MAIN();
@@ -27,14 +27,19 @@
  */
 
 #include <malloc.h>
+#include <stdint.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <thread>
 #include <vector>
 
 #include <benchmark/benchmark.h>
 #include "util.h"
 
 #if defined(__BIONIC__)
+#include "platform/bionic/malloc.h"
 
 static void RunMalloptPurge(benchmark::State& state, int purge_value) {
   static size_t sizes[] = {8, 16, 32, 64, 128, 1024, 4096, 16384, 65536, 131072, 1048576};
@@ -78,4 +83,135 @@ static void BM_mallopt_purge_all(benchmark::State& state) {
 }
 BIONIC_BENCHMARK(BM_mallopt_purge_all);
 
+// An allocation limit can't be removed once it's set, so these benchmarks run the allocations in a
+// child process. Each iteration asks the child for a batch of malloc/free pairs on one thread while
+// range(0) - 1 other threads keep allocating, and waits for the child to finish the batch. The work
+// happens in the child, so only the real time of these benchmarks is meaningful.
+static constexpr size_t kMallocBatchSize = 1024;
+
+static void MallocFreeBatch() {
+  void* ptrs[16];
+  for (size_t i = 0; i < kMallocBatchSize; i += 16) {
+    for (size_t j = 0; j < 16; j++) {
+      ptrs[j] = malloc(16 + (i + j) % 256);
+    }
+    for (size_t j = 0; j < 16; j++) {
+      free(ptrs[j]);
+    }
+  }
+}
+
+static void RunMallocChild(int request_fd, int reply_fd, bool set_limit, size_t thread_count) {
+  if (set_limit) {
+    size_t limit = SIZE_MAX;
+    if (!android_mallopt(M_SET_ALLOCATION_LIMIT_BYTES, &limit, sizeof(limit))) _exit(1);
+  }
+  std::atomic<bool> done(false);
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_count; ++i) {
+    threads.emplace_back([&done]() {
+      while (!done) MallocFreeBatch();
+    });
+  }
+  char c;
+  while (read(request_fd, &c, 1) == 1) {
+    MallocFreeBatch();
+    if (write(reply_fd, &c, 1) != 1) break;
+  }
+  done = true;
+  for (std::thread& thread : threads) thread.join();
+  _exit(0);
+}
+
+static void RunMallocThreads(benchmark::State& state, bool set_limit) {
+  int request_fds[2];
+  int reply_fds[2];
+  if (pipe(request_fds) == -1 || pipe(reply_fds) == -1) {
+    state.SkipWithError("pipe failed");
+    return;
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(request_fds[1]);
+    close(reply_fds[0]);
+    RunMallocChild(request_fds[0], reply_fds[1], set_limit, state.range(0));
+  }
+  close(request_fds[0]);
+  close(reply_fds[1]);
+
+  char c = 0;
+  for (auto _ : state) {
+    if (write(request_fds[1], &c, 1) != 1 || read(reply_fds[0], &c, 1) != 1) {
+      state.SkipWithError("child failed");
+      break;
+    }
+  }
+
+  close(request_fds[1]);
+  close(reply_fds[0]);
+  waitpid(pid, nullptr, 0);
+}
+
+static void BM_malloc_free_threads(benchmark::State& state) {
+  RunMallocThreads(state, false);
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_malloc_free_threads, "NUM_THREADS");
+
+static void BM_malloc_free_threads_allocation_limit(benchmark::State& state) {
+  RunMallocThreads(state, true);
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_malloc_free_threads_allocation_limit, "NUM_THREADS");
+
+// These compare allocating and freeing range(0) 64 byte objects one at a time, and as a batch.
+static constexpr size_t kBatchObjectSize = 64;
+
+static void BM_malloc_free_loop(benchmark::State& state) {
+  std::vector<void*> ptrs(state.range(0));
+  for (auto _ : state) {
+    for (void*& ptr : ptrs) {
+      ptr = malloc(kBatchObjectSize);
+    }
+    benchmark::DoNotOptimize(ptrs.data());
+    for (void* ptr : ptrs) {
+      free(ptr);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_malloc_free_loop, "NUM_ALLOCATIONS");
+
+static void BM_malloc_batch_free_batch(benchmark::State& state) {
+  std::vector<void*> ptrs(state.range(0));
+  for (auto _ : state) {
+    if (malloc_batch(kBatchObjectSize, ptrs.data(), ptrs.size()) != ptrs.size()) {
+      state.SkipWithError("malloc_batch failed");
+      break;
+    }
+    benchmark::DoNotOptimize(ptrs.data());
+    free_batch(ptrs.data(), ptrs.size());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_malloc_batch_free_batch, "NUM_ALLOCATIONS");
+
+static void BM_malloc_free(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  for (auto _ : state) {
+    void* ptr;
+    benchmark::DoNotOptimize(ptr = malloc(nbytes));
+    free(ptr);
+  }
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_malloc_free, "AT_COMMON_SIZES");
+
+static void BM_malloc_free_sized(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  for (auto _ : state) {
+    void* ptr;
+    benchmark::DoNotOptimize(ptr = malloc(nbytes));
+    free_sized(ptr, nbytes);
+  }
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_malloc_free_sized, "AT_COMMON_SIZES");
+
 #endif
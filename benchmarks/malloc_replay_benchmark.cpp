@@ -0,0 +1,537 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+// Replays an allocation trace written by malloc debug's record_allocs option (see
+// libc/malloc_debug/README.md), in either the text or the binary format, on as many threads as the
+// trace has, starting the operations in the order they were recorded in, and reports throughput,
+// latency percentiles, peak RSS and fragmentation. If the trace has times, the gaps between
+// operations in the traced process are reported too, and --timed replays with those gaps rather
+// than as fast as possible.
+//
+//   malloc-replay-benchmark [--timed] TRACE_FILE
+
+#include <errno.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "malloc_debug/RecordEntry.h"
+
+// The trace is converted to these as it's read, so that replaying doesn't parse anything. Pointers
+// are replaced by ids, numbered in the order they were allocated; 0 stands for a null pointer.
+struct TraceEntry {
+  enum Op : uint8_t { kMalloc, kCalloc, kMemalign, kRealloc, kFree };
+
+  Op op;
+  uint32_t thread;
+  uint32_t id;
+  uint32_t old_id;
+  uint64_t size;
+  // nmemb for calloc, alignment for memalign.
+  uint64_t arg;
+  // When the operation started in the traced process, or 0 if the trace has no times.
+  uint64_t start_ns;
+};
+
+struct Trace {
+  std::vector<TraceEntry> entries;
+  size_t thread_count = 0;
+  size_t id_count = 1;
+  uint64_t peak_live_bytes = 0;
+  // Whether every entry has the time it started at.
+  bool has_times = true;
+  uint64_t first_start_ns = UINT64_MAX;
+};
+
+// Turns the records of a trace, in the order the operations completed, into TraceEntry values.
+class TraceBuilder {
+ public:
+  explicit TraceBuilder(Trace* trace) : trace_(trace), id_sizes_(1) {}
+
+  // Returns false if the record has an unknown type.
+  bool Add(const RecordEntry& record, bool has_times) {
+    TraceEntry entry = {};
+    auto [it, inserted] = threads_.emplace(record.tid, threads_.size());
+    entry.thread = it->second;
+    entry.size = record.size;
+
+    switch (record.type) {
+      case RecordType::kThreadDone:
+        return true;
+      case RecordType::kMalloc:
+        entry.op = TraceEntry::kMalloc;
+        entry.id = NewId(record.pointer, record.size);
+        break;
+      case RecordType::kCalloc:
+        entry.op = TraceEntry::kCalloc;
+        entry.arg = record.extra;
+        entry.id = NewId(record.pointer, record.extra * record.size);
+        break;
+      case RecordType::kMemalign:
+        entry.op = TraceEntry::kMemalign;
+        entry.arg = record.extra;
+        entry.id = NewId(record.pointer, record.size);
+        break;
+      case RecordType::kRealloc:
+        if (record.pointer == 0 && record.size != 0) {
+          // A failed realloc left the old pointer alone, so there's nothing to replay.
+          return true;
+        }
+        entry.op = TraceEntry::kRealloc;
+        entry.old_id = record.extra == 0 ? 0 : FreeId(record.extra);
+        if (record.extra != 0 && entry.old_id == 0) {
+          // Growing an unknown pointer is replayed as an allocation.
+          entry.op = TraceEntry::kMalloc;
+        }
+        entry.id = NewId(record.pointer, record.size);
+        break;
+      case RecordType::kFree:
+        entry.op = TraceEntry::kFree;
+        entry.id = FreeId(record.pointer);
+        if (entry.id == 0) return true;
+        break;
+      default:
+        return false;
+    }
+
+    if (has_times) {
+      entry.start_ns = record.start_ns;
+      trace_->first_start_ns = std::min(trace_->first_start_ns, record.start_ns);
+    } else {
+      trace_->has_times = false;
+    }
+    trace_->entries.push_back(entry);
+    return true;
+  }
+
+  void Finish() {
+    trace_->thread_count = threads_.size();
+    if (trace_->entries.empty()) trace_->has_times = false;
+  }
+
+ private:
+  uint32_t NewId(uint64_t pointer, uint64_t size) {
+    if (pointer == 0) return 0;
+    uint32_t id = trace_->id_count++;
+    live_ids_[pointer] = id;
+    id_sizes_.push_back(size);
+    live_bytes_ += size;
+    trace_->peak_live_bytes = std::max(trace_->peak_live_bytes, live_bytes_);
+    return id;
+  }
+
+  uint32_t FreeId(uint64_t pointer) {
+    auto it = live_ids_.find(pointer);
+    // Pointers allocated before recording started aren't known, so their frees are dropped.
+    if (it == live_ids_.end()) return 0;
+    uint32_t id = it->second;
+    live_ids_.erase(it);
+    live_bytes_ -= id_sizes_[id];
+    return id;
+  }
+
+  Trace* trace_;
+  std::unordered_map<int32_t, uint32_t> threads_;
+  std::unordered_map<uint64_t, uint32_t> live_ids_;
+  std::vector<uint64_t> id_sizes_;
+  uint64_t live_bytes_ = 0;
+};
+
+// Reads the text format, one "TID: OPERATION ARGS [START_NS END_NS]" line per record. Traces
+// recorded before the times were added to the format are still accepted.
+static bool ReadTextTrace(const char* path, FILE* fp, TraceBuilder* builder) {
+  char* line = nullptr;
+  size_t line_size = 0;
+  size_t line_number = 0;
+  bool ok = true;
+  while (getline(&line, &line_size, fp) != -1) {
+    ++line_number;
+    RecordEntry record = {};
+    char op[16];
+    int offset;
+    if (sscanf(line, "%d: %15s%n", &record.tid, op, &offset) != 2) {
+      fprintf(stderr, "%s:%zu: malformed line: %s", path, line_number, line);
+      ok = false;
+      break;
+    }
+    const char* args = line + offset;
+
+    // The number of arguments before the times.
+    int expected;
+    int matched;
+    if (strcmp(op, "malloc") == 0) {
+      record.type = RecordType::kMalloc;
+      expected = 2;
+      matched = sscanf(args, "%" SCNx64 " %" SCNu64 " %" SCNu64 " %" SCNu64, &record.pointer,
+                       &record.size, &record.start_ns, &record.end_ns);
+    } else if (strcmp(op, "calloc") == 0 || strcmp(op, "memalign") == 0) {
+      record.type = op[0] == 'c' ? RecordType::kCalloc : RecordType::kMemalign;
+      expected = 3;
+      matched = sscanf(args, "%" SCNx64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64,
+                       &record.pointer, &record.extra, &record.size, &record.start_ns,
+                       &record.end_ns);
+    } else if (strcmp(op, "realloc") == 0) {
+      record.type = RecordType::kRealloc;
+      expected = 3;
+      matched = sscanf(args, "%" SCNx64 " %" SCNx64 " %" SCNu64 " %" SCNu64 " %" SCNu64,
+                       &record.pointer, &record.extra, &record.size, &record.start_ns,
+                       &record.end_ns);
+    } else if (strcmp(op, "free") == 0) {
+      record.type = RecordType::kFree;
+      expected = 1;
+      matched = sscanf(args, "%" SCNx64 " %" SCNu64 " %" SCNu64, &record.pointer,
+                       &record.start_ns, &record.end_ns);
+    } else if (strcmp(op, "thread_done") == 0) {
+      record.type = RecordType::kThreadDone;
+      expected = matched = 0;
+    } else {
+      fprintf(stderr, "%s:%zu: unknown operation: %s", path, line_number, line);
+      ok = false;
+      break;
+    }
+    if (matched != expected && matched != expected + 2) {
+      fprintf(stderr, "%s:%zu: malformed line: %s", path, line_number, line);
+      ok = false;
+      break;
+    }
+    builder->Add(record, matched == expected + 2);
+  }
+  free(line);
+  return ok;
+}
+
+// Reads the binary format that the record_allocs_binary option writes: a RecordFileHeader, whose
+// magic has already been read, followed by RecordEntry values.
+static bool ReadBinaryTrace(const char* path, FILE* fp, TraceBuilder* builder) {
+  RecordFileHeader header;
+  if (fread(reinterpret_cast<char*>(&header) + sizeof(header.magic),
+            sizeof(header) - sizeof(header.magic), 1, fp) != 1) {
+    fprintf(stderr, "%s: truncated header\n", path);
+    return false;
+  }
+  if (header.version != kRecordFileVersion || header.entry_size != sizeof(RecordEntry)) {
+    fprintf(stderr, "%s: unsupported version %u, entry size %u\n", path, header.version,
+            header.entry_size);
+    return false;
+  }
+
+  std::vector<RecordEntry> records;
+  RecordEntry record;
+  size_t bytes;
+  while ((bytes = fread(&record, 1, sizeof(record), fp)) == sizeof(record)) {
+    // thread_done records have no times, and there's nothing to replay for them.
+    if (record.type != RecordType::kThreadDone) records.push_back(record);
+  }
+  if (ferror(fp)) {
+    fprintf(stderr, "%s: read failed: %s\n", path, strerror(errno));
+    return false;
+  }
+  if (bytes != 0) {
+    fprintf(stderr, "%s: ends with a partial record\n", path);
+    return false;
+  }
+
+  // The records of different threads are interleaved in the order their buffers were flushed, not
+  // the order the operations happened. Put them in the order the operations completed, as the text
+  // format has them, so that every free comes after the allocation it frees.
+  std::stable_sort(records.begin(), records.end(),
+                   [](const RecordEntry& a, const RecordEntry& b) { return a.end_ns < b.end_ns; });
+  for (size_t i = 0; i < records.size(); ++i) {
+    if (!builder->Add(records[i], true)) {
+      fprintf(stderr, "%s: record %zu has unknown type %u\n", path, i,
+              static_cast<uint32_t>(records[i].type));
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool ReadTrace(const char* path, Trace* trace) {
+  FILE* fp = fopen(path, "re");
+  if (fp == nullptr) {
+    fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+    return false;
+  }
+
+  TraceBuilder builder(trace);
+  char magic[sizeof(RecordFileHeader::magic)];
+  bool ok;
+  if (fread(magic, sizeof(magic), 1, fp) == 1 &&
+      memcmp(magic, kRecordFileMagic, sizeof(magic)) == 0) {
+    ok = ReadBinaryTrace(path, fp, &builder);
+  } else {
+    rewind(fp);
+    ok = ReadTextTrace(path, fp, &builder);
+  }
+  fclose(fp);
+  builder.Finish();
+  return ok;
+}
+
+static size_t GetRssBytes() {
+  FILE* fp = fopen("/proc/self/statm", "re");
+  if (fp == nullptr) return 0;
+  size_t pages = 0;
+  if (fscanf(fp, "%*u %zu", &pages) != 1) pages = 0;
+  fclose(fp);
+  return pages * getpagesize();
+}
+
+class Replayer {
+ public:
+  Replayer(const Trace& trace, bool timed)
+      : trace_(trace),
+        timed_(timed),
+        pointers_(new std::atomic<void*>[trace.id_count]),
+        ready_(new std::atomic<bool>[trace.id_count]),
+        latencies_(trace.thread_count) {
+    for (size_t i = 0; i < trace.id_count; ++i) {
+      pointers_[i] = nullptr;
+      ready_[i] = false;
+    }
+    // Everything the replay needs is allocated up front, so that it doesn't show up in the RSS.
+    entries_by_thread_.resize(trace.thread_count);
+    for (size_t i = 0; i < trace.entries.size(); ++i) {
+      entries_by_thread_[trace.entries[i].thread].push_back(i);
+    }
+    for (size_t i = 0; i < trace.thread_count; ++i) {
+      latencies_[i].reserve(entries_by_thread_[i].size());
+    }
+  }
+
+  // Returns the wall time the replay took.
+  std::chrono::nanoseconds Run() {
+    std::vector<std::thread> threads;
+    start_ = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < trace_.thread_count; ++i) {
+      threads.emplace_back([this, i]() { RunThread(i); });
+    }
+    for (std::thread& thread : threads) thread.join();
+    return std::chrono::steady_clock::now() - start_;
+  }
+
+  // Frees what the trace left allocated.
+  void FreeAll() {
+    for (size_t i = 0; i < trace_.id_count; ++i) {
+      free(pointers_[i].exchange(nullptr));
+    }
+  }
+
+  std::vector<uint64_t> AllLatencies() const {
+    std::vector<uint64_t> all;
+    for (const std::vector<uint64_t>& latencies : latencies_) {
+      all.insert(all.end(), latencies.begin(), latencies.end());
+    }
+    return all;
+  }
+
+ private:
+  static void Wait(size_t* spins) {
+    if (++*spins > 100) sched_yield();
+  }
+
+  // Waits until the allocation that produced id has finished, possibly on another thread.
+  void* TakePointer(uint32_t id) {
+    size_t spins = 0;
+    while (!ready_[id].load(std::memory_order_acquire)) Wait(&spins);
+    return pointers_[id].exchange(nullptr, std::memory_order_relaxed);
+  }
+
+  void SetPointer(uint32_t id, void* pointer, size_t size) {
+    if (pointer != nullptr) {
+      // Touch the memory so that it counts towards the RSS, as it would have in the traced process.
+      for (size_t i = 0; i < size; i += 4096) static_cast<volatile char*>(pointer)[i] = 1;
+    }
+    if (id == 0) {
+      free(pointer);
+      return;
+    }
+    pointers_[id].store(pointer, std::memory_order_relaxed);
+    ready_[id].store(true, std::memory_order_release);
+  }
+
+  void RunThread(size_t thread) {
+    std::vector<uint64_t>& latencies = latencies_[thread];
+    for (size_t index : entries_by_thread_[thread]) {
+      // Operations start in the order they were recorded, but don't wait for each other to finish.
+      size_t spins = 0;
+      while (next_.load(std::memory_order_acquire) != index) Wait(&spins);
+      const TraceEntry& entry = trace_.entries[index];
+      if (timed_) {
+        // Keep the gaps the traced process had between operations. An operation that's already
+        // late starts right away.
+        auto at = start_ + std::chrono::nanoseconds(entry.start_ns - trace_.first_start_ns);
+        while (std::chrono::steady_clock::now() < at) Wait(&spins);
+      }
+      void* old_pointer = nullptr;
+      if (entry.op == TraceEntry::kFree || (entry.op == TraceEntry::kRealloc && entry.old_id != 0)) {
+        old_pointer = TakePointer(entry.op == TraceEntry::kFree ? entry.id : entry.old_id);
+      }
+      next_.store(index + 1, std::memory_order_release);
+
+      void* pointer = nullptr;
+      auto start = std::chrono::steady_clock::now();
+      switch (entry.op) {
+        case TraceEntry::kMalloc:
+          pointer = malloc(entry.size);
+          break;
+        case TraceEntry::kCalloc:
+          pointer = calloc(entry.arg, entry.size);
+          break;
+        case TraceEntry::kMemalign:
+          pointer = memalign(entry.arg, entry.size);
+          break;
+        case TraceEntry::kRealloc:
+          pointer = realloc(old_pointer, entry.size);
+          break;
+        case TraceEntry::kFree:
+          free(old_pointer);
+          break;
+      }
+      latencies.push_back((std::chrono::steady_clock::now() - start).count());
+
+      if (entry.op != TraceEntry::kFree) {
+        SetPointer(entry.id, pointer, entry.op == TraceEntry::kCalloc ? entry.arg * entry.size
+                                                                        : entry.size);
+      }
+    }
+  }
+
+  const Trace& trace_;
+  const bool timed_;
+  std::chrono::steady_clock::time_point start_;
+  std::unique_ptr<std::atomic<void*>[]> pointers_;
+  std::unique_ptr<std::atomic<bool>[]> ready_;
+  std::vector<std::vector<size_t>> entries_by_thread_;
+  std::vector<std::vector<uint64_t>> latencies_;
+  std::atomic<size_t> next_ = 0;
+};
+
+// Prints the given percentiles of values, which must be sorted and not empty.
+static void PrintPercentiles(const char* name, const std::vector<uint64_t>& values) {
+  auto percentile = [&](double p) {
+    return values[std::min(values.size() - 1, static_cast<size_t>(p * values.size()))];
+  };
+  printf("%s: p50 %" PRIu64 " ns, p90 %" PRIu64 " ns, p99 %" PRIu64 " ns, p99.9 %" PRIu64
+         " ns, max %" PRIu64 " ns\n",
+         name, percentile(0.5), percentile(0.9), percentile(0.99), percentile(0.999),
+         values.back());
+}
+
+static int Usage(const char* name) {
+  fprintf(stderr, "usage: %s [--timed] TRACE_FILE\n", name);
+  fprintf(stderr, "  TRACE_FILE is a text or binary record_allocs file.\n");
+  fprintf(stderr, "  --timed  start each operation as long after the first as it was recorded,\n");
+  fprintf(stderr, "           rather than as soon as the previous one has started.\n");
+  return 1;
+}
+
+int main(int argc, char* argv[]) {
+  bool timed = false;
+  if (argc == 3 && strcmp(argv[1], "--timed") == 0) {
+    timed = true;
+  } else if (argc != 2) {
+    return Usage(argv[0]);
+  }
+  const char* path = argv[argc - 1];
+
+  Trace trace;
+  if (!ReadTrace(path, &trace)) return 1;
+  if (trace.entries.empty()) {
+    fprintf(stderr, "%s: no allocations to replay\n", path);
+    return 1;
+  }
+  if (timed && !trace.has_times) {
+    fprintf(stderr, "%s: --timed needs a trace with times for every operation\n", path);
+    return 1;
+  }
+
+  Replayer replayer(trace, timed);
+  size_t rss_before = GetRssBytes();
+
+  // Sample the RSS while the trace replays.
+  std::atomic<bool> done = false;
+  std::atomic<size_t> peak_rss = rss_before;
+  std::thread sampler([&]() {
+    while (!done) {
+      size_t rss = GetRssBytes();
+      if (rss > peak_rss) peak_rss = rss;
+      usleep(1000);
+    }
+  });
+  std::chrono::nanoseconds elapsed = replayer.Run();
+  done = true;
+  sampler.join();
+  peak_rss = std::max(peak_rss.load(), GetRssBytes());
+  replayer.FreeAll();
+
+  std::vector<uint64_t> latencies = replayer.AllLatencies();
+  std::sort(latencies.begin(), latencies.end());
+
+  printf("Operations: %zu on %zu threads\n", trace.entries.size(), trace.thread_count);
+  printf("Time: %.3f ms\n", elapsed.count() / 1e6);
+  printf("Throughput: %.0f ops/s\n", trace.entries.size() / (elapsed.count() / 1e9));
+  PrintPercentiles("Latency", latencies);
+  if (trace.has_times) {
+    // The gaps between one operation starting and the next one starting, on any thread, in the
+    // traced process.
+    std::vector<uint64_t> starts;
+    for (const TraceEntry& entry : trace.entries) starts.push_back(entry.start_ns);
+    std::sort(starts.begin(), starts.end());
+    printf("Recorded time: %.3f ms\n", (starts.back() - starts.front()) / 1e6);
+    if (starts.size() > 1) {
+      std::vector<uint64_t> gaps;
+      for (size_t i = 1; i < starts.size(); ++i) gaps.push_back(starts[i] - starts[i - 1]);
+      std::sort(gaps.begin(), gaps.end());
+      PrintPercentiles("Recorded inter-arrival gap", gaps);
+    }
+  }
+  size_t rss_growth = peak_rss - rss_before;
+  printf("Peak RSS: %.2f MB (%.2f MB above the RSS before replaying)\n", peak_rss / 1048576.0,
+         rss_growth / 1048576.0);
+  printf("Peak live bytes: %.2f MB\n", trace.peak_live_bytes / 1048576.0);
+  // How much of the memory the replay made resident wasn't holding live allocations at the peak.
+  if (rss_growth > trace.peak_live_bytes) {
+    printf("Fragmentation: %.1f%%\n", 100.0 * (rss_growth - trace.peak_live_bytes) / rss_growth);
+  } else {
+    printf("Fragmentation: 0.0%%\n");
+  }
+  return 0;
+}
@@ -14,7 +14,12 @@
  * limitations under the License.
  */
 
+#include <limits.h>
 #include <pthread.h>
+#include <time.h>
+
+#include <atomic>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 #include "util.h"
@@ -148,6 +153,64 @@ static void BM_pthread_mutex_lock_RECURSIVE_PI(benchmark::State& state) {
 }
 BIONIC_BENCHMARK(BM_pthread_mutex_lock_RECURSIVE_PI);
 
+namespace {
+// A mutex that range(0) - 1 other threads keep taking for a short critical section while the
+// benchmark thread measures its own lock/unlock pairs.
+struct ContendedMutex {
+  pthread_mutex_t mutex;
+  std::atomic<bool> done;
+  size_t counter;
+  std::vector<pthread_t> threads;
+
+  ContendedMutex(int type, size_t thread_count) : done(false), counter(0) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, type);
+    pthread_mutex_init(&mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    threads.resize(thread_count > 0 ? thread_count - 1 : 0);
+    for (pthread_t& thread : threads) pthread_create(&thread, nullptr, Contend, this);
+  }
+
+  ~ContendedMutex() {
+    done = true;
+    for (pthread_t thread : threads) pthread_join(thread, nullptr);
+    pthread_mutex_destroy(&mutex);
+  }
+
+  void LockUnlock() {
+    pthread_mutex_lock(&mutex);
+    ++counter;
+    pthread_mutex_unlock(&mutex);
+  }
+
+  static void* Contend(void* arg) {
+    ContendedMutex* m = reinterpret_cast<ContendedMutex*>(arg);
+    while (!m->done) m->LockUnlock();
+    return nullptr;
+  }
+};
+}
+
+static void BM_pthread_mutex_lock_contended(benchmark::State& state) {
+  ContendedMutex m(PTHREAD_MUTEX_NORMAL, state.range(0));
+  while (state.KeepRunning()) {
+    m.LockUnlock();
+  }
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_pthread_mutex_lock_contended, "NUM_THREADS");
+
+#if !defined(ANDROID_HOST_MUSL)
+static void BM_pthread_mutex_lock_contended_ADAPTIVE(benchmark::State& state) {
+  ContendedMutex m(PTHREAD_MUTEX_ADAPTIVE_NP, state.range(0));
+  while (state.KeepRunning()) {
+    m.LockUnlock();
+  }
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_pthread_mutex_lock_contended_ADAPTIVE, "NUM_THREADS");
+#endif
+
 static void BM_pthread_rwlock_read(benchmark::State& state) {
   pthread_rwlock_t lock;
   pthread_rwlock_init(&lock, nullptr);
@@ -174,6 +237,201 @@ static void BM_pthread_rwlock_write(benchmark::State& state) {
 }
 BIONIC_BENCHMARK(BM_pthread_rwlock_write);
 
+#if defined(__BIONIC__)
+static void BM_pthread_rwlock_read_READER_BIASED(benchmark::State& state) {
+  pthread_rwlock_t lock = PTHREAD_RWLOCK_READER_BIASED_INITIALIZER_NP;
+
+  while (state.KeepRunning()) {
+    pthread_rwlock_rdlock(&lock);
+    pthread_rwlock_unlock(&lock);
+  }
+
+  pthread_rwlock_destroy(&lock);
+}
+BIONIC_BENCHMARK(BM_pthread_rwlock_read_READER_BIASED);
+
+static void BM_pthread_rwlock_write_READER_BIASED(benchmark::State& state) {
+  pthread_rwlock_t lock = PTHREAD_RWLOCK_READER_BIASED_INITIALIZER_NP;
+
+  while (state.KeepRunning()) {
+    pthread_rwlock_wrlock(&lock);
+    pthread_rwlock_unlock(&lock);
+  }
+
+  pthread_rwlock_destroy(&lock);
+}
+BIONIC_BENCHMARK(BM_pthread_rwlock_write_READER_BIASED);
+#endif
+
+#if !defined(ANDROID_HOST_MUSL)
+namespace {
+// A rwlock that range(0) - 1 other threads keep read-locking while the benchmark thread measures
+// its own read lock/unlock pairs.
+struct ConcurrentReaders {
+  pthread_rwlock_t lock;
+  std::atomic<bool> done;
+  std::vector<pthread_t> threads;
+
+  ConcurrentReaders(int kind, size_t thread_count) : done(false) {
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setkind_np(&attr, kind);
+    pthread_rwlock_init(&lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+
+    threads.resize(thread_count > 0 ? thread_count - 1 : 0);
+    for (pthread_t& thread : threads) pthread_create(&thread, nullptr, Read, this);
+  }
+
+  ~ConcurrentReaders() {
+    done = true;
+    for (pthread_t thread : threads) pthread_join(thread, nullptr);
+    pthread_rwlock_destroy(&lock);
+  }
+
+  void ReadLockUnlock() {
+    pthread_rwlock_rdlock(&lock);
+    pthread_rwlock_unlock(&lock);
+  }
+
+  static void* Read(void* arg) {
+    ConcurrentReaders* r = reinterpret_cast<ConcurrentReaders*>(arg);
+    while (!r->done) r->ReadLockUnlock();
+    return nullptr;
+  }
+};
+}
+
+static void BM_pthread_rwlock_read_concurrent(benchmark::State& state) {
+  ConcurrentReaders r(PTHREAD_RWLOCK_PREFER_READER_NP, state.range(0));
+  while (state.KeepRunning()) {
+    r.ReadLockUnlock();
+  }
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_pthread_rwlock_read_concurrent, "NUM_THREADS");
+#endif
+
+#if defined(__BIONIC__)
+static void BM_pthread_rwlock_read_concurrent_READER_BIASED(benchmark::State& state) {
+  ConcurrentReaders r(PTHREAD_RWLOCK_READER_BIASED_NP, state.range(0));
+  while (state.KeepRunning()) {
+    r.ReadLockUnlock();
+  }
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_pthread_rwlock_read_concurrent_READER_BIASED, "NUM_THREADS");
+#endif
+
+namespace {
+// range(0) threads waiting on a condition variable. Each round, the benchmark thread broadcasts
+// and waits until every waiter has woken up and taken the mutex.
+struct BroadcastHerd {
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t go_cond = PTHREAD_COND_INITIALIZER;
+  pthread_cond_t arrived_cond = PTHREAD_COND_INITIALIZER;
+  size_t round = 0;
+  size_t arrived = 0;
+  bool done = false;
+  std::vector<pthread_t> threads;
+
+  explicit BroadcastHerd(size_t thread_count) : threads(thread_count) {
+    for (pthread_t& thread : threads) pthread_create(&thread, nullptr, Wait, this);
+    WaitForArrivals();
+  }
+
+  ~BroadcastHerd() {
+    pthread_mutex_lock(&mutex);
+    done = true;
+    pthread_cond_broadcast(&go_cond);
+    pthread_mutex_unlock(&mutex);
+    for (pthread_t thread : threads) pthread_join(thread, nullptr);
+  }
+
+  void WaitForArrivals() {
+    pthread_mutex_lock(&mutex);
+    while (arrived < threads.size() * (round + 1)) pthread_cond_wait(&arrived_cond, &mutex);
+    pthread_mutex_unlock(&mutex);
+  }
+
+  void Broadcast() {
+    pthread_mutex_lock(&mutex);
+    ++round;
+    pthread_cond_broadcast(&go_cond);
+    pthread_mutex_unlock(&mutex);
+  }
+
+  static void* Wait(void* arg) {
+    BroadcastHerd* h = reinterpret_cast<BroadcastHerd*>(arg);
+    pthread_mutex_lock(&h->mutex);
+    for (size_t round = 0; !h->done; ++round) {
+      if (++h->arrived == h->threads.size() * (round + 1)) pthread_cond_signal(&h->arrived_cond);
+      while (h->round == round && !h->done) pthread_cond_wait(&h->go_cond, &h->mutex);
+    }
+    pthread_mutex_unlock(&h->mutex);
+    return nullptr;
+  }
+};
+}
+
+static void BM_pthread_cond_broadcast_herd(benchmark::State& state) {
+  BroadcastHerd herd(state.range(0));
+  while (state.KeepRunning()) {
+    herd.Broadcast();
+    herd.WaitForArrivals();
+  }
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_pthread_cond_broadcast_herd, "NUM_THREADS");
+
+namespace {
+// A single-slot queue between the benchmark thread and a consumer thread.
+struct ProducerConsumer {
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t not_empty = PTHREAD_COND_INITIALIZER;
+  pthread_cond_t not_full = PTHREAD_COND_INITIALIZER;
+  bool full = false;
+  bool done = false;
+  pthread_t consumer;
+
+  ProducerConsumer() { pthread_create(&consumer, nullptr, Consume, this); }
+
+  ~ProducerConsumer() {
+    pthread_mutex_lock(&mutex);
+    done = true;
+    pthread_cond_signal(&not_empty);
+    pthread_mutex_unlock(&mutex);
+    pthread_join(consumer, nullptr);
+  }
+
+  void Produce() {
+    pthread_mutex_lock(&mutex);
+    while (full) pthread_cond_wait(&not_full, &mutex);
+    full = true;
+    pthread_cond_signal(&not_empty);
+    pthread_mutex_unlock(&mutex);
+  }
+
+  static void* Consume(void* arg) {
+    ProducerConsumer* pc = reinterpret_cast<ProducerConsumer*>(arg);
+    pthread_mutex_lock(&pc->mutex);
+    while (true) {
+      while (!pc->full && !pc->done) pthread_cond_wait(&pc->not_empty, &pc->mutex);
+      if (pc->done) break;
+      pc->full = false;
+      pthread_cond_signal(&pc->not_full);
+    }
+    pthread_mutex_unlock(&pc->mutex);
+    return nullptr;
+  }
+};
+}
+
+static void BM_pthread_cond_producer_consumer(benchmark::State& state) {
+  ProducerConsumer pc;
+  while (state.KeepRunning()) {
+    pc.Produce();
+  }
+}
+BIONIC_BENCHMARK(BM_pthread_cond_producer_consumer);
+
 static void* IdleThread(void*) {
   return nullptr;
 }
@@ -202,6 +460,31 @@ static void BM_pthread_create_and_run(benchmark::State& state) {
 }
 BIONIC_BENCHMARK(BM_pthread_create_and_run);
 
+static void* SetSpecificThread(void* key) {
+  pthread_setspecific(*reinterpret_cast<pthread_key_t*>(key), key);
+  return nullptr;
+}
+
+static void NoOpKeyDestructor(void*) {}
+
+// Thread exit cost with range(0) keys registered, of which the thread only uses one.
+static void BM_pthread_create_and_run_with_keys(benchmark::State& state) {
+  std::vector<pthread_key_t> keys(state.range(0));
+  for (pthread_key_t& key : keys) pthread_key_create(&key, NoOpKeyDestructor);
+  pthread_key_t used_key;
+  pthread_key_create(&used_key, NoOpKeyDestructor);
+
+  while (state.KeepRunning()) {
+    pthread_t thread;
+    pthread_create(&thread, nullptr, SetSpecificThread, &used_key);
+    pthread_join(thread, nullptr);
+  }
+
+  pthread_key_delete(used_key);
+  for (pthread_key_t key : keys) pthread_key_delete(key);
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_pthread_create_and_run_with_keys, "NUM_PTHREAD_KEYS");
+
 static void* ExitThread(void*) {
   pthread_exit(nullptr);
 }
@@ -215,6 +498,17 @@ static void BM_pthread_exit_and_join(benchmark::State& state) {
 }
 BIONIC_BENCHMARK(BM_pthread_exit_and_join);
 
+// Thread-per-task throughput: start a batch of threads and wait for all of them.
+static void BM_pthread_create_and_join_batch(benchmark::State& state) {
+  std::vector<pthread_t> threads(state.range(0));
+  while (state.KeepRunning()) {
+    for (pthread_t& thread : threads) pthread_create(&thread, nullptr, RunThread, nullptr);
+    for (pthread_t thread : threads) pthread_join(thread, nullptr);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_pthread_create_and_join_batch, "NUM_THREADS");
+
 static void BM_pthread_key_create(benchmark::State& state) {
   while (state.KeepRunning()) {
     pthread_key_t key;
@@ -238,3 +532,49 @@ static void BM_pthread_key_delete(benchmark::State& state) {
   }
 }
 BIONIC_BENCHMARK(BM_pthread_key_delete);
+
+static pthread_mutex_t g_idle_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_idle_cond = PTHREAD_COND_INITIALIZER;
+static bool g_idle_done;
+
+static void* WaitThread(void*) {
+  pthread_mutex_lock(&g_idle_mutex);
+  while (!g_idle_done) pthread_cond_wait(&g_idle_cond, &g_idle_mutex);
+  pthread_mutex_unlock(&g_idle_mutex);
+  return nullptr;
+}
+
+// Every call that takes a pthread_t has to look the thread up first. The
+// first thread created is the one a search of the thread list finds last.
+static void BM_pthread_getcpuclockid_idle_threads(benchmark::State& state) {
+  g_idle_done = false;
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, PTHREAD_STACK_MIN);
+
+  pthread_t target;
+  pthread_create(&target, &attr, WaitThread, nullptr);
+  std::vector<pthread_t> threads;
+  for (int i = 0; i < state.range(0); ++i) {
+    pthread_t thread;
+    if (pthread_create(&thread, &attr, WaitThread, nullptr) != 0) {
+      state.SkipWithError("pthread_create failed");
+      break;
+    }
+    threads.push_back(thread);
+  }
+  pthread_attr_destroy(&attr);
+
+  clockid_t clock;
+  while (state.KeepRunning()) {
+    pthread_getcpuclockid(target, &clock);
+  }
+
+  pthread_mutex_lock(&g_idle_mutex);
+  g_idle_done = true;
+  pthread_cond_broadcast(&g_idle_cond);
+  pthread_mutex_unlock(&g_idle_mutex);
+  pthread_join(target, nullptr);
+  for (pthread_t thread : threads) pthread_join(thread, nullptr);
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_pthread_getcpuclockid_idle_threads, "NUM_IDLE_THREADS");
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+// 8MiB of text: 2048 functions, each on its own 4KiB page. Calling all of them
+// needs 2048 iTLB entries with 4KiB pages, or 4 with 2MiB pages.
+
+// __COUNTER__ makes every function different so that none are folded together.
+#define HUGEPAGE_TEXT_FN(id)                                                           \
+  extern "C" __attribute__((noinline, aligned(4096))) int hugepage_text_fn_##id(int x) { \
+    return x + __COUNTER__;                                                            \
+  }
+#define HUGEPAGE_TEXT_FN16(id)                                                   \
+  HUGEPAGE_TEXT_FN(id##0) HUGEPAGE_TEXT_FN(id##1) HUGEPAGE_TEXT_FN(id##2)         \
+  HUGEPAGE_TEXT_FN(id##3) HUGEPAGE_TEXT_FN(id##4) HUGEPAGE_TEXT_FN(id##5)         \
+  HUGEPAGE_TEXT_FN(id##6) HUGEPAGE_TEXT_FN(id##7) HUGEPAGE_TEXT_FN(id##8)         \
+  HUGEPAGE_TEXT_FN(id##9) HUGEPAGE_TEXT_FN(id##a) HUGEPAGE_TEXT_FN(id##b)         \
+  HUGEPAGE_TEXT_FN(id##c) HUGEPAGE_TEXT_FN(id##d) HUGEPAGE_TEXT_FN(id##e)         \
+  HUGEPAGE_TEXT_FN(id##f)
+#define HUGEPAGE_TEXT_FN256(id)                                                  \
+  HUGEPAGE_TEXT_FN16(id##0) HUGEPAGE_TEXT_FN16(id##1) HUGEPAGE_TEXT_FN16(id##2)   \
+  HUGEPAGE_TEXT_FN16(id##3) HUGEPAGE_TEXT_FN16(id##4) HUGEPAGE_TEXT_FN16(id##5)   \
+  HUGEPAGE_TEXT_FN16(id##6) HUGEPAGE_TEXT_FN16(id##7) HUGEPAGE_TEXT_FN16(id##8)   \
+  HUGEPAGE_TEXT_FN16(id##9) HUGEPAGE_TEXT_FN16(id##a) HUGEPAGE_TEXT_FN16(id##b)   \
+  HUGEPAGE_TEXT_FN16(id##c) HUGEPAGE_TEXT_FN16(id##d) HUGEPAGE_TEXT_FN16(id##e)   \
+  HUGEPAGE_TEXT_FN16(id##f)
+
+HUGEPAGE_TEXT_FN256(0)
+HUGEPAGE_TEXT_FN256(1)
+HUGEPAGE_TEXT_FN256(2)
+HUGEPAGE_TEXT_FN256(3)
+HUGEPAGE_TEXT_FN256(4)
+HUGEPAGE_TEXT_FN256(5)
+HUGEPAGE_TEXT_FN256(6)
+HUGEPAGE_TEXT_FN256(7)
+
+#define HUGEPAGE_TEXT_REF(id) hugepage_text_fn_##id,
+#define HUGEPAGE_TEXT_REF16(id)                                                  \
+  HUGEPAGE_TEXT_REF(id##0) HUGEPAGE_TEXT_REF(id##1) HUGEPAGE_TEXT_REF(id##2)      \
+  HUGEPAGE_TEXT_REF(id##3) HUGEPAGE_TEXT_REF(id##4) HUGEPAGE_TEXT_REF(id##5)      \
+  HUGEPAGE_TEXT_REF(id##6) HUGEPAGE_TEXT_REF(id##7) HUGEPAGE_TEXT_REF(id##8)      \
+  HUGEPAGE_TEXT_REF(id##9) HUGEPAGE_TEXT_REF(id##a) HUGEPAGE_TEXT_REF(id##b)      \
+  HUGEPAGE_TEXT_REF(id##c) HUGEPAGE_TEXT_REF(id##d) HUGEPAGE_TEXT_REF(id##e)      \
+  HUGEPAGE_TEXT_REF(id##f)
+#define HUGEPAGE_TEXT_REF256(id)                                                 \
+  HUGEPAGE_TEXT_REF16(id##0) HUGEPAGE_TEXT_REF16(id##1) HUGEPAGE_TEXT_REF16(id##2) \
+  HUGEPAGE_TEXT_REF16(id##3) HUGEPAGE_TEXT_REF16(id##4) HUGEPAGE_TEXT_REF16(id##5) \
+  HUGEPAGE_TEXT_REF16(id##6) HUGEPAGE_TEXT_REF16(id##7) HUGEPAGE_TEXT_REF16(id##8) \
+  HUGEPAGE_TEXT_REF16(id##9) HUGEPAGE_TEXT_REF16(id##a) HUGEPAGE_TEXT_REF16(id##b) \
+  HUGEPAGE_TEXT_REF16(id##c) HUGEPAGE_TEXT_REF16(id##d) HUGEPAGE_TEXT_REF16(id##e) \
+  HUGEPAGE_TEXT_REF16(id##f)
+
+static int (*const kHugepageTextFns[])(int) = {
+  HUGEPAGE_TEXT_REF256(0)
+  HUGEPAGE_TEXT_REF256(1)
+  HUGEPAGE_TEXT_REF256(2)
+  HUGEPAGE_TEXT_REF256(3)
+  HUGEPAGE_TEXT_REF256(4)
+  HUGEPAGE_TEXT_REF256(5)
+  HUGEPAGE_TEXT_REF256(6)
+  HUGEPAGE_TEXT_REF256(7)
+};
+
+// Calls every function, in an order that defeats the instruction prefetcher,
+// the given number of times.
+extern "C" int hugepage_text_run(int passes) {
+  static constexpr unsigned kCount = sizeof(kHugepageTextFns) / sizeof(kHugepageTextFns[0]);
+  int result = 0;
+  for (int pass = 0; pass < passes; ++pass) {
+    for (unsigned i = 0; i < kCount; ++i) {
+      // 1021 is prime, so this visits every function exactly once per pass.
+      result = kHugepageTextFns[(i * 1021) % kCount](result);
+    }
+  }
+  return result;
+}
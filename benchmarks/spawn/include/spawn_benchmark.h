@@ -28,11 +28,17 @@
 
 #pragma once
 
+#include <functional>
+
 #include <android-base/file.h>
 #include <benchmark/benchmark.h>
 
 void BM_spawn_test(benchmark::State& state, const char* const* argv);
 
+// Like BM_spawn_test, but calls |setup| (untimed) before each spawn.
+void BM_spawn_test(benchmark::State& state, const char* const* argv,
+                   const std::function<void()>& setup);
+
 static inline std::string test_program(const char* name) {
 #if defined(__LP64__)
   return android::base::GetExecutableDirectory() + "/" + name + "64";
@@ -39,7 +39,18 @@
 extern char** environ;
 
 void BM_spawn_test(benchmark::State& state, const char* const* argv) {
+  BM_spawn_test(state, argv, nullptr);
+}
+
+void BM_spawn_test(benchmark::State& state, const char* const* argv,
+                   const std::function<void()>& setup) {
   for (auto _ : state) {
+    if (setup) {
+      state.PauseTiming();
+      setup();
+      state.ResumeTiming();
+    }
+
     pid_t child = 0;
     if (int spawn_err = posix_spawn(&child, argv[0], nullptr, nullptr, const_cast<char**>(argv),
                                     environ)) {
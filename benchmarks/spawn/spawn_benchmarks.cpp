@@ -26,6 +26,8 @@
  * SUCH DAMAGE.
  */
 
+#include <stdlib.h>
+
 #include "spawn_benchmark.h"
 
 SPAWN_BENCHMARK(noop, test_program("bench_noop").c_str());
@@ -50,4 +52,51 @@ SPAWN_BENCHMARK(vendor_sh_true, "/vendor/bin/sh", "-c", "true");
 
 #endif
 
+// Calls a function on every page of a library with 8MiB of text 1000 times, with the linker's huge
+// page policy for text (see linker/ld.config.format.md) set to |policy|. Linkers that don't
+// support LD_HUGEPAGE_TEXT ignore it.
+static void BM_spawn_hugepage_text(benchmark::State& state, const char* policy) {
+  std::string program = test_program("bench_hugepage_text");
+  setenv("LD_LIBRARY_PATH", android::base::GetExecutableDirectory().c_str(), 1);
+  if (policy != nullptr) {
+    setenv("LD_HUGEPAGE_TEXT", policy, 1);
+  }
+
+  BM_spawn_test(state, (const char*[]) { program.c_str(), "1000", nullptr });
+
+  unsetenv("LD_HUGEPAGE_TEXT");
+  unsetenv("LD_LIBRARY_PATH");
+}
+
+BENCHMARK_CAPTURE(BM_spawn_hugepage_text, default, nullptr)
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_spawn_hugepage_text, align, "align")
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_spawn_hugepage_text, collapse, "collapse")
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// Accesses a TLS variable in a shared library 10 million times, with the library's TLS segment in
+// static TLS ("needed"), in the static TLS surplus ("surplus", see LD_STATIC_TLS_SURPLUS) or in
+// dynamically-allocated TLS ("dynamic"). Linkers that don't support LD_STATIC_TLS_SURPLUS ignore
+// it.
+static void BM_spawn_tls_access(benchmark::State& state, const char* mode, const char* surplus) {
+  std::string program = test_program("bench_tls_access");
+  setenv("LD_LIBRARY_PATH", android::base::GetExecutableDirectory().c_str(), 1);
+  if (surplus != nullptr) {
+    setenv("LD_STATIC_TLS_SURPLUS", surplus, 1);
+  }
+
+  BM_spawn_test(state, (const char*[]) { program.c_str(), mode, "10000000", nullptr });
+
+  unsetenv("LD_STATIC_TLS_SURPLUS");
+  unsetenv("LD_LIBRARY_PATH");
+}
+
+BENCHMARK_CAPTURE(BM_spawn_tls_access, needed, "needed", nullptr)
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_spawn_tls_access, surplus, "dlopen", "1024")
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_spawn_tls_access, dynamic, "dlopen", nullptr)
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+
 BENCHMARK_MAIN();
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" int tls_access_bump();
+
+// Bumps a TLS variable in a shared library PASSES times. With "needed", the
+// library is a DT_NEEDED dependency, so its TLS segment is in static TLS. With
+// "dlopen", a copy of the library is loaded with dlopen(), so its TLS segment
+// is in the static TLS surplus if LD_STATIC_TLS_SURPLUS reserved enough, and
+// allocated on each thread's first access otherwise.
+int main(int argc, char* argv[]) {
+  if (argc != 3 || (strcmp(argv[1], "needed") != 0 && strcmp(argv[1], "dlopen") != 0)) {
+    fprintf(stderr, "usage: %s needed|dlopen PASSES\n", argv[0]);
+    exit(1);
+  }
+
+  int (*bump)() = tls_access_bump;
+  if (strcmp(argv[1], "dlopen") == 0) {
+    void* lib = dlopen("libbench_tls_access_dlopen.so", RTLD_NOW | RTLD_LOCAL);
+    if (lib == nullptr) {
+      fprintf(stderr, "dlopen failed: %s\n", dlerror());
+      exit(1);
+    }
+    bump = reinterpret_cast<int (*)()>(dlsym(lib, "tls_access_bump"));
+  }
+
+  const int passes = atoi(argv[2]);
+  int result = 0;
+  for (int i = 0; i < passes; ++i) {
+    result = bump();
+  }
+
+  // Don't let the result be optimized away.
+  return result == passes ? 0 : 1;
+}
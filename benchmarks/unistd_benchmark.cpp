@@ -15,6 +15,7 @@
  */
 
 #include <errno.h>
+#include <sched.h>
 #include <string.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
@@ -36,6 +37,10 @@ BIONIC_TRIVIAL_BENCHMARK(BM_unistd_gettid, gettid());
 #endif
 BIONIC_TRIVIAL_BENCHMARK(BM_unistd_gettid_syscall, syscall(__NR_gettid));
 
+BIONIC_TRIVIAL_BENCHMARK(BM_unistd_sched_getcpu, sched_getcpu());
+BIONIC_TRIVIAL_BENCHMARK(BM_unistd_sched_getcpu_syscall,
+                         syscall(__NR_getcpu, nullptr, nullptr, nullptr));
+
 // Many native allocators have custom prefork and postfork functions.
 // Measure the fork call to make sure nothing takes too long.
 void BM_unistd_fork_call(benchmark::State& state) {
@@ -35,6 +35,7 @@
 #include "private/bionic_defs.h"
 #include "private/bionic_elf_tls.h"
 #include "private/bionic_globals.h"
+#include "private/bionic_percpu.h"
 #include "private/bionic_ssp.h"
 #include "pthread_internal.h"
 
@@ -170,6 +171,9 @@ extern "C" void __libc_init_main_thread_final() {
 
   __set_tls(&new_tcb->tls_slot(0));
 
+  // Let the kernel keep track of our CPU, now that our rseq area is in its final place.
+  __libc_init_rseq_main_thread();
+
   __set_stack_and_tls_vma_name(true);
   __free_temp_bionic_tls(temp_tls);
 }
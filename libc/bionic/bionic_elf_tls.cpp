@@ -30,6 +30,7 @@
 
 #include <async_safe/CHECK.h>
 #include <async_safe/log.h>
+#include <linux/rseq.h>
 #include <string.h>
 #include <sys/param.h>
 #include <unistd.h>
@@ -153,6 +154,9 @@ size_t StaticTlsLayout::reserve_exe_segment_and_tcb(const TlsSegment* exe_segmen
 
 void StaticTlsLayout::reserve_bionic_tls() {
   offset_bionic_tls_ = reserve_type<bionic_tls>();
+  // Every thread's rseq area is at the same offset from its thread pointer, which is what
+  // __rseq_offset tells code that wants to share the area.
+  offset_rseq_ = reserve_type<struct rseq>();
 }
 
 void StaticTlsLayout::finish_layout() {
@@ -197,9 +201,9 @@ void __init_static_tls(void* static_tls) {
   for (size_t i = 0; i < modules.module_count; ++i) {
     TlsModule& module = modules.module_table[i];
     if (module.static_offset == SIZE_MAX) {
-      // All of the static modules come before all of the dynamic modules, so
-      // once we see the first dynamic module, we're done.
-      break;
+      // The modules loaded at startup come first, but a module placed in the
+      // static TLS surplus can follow a dynamic module.
+      continue;
     }
     if (module.segment.init_size == 0) {
       // Skip the memcpy call for TLS segments with no initializer, which is
@@ -212,6 +216,26 @@ void __init_static_tls(void* static_tls) {
   }
 }
 
+// Resets a thread's copy of a module in static TLS to the module's initial
+// image. The copy may still hold the values of an unloaded module that used the
+// same part of the static TLS surplus.
+void __init_static_tls_module(void* static_tls, const TlsModule& module) {
+  char* block = static_cast<char*>(static_tls) + module.static_offset;
+  memcpy(block, module.segment.init_ptr, module.segment.init_size);
+  memset(block + module.segment.init_size, 0, module.segment.size - module.segment.init_size);
+}
+
+// Returns true if a DTV entry points into the thread's static TLS memory rather
+// than at a block from the TLS allocator. Besides the modules loaded at
+// startup, this is the case for a module that is, or was, in the static TLS
+// surplus.
+bool __is_static_tls_block(bionic_tcb* tcb, const void* block) {
+  const StaticTlsLayout& layout = __libc_shared_globals()->static_tls_layout;
+  const char* static_tls = reinterpret_cast<char*>(tcb) - layout.offset_bionic_tcb();
+  const char* p = static_cast<const char*>(block);
+  return p >= static_tls && p < static_tls + layout.size();
+}
+
 static inline size_t dtv_size_in_bytes(size_t module_count) {
   return sizeof(TlsDtv) + module_count * sizeof(void*);
 }
@@ -279,6 +303,11 @@ static void update_tls_dtv(bionic_tcb* tcb) {
         continue;
       }
     }
+    if (__is_static_tls_block(tcb, dtv->modules[i])) {
+      // The module was unloaded from the static TLS surplus.
+      dtv->modules[i] = nullptr;
+      continue;
+    }
     if (modules.on_destruction_cb != nullptr) {
       void* dtls_begin = dtv->modules[i];
       void* dtls_end =
@@ -373,6 +402,10 @@ void __free_dynamic_tls(bionic_tcb* tcb) {
       // This module's TLS memory is allocated statically, so don't free it here.
       continue;
     }
+    if (__is_static_tls_block(tcb, dtv->modules[i])) {
+      // Nor for a module that was unloaded from the static TLS surplus.
+      continue;
+    }
 
     if (modules.on_destruction_cb != nullptr) {
       void* dtls_begin = dtv->modules[i];
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "private/bionic_percpu.h"
+
+#include <linux/rseq.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "private/ErrnoRestorer.h"
+#include "private/bionic_elf_tls.h"
+#include "private/bionic_globals.h"
+
+extern "C" int __rseq(struct rseq*, uint32_t, int, uint32_t);
+
+ptrdiff_t __rseq_offset = 0;
+unsigned int __rseq_size = 0;
+unsigned int __rseq_flags = 0;
+
+static ptrdiff_t __rseq_area_offset() {
+  const StaticTlsLayout& layout = __libc_shared_globals()->static_tls_layout;
+  return static_cast<ptrdiff_t>(layout.offset_rseq()) -
+         static_cast<ptrdiff_t>(layout.offset_thread_pointer());
+}
+
+void __libc_init_rseq_main_thread() {
+  __rseq_offset = __rseq_area_offset();
+  __get_rseq_area()->cpu_id = RSEQ_CPU_ID_UNINITIALIZED;
+
+  // A process that registers its own rseq area, without knowing to look for ours, can opt out.
+  const char* disable = getenv("LIBC_DISABLE_RSEQ");
+  if (disable != nullptr && strcmp(disable, "1") == 0) return;
+
+  __rseq_size = sizeof(struct rseq);
+  __rseq_register_current_thread();
+  if (static_cast<int32_t>(__get_rseq_area()->cpu_id) == RSEQ_CPU_ID_REGISTRATION_FAILED) {
+    // Kernels before 4.18 don't have rseq, so don't try again for other threads.
+    __rseq_size = 0;
+  }
+}
+
+void __libc_init_rseq_from_linker() {
+  __rseq_offset = __rseq_area_offset();
+  // If the dynamic linker registered the main thread's area, the kernel has stored a CPU in it.
+  if (static_cast<int32_t>(__get_rseq_area()->cpu_id) >= 0) {
+    __rseq_size = sizeof(struct rseq);
+  }
+}
+
+void __rseq_register_current_thread() {
+  if (__rseq_size == 0) return;
+  ErrnoRestorer errno_restorer;
+  struct rseq* area = __get_rseq_area();
+  area->cpu_id_start = 0;
+  area->cpu_id = RSEQ_CPU_ID_UNINITIALIZED;
+  area->rseq_cs = 0;
+  area->flags = 0;
+  if (__rseq(area, __rseq_size, __rseq_flags, RSEQ_SIG) == -1) {
+    area->cpu_id = RSEQ_CPU_ID_REGISTRATION_FAILED;
+  }
+}
+
+void __rseq_unregister_current_thread() {
+  if (__rseq_size == 0) return;
+  ErrnoRestorer errno_restorer;
+  struct rseq* area = __get_rseq_area();
+  if (static_cast<int32_t>(area->cpu_id) == RSEQ_CPU_ID_REGISTRATION_FAILED) return;
+  __rseq(area, __rseq_size, RSEQ_FLAG_UNREGISTER, RSEQ_SIG);
+  area->cpu_id = RSEQ_CPU_ID_REGISTRATION_FAILED;
+}
@@ -153,7 +153,9 @@ __BIONIC_WEAK_FOR_NATIVE_BRIDGE
 void __libc_add_main_thread() {
   // Get the main thread from TLS and add it to the thread list.
   pthread_internal_t* main_thread = __get_thread();
-  __pthread_internal_add(main_thread);
+  if (!__pthread_internal_add(main_thread)) {
+    async_safe_fatal("failed to add the main thread to the thread list");
+  }
 }
 
 void __libc_init_common() {
@@ -289,12 +291,17 @@ static bool __is_unsafe_environment_variable(const char* name) {
       "LD_DEBUG",
       "LD_DEBUG_OUTPUT",
       "LD_DYNAMIC_WEAK",
+      "LD_HUGEPAGE_TEXT",
       "LD_HWASAN",
       "LD_LIBRARY_PATH",
+      "LD_LOADER_THREADS",
       "LD_ORIGIN_PATH",
       "LD_PRELOAD",
       "LD_PROFILE",
+      "LD_RELRO_CACHE_DIR",
       "LD_SHOW_AUXV",
+      "LD_STATIC_TLS_SURPLUS",
+      "LD_SYMBOL_CACHE_DIR",
       "LD_USE_LOAD_BIAS",
       "LIBC_DEBUG_MALLOC_OPTIONS",
       "LIBC_HOOKS_ENABLE",
@@ -49,10 +49,12 @@
 #include "private/bionic_defs.h"
 #include "private/bionic_elf_tls.h"
 #include "private/bionic_globals.h"
+#include "private/bionic_percpu.h"
 #include "platform/bionic/macros.h"
 #include "private/bionic_ssp.h"
 #include "private/bionic_tls.h"
 #include "private/KernelArgumentBlock.h"
+#include "pthread_internal.h"
 
 extern "C" {
   extern void netdClientInit(void);
@@ -89,6 +91,14 @@ static void __libc_preinit_impl() {
   tls_modules.generation_libc_so = &__libc_tls_generation_copy;
   __libc_tls_generation_copy = tls_modules.generation;
 
+  // Let the linker place dlopen'ed modules in the static TLS surplus, which
+  // needs libc.so's list of threads.
+  tls_modules.init_static_tls_module_cb = __init_static_tls_module_for_all_threads;
+
+  // The linker has already decided whether threads register rseq areas, and registered the main
+  // thread's. Pick that up before any other thread can be created.
+  __libc_init_rseq_from_linker();
+
   __libc_init_globals();
   __libc_init_common();
   __libc_init_scudo();
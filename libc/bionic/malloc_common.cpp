@@ -204,6 +204,33 @@ extern "C" void* reallocarray(void* old_mem, size_t item_count, size_t item_size
   return realloc(old_mem, new_size);
 }
 
+extern "C" size_t malloc_batch(size_t bytes, void** ptrs, size_t count) {
+  size_t allocated = DispatchMallocBatch(GetDispatchTable(), bytes, ptrs, count);
+  if (__predict_false(allocated < count)) {
+    warning_log("malloc_batch(%zu, %p, %zu) failed: returning %zu pointers", bytes, ptrs, count,
+                allocated);
+  }
+  for (size_t i = 0; i < allocated; ++i) {
+    ptrs[i] = MaybeTagPointer(ptrs[i]);
+  }
+  return allocated;
+}
+
+extern "C" void free_batch(void** ptrs, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    ptrs[i] = MaybeUntagAndCheckPointer(ptrs[i]);
+  }
+  DispatchFreeBatch(GetDispatchTable(), ptrs, count);
+}
+
+extern "C" void free_sized(void* mem, size_t bytes) {
+  DispatchFreeSized(GetDispatchTable(), MaybeUntagAndCheckPointer(mem), bytes);
+}
+
+extern "C" void free_aligned_sized(void* mem, size_t alignment, size_t bytes) {
+  DispatchFreeAlignedSized(GetDispatchTable(), MaybeUntagAndCheckPointer(mem), alignment, bytes);
+}
+
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
 extern "C" void* pvalloc(size_t bytes) {
   auto dispatch_table = GetDispatchTable();
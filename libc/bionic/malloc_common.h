@@ -84,6 +84,74 @@ static inline const MallocDispatch* GetDefaultDispatchTable() {
   return atomic_load_explicit(&__libc_globals->default_dispatch_table, memory_order_acquire);
 }
 
+// =============================================================================
+// Batch and sized allocation functions
+// =============================================================================
+// These are optional in a dispatch table, and the native allocators don't have
+// them, so they fall back on malloc and free one object at a time.
+template <typename MallocFunction>
+static inline size_t MallocEach(MallocFunction malloc_function, size_t bytes, void** ptrs,
+                                size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    ptrs[i] = malloc_function(bytes);
+    if (__predict_false(ptrs[i] == nullptr)) {
+      return i;
+    }
+  }
+  return count;
+}
+
+template <typename FreeFunction>
+static inline void FreeEach(FreeFunction free_function, void** ptrs, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    free_function(ptrs[i]);
+  }
+}
+
+static inline size_t DispatchMallocBatch(const MallocDispatch* dispatch_table, size_t bytes,
+                                         void** ptrs, size_t count) {
+  if (__predict_false(dispatch_table != nullptr)) {
+    if (dispatch_table->malloc_batch != nullptr) {
+      return dispatch_table->malloc_batch(bytes, ptrs, count);
+    }
+    return MallocEach(dispatch_table->malloc, bytes, ptrs, count);
+  }
+  return MallocEach(Malloc(malloc), bytes, ptrs, count);
+}
+
+static inline void DispatchFreeBatch(const MallocDispatch* dispatch_table, void** ptrs,
+                                     size_t count) {
+  if (__predict_false(dispatch_table != nullptr)) {
+    if (dispatch_table->free_batch != nullptr) {
+      return dispatch_table->free_batch(ptrs, count);
+    }
+    return FreeEach(dispatch_table->free, ptrs, count);
+  }
+  return FreeEach(Malloc(free), ptrs, count);
+}
+
+static inline void DispatchFreeSized(const MallocDispatch* dispatch_table, void* ptr,
+                                     size_t bytes) {
+  if (__predict_false(dispatch_table != nullptr)) {
+    if (dispatch_table->free_sized != nullptr) {
+      return dispatch_table->free_sized(ptr, bytes);
+    }
+    return dispatch_table->free(ptr);
+  }
+  return Malloc(free)(ptr);
+}
+
+static inline void DispatchFreeAlignedSized(const MallocDispatch* dispatch_table, void* ptr,
+                                            size_t alignment, size_t bytes) {
+  if (__predict_false(dispatch_table != nullptr)) {
+    if (dispatch_table->free_aligned_sized != nullptr) {
+      return dispatch_table->free_aligned_sized(ptr, alignment, bytes);
+    }
+    return dispatch_table->free(ptr);
+  }
+  return Malloc(free)(ptr);
+}
+
 // =============================================================================
 // Log functions
 // =============================================================================
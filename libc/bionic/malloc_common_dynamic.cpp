@@ -136,6 +136,14 @@ static bool InitMallocFunction(void* malloc_impl_handler, FunctionType* func, co
   return true;
 }
 
+template<typename FunctionType>
+static void InitOptionalMallocFunction(void* malloc_impl_handler, FunctionType* func,
+                                       const char* prefix, const char* suffix) {
+  char symbol[128];
+  snprintf(symbol, sizeof(symbol), "%s_%s", prefix, suffix);
+  *func = reinterpret_cast<FunctionType>(dlsym(malloc_impl_handler, symbol));
+}
+
 static bool InitMallocFunctions(void* impl_handler, MallocDispatch* table, const char* prefix) {
   if (!InitMallocFunction<MallocFree>(impl_handler, &table->free, prefix, "free")) {
     return false;
@@ -195,6 +203,16 @@ static bool InitMallocFunctions(void* impl_handler, MallocDispatch* table, const
   }
 #endif
 
+  // Libraries that don't have these get a table that falls back on malloc and free.
+  InitOptionalMallocFunction<MallocMallocBatch>(impl_handler, &table->malloc_batch, prefix,
+                                                "malloc_batch");
+  InitOptionalMallocFunction<MallocFreeBatch>(impl_handler, &table->free_batch, prefix,
+                                              "free_batch");
+  InitOptionalMallocFunction<MallocFreeSized>(impl_handler, &table->free_sized, prefix,
+                                              "free_sized");
+  InitOptionalMallocFunction<MallocFreeAlignedSized>(impl_handler, &table->free_aligned_sized,
+                                                     prefix, "free_aligned_sized");
+
   return true;
 }
 
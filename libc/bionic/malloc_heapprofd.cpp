@@ -304,6 +304,8 @@ void HandleHeapprofdSignal() {
     // Now, replace the malloc function so that the next call to malloc() will
     // initialize heapprofd.
     gEphemeralDispatch.malloc = MallocInitHeapprofdHook;
+    // Batch allocations fall back on malloc, so they initialize heapprofd too.
+    gEphemeralDispatch.malloc_batch = nullptr;
 
     // And finally, install these new malloc-family interceptors.
     __libc_globals.mutate([](libc_globals* globals) {
@@ -32,6 +32,7 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <platform/bionic/tls.h>
 #include <private/bionic_malloc_dispatch.h>
 
 #if __has_feature(hwaddress_sanitizer)
@@ -51,6 +52,10 @@ static void* LimitMemalign(size_t alignment, size_t bytes);
 static int LimitPosixMemalign(void** memptr, size_t alignment, size_t size);
 static void* LimitRealloc(void* old_mem, size_t bytes);
 static void* LimitAlignedAlloc(size_t alignment, size_t size);
+static size_t LimitMallocBatch(size_t bytes, void** ptrs, size_t count);
+static void LimitFreeBatch(void** ptrs, size_t count);
+static void LimitFreeSized(void* mem, size_t bytes);
+static void LimitFreeAlignedSized(void* mem, size_t alignment, size_t bytes);
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
 static void* LimitPvalloc(size_t bytes);
 static void* LimitValloc(size_t bytes);
@@ -88,26 +93,76 @@ static constexpr MallocDispatch __limit_dispatch
     LimitMallopt,
     LimitAlignedAlloc,
     LimitMallocInfo,
+    LimitMallocBatch,
+    LimitFreeBatch,
+    LimitFreeSized,
+    LimitFreeAlignedSized,
   };
 
-static _Atomic uint64_t gAllocated;
+// Allocations and frees are counted in a shard picked by the calling thread, and a shard's count
+// is only folded into gAllocated once it has moved by kAllocatedBatchBytes. That way threads don't
+// all update the same cache line on every allocation. gAllocated can be short by up to
+// kAllocatedSlackBytes, so an allocation that might go over the limit folds every shard in, and
+// is only refused if the exact total is over the limit.
+static constexpr int64_t kAllocatedBatchBytes = 64 * 1024;
+static constexpr size_t kAllocatedShardCount = 32;
+static constexpr int64_t kAllocatedSlackBytes = kAllocatedBatchBytes * kAllocatedShardCount;
+
+struct alignas(64) AllocatedShard {
+  _Atomic(int64_t) bytes;
+};
+
+static AllocatedShard gAllocatedShards[kAllocatedShardCount];
+// Can be negative while the frees of some allocations are folded in before the allocations.
+static _Atomic(int64_t) gAllocated;
 static uint64_t gAllocLimit;
 
-static inline bool CheckLimit(size_t bytes) {
+static inline AllocatedShard& CurrentAllocatedShard() {
+  // The thread pointer is a cheap way to tell threads apart that doesn't depend on the layout of
+  // pthread_internal_t, which this file can't use because it's also in libc_ndk.a.
+  uint64_t thread = reinterpret_cast<uintptr_t>(__get_tls()) / 4096;
+  return gAllocatedShards[((thread * 0x9e3779b97f4a7c15ULL) >> 32) % kAllocatedShardCount];
+}
+
+static inline void AddAllocated(int64_t bytes) {
+  AllocatedShard& shard = CurrentAllocatedShard();
+  int64_t pending = atomic_fetch_add_explicit(&shard.bytes, bytes, memory_order_relaxed) + bytes;
+  if (__predict_false(pending >= kAllocatedBatchBytes || pending <= -kAllocatedBatchBytes)) {
+    atomic_fetch_add_explicit(&gAllocated,
+                              atomic_exchange_explicit(&shard.bytes, 0, memory_order_relaxed),
+                              memory_order_relaxed);
+  }
+}
+
+// Folds every shard into gAllocated, and returns the total.
+static int64_t FoldAllocated() {
+  int64_t pending = 0;
+  for (AllocatedShard& shard : gAllocatedShards) {
+    pending += atomic_exchange_explicit(&shard.bytes, 0, memory_order_relaxed);
+  }
+  return atomic_fetch_add_explicit(&gAllocated, pending, memory_order_relaxed) + pending;
+}
+
+static inline bool WithinLimit(int64_t allocated, size_t bytes) {
   uint64_t total;
-  if (__predict_false(__builtin_add_overflow(
-                          atomic_load_explicit(&gAllocated, memory_order_relaxed), bytes, &total) ||
-                      total > gAllocLimit)) {
-    return false;
+  return !__builtin_add_overflow(static_cast<uint64_t>(allocated < 0 ? 0 : allocated), bytes,
+                                 &total) &&
+         total <= gAllocLimit;
+}
+
+static inline bool CheckLimit(size_t bytes) {
+  int64_t allocated = atomic_load_explicit(&gAllocated, memory_order_relaxed);
+  if (__predict_true(WithinLimit(allocated + kAllocatedSlackBytes, bytes))) {
+    return true;
   }
-  return true;
+  return WithinLimit(FoldAllocated(), bytes);
 }
 
 static inline void* IncrementLimit(void* mem) {
   if (__predict_false(mem == nullptr)) {
     return nullptr;
   }
-  atomic_fetch_add(&gAllocated, LimitUsableSize(mem));
+  AddAllocated(LimitUsableSize(mem));
   return mem;
 }
 
@@ -126,7 +181,7 @@ void* LimitCalloc(size_t n_elements, size_t elem_size) {
 }
 
 void LimitFree(void* mem) {
-  atomic_fetch_sub(&gAllocated, LimitUsableSize(mem));
+  AddAllocated(-static_cast<int64_t>(LimitUsableSize(mem)));
   auto dispatch_table = GetDefaultDispatchTable();
   if (__predict_false(dispatch_table != nullptr)) {
     return dispatch_table->free(mem);
@@ -192,6 +247,42 @@ static void* LimitAlignedAlloc(size_t alignment, size_t size) {
   return IncrementLimit(Malloc(aligned_alloc)(alignment, size));
 }
 
+static size_t LimitMallocBatch(size_t bytes, void** ptrs, size_t count) {
+  // The whole batch is checked against the limit, and accounted for, at once.
+  size_t total;
+  if (__builtin_mul_overflow(bytes, count, &total) || !CheckLimit(total)) {
+    warning_log("malloc_limit: malloc_batch(%zu, %p, %zu) exceeds limit %" PRId64, bytes, ptrs,
+                count, gAllocLimit);
+    return 0;
+  }
+  size_t allocated = DispatchMallocBatch(GetDefaultDispatchTable(), bytes, ptrs, count);
+  int64_t usable_size = 0;
+  for (size_t i = 0; i < allocated; ++i) {
+    usable_size += LimitUsableSize(ptrs[i]);
+  }
+  AddAllocated(usable_size);
+  return allocated;
+}
+
+static void LimitFreeBatch(void** ptrs, size_t count) {
+  int64_t usable_size = 0;
+  for (size_t i = 0; i < count; ++i) {
+    usable_size += LimitUsableSize(ptrs[i]);
+  }
+  AddAllocated(-usable_size);
+  DispatchFreeBatch(GetDefaultDispatchTable(), ptrs, count);
+}
+
+static void LimitFreeSized(void* mem, size_t bytes) {
+  AddAllocated(-static_cast<int64_t>(LimitUsableSize(mem)));
+  DispatchFreeSized(GetDefaultDispatchTable(), mem, bytes);
+}
+
+static void LimitFreeAlignedSized(void* mem, size_t alignment, size_t bytes) {
+  AddAllocated(-static_cast<int64_t>(LimitUsableSize(mem)));
+  DispatchFreeAlignedSized(GetDefaultDispatchTable(), mem, alignment, bytes);
+}
+
 static void* LimitRealloc(void* old_mem, size_t bytes) {
   size_t old_usable_size = LimitUsableSize(old_mem);
   void* new_ptr;
@@ -213,17 +304,12 @@ static void* LimitRealloc(void* old_mem, size_t bytes) {
 
   if (__predict_false(new_ptr == nullptr)) {
     // This acts as if the pointer was freed.
-    atomic_fetch_sub(&gAllocated, old_usable_size);
+    AddAllocated(-static_cast<int64_t>(old_usable_size));
     return nullptr;
   }
 
   size_t new_usable_size = LimitUsableSize(new_ptr);
-  // Assumes that most allocations increase in size, rather than shrink.
-  if (__predict_false(old_usable_size > new_usable_size)) {
-    atomic_fetch_sub(&gAllocated, old_usable_size - new_usable_size);
-  } else {
-    atomic_fetch_add(&gAllocated, new_usable_size - old_usable_size);
-  }
+  AddAllocated(static_cast<int64_t>(new_usable_size) - static_cast<int64_t>(old_usable_size));
   return new_ptr;
 }
 
@@ -37,6 +37,7 @@
 
 #include "pthread_internal.h"
 
+#include "platform/bionic/macros.h"
 #include "private/bionic_futex.h"
 #include "private/bionic_time_conversions.h"
 #include "private/bionic_tls.h"
@@ -118,6 +119,45 @@ struct pthread_cond_internal_t {
 #if defined(__LP64__)
   atomic_uint waiters;
   char __reserved[40];
+
+  // The mutex that waiters use, so that pthread_cond_broadcast can requeue them to it, 0 if there
+  // haven't been any waiters yet, or kNoRequeue. pthread_cond_t is only 4-byte aligned, so this
+  // lives at whichever 8-byte aligned offset in __reserved comes first.
+  static constexpr uintptr_t kNoRequeue = UINTPTR_MAX;
+
+  _Atomic(uintptr_t)* requeue_mutex() {
+    return reinterpret_cast<_Atomic(uintptr_t)*>(align_up(__reserved, sizeof(uintptr_t)));
+  }
+
+  // Records the mutex a waiter is about to wait with. Returns true if pthread_cond_broadcast may
+  // requeue the waiter to it.
+  bool set_requeue_mutex(pthread_mutex_t* mutex) {
+    _Atomic(uintptr_t)* slot = requeue_mutex();
+    uintptr_t new_value = reinterpret_cast<uintptr_t>(mutex);
+    uintptr_t old_value = atomic_load_explicit(slot, memory_order_relaxed);
+    if (old_value == kNoRequeue) return false;
+
+    // Mutex addresses mean nothing to other processes. The mutex at a recorded address may also
+    // have been destroyed and reinitialized as a type that can't be requeued to, so check the
+    // mutex itself every time, not just when recording it.
+    bool can_requeue = !process_shared() && __pthread_mutex_supports_requeue(mutex);
+    if (old_value == new_value && can_requeue) return true;
+
+    // Sequentially consistent, so that a broadcast that our futex wait misses (see
+    // __pthread_cond_pulse) can't miss this store.
+    //
+    // POSIX doesn't allow concurrent waits with different mutexes, but a condition variable may
+    // be used with one mutex and then another, which turns requeueing off for good.
+    if (old_value == 0 && can_requeue) {
+      if (atomic_compare_exchange_strong_explicit(slot, &old_value, new_value,
+                                                  memory_order_seq_cst, memory_order_relaxed) ||
+          old_value == new_value) {
+        return true;
+      }
+    }
+    atomic_store_explicit(slot, kNoRequeue, memory_order_seq_cst);
+    return false;
+  }
 #endif
 };
 
@@ -144,6 +184,7 @@ int pthread_cond_init(pthread_cond_t* cond_interface, const pthread_condattr_t*
 
 #if defined(__LP64__)
   atomic_init(&cond->waiters, 0);
+  atomic_init(cond->requeue_mutex(), 0);
 #endif
 
   return 0;
@@ -177,6 +218,25 @@ static int __pthread_cond_pulse(pthread_cond_internal_t* cond, int thread_count)
   // The increase of value should leave flags alone, even if the value can overflows.
   atomic_fetch_add_explicit(&cond->state, COND_COUNTER_STEP, memory_order_relaxed);
 
+#if defined(__LP64__)
+  if (thread_count > 1) {
+    // Rather than waking every waiter only for all but one to block on the mutex again, wake one
+    // and move the rest to the mutex futex. Each unlock of the mutex then wakes the next of them.
+    // The fence pairs with the store in set_requeue_mutex: any waiter whose futex wait didn't see
+    // the state we just changed stored its mutex before that wait, so we see that mutex here.
+    // If the state has changed again by the time we requeue, the later change has woken any
+    // waiters, and we fall back to waking them too.
+    atomic_thread_fence(memory_order_seq_cst);
+    uintptr_t mutex = atomic_load_explicit(cond->requeue_mutex(), memory_order_relaxed);
+    unsigned int state = atomic_load_explicit(&cond->state, memory_order_relaxed);
+    if (mutex != 0 && mutex != pthread_cond_internal_t::kNoRequeue &&
+        __futex_cmp_requeue_ex(&cond->state, false, 1, INT_MAX, reinterpret_cast<void*>(mutex),
+                               state) >= 0) {
+      return 0;
+    }
+  }
+#endif
+
   __futex_wake_ex(&cond->state, cond->process_shared(), thread_count);
   return 0;
 }
@@ -192,6 +252,7 @@ static int __pthread_cond_timedwait(pthread_cond_internal_t* cond, pthread_mutex
 
 #if defined(__LP64__)
   atomic_fetch_add_explicit(&cond->waiters, 1, memory_order_relaxed);
+  bool may_be_requeued = cond->set_requeue_mutex(mutex);
 #endif
 
   pthread_mutex_unlock(mutex);
@@ -200,9 +261,22 @@ static int __pthread_cond_timedwait(pthread_cond_internal_t* cond, pthread_mutex
 
 #if defined(__LP64__)
   atomic_fetch_sub_explicit(&cond->waiters, 1, memory_order_relaxed);
-#endif
 
+  if (may_be_requeued) {
+    __pthread_mutex_lock_after_requeue(mutex);
+    // A requeued waiter carries on waiting with its timeout, on the mutex futex. If the mutex
+    // wasn't handed over before the deadline, the wait timed out after the broadcast that woke
+    // us, so report the wakeup rather than the timeout.
+    if (status == -ETIMEDOUT &&
+        atomic_load_explicit(&cond->state, memory_order_relaxed) != old_state) {
+      return 0;
+    }
+  } else {
+    pthread_mutex_lock(mutex);
+  }
+#else
   pthread_mutex_lock(mutex);
+#endif
 
   if (status == -ETIMEDOUT) {
     return ETIMEDOUT;
@@ -46,7 +46,10 @@
 #include "private/ScopedRWLock.h"
 #include "private/bionic_constants.h"
 #include "private/bionic_defs.h"
+#include "private/bionic_futex.h"
 #include "private/bionic_globals.h"
+#include "private/bionic_lock.h"
+#include "private/bionic_percpu.h"
 #include "private/bionic_ssp.h"
 #include "private/bionic_systrace.h"
 #include "private/bionic_tls.h"
@@ -203,6 +206,82 @@ int __init_thread(pthread_internal_t* thread) {
   return 0;
 }
 
+// The mappings of a few recently joined threads are kept for reuse, so that
+// programs that create a thread per task don't pay for mmap, mprotect and
+// munmap (and the mmap_lock contention that comes with them) every time.
+//
+// A cached mapping has had MADV_DONTNEED applied to its writable region, so
+// it reads back as zeroes, the same as a new anonymous mapping.
+// __init_static_tls relies on that.
+//
+// The lock is only ever tried: a contended cache falls back to mmap/munmap,
+// and a child forked while the lock is held can't deadlock on it.
+static constexpr size_t kThreadMappingCacheSize = 16;
+#if defined(__LP64__)
+static constexpr size_t kThreadMappingCacheMaxBytes = 64 * 1024 * 1024;
+#else
+static constexpr size_t kThreadMappingCacheMaxBytes = 8 * 1024 * 1024;
+#endif
+
+struct CachedThreadMapping {
+  ThreadMapping mapping;
+  size_t stack_guard_size;
+};
+
+static Lock g_thread_mapping_cache_lock;
+static CachedThreadMapping g_thread_mapping_cache[kThreadMappingCacheSize];
+static size_t g_thread_mapping_cache_count;
+static size_t g_thread_mapping_cache_bytes;
+
+static bool __thread_mapping_cache_usable() {
+#ifdef __aarch64__
+  // Cached mappings were created without PROT_MTE, and their stale stack tags
+  // wouldn't be cleared anyway.
+  if (atomic_load(&__libc_globals->memtag_stack)) return false;
+#endif
+  return true;
+}
+
+static bool __take_cached_thread_mapping(size_t mmap_size, size_t stack_guard_size,
+                                         ThreadMapping* result) {
+  if (!__thread_mapping_cache_usable() || !g_thread_mapping_cache_lock.trylock()) return false;
+  bool found = false;
+  for (size_t i = 0; i < g_thread_mapping_cache_count; ++i) {
+    CachedThreadMapping& entry = g_thread_mapping_cache[i];
+    if (entry.mapping.mmap_size == mmap_size && entry.stack_guard_size == stack_guard_size) {
+      *result = entry.mapping;
+      entry = g_thread_mapping_cache[--g_thread_mapping_cache_count];
+      g_thread_mapping_cache_bytes -= mmap_size;
+      found = true;
+      break;
+    }
+  }
+  g_thread_mapping_cache_lock.unlock();
+  return found;
+}
+
+static bool __cache_thread_mapping(const ThreadMapping& mapping, size_t stack_guard_size) {
+  if (!__thread_mapping_cache_usable() || mapping.mmap_size > kThreadMappingCacheMaxBytes) {
+    return false;
+  }
+  if (madvise(mapping.mmap_base_unguarded, mapping.mmap_size_unguarded, MADV_DONTNEED) != 0) {
+    return false;
+  }
+  // The old name pointed into the pthread_internal_t that was just discarded.
+  prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, mapping.mmap_base_unguarded,
+        mapping.mmap_size_unguarded, "stack_and_tls:cached");
+
+  if (!g_thread_mapping_cache_lock.trylock()) return false;
+  bool cached = false;
+  if (g_thread_mapping_cache_count < kThreadMappingCacheSize &&
+      mapping.mmap_size <= kThreadMappingCacheMaxBytes - g_thread_mapping_cache_bytes) {
+    g_thread_mapping_cache[g_thread_mapping_cache_count++] = {mapping, stack_guard_size};
+    g_thread_mapping_cache_bytes += mapping.mmap_size;
+    cached = true;
+  }
+  g_thread_mapping_cache_lock.unlock();
+  return cached;
+}
 
 // Allocate a thread's primary mapping. This mapping includes static TLS and
 // optionally a stack. Static TLS includes ELF TLS segments and the bionic_tls
@@ -223,6 +302,9 @@ ThreadMapping __allocate_thread_mapping(size_t stack_size, size_t stack_guard_si
   mmap_size = __BIONIC_ALIGN(mmap_size, PAGE_SIZE);
   if (mmap_size < unaligned_size) return {};
 
+  ThreadMapping cached;
+  if (__take_cached_thread_mapping(mmap_size, stack_guard_size, &cached)) return cached;
+
   // Create a new private anonymous map. Make the entire mapping PROT_NONE, then carve out a
   // read+write area in the middle.
   const int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
@@ -263,6 +345,27 @@ ThreadMapping __allocate_thread_mapping(size_t stack_size, size_t stack_guard_si
   return result;
 }
 
+// Free a mapping allocated by __allocate_thread_mapping. The thread must no
+// longer be running on it.
+void __free_thread_mapping(pthread_internal_t* thread) {
+  const StaticTlsLayout& layout = __libc_shared_globals()->static_tls_layout;
+
+  // The pthread_internal_t may be inside the mapping, so copy out what we need.
+  ThreadMapping mapping = {};
+  mapping.mmap_base = static_cast<char*>(thread->mmap_base);
+  mapping.mmap_size = thread->mmap_size;
+  mapping.mmap_base_unguarded = static_cast<char*>(thread->mmap_base_unguarded);
+  mapping.mmap_size_unguarded = thread->mmap_size_unguarded;
+  mapping.static_tls = mapping.mmap_base + mapping.mmap_size - PTHREAD_GUARD_SIZE - layout.size();
+  mapping.stack_base = mapping.mmap_base;
+  mapping.stack_top = mapping.static_tls;
+  size_t stack_guard_size = mapping.mmap_base_unguarded - mapping.mmap_base;
+
+  if (!__cache_thread_mapping(mapping, stack_guard_size)) {
+    munmap(mapping.mmap_base, mapping.mmap_size);
+  }
+}
+
 static int __allocate_thread(pthread_attr_t* attr, bionic_tcb** tcbp, void** child_stack) {
   ThreadMapping mapping;
   char* stack_top;
@@ -365,6 +468,7 @@ static int __pthread_start(void* arg) {
   // accesses previously made by the creating thread are visible to us.
   thread->startup_handshake_lock.lock();
 
+  __rseq_register_current_thread();
   __set_stack_and_tls_vma_name(false);
   __init_additional_stacks(thread);
   __rt_sigprocmask(SIG_SETMASK, &thread->start_mask, nullptr, sizeof(thread->start_mask));
@@ -392,7 +496,26 @@ static void* __do_nothing(void*) {
   return nullptr;
 }
 
-pthread_rwlock_t g_thread_creation_lock = PTHREAD_RWLOCK_INITIALIZER;
+// Lets a thread that couldn't be added to the thread list exit without running user code, and
+// frees its mapping once it has. The thread isn't on the list, so it can't clean up after itself
+// the way a detached thread does.
+static void __discard_unlisted_thread(pthread_internal_t* thread) {
+  atomic_store(&thread->join_state, THREAD_NOT_JOINED);
+  thread->start_routine = __do_nothing;
+  pid_t tid = thread->tid;
+  volatile int* tid_ptr = &thread->tid;
+  thread->startup_handshake_lock.unlock();
+
+  // The kernel clears the tid once the thread has exited (CLONE_CHILD_CLEARTID).
+  while (*tid_ptr != 0) {
+    __futex_wait(tid_ptr, tid, nullptr);
+  }
+  if (thread->mmap_size != 0) {
+    __free_thread_mapping(thread);
+  }
+}
+
+pthread_rwlock_t g_thread_creation_lock = PTHREAD_RWLOCK_READER_BIASED_INITIALIZER_NP;
 
 __BIONIC_WEAK_FOR_NATIVE_BRIDGE
 int pthread_create(pthread_t* thread_out, pthread_attr_t const* attr,
@@ -408,6 +531,12 @@ int pthread_create(pthread_t* thread_out, pthread_attr_t const* attr,
     attr = nullptr; // Prevent misuse below.
   }
 
+  // Hold the creation lock from before the new thread's static TLS is
+  // initialized, so that a module the linker places in the static TLS surplus
+  // meanwhile is initialized for this thread too (see
+  // __init_static_tls_module_for_all_threads).
+  ScopedReadLock locker(&g_thread_creation_lock);
+
   bionic_tcb* tcb = nullptr;
   void* child_stack = nullptr;
   int result = __allocate_thread(&thread_attr, &tcb, &child_stack);
@@ -442,8 +571,6 @@ int pthread_create(pthread_t* thread_out, pthread_attr_t const* attr,
   tls = &tls_descriptor;
 #endif
 
-  ScopedReadLock locker(&g_thread_creation_lock);
-
   sigset64_t block_all_mask;
   sigfillset64(&block_all_mask);
   __rt_sigprocmask(SIG_SETMASK, &block_all_mask, &thread->start_mask, sizeof(thread->start_mask));
@@ -456,7 +583,7 @@ int pthread_create(pthread_t* thread_out, pthread_attr_t const* attr,
     // reminder that you can't rewrite this function to use a ScopedPthreadMutexLocker.
     thread->startup_handshake_lock.unlock();
     if (thread->mmap_size != 0) {
-      munmap(thread->mmap_base, thread->mmap_size);
+      __free_thread_mapping(thread);
     }
     async_safe_format_log(ANDROID_LOG_WARN, "libc", "pthread_create failed: clone failed: %s",
                           strerror(clone_errno));
@@ -468,14 +595,22 @@ int pthread_create(pthread_t* thread_out, pthread_attr_t const* attr,
     // Mark the thread detached and replace its start_routine with a no-op.
     // Letting the thread run is the easiest way to clean up its resources.
     atomic_store(&thread->join_state, THREAD_DETACHED);
-    __pthread_internal_add(thread);
+    if (!__pthread_internal_add(thread)) {
+      __discard_unlisted_thread(thread);
+      return init_errno;
+    }
     thread->start_routine = __do_nothing;
     thread->startup_handshake_lock.unlock();
     return init_errno;
   }
 
+  if (!__pthread_internal_add(thread)) {
+    __discard_unlisted_thread(thread);
+    return EAGAIN;
+  }
+
   // Publish the pthread_t and unlock the mutex to let the new thread start running.
-  *thread_out = __pthread_internal_add(thread);
+  *thread_out = reinterpret_cast<pthread_t>(thread);
   thread->startup_handshake_lock.unlock();
 
   return 0;
@@ -35,6 +35,7 @@
 
 #include "private/bionic_constants.h"
 #include "private/bionic_defs.h"
+#include "private/bionic_percpu.h"
 #include "private/ScopedRWLock.h"
 #include "private/ScopedSignalBlocker.h"
 #include "pthread_internal.h"
@@ -130,6 +131,8 @@ void pthread_exit(void* return_value) {
     // First make sure that the kernel does not try to clear the tid field
     // because we'll have freed the memory before the thread actually exits.
     __set_tid_address(nullptr);
+    // The same goes for the CPU the kernel keeps in our rseq area.
+    __rseq_unregister_current_thread();
 
     // pthread_internal_t is freed below with stack, not here.
     __pthread_internal_remove(thread);
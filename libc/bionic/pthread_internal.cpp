@@ -33,6 +33,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <sys/prctl.h>
 
 #include <async_safe/log.h>
 #include <bionic/reserved_signals.h>
@@ -40,14 +41,142 @@
 #include "private/ErrnoRestorer.h"
 #include "private/ScopedRWLock.h"
 #include "private/bionic_futex.h"
+#include "private/bionic_globals.h"
 #include "private/bionic_tls.h"
 
 static pthread_internal_t* g_thread_list = nullptr;
 static pthread_rwlock_t g_thread_list_lock = PTHREAD_RWLOCK_INITIALIZER;
 
-pthread_t __pthread_internal_add(pthread_internal_t* thread) {
+// Every function that takes a pthread_t checks it with __pthread_internal_find(),
+// so the threads on g_thread_list are also kept in a hash set that can be
+// searched without taking g_thread_list_lock.
+//
+// The set uses open addressing with linear probing. Writers hold the write lock
+// and change one slot at a time; a removal shifts the following entries back
+// rather than leaving a marker, so a lookup that races with a removal can miss
+// a thread that is still present, but never finds one that isn't. Lookups that
+// miss are repeated with the lock held.
+//
+// When the set gets too full it is copied to a table twice the size. A lookup
+// may still be searching the old table, so old tables are never unmapped. They
+// add up to less than the current table.
+struct ThreadTable {
+  ThreadTable* previous;
+  size_t mask;
+  size_t shift;
+  size_t count;
+
+  _Atomic(pthread_internal_t*)* slots() {
+    return reinterpret_cast<_Atomic(pthread_internal_t*)*>(this + 1);
+  }
+  size_t capacity() const { return mask + 1; }
+};
+
+static constexpr size_t kMinThreadTableCapacity = 256;
+
+static _Atomic(ThreadTable*) g_thread_table = nullptr;
+
+static size_t thread_table_home(const ThreadTable* table, const pthread_internal_t* thread) {
+  // Fibonacci hashing: the pthread_internal_t objects are at similar offsets
+  // into their mappings, so the low bits of their addresses don't vary much.
+#if defined(__LP64__)
+  static constexpr uintptr_t kGoldenRatio = 0x9e3779b97f4a7c15;
+#else
+  static constexpr uintptr_t kGoldenRatio = 0x9e3779b9;
+#endif
+  return (reinterpret_cast<uintptr_t>(thread) * kGoldenRatio) >> table->shift;
+}
+
+static ThreadTable* thread_table_alloc(size_t capacity) {
+  size_t mmap_size = __BIONIC_ALIGN(sizeof(ThreadTable) + capacity * sizeof(pthread_internal_t*),
+                                    PAGE_SIZE);
+  void* map = mmap(nullptr, mmap_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) {
+    async_safe_format_log(ANDROID_LOG_WARN, "libc",
+                          "pthread_create failed: couldn't allocate the thread table: %m");
+    return nullptr;
+  }
+  prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, map, mmap_size, "thread table");
+
+  ThreadTable* table = static_cast<ThreadTable*>(map);
+  table->mask = capacity - 1;
+  table->shift = sizeof(uintptr_t) * 8 - __builtin_ctzl(capacity);
+  return table;
+}
+
+// The caller must hold g_thread_list_lock.
+static bool thread_table_contains(ThreadTable* table, pthread_internal_t* thread) {
+  for (size_t i = thread_table_home(table, thread), n = 0; n < table->capacity();
+       i = (i + 1) & table->mask, ++n) {
+    pthread_internal_t* t = atomic_load_explicit(&table->slots()[i], memory_order_relaxed);
+    if (t == thread) return true;
+    if (t == nullptr) return false;
+  }
+  return false;
+}
+
+// The caller must hold the write lock, and the table must have an empty slot.
+static void thread_table_insert(ThreadTable* table, pthread_internal_t* thread) {
+  size_t i = thread_table_home(table, thread);
+  while (atomic_load_explicit(&table->slots()[i], memory_order_relaxed) != nullptr) {
+    i = (i + 1) & table->mask;
+  }
+  atomic_store_explicit(&table->slots()[i], thread, memory_order_relaxed);
+  ++table->count;
+}
+
+// The caller must hold the write lock. Returns false, leaving the table as it
+// was, if the table needed to grow and a bigger one couldn't be allocated.
+static bool thread_table_add(pthread_internal_t* thread) {
+  ThreadTable* table = atomic_load_explicit(&g_thread_table, memory_order_relaxed);
+  if (table == nullptr || (table->count + 1) * 4 > table->capacity() * 3) {
+    ThreadTable* new_table = thread_table_alloc(table == nullptr ? kMinThreadTableCapacity
+                                                                 : table->capacity() * 2);
+    if (new_table == nullptr) return false;
+    if (table != nullptr) {
+      for (size_t i = 0; i < table->capacity(); ++i) {
+        pthread_internal_t* t = atomic_load_explicit(&table->slots()[i], memory_order_relaxed);
+        if (t != nullptr) thread_table_insert(new_table, t);
+      }
+    }
+    new_table->previous = table;
+    atomic_store_explicit(&g_thread_table, new_table, memory_order_release);
+    table = new_table;
+  }
+  thread_table_insert(table, thread);
+  return true;
+}
+
+static void thread_table_remove(pthread_internal_t* thread) {
+  ThreadTable* table = atomic_load_explicit(&g_thread_table, memory_order_relaxed);
+  _Atomic(pthread_internal_t*)* slots = table->slots();
+  size_t hole = thread_table_home(table, thread);
+  while (atomic_load_explicit(&slots[hole], memory_order_relaxed) != thread) {
+    hole = (hole + 1) & table->mask;
+  }
+
+  // Move back each following entry that would still be found from its home
+  // slot, until the run of entries ends.
+  for (size_t i = (hole + 1) & table->mask; ; i = (i + 1) & table->mask) {
+    pthread_internal_t* t = atomic_load_explicit(&slots[i], memory_order_relaxed);
+    if (t == nullptr) break;
+    size_t home = thread_table_home(table, t);
+    if (((i - home) & table->mask) >= ((i - hole) & table->mask)) {
+      atomic_store_explicit(&slots[hole], t, memory_order_relaxed);
+      hole = i;
+    }
+  }
+  atomic_store_explicit(&slots[hole], nullptr, memory_order_relaxed);
+  --table->count;
+}
+
+bool __pthread_internal_add(pthread_internal_t* thread) {
   ScopedWriteLock locker(&g_thread_list_lock);
 
+  if (!thread_table_add(thread)) {
+    return false;
+  }
+
   // We insert at the head.
   thread->next = g_thread_list;
   thread->prev = nullptr;
@@ -55,7 +184,7 @@ pthread_t __pthread_internal_add(pthread_internal_t* thread) {
     thread->next->prev = thread;
   }
   g_thread_list = thread;
-  return reinterpret_cast<pthread_t>(thread);
+  return true;
 }
 
 void __pthread_internal_remove(pthread_internal_t* thread) {
@@ -69,12 +198,13 @@ void __pthread_internal_remove(pthread_internal_t* thread) {
   } else {
     g_thread_list = thread->next;
   }
+  thread_table_remove(thread);
 }
 
 static void __pthread_internal_free(pthread_internal_t* thread) {
   if (thread->mmap_size != 0) {
     // Free mapped space, including thread stack and pthread_internal_t.
-    munmap(thread->mmap_base, thread->mmap_size);
+    __free_thread_mapping(thread);
   }
 }
 
@@ -94,13 +224,16 @@ pthread_internal_t* __pthread_internal_find(pthread_t thread_id, const char* cal
   // Check if we're looking for ourselves before acquiring the lock.
   if (thread == __get_thread()) return thread;
 
+  // Most lookups are for a live thread, and find it without the lock.
+  ThreadTable* table = atomic_load_explicit(&g_thread_table, memory_order_acquire);
+  if (table != nullptr && thread_table_contains(table, thread)) return thread;
+
   {
     // Make sure to release the lock before the abort below. Otherwise,
     // some apps might deadlock in their own crash handlers (see b/6565627).
     ScopedReadLock locker(&g_thread_list_lock);
-    for (pthread_internal_t* t = g_thread_list; t != nullptr; t = t->next) {
-      if (t == thread) return thread;
-    }
+    table = atomic_load_explicit(&g_thread_table, memory_order_relaxed);
+    if (table != nullptr && thread_table_contains(table, thread)) return thread;
   }
 
   // Historically we'd return null, but from API level 26 we catch this error.
@@ -119,6 +252,20 @@ pthread_internal_t* __pthread_internal_find(pthread_t thread_id, const char* cal
   return nullptr;
 }
 
+// Initializes a module that the dynamic linker placed in the static TLS surplus
+// in every thread. pthread_create holds the creation lock from before it
+// initializes the new thread's static TLS until the thread is on the list, so
+// every thread is either on the list or sees the module in the module table.
+void __init_static_tls_module_for_all_threads(const TlsModule& module) {
+  const StaticTlsLayout& layout = __libc_shared_globals()->static_tls_layout;
+  ScopedWriteLock creation_locker(&g_thread_creation_lock);
+  ScopedReadLock list_locker(&g_thread_list_lock);
+  for (pthread_internal_t* t = g_thread_list; t != nullptr; t = t->next) {
+    char* static_tls = reinterpret_cast<char*>(t->bionic_tls) - layout.offset_bionic_tls();
+    __init_static_tls_module(static_tls, module);
+  }
+}
+
 bool android_run_on_all_threads(bool (*func)(void*), void* arg) {
   // Take the locks in this order to avoid inversion (pthread_create ->
   // __pthread_internal_add).
@@ -183,6 +183,11 @@ class pthread_internal_t {
   // the parent is waiting for the vfork child to return control by calling either exec*() or
   // exit().
   void* vfork_child_stack_bottom;
+
+  // The dynamic linker's error buffer while this thread is in a dlsym() or dladdr() call that
+  // runs concurrently with other threads' lookups, or null. Such calls can't share the linker's
+  // global error buffer.
+  char* dl_lookup_error_buffer;
 };
 
 struct ThreadMapping {
@@ -205,13 +210,22 @@ __LIBC_HIDDEN__ void __free_temp_bionic_tls(bionic_tls* tls);
 __LIBC_HIDDEN__ void __init_additional_stacks(pthread_internal_t*);
 __LIBC_HIDDEN__ int __init_thread(pthread_internal_t* thread);
 __LIBC_HIDDEN__ ThreadMapping __allocate_thread_mapping(size_t stack_size, size_t stack_guard_size);
+__LIBC_HIDDEN__ void __free_thread_mapping(pthread_internal_t* thread);
 __LIBC_HIDDEN__ void __set_stack_and_tls_vma_name(bool is_main_thread);
 
-__LIBC_HIDDEN__ pthread_t __pthread_internal_add(pthread_internal_t* thread);
+// Returns false if the thread couldn't be added because memory ran out.
+__LIBC_HIDDEN__ bool __pthread_internal_add(pthread_internal_t* thread);
 __LIBC_HIDDEN__ pthread_internal_t* __pthread_internal_find(pthread_t pthread_id, const char* caller);
 __LIBC_HIDDEN__ pid_t __pthread_internal_gettid(pthread_t pthread_id, const char* caller);
 __LIBC_HIDDEN__ void __pthread_internal_remove(pthread_internal_t* thread);
 __LIBC_HIDDEN__ void __pthread_internal_remove_and_free(pthread_internal_t* thread);
+__LIBC_HIDDEN__ void __init_static_tls_module_for_all_threads(const TlsModule& module);
+
+// pthread_cond_broadcast() can requeue its waiters to the futex of the mutex they'll lock next,
+// rather than waking them all at once, if the mutex supports it. Waiters that might have been
+// requeued must then lock the mutex with __pthread_mutex_lock_after_requeue().
+__LIBC_HIDDEN__ bool __pthread_mutex_supports_requeue(pthread_mutex_t* mutex);
+__LIBC_HIDDEN__ void __pthread_mutex_lock_after_requeue(pthread_mutex_t* mutex);
 
 static inline __always_inline bionic_tcb* __get_bionic_tcb() {
   return reinterpret_cast<bionic_tcb*>(&__get_tls()[MIN_TLS_SLOT]);
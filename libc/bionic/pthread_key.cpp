@@ -73,17 +73,41 @@ static inline pthread_key_data_t* get_thread_key_data() {
   return __get_bionic_tls().key_data;
 }
 
+static inline void SetKeyLive(bionic_tls& tls, size_t key) {
+  tls.key_live[key / 32] |= 1u << (key % 32);
+}
+
+static inline void ClearKeyLive(bionic_tls& tls, size_t key) {
+  tls.key_live[key / 32] &= ~(1u << (key % 32));
+}
+
 // Called from pthread_exit() to remove all pthread keys. This must call the destructor of
 // all keys that have a non-NULL data value and a non-NULL destructor.
+// Only the keys this thread has set a value for are visited, so that a thread that used few keys
+// exits quickly however many keys exist.
 __LIBC_HIDDEN__ void pthread_key_clean_all() {
   // Because destructors can do funky things like deleting/creating other keys,
   // we need to implement this in a loop.
-  pthread_key_data_t* key_data = get_thread_key_data();
+  bionic_tls& tls = __get_bionic_tls();
+  pthread_key_data_t* key_data = tls.key_data;
   for (size_t rounds = PTHREAD_DESTRUCTOR_ITERATIONS; rounds > 0; --rounds) {
     size_t called_destructor_count = 0;
-    for (size_t i = 0; i < BIONIC_PTHREAD_KEY_COUNT; ++i) {
-      uintptr_t seq = atomic_load_explicit(&key_map[i].seq, memory_order_relaxed);
-      if (SeqOfKeyInUse(seq) && seq == key_data[i].seq && key_data[i].data != nullptr) {
+    for (size_t word = 0; word < BIONIC_PTHREAD_KEY_LIVE_WORDS; ++word) {
+      uint32_t live = tls.key_live[word];
+      while (live != 0) {
+        size_t bit = __builtin_ctz(live);
+        size_t i = word * 32 + bit;
+        // Destructors may set values of other keys, so reread the bitmap for the keys after this
+        // one, like the loop over all keys would have seen them.
+        auto next_live = [&]() { return tls.key_live[word] & ~((2u << bit) - 1); };
+
+        uintptr_t seq = atomic_load_explicit(&key_map[i].seq, memory_order_relaxed);
+        if (!SeqOfKeyInUse(seq) || seq != key_data[i].seq || key_data[i].data == nullptr) {
+          // The value is null or belongs to a deleted key, so there's nothing to destroy.
+          ClearKeyLive(tls, i);
+          live = next_live();
+          continue;
+        }
         // Other threads may be calling pthread_key_delete/pthread_key_create while current thread
         // is exiting. So we need to ensure we read the right key_destructor.
         // We can rely on a user-established happens-before relationship between the creation and
@@ -94,11 +118,13 @@ __LIBC_HIDDEN__ void pthread_key_clean_all() {
         key_destructor_t key_destructor = reinterpret_cast<key_destructor_t>(
           atomic_load_explicit(&key_map[i].key_destructor, memory_order_relaxed));
         if (key_destructor == nullptr) {
+          live = next_live();
           continue;
         }
         atomic_thread_fence(memory_order_acquire);
         if (atomic_load_explicit(&key_map[i].seq, memory_order_relaxed) != seq) {
-           continue;
+          live = next_live();
+          continue;
         }
 
         // We need to clear the key data now, this will prevent the destructor (or a later one)
@@ -107,9 +133,11 @@ __LIBC_HIDDEN__ void pthread_key_clean_all() {
         // function is responsible for manually releasing the corresponding data.
         void* data = key_data[i].data;
         key_data[i].data = nullptr;
+        ClearKeyLive(tls, i);
 
         (*key_destructor)(data);
         ++called_destructor_count;
+        live = next_live();
       }
     }
 
@@ -182,9 +210,15 @@ int pthread_setspecific(pthread_key_t key, const void* ptr) {
   key &= ~KEY_VALID_FLAG;
   uintptr_t seq = atomic_load_explicit(&key_map[key].seq, memory_order_relaxed);
   if (__predict_true(SeqOfKeyInUse(seq))) {
-    pthread_key_data_t* data = &get_thread_key_data()[key];
+    bionic_tls& tls = __get_bionic_tls();
+    pthread_key_data_t* data = &tls.key_data[key];
     data->seq = seq;
     data->data = const_cast<void*>(ptr);
+    if (ptr != nullptr) {
+      SetKeyLive(tls, key);
+    } else {
+      ClearKeyLive(tls, key);
+    }
     return 0;
   }
   return EINVAL;
@@ -75,7 +75,7 @@ int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type_p)
 {
     int type = (*attr & MUTEXATTR_TYPE_MASK);
 
-    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ERRORCHECK) {
+    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ADAPTIVE_NP) {
         return EINVAL;
     }
 
@@ -85,7 +85,7 @@ int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type_p)
 
 int pthread_mutexattr_settype(pthread_mutexattr_t *attr, int type)
 {
-    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ERRORCHECK ) {
+    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ADAPTIVE_NP) {
         return EINVAL;
     }
 
@@ -447,7 +447,8 @@ static void FreeId(int id) {
 //   bits 15-13 are constant during the lifetime of the mutex.
 //
 //   owner_tid is used only in recursive and errorcheck Non-PI mutexes to hold the mutex owner
-//   thread id.
+//   thread id. In normal Non-PI mutexes it holds the adaptive spinning state instead: 0 for a
+//   mutex that doesn't spin, otherwise MUTEX_ADAPTIVE_FLAG | <spin estimate>.
 //
 // PI mutexes and Non-PI mutexes are distinguished by checking type field in state.
 #if defined(__LP64__)
@@ -494,6 +495,9 @@ static_assert(sizeof(pthread_mutex_t) == sizeof(pthread_mutex_internal_t),
 static_assert(alignof(pthread_mutex_t) == 4,
               "pthread_mutex_t should fulfill the alignment of pthread_mutex_internal_t.");
 
+#define MUTEX_ADAPTIVE_FLAG 0x8000
+#define MUTEX_ADAPTIVE_ESTIMATE_MASK 0x7fff
+
 static inline pthread_mutex_internal_t* __get_internal_mutex(pthread_mutex_t* mutex_interface) {
   return reinterpret_cast<pthread_mutex_internal_t*>(mutex_interface);
 }
@@ -513,7 +517,15 @@ int pthread_mutex_init(pthread_mutex_t* mutex_interface, const pthread_mutexattr
         state |= MUTEX_SHARED_MASK;
     }
 
-    switch (*attr & MUTEXATTR_TYPE_MASK) {
+    int type = *attr & MUTEXATTR_TYPE_MASK;
+    bool adaptive = false;
+    switch (type) {
+    case PTHREAD_MUTEX_ADAPTIVE_NP:
+      // An adaptive mutex is a normal mutex that spins before sleeping.
+      adaptive = true;
+      type = PTHREAD_MUTEX_NORMAL;
+      state |= MUTEX_TYPE_BITS_NORMAL;
+      break;
     case PTHREAD_MUTEX_NORMAL:
       state |= MUTEX_TYPE_BITS_NORMAL;
       break;
@@ -540,11 +552,11 @@ int pthread_mutex_init(pthread_mutex_t* mutex_interface, const pthread_mutexattr
 #endif
         atomic_init(&mutex->state, PI_MUTEX_STATE);
         PIMutex& pi_mutex = mutex->ToPIMutex();
-        pi_mutex.type = *attr & MUTEXATTR_TYPE_MASK;
+        pi_mutex.type = type;
         pi_mutex.shared = (*attr & MUTEXATTR_SHARED_MASK) != 0;
     } else {
         atomic_init(&mutex->state, state);
-        atomic_init(&mutex->owner_tid, 0);
+        atomic_init(&mutex->owner_tid, adaptive ? MUTEX_ADAPTIVE_FLAG : 0);
     }
     return 0;
 }
@@ -565,6 +577,54 @@ static inline __always_inline int NormalMutexTryLock(pthread_mutex_internal_t* m
     return EBUSY;
 }
 
+// Wait on a Non-PI mutex.
+static inline __always_inline int MutexWait(pthread_mutex_internal_t* mutex, uint16_t shared,
+                                            uint16_t old_state, bool use_realtime_clock,
+                                            const timespec* abs_timeout) {
+// __futex_wait always waits on a 32-bit value. But state is 16-bit. On 64-bit devices, the __pad
+// field in mutex is not used. But on 32-bit devices owner_tid makes up the rest of the value (it
+// holds the owner of recursive and errorcheck mutexes and the spinning state of adaptive normal
+// mutexes), so we need to add it to the value argument for __futex_wait, otherwise we may always
+// get EAGAIN error.
+
+#if defined(__LP64__)
+  return __futex_wait_ex(&mutex->state, shared, old_state, use_realtime_clock, abs_timeout);
+
+#else
+  // This implementation works only when the layout of pthread_mutex_internal_t matches below expectation.
+  // And it is based on the assumption that Android is always in little-endian devices.
+  static_assert(offsetof(pthread_mutex_internal_t, state) == 0, "");
+  static_assert(offsetof(pthread_mutex_internal_t, owner_tid) == 2, "");
+
+  uint32_t owner_tid = atomic_load_explicit(&mutex->owner_tid, memory_order_relaxed);
+  return __futex_wait_ex(&mutex->state, shared, (owner_tid << 16) | old_state,
+                         use_realtime_clock, abs_timeout);
+#endif
+}
+
+// Spin for a while on a contended adaptive normal mutex, in the hope that its owner releases it
+// soon. Returns true if the mutex was acquired.
+static bool __attribute__((noinline)) NormalMutexAdaptiveSpin(pthread_mutex_internal_t* mutex,
+                                                              uint16_t shared,
+                                                              uint32_t spin_state) {
+    const uint16_t unlocked           = shared | MUTEX_STATE_BITS_UNLOCKED;
+    const uint16_t locked_uncontended = shared | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
+
+    uint16_t estimate = spin_state & MUTEX_ADAPTIVE_ESTIMATE_MASK;
+    bool acquired = __adaptive_spin(&estimate, [&]() {
+        uint16_t old_state = atomic_load_explicit(&mutex->state, memory_order_relaxed);
+        return old_state == unlocked &&
+               atomic_compare_exchange_strong_explicit(&mutex->state, &old_state,
+                                                       locked_uncontended, memory_order_acquire,
+                                                       memory_order_relaxed);
+    });
+    uint32_t new_spin_state = MUTEX_ADAPTIVE_FLAG | estimate;
+    if (new_spin_state != spin_state) {
+        atomic_store_explicit(&mutex->owner_tid, new_spin_state, memory_order_relaxed);
+    }
+    return acquired;
+}
+
 /*
  * Lock a normal Non-PI mutex.
  *
@@ -589,6 +649,11 @@ static inline __always_inline int NormalMutexLock(pthread_mutex_internal_t* mute
         return result;
     }
 
+    uint32_t spin_state = atomic_load_explicit(&mutex->owner_tid, memory_order_relaxed);
+    if (spin_state != 0 && NormalMutexAdaptiveSpin(mutex, shared, spin_state)) {
+        return 0;
+    }
+
     ScopedTrace trace("Contending for pthread mutex");
 
     const uint16_t unlocked           = shared | MUTEX_STATE_BITS_UNLOCKED;
@@ -604,8 +669,8 @@ static inline __always_inline int NormalMutexLock(pthread_mutex_internal_t* mute
     // made by other threads visible to the current CPU.
     while (atomic_exchange_explicit(&mutex->state, locked_contended,
                                     memory_order_acquire) != unlocked) {
-        if (__futex_wait_ex(&mutex->state, shared, locked_contended, use_realtime_clock,
-                            abs_timeout_or_null) == -ETIMEDOUT) {
+        if (MutexWait(mutex, shared, locked_contended, use_realtime_clock,
+                      abs_timeout_or_null) == -ETIMEDOUT) {
             return ETIMEDOUT;
         }
     }
@@ -681,32 +746,6 @@ static inline __always_inline int RecursiveIncrement(pthread_mutex_internal_t* m
     return 0;
 }
 
-// Wait on a recursive or errorcheck Non-PI mutex.
-static inline __always_inline int RecursiveOrErrorcheckMutexWait(pthread_mutex_internal_t* mutex,
-                                                                 uint16_t shared,
-                                                                 uint16_t old_state,
-                                                                 bool use_realtime_clock,
-                                                                 const timespec* abs_timeout) {
-// __futex_wait always waits on a 32-bit value. But state is 16-bit. For a normal mutex, the owner_tid
-// field in mutex is not used. On 64-bit devices, the __pad field in mutex is not used.
-// But when a recursive or errorcheck mutex is used on 32-bit devices, we need to add the
-// owner_tid value in the value argument for __futex_wait, otherwise we may always get EAGAIN error.
-
-#if defined(__LP64__)
-  return __futex_wait_ex(&mutex->state, shared, old_state, use_realtime_clock, abs_timeout);
-
-#else
-  // This implementation works only when the layout of pthread_mutex_internal_t matches below expectation.
-  // And it is based on the assumption that Android is always in little-endian devices.
-  static_assert(offsetof(pthread_mutex_internal_t, state) == 0, "");
-  static_assert(offsetof(pthread_mutex_internal_t, owner_tid) == 2, "");
-
-  uint32_t owner_tid = atomic_load_explicit(&mutex->owner_tid, memory_order_relaxed);
-  return __futex_wait_ex(&mutex->state, shared, (owner_tid << 16) | old_state,
-                         use_realtime_clock, abs_timeout);
-#endif
-}
-
 // Lock a Non-PI mutex.
 static int MutexLockWithTimeout(pthread_mutex_internal_t* mutex, bool use_realtime_clock,
                                 const timespec* abs_timeout_or_null) {
@@ -781,8 +820,8 @@ static int MutexLockWithTimeout(pthread_mutex_internal_t* mutex, bool use_realti
             return result;
         }
         // We are in locked_contended state, sleep until someone wakes us up.
-        if (RecursiveOrErrorcheckMutexWait(mutex, shared, old_state, use_realtime_clock,
-                                           abs_timeout_or_null) == -ETIMEDOUT) {
+        if (MutexWait(mutex, shared, old_state, use_realtime_clock,
+                      abs_timeout_or_null) == -ETIMEDOUT) {
             return ETIMEDOUT;
         }
         old_state = atomic_load_explicit(&mutex->state, memory_order_relaxed);
@@ -791,6 +830,27 @@ static int MutexLockWithTimeout(pthread_mutex_internal_t* mutex, bool use_realti
 
 }  // namespace NonPI
 
+bool __pthread_mutex_supports_requeue(pthread_mutex_t* mutex_interface) {
+    // Waiters on a private normal mutex all sleep on the state futex, and need nothing but a
+    // wakeup to retry taking the mutex.
+    pthread_mutex_internal_t* mutex = __get_internal_mutex(mutex_interface);
+    uint16_t state = atomic_load_explicit(&mutex->state, memory_order_relaxed);
+    return (state & MUTEX_TYPE_MASK) == MUTEX_TYPE_BITS_NORMAL && (state & MUTEX_SHARED_MASK) == 0;
+}
+
+void __pthread_mutex_lock_after_requeue(pthread_mutex_t* mutex_interface) {
+    // Other waiters may have been requeued to the mutex futex, and nothing but the unlock of a
+    // contended mutex will wake them. So take the mutex as contended even if it's free, so that
+    // our unlock passes the wakeup on to the next of them.
+    pthread_mutex_internal_t* mutex = __get_internal_mutex(mutex_interface);
+    const uint16_t unlocked         = MUTEX_STATE_BITS_UNLOCKED;
+    const uint16_t locked_contended = MUTEX_STATE_BITS_LOCKED_CONTENDED;
+    while (atomic_exchange_explicit(&mutex->state, locked_contended,
+                                    memory_order_acquire) != unlocked) {
+        NonPI::MutexWait(mutex, 0, locked_contended, false, nullptr);
+    }
+}
+
 static inline __always_inline bool IsMutexDestroyed(uint16_t mutex_state) {
     return mutex_state == 0xffff;
 }
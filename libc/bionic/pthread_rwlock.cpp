@@ -33,6 +33,7 @@
 #include "pthread_internal.h"
 #include "private/bionic_futex.h"
 #include "private/bionic_lock.h"
+#include "private/bionic_percpu.h"
 #include "private/bionic_time_conversions.h"
 
 /* Technical note:
@@ -59,15 +60,15 @@
 
 // A rwlockattr is implemented as a 32-bit integer which has following fields:
 //  bits    name              description
-//   1     rwlock_kind       have rwlock preference like PTHREAD_RWLOCK_PREFER_READER_NP.
+//  2-1     rwlock_kind       have rwlock preference like PTHREAD_RWLOCK_PREFER_READER_NP.
 //   0      process_shared    set to 1 if the rwlock is shared between processes.
 
 #define RWLOCKATTR_PSHARED_SHIFT 0
 #define RWLOCKATTR_KIND_SHIFT    1
 
 #define RWLOCKATTR_PSHARED_MASK  1
-#define RWLOCKATTR_KIND_MASK     2
-#define RWLOCKATTR_RESERVED_MASK (~3)
+#define RWLOCKATTR_KIND_MASK     6
+#define RWLOCKATTR_RESERVED_MASK (~7)
 
 static inline __always_inline __always_inline bool __rwlockattr_getpshared(const pthread_rwlockattr_t* attr) {
   return (*attr & RWLOCKATTR_PSHARED_MASK) >> RWLOCKATTR_PSHARED_SHIFT;
@@ -126,7 +127,8 @@ int pthread_rwlockattr_getkind_np(const pthread_rwlockattr_t* attr, int* pref) {
 int pthread_rwlockattr_setkind_np(pthread_rwlockattr_t* attr, int pref) {
   switch (pref) {
     case PTHREAD_RWLOCK_PREFER_READER_NP:   // Fall through.
-    case PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP:
+    case PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP:   // Fall through.
+    case PTHREAD_RWLOCK_READER_BIASED_NP:
       __rwlockattr_setkind(attr, pref);
       return 0;
     default:
@@ -160,7 +162,8 @@ struct pthread_rwlock_internal_t {
 
   bool pshared;
   bool writer_nonrecursive_preferred;
-  uint16_t __pad;
+  bool reader_biased;
+  uint8_t __pad;
 
 // When a reader thread plans to suspend on the rwlock, it will add STATE_HAVE_PENDING_READERS_FLAG
 // in state, increase pending_reader_count, and wait on pending_reader_wakeup_serial. After woken
@@ -174,10 +177,11 @@ struct pthread_rwlock_internal_t {
   uint32_t pending_reader_wakeup_serial;  // Pending reader threads wait on this address by futex_wait.
   uint32_t pending_writer_wakeup_serial;  // Pending writer threads wait on this address by futex_wait.
 
+  // Only used by reader-biased rwlocks, see the reader table below.
+  atomic_uint reader_bias;
+
 #if defined(__LP64__)
-  char __reserved[20];
-#else
-  char __reserved[4];
+  char __reserved[16];
 #endif
 };
 
@@ -223,6 +227,198 @@ static inline __always_inline pthread_rwlock_internal_t* __get_internal_rwlock(p
   return reinterpret_cast<pthread_rwlock_internal_t*>(rwlock_interface);
 }
 
+// PTHREAD_RWLOCK_READER_BIASED_INITIALIZER_NP sets reader_biased directly, through
+// __PTHREAD_RWLOCK_READER_BIASED_INIT_WORD: the third byte (of little-endian) word 2.
+static_assert(offsetof(pthread_rwlock_internal_t, reader_biased) == 2 * sizeof(int32_t) + 2 &&
+              __PTHREAD_RWLOCK_READER_BIASED_INIT_WORD == 1 << (2 * 8),
+              "PTHREAD_RWLOCK_READER_BIASED_INITIALIZER_NP doesn't match pthread_rwlock_internal_t.");
+
+// Reader-biased rwlocks:
+//
+// Readers of a normal rwlock all update its state, so the cache line holding it bounces between
+// the cores even when no writer ever shows up. While a reader-biased rwlock is biased, readers
+// instead count themselves in a process-wide reader table that is split into shards, and only
+// threads that hash to the same shard share a cache line. A writer first takes the state as usual,
+// which stops new readers of the state, then revokes the bias, which stops new readers of the
+// table. If readers are left in the table, the writer gives the state back while it waits for them
+// to drain, so that they can still take the lock again recursively.
+//
+// Readers don't remember how they got the lock. A reader leaving the lock may take itself out of
+// the table or out of the state, whichever currently has a count for the lock: only the total
+// number of readers matters, and a writer waits until both are zero.
+//
+// Revoking the bias scans the whole table, so after a revocation readers use the state for a
+// while (kReaderBiasInhibitCount reads) before the bias is restored. Only a reader that holds the
+// lock through the state restores the bias, so it can't happen while a writer owns the lock.
+//
+// The reader_bias field of a reader-biased rwlock has following fields:
+//  bits     name              description
+//  31-16    drain_serial      changed when a reader leaves the table while a writer may be draining.
+//   15      drained           set when a writer found the table empty after the bias was revoked.
+//  14-0     inhibit_count     reads through the state left before the bias is restored,
+//                             0 if the rwlock is biased.
+
+#define READER_BIAS_INHIBIT_COUNT_MASK  0x7fff
+#define READER_BIAS_DRAINED_FLAG        0x8000
+#define READER_BIAS_DRAIN_SERIAL_STEP   0x10000
+
+static constexpr unsigned kReaderBiasInhibitCount = 256;
+
+static constexpr size_t kReaderShardCount = 32;
+static constexpr size_t kReaderSlotsPerShard = 8;
+
+struct ReaderSlot {
+  _Atomic(pthread_rwlock_internal_t*) rwlock;
+  atomic_uint count;
+};
+
+struct alignas(64) ReaderShard {
+  ReaderSlot slots[kReaderSlotsPerShard];
+};
+
+// The dynamic linker links its own copy of this file, and so has its own table. A writer only
+// looks in the table of the copy it was linked with, so a reader-biased rwlock must never be
+// shared between the linker and libc.so (such as anything in libc_shared_globals): the writer
+// wouldn't see the other side's readers.
+static ReaderShard g_reader_table[kReaderShardCount];
+
+static inline __always_inline bool __reader_bias_enabled(unsigned bias) {
+  return (bias & READER_BIAS_INHIBIT_COUNT_MASK) == 0;
+}
+
+// Readers use the shard of the CPU they're on, so readers on different CPUs don't share cache lines.
+// A reader that migrates while it holds the lock finds its count in another shard as it leaves.
+static inline __always_inline ReaderShard& __current_reader_shard() {
+  return g_reader_table[__get_current_cpu_shard(kReaderShardCount)];
+}
+
+static inline __always_inline size_t __reader_slot_hash(pthread_rwlock_internal_t* rwlock) {
+  return reinterpret_cast<uintptr_t>(rwlock) / sizeof(pthread_rwlock_internal_t);
+}
+
+// Returns the slot of the given shard that counts readers of rwlock, claiming a free slot if
+// `claim` is true. Returns nullptr if there is no such slot.
+static ReaderSlot* __find_reader_slot(ReaderShard& shard, pthread_rwlock_internal_t* rwlock,
+                                      bool claim) {
+  size_t hash = __reader_slot_hash(rwlock);
+  for (size_t i = 0; i < kReaderSlotsPerShard; ++i) {
+    ReaderSlot* slot = &shard.slots[(hash + i) % kReaderSlotsPerShard];
+    pthread_rwlock_internal_t* owner = atomic_load_explicit(&slot->rwlock, memory_order_relaxed);
+    if (owner == rwlock) {
+      return slot;
+    }
+    if (owner == nullptr && claim) {
+      if (atomic_compare_exchange_strong_explicit(&slot->rwlock, &owner, rwlock,
+                                                  memory_order_relaxed, memory_order_relaxed) ||
+          owner == rwlock) {
+        return slot;
+      }
+    }
+  }
+  return nullptr;
+}
+
+// Takes one reader out of the given slot, if it has any.
+static bool __leave_reader_slot(pthread_rwlock_internal_t* rwlock, ReaderSlot* slot) {
+  if (slot == nullptr) {
+    return false;
+  }
+  unsigned old_count = atomic_load_explicit(&slot->count, memory_order_relaxed);
+  do {
+    if (old_count == 0) {
+      return false;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(&slot->count, &old_count, old_count - 1,
+                                                  memory_order_seq_cst, memory_order_relaxed));
+
+  // Pairs with the writer revoking the bias and then scanning the table: either the writer sees
+  // this reader gone, or this reader sees the bias revoked and wakes the writer.
+  unsigned bias = atomic_load_explicit(&rwlock->reader_bias, memory_order_seq_cst);
+  if (!__reader_bias_enabled(bias) && !(bias & READER_BIAS_DRAINED_FLAG)) {
+    atomic_fetch_add_explicit(&rwlock->reader_bias, READER_BIAS_DRAIN_SERIAL_STEP,
+                              memory_order_seq_cst);
+    __futex_wake_ex(&rwlock->reader_bias, false, INT_MAX);
+  }
+  return true;
+}
+
+// Tries to take a read lock through the reader table.
+static inline __always_inline bool __enter_reader_table(pthread_rwlock_internal_t* rwlock) {
+  if (!__reader_bias_enabled(atomic_load_explicit(&rwlock->reader_bias, memory_order_relaxed))) {
+    return false;
+  }
+  ReaderSlot* slot = __find_reader_slot(__current_reader_shard(), rwlock, true);
+  if (slot == nullptr) {
+    return false;
+  }
+  atomic_fetch_add_explicit(&slot->count, 1, memory_order_seq_cst);
+  // Check the bias again now that we're visible to writers. If a writer revoked it meanwhile,
+  // back out and use the state instead.
+  if (__predict_true(__reader_bias_enabled(atomic_load_explicit(&rwlock->reader_bias,
+                                                                memory_order_seq_cst)))) {
+    return true;
+  }
+  __leave_reader_slot(rwlock, slot);
+  return false;
+}
+
+// Called by readers holding the lock through the state, so never while a writer owns it.
+static inline __always_inline void __count_down_reader_bias_inhibit(
+    pthread_rwlock_internal_t* rwlock) {
+  unsigned old_bias = atomic_load_explicit(&rwlock->reader_bias, memory_order_relaxed);
+  while (!__reader_bias_enabled(old_bias)) {
+    unsigned new_bias = old_bias - 1;
+    if (__reader_bias_enabled(new_bias)) {
+      new_bias &= ~READER_BIAS_DRAINED_FLAG;
+    }
+    // Release pairs with the acquire of readers entering the reader table, which then see
+    // everything the last writer did.
+    if (atomic_compare_exchange_weak_explicit(&rwlock->reader_bias, &old_bias, new_bias,
+                                              memory_order_release, memory_order_relaxed)) {
+      if (__reader_bias_enabled(new_bias)) {
+        // Writers waiting for the reader table to drain have to look at it again.
+        __futex_wake_ex(&rwlock->reader_bias, false, INT_MAX);
+      }
+      return;
+    }
+  }
+}
+
+static bool __reader_table_is_empty(pthread_rwlock_internal_t* rwlock) {
+  for (size_t i = 0; i < kReaderShardCount; ++i) {
+    ReaderSlot* slot = __find_reader_slot(g_reader_table[i], rwlock, false);
+    if (slot != nullptr && atomic_load_explicit(&slot->count, memory_order_seq_cst) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Called by a writer that just took the state. Revokes the bias and returns whether the reader
+// table is empty. If it isn't, sets *bias to a value to futex_wait on until a reader leaves.
+static bool __revoke_reader_bias(pthread_rwlock_internal_t* rwlock, unsigned* bias) {
+  unsigned old_bias = atomic_load_explicit(&rwlock->reader_bias, memory_order_relaxed);
+  while (__reader_bias_enabled(old_bias)) {
+    if (atomic_compare_exchange_weak_explicit(&rwlock->reader_bias, &old_bias,
+                                              old_bias | kReaderBiasInhibitCount,
+                                              memory_order_seq_cst, memory_order_relaxed)) {
+      old_bias |= kReaderBiasInhibitCount;
+      break;
+    }
+  }
+  if (old_bias & READER_BIAS_DRAINED_FLAG) {
+    return true;
+  }
+
+  *bias = atomic_load_explicit(&rwlock->reader_bias, memory_order_seq_cst);
+  if (!__reader_table_is_empty(rwlock)) {
+    return false;
+  }
+  // Nobody can enter the table until the bias is restored, so later writers needn't scan it.
+  atomic_fetch_or_explicit(&rwlock->reader_bias, READER_BIAS_DRAINED_FLAG, memory_order_relaxed);
+  return true;
+}
+
 int pthread_rwlock_init(pthread_rwlock_t* rwlock_interface, const pthread_rwlockattr_t* attr) {
   pthread_rwlock_internal_t* rwlock = __get_internal_rwlock(rwlock_interface);
 
@@ -238,6 +434,10 @@ int pthread_rwlock_init(pthread_rwlock_t* rwlock_interface, const pthread_rwlock
       case PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP:
         rwlock->writer_nonrecursive_preferred = true;
         break;
+      case PTHREAD_RWLOCK_READER_BIASED_NP:
+        // The reader table is private to this process.
+        rwlock->reader_biased = !rwlock->pshared;
+        break;
       default:
         return EINVAL;
     }
@@ -247,6 +447,7 @@ int pthread_rwlock_init(pthread_rwlock_t* rwlock_interface, const pthread_rwlock
   }
 
   atomic_init(&rwlock->state, 0);
+  atomic_init(&rwlock->reader_bias, 0);
   rwlock->pending_lock.init(rwlock->pshared);
   return 0;
 }
@@ -257,6 +458,18 @@ int pthread_rwlock_destroy(pthread_rwlock_t* rwlock_interface) {
   if (atomic_load_explicit(&rwlock->state, memory_order_relaxed) != 0) {
     return EBUSY;
   }
+  if (rwlock->reader_biased) {
+    if (!__reader_table_is_empty(rwlock)) {
+      return EBUSY;
+    }
+    // Give the slots back for other rwlocks to use.
+    for (size_t i = 0; i < kReaderShardCount; ++i) {
+      ReaderSlot* slot = __find_reader_slot(g_reader_table[i], rwlock, false);
+      if (slot != nullptr) {
+        atomic_store_explicit(&slot->rwlock, nullptr, memory_order_relaxed);
+      }
+    }
+  }
   return 0;
 }
 
@@ -270,6 +483,10 @@ static inline __always_inline bool __can_acquire_read_lock(int old_state,
 }
 
 static inline __always_inline int __pthread_rwlock_tryrdlock(pthread_rwlock_internal_t* rwlock) {
+  if (__predict_false(rwlock->reader_biased) && __enter_reader_table(rwlock)) {
+    return 0;
+  }
+
   int old_state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
 
   while (__predict_true(__can_acquire_read_lock(old_state, rwlock->writer_nonrecursive_preferred))) {
@@ -280,6 +497,9 @@ static inline __always_inline int __pthread_rwlock_tryrdlock(pthread_rwlock_inte
     }
     if (__predict_true(atomic_compare_exchange_weak_explicit(&rwlock->state, &old_state, new_state,
                                               memory_order_acquire, memory_order_relaxed))) {
+      if (__predict_false(rwlock->reader_biased)) {
+        __count_down_reader_bias_inhibit(rwlock);
+      }
       return 0;
     }
   }
@@ -344,7 +564,9 @@ static inline __always_inline bool __can_acquire_write_lock(int old_state) {
   return !__state_owned_by_readers_or_writer(old_state);
 }
 
-static inline __always_inline int __pthread_rwlock_trywrlock(pthread_rwlock_internal_t* rwlock) {
+static int __pthread_rwlock_unlock(pthread_rwlock_internal_t* rwlock);
+
+static inline __always_inline int __pthread_rwlock_trywrlock_state(pthread_rwlock_internal_t* rwlock) {
   int old_state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
 
   while (__predict_true(__can_acquire_write_lock(old_state))) {
@@ -358,21 +580,49 @@ static inline __always_inline int __pthread_rwlock_trywrlock(pthread_rwlock_inte
   return EBUSY;
 }
 
+static inline __always_inline int __pthread_rwlock_trywrlock(pthread_rwlock_internal_t* rwlock) {
+  int result = __pthread_rwlock_trywrlock_state(rwlock);
+  if (__predict_false(rwlock->reader_biased) && result == 0) {
+    unsigned bias;
+    if (!__revoke_reader_bias(rwlock, &bias)) {
+      __pthread_rwlock_unlock(rwlock);
+      result = EBUSY;
+    }
+  }
+  return result;
+}
+
 static int __pthread_rwlock_timedwrlock(pthread_rwlock_internal_t* rwlock, bool use_realtime_clock,
                                         const timespec* abs_timeout_or_null) {
   if (atomic_load_explicit(&rwlock->writer_tid, memory_order_relaxed) == __get_thread()->tid) {
     return EDEADLK;
   }
   while (true) {
-    int result = __pthread_rwlock_trywrlock(rwlock);
+    int result = __pthread_rwlock_trywrlock_state(rwlock);
+    unsigned bias;
+    bool readers_in_table = false;
     if (result == 0) {
-      return result;
+      if (__predict_true(!rwlock->reader_biased) || __revoke_reader_bias(rwlock, &bias)) {
+        return 0;
+      }
+      // Don't keep the state while waiting for the reader table to drain: a reader in the table
+      // may take the lock again recursively, which would then have to wait for us.
+      __pthread_rwlock_unlock(rwlock);
+      readers_in_table = true;
     }
     result = check_timespec(abs_timeout_or_null, true);
     if (result != 0) {
       return result;
     }
 
+    if (readers_in_table) {
+      if (__futex_wait_ex(&rwlock->reader_bias, false, bias, use_realtime_clock,
+                          abs_timeout_or_null) == -ETIMEDOUT) {
+        return ETIMEDOUT;
+      }
+      continue;
+    }
+
     int old_state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
     if (__can_acquire_write_lock(old_state)) {
       continue;
@@ -483,10 +733,67 @@ int pthread_rwlock_trywrlock(pthread_rwlock_t* rwlock_interface) {
   return __pthread_rwlock_trywrlock(__get_internal_rwlock(rwlock_interface));
 }
 
-int pthread_rwlock_unlock(pthread_rwlock_t* rwlock_interface) {
-  pthread_rwlock_internal_t* rwlock = __get_internal_rwlock(rwlock_interface);
+static void __pthread_rwlock_wake_pending(pthread_rwlock_internal_t* rwlock) {
+  rwlock->pending_lock.lock();
+  if (rwlock->pending_writer_count != 0) {
+    rwlock->pending_writer_wakeup_serial++;
+    rwlock->pending_lock.unlock();
+
+    __futex_wake_ex(&rwlock->pending_writer_wakeup_serial, rwlock->pshared, 1);
 
+  } else if (rwlock->pending_reader_count != 0) {
+    rwlock->pending_reader_wakeup_serial++;
+    rwlock->pending_lock.unlock();
+
+    __futex_wake_ex(&rwlock->pending_reader_wakeup_serial, rwlock->pshared, INT_MAX);
+
+  } else {
+    // It happens when waiters are woken up by timeout.
+    rwlock->pending_lock.unlock();
+  }
+}
+
+// A reader of a reader-biased rwlock leaves from wherever a reader is counted: the reader table
+// shard of this thread, the state, or any other shard, in order of how cheap that is.
+static int __pthread_rwlock_rdunlock_biased(pthread_rwlock_internal_t* rwlock) {
+  if (__leave_reader_slot(rwlock, __find_reader_slot(__current_reader_shard(), rwlock, false))) {
+    return 0;
+  }
+
+  // Other readers may be leaving through the state at the same time, so it mustn't go below zero.
   int old_state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
+  while (__state_owned_by_readers(old_state)) {
+    if (atomic_compare_exchange_weak_explicit(&rwlock->state, &old_state,
+                                              old_state - STATE_READER_COUNT_CHANGE_STEP,
+                                              memory_order_release, memory_order_relaxed)) {
+      if (__state_is_last_reader(old_state) && __state_have_pending_readers_or_writers(old_state)) {
+        __pthread_rwlock_wake_pending(rwlock);
+      }
+      return 0;
+    }
+  }
+
+  for (size_t i = 0; i < kReaderShardCount; ++i) {
+    if (__leave_reader_slot(rwlock, __find_reader_slot(g_reader_table[i], rwlock, false))) {
+      return 0;
+    }
+  }
+  return EPERM;
+}
+
+static int __pthread_rwlock_unlock(pthread_rwlock_internal_t* rwlock) {
+  if (__predict_false(rwlock->reader_biased)) {
+    // Only the thread that owns the lock for writing can find its own tid in writer_tid, so check
+    // that before looking at the state: any other caller can only be a reader, even while the
+    // state is owned by a writer that is waiting for readers in the reader table to leave. A
+    // caller that holds nothing finds no reader to take out, and gets EPERM.
+    if (atomic_load_explicit(&rwlock->writer_tid, memory_order_relaxed) != __get_thread()->tid) {
+      return __pthread_rwlock_rdunlock_biased(rwlock);
+    }
+  }
+
+  int old_state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
+
   if (__state_owned_by_writer(old_state)) {
     if (atomic_load_explicit(&rwlock->writer_tid, memory_order_relaxed) != __get_thread()->tid) {
       return EPERM;
@@ -509,23 +816,10 @@ int pthread_rwlock_unlock(pthread_rwlock_t* rwlock_interface) {
     return EPERM;
   }
 
-  // Wake up pending readers or writers.
-  rwlock->pending_lock.lock();
-  if (rwlock->pending_writer_count != 0) {
-    rwlock->pending_writer_wakeup_serial++;
-    rwlock->pending_lock.unlock();
-
-    __futex_wake_ex(&rwlock->pending_writer_wakeup_serial, rwlock->pshared, 1);
-
-  } else if (rwlock->pending_reader_count != 0) {
-    rwlock->pending_reader_wakeup_serial++;
-    rwlock->pending_lock.unlock();
-
-    __futex_wake_ex(&rwlock->pending_reader_wakeup_serial, rwlock->pshared, INT_MAX);
-
-  } else {
-    // It happens when waiters are woken up by timeout.
-    rwlock->pending_lock.unlock();
-  }
+  __pthread_rwlock_wake_pending(rwlock);
   return 0;
 }
+
+int pthread_rwlock_unlock(pthread_rwlock_t* rwlock_interface) {
+  return __pthread_rwlock_unlock(__get_internal_rwlock(rwlock_interface));
+}
@@ -29,9 +29,16 @@
 #define _GNU_SOURCE 1
 #include <sched.h>
 
+#include "private/bionic_percpu.h"
+
 extern "C" int __getcpu(unsigned*, unsigned*, void*);
 
 int sched_getcpu() {
+  // The kernel keeps the CPU in our rseq area up to date, so there's no need for a system call.
+  // A vfork child shares its parent's area without being registered, so it has to ask.
+  int rseq_cpu = __get_rseq_cpu();
+  if (__predict_true(rseq_cpu >= 0 && !__get_thread()->is_vforked())) return rseq_cpu;
+
   unsigned cpu;
   int rc = __getcpu(&cpu, nullptr, nullptr);
   if (rc == -1) {
@@ -135,7 +135,7 @@ void __libc_iterate_dynamic_tls(pid_t tid,
 
   for (size_t i = modules.static_module_count; i < dtv->count; ++i) {
     void* dtls_begin = dtv->modules[i];
-    if (dtls_begin == nullptr) continue;
+    if (dtls_begin == nullptr || __is_static_tls_block(tcb, dtls_begin)) continue;
     void* dtls_end =
         static_cast<void*>(static_cast<char*>(dtls_begin) + allocator.get_chunk_size(dtls_begin));
     size_t dso_id = __tls_module_idx_to_id(i);
@@ -78,6 +78,47 @@ void* _Nullable reallocarray(void* _Nullable __ptr, size_t __item_count, size_t
  */
 void free(void* _Nullable __ptr);
 
+/**
+ * free_sized() deallocates memory on the heap that was allocated by malloc(),
+ * calloc() or realloc() with the given size, which the allocator may use to
+ * avoid looking it up. The behavior is undefined if the size is wrong.
+ *
+ * Available since API level 35.
+ */
+void free_sized(void* _Nullable __ptr, size_t __byte_count) __INTRODUCED_IN(35);
+
+/**
+ * free_aligned_sized() deallocates memory on the heap that was allocated by
+ * aligned_alloc() with the given alignment and size. The behavior is undefined
+ * if either is wrong.
+ *
+ * Available since API level 35.
+ */
+void free_aligned_sized(void* _Nullable __ptr, size_t __alignment, size_t __byte_count) __INTRODUCED_IN(35);
+
+/**
+ * malloc_batch() allocates `__count` objects of `__byte_count` bytes each on
+ * the heap, and stores pointers to them in `__ptrs`. This is cheaper than
+ * calling malloc() `__count` times.
+ *
+ * Returns the number of objects allocated, which is only less than `__count`
+ * if the heap ran out of memory, in which case `errno` is set. The first
+ * that many entries of `__ptrs` are valid.
+ *
+ * Available since API level 35.
+ */
+size_t malloc_batch(size_t __byte_count, void* _Nullable * _Nonnull __ptrs, size_t __count) __wur __INTRODUCED_IN(35);
+
+/**
+ * free_batch() deallocates the `__count` pointers in `__ptrs`, any of which
+ * may be null. This is cheaper than calling free() `__count` times.
+ *
+ * The contents of `__ptrs` are unspecified afterwards.
+ *
+ * Available since API level 35.
+ */
+void free_batch(void* _Nullable * _Nonnull __ptrs, size_t __count) __INTRODUCED_IN(35);
+
 /**
  * [memalign(3)](http://man7.org/linux/man-pages/man3/memalign.3.html) allocates
  * memory on the heap with the required alignment.
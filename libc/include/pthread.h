@@ -47,6 +47,14 @@ enum {
   PTHREAD_MUTEX_RECURSIVE = 1,
   PTHREAD_MUTEX_ERRORCHECK = 2,
 
+  /**
+   * A normal mutex that spins for a short, adaptively chosen time before
+   * sleeping when it is contended. Suits mutexes that are held only briefly.
+   * Android versions that don't support this type return EINVAL from
+   * pthread_mutexattr_settype().
+   */
+  PTHREAD_MUTEX_ADAPTIVE_NP = 3,
+
   PTHREAD_MUTEX_ERRORCHECK_NP = PTHREAD_MUTEX_ERRORCHECK,
   PTHREAD_MUTEX_RECURSIVE_NP  = PTHREAD_MUTEX_RECURSIVE,
 
@@ -62,9 +70,29 @@ enum {
 
 #define PTHREAD_RWLOCK_INITIALIZER  { { 0 } }
 
+/* Private: the word of pthread_rwlock_t that holds the reader-biased flag, with it set. */
+#define __PTHREAD_RWLOCK_READER_BIASED_INIT_WORD  (1 << 16)
+
+/**
+ * Statically initializes a PTHREAD_RWLOCK_READER_BIASED_NP rwlock.
+ * Android versions that don't support that kind treat this like
+ * PTHREAD_RWLOCK_INITIALIZER.
+ */
+#define PTHREAD_RWLOCK_READER_BIASED_INITIALIZER_NP  { { 0, 0, __PTHREAD_RWLOCK_READER_BIASED_INIT_WORD } }
+
 enum {
   PTHREAD_RWLOCK_PREFER_READER_NP = 0,
   PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP = 1,
+
+  /**
+   * Prefers readers like PTHREAD_RWLOCK_PREFER_READER_NP, but readers don't
+   * all update the same cache line, so read-mostly rwlocks scale with the
+   * number of cores. Writers pay for this, and wait for every earlier reader
+   * to leave. Process-shared rwlocks of this kind behave like
+   * PTHREAD_RWLOCK_PREFER_READER_NP. Android versions that don't support this
+   * kind return EINVAL from pthread_rwlockattr_setkind_np().
+   */
+  PTHREAD_RWLOCK_READER_BIASED_NP = 2,
 };
 
 #define PTHREAD_ONCE_INIT 0
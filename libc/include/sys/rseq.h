@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#pragma once
+
+/**
+ * @file sys/rseq.h
+ * @brief Restartable sequences.
+ */
+
+#include <sys/cdefs.h>
+#include <stddef.h>
+
+#include <linux/rseq.h>
+
+__BEGIN_DECLS
+
+/*
+ * Unless the LIBC_DISABLE_RSEQ environment variable is set to 1 when the
+ * process starts, libc registers an rseq area for every thread. The kernel
+ * only accepts one area per thread, so code that needs rseq should use libc's
+ * area rather than registering its own. These have the same meaning as in
+ * glibc.
+ */
+
+/**
+ * The offset of the calling thread's `struct rseq` from the thread pointer
+ * (`__builtin_thread_pointer()`). The same for every thread.
+ *
+ * Available since API level 35.
+ */
+extern const ptrdiff_t __rseq_offset __INTRODUCED_IN(35);
+
+/**
+ * The size of the registered `struct rseq`, or 0 if libc didn't register one.
+ *
+ * Available since API level 35.
+ */
+extern const unsigned int __rseq_size __INTRODUCED_IN(35);
+
+/**
+ * The flags libc passed to rseq(2) when registering each area.
+ *
+ * Available since API level 35.
+ */
+extern const unsigned int __rseq_flags __INTRODUCED_IN(35);
+
+__END_DECLS
@@ -183,6 +183,10 @@ const std::unordered_map<std::string, Config::OptionInfo> Config::kOptions = {
         "record_allocs",
         {RECORD_ALLOCS, &Config::SetRecordAllocs},
     },
+    {
+        "record_allocs_binary",
+        {RECORD_ALLOCS | RECORD_ALLOCS_BINARY, &Config::SetRecordAllocs},
+    },
     {
         "record_allocs_file",
         {0, &Config::SetRecordAllocsFile},
@@ -82,16 +82,25 @@ void DebugData::PrepareFork() {
   if (pointer != nullptr) {
     pointer->PrepareFork();
   }
+  if (record != nullptr) {
+    record->PrepareFork();
+  }
 }
 
 void DebugData::PostForkParent() {
   if (pointer != nullptr) {
     pointer->PostForkParent();
   }
+  if (record != nullptr) {
+    record->PostForkParent();
+  }
 }
 
 void DebugData::PostForkChild() {
   if (pointer != nullptr) {
     pointer->PostForkChild();
   }
+  if (record != nullptr) {
+    record->PostForkChild();
+  }
 }
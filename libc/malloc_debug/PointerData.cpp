@@ -58,18 +58,12 @@
 std::atomic_uint8_t PointerData::backtrace_enabled_;
 std::atomic_bool PointerData::backtrace_dump_;
 
-std::mutex PointerData::pointer_mutex_;
-std::unordered_map<uintptr_t, PointerInfoType> PointerData::pointers_ GUARDED_BY(
-    PointerData::pointer_mutex_);
-
-std::mutex PointerData::frame_mutex_;
-std::unordered_map<FrameKeyType, size_t> PointerData::key_to_index_ GUARDED_BY(
-    PointerData::frame_mutex_);
-std::unordered_map<size_t, FrameInfoType> PointerData::frames_ GUARDED_BY(PointerData::frame_mutex_);
-std::unordered_map<size_t, std::vector<unwindstack::FrameData>> PointerData::backtraces_info_
-    GUARDED_BY(PointerData::frame_mutex_);
+PointerData::PointerShard PointerData::pointer_shards_[kPointerShards];
+PointerData::FrameShard PointerData::frame_shards_[kFrameShards];
 constexpr size_t kBacktraceEmptyIndex = 1;
-size_t PointerData::cur_hash_index_ GUARDED_BY(PointerData::frame_mutex_);
+
+// The number of pointers each shard has room for before its table grows.
+static constexpr size_t kInitialPointersPerShard = 128;
 
 std::mutex PointerData::free_pointer_mutex_;
 std::deque<FreePointerInfoType> PointerData::free_pointers_ GUARDED_BY(
@@ -87,16 +81,33 @@ static void EnableDump(int, siginfo_t*, void*) {
   g_debug->pointer->EnableDumping();
 }
 
+class PointerData::ScopedAllShardsLock {
+ public:
+  ScopedAllShardsLock() { LockAllShards(); }
+  ~ScopedAllShardsLock() { UnlockAllShards(); }
+
+ private:
+  BIONIC_DISALLOW_COPY_AND_ASSIGN(ScopedAllShardsLock);
+};
+
 PointerData::PointerData(DebugData* debug_data) : OptionData(debug_data) {}
 
 bool PointerData::Initialize(const Config& config) NO_THREAD_SAFETY_ANALYSIS {
-  pointers_.clear();
-  key_to_index_.clear();
-  frames_.clear();
+  for (PointerShard& shard : pointer_shards_) {
+    shard.pointers.Reset(kInitialPointersPerShard);
+  }
+  for (FrameShard& shard : frame_shards_) {
+    shard.key_to_index.clear();
+    shard.frames.clear();
+    shard.backtraces_info.clear();
+    // A hash index of kBacktraceEmptyIndex indicates that we tried to get
+    // a backtrace, but there was nothing recorded. The hash indexes of a
+    // shard are the multiples of kFrameShards offset by the shard's index,
+    // so start above that.
+    shard.next_index = 1;
+  }
+  static_assert(kFrameShards > kBacktraceEmptyIndex);
   free_pointers_.clear();
-  // A hash index of kBacktraceEmptyIndex indicates that we tried to get
-  // a backtrace, but there was nothing recorded.
-  cur_hash_index_ = kBacktraceEmptyIndex + 1;
 
   backtrace_enabled_ = config.backtrace_enabled();
   if (config.backtrace_enable_on_signal()) {
@@ -167,21 +178,23 @@ size_t PointerData::AddBacktrace(size_t num_frames, size_t size_bytes) {
   }
 
   FrameKeyType key{.num_frames = frames.size(), .frames = frames.data()};
+  size_t shard_index = HashPointer(std::hash<FrameKeyType>()(key)) % kFrameShards;
+  FrameShard& shard = frame_shards_[shard_index];
   size_t hash_index;
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
-  auto entry = key_to_index_.find(key);
-  if (entry == key_to_index_.end()) {
-    hash_index = cur_hash_index_++;
+  std::lock_guard<std::mutex> frame_guard(shard.mutex);
+  auto entry = shard.key_to_index.find(key);
+  if (entry == shard.key_to_index.end()) {
+    hash_index = shard.next_index++ * kFrameShards + shard_index;
     key.frames = frames.data();
-    key_to_index_.emplace(key, hash_index);
+    shard.key_to_index.emplace(key, hash_index);
 
-    frames_.emplace(hash_index, FrameInfoType{.references = 1, .frames = std::move(frames)});
+    shard.frames.emplace(hash_index, FrameInfoType{.references = 1, .frames = std::move(frames)});
     if (g_debug->config().options() & BACKTRACE_FULL) {
-      backtraces_info_.emplace(hash_index, std::move(frames_info));
+      shard.backtraces_info.emplace(hash_index, std::move(frames_info));
     }
   } else {
     hash_index = entry->second;
-    FrameInfoType* frame_info = &frames_[hash_index];
+    FrameInfoType* frame_info = &shard.frames[hash_index];
     frame_info->references++;
   }
   return hash_index;
@@ -192,19 +205,20 @@ void PointerData::RemoveBacktrace(size_t hash_index) {
     return;
   }
 
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
-  auto frame_entry = frames_.find(hash_index);
-  if (frame_entry == frames_.end()) {
+  FrameShard& shard = GetFrameShard(hash_index);
+  std::lock_guard<std::mutex> frame_guard(shard.mutex);
+  auto frame_entry = shard.frames.find(hash_index);
+  if (frame_entry == shard.frames.end()) {
     error_log("hash_index %zu does not have matching frame data.", hash_index);
     return;
   }
   FrameInfoType* frame_info = &frame_entry->second;
   if (--frame_info->references == 0) {
     FrameKeyType key{.num_frames = frame_info->frames.size(), .frames = frame_info->frames.data()};
-    key_to_index_.erase(key);
-    frames_.erase(hash_index);
+    shard.key_to_index.erase(key);
+    shard.frames.erase(hash_index);
     if (g_debug->config().options() & BACKTRACE_FULL) {
-      backtraces_info_.erase(hash_index);
+      shard.backtraces_info.erase(hash_index);
     }
   }
 }
@@ -218,49 +232,50 @@ void PointerData::Add(const void* ptr, size_t pointer_size) {
     }
   }
 
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
   uintptr_t mangled_ptr = ManglePointer(reinterpret_cast<uintptr_t>(ptr));
-  pointers_[mangled_ptr] =
-      PointerInfoType{PointerInfoType::GetEncodedSize(pointer_size), hash_index};
+  PointerShard& shard = GetPointerShard(mangled_ptr);
+  std::lock_guard<std::mutex> pointer_guard(shard.mutex);
+  shard.pointers.Insert(mangled_ptr,
+                        PointerInfoType{PointerInfoType::GetEncodedSize(pointer_size), hash_index});
 }
 
 void PointerData::Remove(const void* ptr) {
-  size_t hash_index;
+  PointerInfoType info;
   {
-    std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
     uintptr_t mangled_ptr = ManglePointer(reinterpret_cast<uintptr_t>(ptr));
-    auto entry = pointers_.find(mangled_ptr);
-    if (entry == pointers_.end()) {
+    PointerShard& shard = GetPointerShard(mangled_ptr);
+    std::lock_guard<std::mutex> pointer_guard(shard.mutex);
+    if (!shard.pointers.Erase(mangled_ptr, &info)) {
       // Attempt to remove unknown pointer.
       error_log("No tracked pointer found for 0x%" PRIxPTR, DemanglePointer(mangled_ptr));
       return;
     }
-    hash_index = entry->second.hash_index;
-    pointers_.erase(mangled_ptr);
   }
 
-  RemoveBacktrace(hash_index);
+  RemoveBacktrace(info.hash_index);
 }
 
 size_t PointerData::GetFrames(const void* ptr, uintptr_t* frames, size_t max_frames) {
   size_t hash_index;
   {
-    std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
     uintptr_t mangled_ptr = ManglePointer(reinterpret_cast<uintptr_t>(ptr));
-    auto entry = pointers_.find(mangled_ptr);
-    if (entry == pointers_.end()) {
+    PointerShard& shard = GetPointerShard(mangled_ptr);
+    std::lock_guard<std::mutex> pointer_guard(shard.mutex);
+    PointerInfoType* info = shard.pointers.Find(mangled_ptr);
+    if (info == nullptr) {
       return 0;
     }
-    hash_index = entry->second.hash_index;
+    hash_index = info->hash_index;
   }
 
   if (hash_index <= kBacktraceEmptyIndex) {
     return 0;
   }
 
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
-  auto frame_entry = frames_.find(hash_index);
-  if (frame_entry == frames_.end()) {
+  FrameShard& shard = GetFrameShard(hash_index);
+  std::lock_guard<std::mutex> frame_guard(shard.mutex);
+  auto frame_entry = shard.frames.find(hash_index);
+  if (frame_entry == shard.frames.end()) {
     return 0;
   }
   FrameInfoType* frame_info = &frame_entry->second;
@@ -273,16 +288,17 @@ size_t PointerData::GetFrames(const void* ptr, uintptr_t* frames, size_t max_fra
 }
 
 void PointerData::LogBacktrace(size_t hash_index) {
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
+  FrameShard& shard = GetFrameShard(hash_index);
+  std::lock_guard<std::mutex> frame_guard(shard.mutex);
   if (g_debug->config().options() & BACKTRACE_FULL) {
-    auto backtrace_info_entry = backtraces_info_.find(hash_index);
-    if (backtrace_info_entry != backtraces_info_.end()) {
+    auto backtrace_info_entry = shard.backtraces_info.find(hash_index);
+    if (backtrace_info_entry != shard.backtraces_info.end()) {
       UnwindLog(backtrace_info_entry->second);
       return;
     }
   } else {
-    auto frame_entry = frames_.find(hash_index);
-    if (frame_entry != frames_.end()) {
+    auto frame_entry = shard.frames.find(hash_index);
+    if (frame_entry != shard.frames.end()) {
       FrameInfoType* frame_info = &frame_entry->second;
       backtrace_log(frame_info->frames.data(), frame_info->frames.size());
       return;
@@ -403,41 +419,77 @@ void PointerData::VerifyAllFreed() {
   }
 }
 
-void PointerData::GetList(std::vector<ListInfoType>* list, bool only_with_backtrace)
-    REQUIRES(pointer_mutex_, frame_mutex_) {
-  for (const auto& entry : pointers_) {
-    FrameInfoType* frame_info = nullptr;
-    std::vector<unwindstack::FrameData>* backtrace_info = nullptr;
-    uintptr_t pointer = DemanglePointer(entry.first);
-    size_t hash_index = entry.second.hash_index;
-    if (hash_index > kBacktraceEmptyIndex) {
-      auto frame_entry = frames_.find(hash_index);
-      if (frame_entry == frames_.end()) {
-        // Somehow wound up with a pointer with a valid hash_index, but
-        // no frame data. This should not be possible since adding a pointer
-        // occurs after the hash_index and frame data have been added.
-        // When removing a pointer, the pointer is deleted before the frame
-        // data.
+void PointerData::LockAllShards() NO_THREAD_SAFETY_ANALYSIS {
+  for (PointerShard& shard : pointer_shards_) {
+    shard.mutex.lock();
+  }
+  for (FrameShard& shard : frame_shards_) {
+    shard.mutex.lock();
+  }
+}
+
+void PointerData::UnlockAllShards() NO_THREAD_SAFETY_ANALYSIS {
+  for (FrameShard& shard : frame_shards_) {
+    shard.mutex.unlock();
+  }
+  for (PointerShard& shard : pointer_shards_) {
+    shard.mutex.unlock();
+  }
+}
+
+bool PointerData::Empty() NO_THREAD_SAFETY_ANALYSIS {
+  for (PointerShard& shard : pointer_shards_) {
+    if (!shard.pointers.empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PointerData::AddToList(std::vector<ListInfoType>* list, uintptr_t mangled_ptr,
+                            const PointerInfoType& info, bool only_with_backtrace)
+    NO_THREAD_SAFETY_ANALYSIS {
+  FrameInfoType* frame_info = nullptr;
+  std::vector<unwindstack::FrameData>* backtrace_info = nullptr;
+  uintptr_t pointer = DemanglePointer(mangled_ptr);
+  size_t hash_index = info.hash_index;
+  if (hash_index > kBacktraceEmptyIndex) {
+    FrameShard& shard = GetFrameShard(hash_index);
+    auto frame_entry = shard.frames.find(hash_index);
+    if (frame_entry == shard.frames.end()) {
+      // Somehow wound up with a pointer with a valid hash_index, but
+      // no frame data. This should not be possible since adding a pointer
+      // occurs after the hash_index and frame data have been added.
+      // When removing a pointer, the pointer is deleted before the frame
+      // data.
+      error_log("Pointer 0x%" PRIxPTR " hash_index %zu does not exist.", pointer, hash_index);
+    } else {
+      frame_info = &frame_entry->second;
+    }
+
+    if (g_debug->config().options() & BACKTRACE_FULL) {
+      auto backtrace_entry = shard.backtraces_info.find(hash_index);
+      if (backtrace_entry == shard.backtraces_info.end()) {
         error_log("Pointer 0x%" PRIxPTR " hash_index %zu does not exist.", pointer, hash_index);
       } else {
-        frame_info = &frame_entry->second;
+        backtrace_info = &backtrace_entry->second;
       }
-
-      if (g_debug->config().options() & BACKTRACE_FULL) {
-        auto backtrace_entry = backtraces_info_.find(hash_index);
-        if (backtrace_entry == backtraces_info_.end()) {
-          error_log("Pointer 0x%" PRIxPTR " hash_index %zu does not exist.", pointer, hash_index);
-        } else {
-          backtrace_info = &backtrace_entry->second;
-        }
-      }
-    }
-    if (hash_index == 0 && only_with_backtrace) {
-      continue;
     }
+  }
+  if (hash_index == 0 && only_with_backtrace) {
+    return;
+  }
+
+  list->emplace_back(ListInfoType{pointer, 1, info.RealSize(), info.ZygoteChildAlloc(), frame_info,
+                                  backtrace_info});
+}
 
-    list->emplace_back(ListInfoType{pointer, 1, entry.second.RealSize(),
-                                    entry.second.ZygoteChildAlloc(), frame_info, backtrace_info});
+void PointerData::GetList(std::vector<ListInfoType>* list, bool only_with_backtrace)
+    NO_THREAD_SAFETY_ANALYSIS {
+  for (PointerShard& shard : pointer_shards_) {
+    shard.pointers.ForEach([&](uintptr_t mangled_ptr, const PointerInfoType& info) {
+      AddToList(list, mangled_ptr, info, only_with_backtrace);
+    });
   }
 
   // Sort by the size of the allocation.
@@ -476,8 +528,7 @@ void PointerData::GetList(std::vector<ListInfoType>* list, bool only_with_backtr
   });
 }
 
-void PointerData::GetUniqueList(std::vector<ListInfoType>* list, bool only_with_backtrace)
-    REQUIRES(pointer_mutex_, frame_mutex_) {
+void PointerData::GetUniqueList(std::vector<ListInfoType>* list, bool only_with_backtrace) {
   GetList(list, only_with_backtrace);
 
   // Remove duplicates of size/backtraces.
@@ -500,8 +551,7 @@ void PointerData::GetUniqueList(std::vector<ListInfoType>* list, bool only_with_
 void PointerData::LogLeaks() {
   std::vector<ListInfoType> list;
 
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
+  ScopedAllShardsLock shards_lock;
   GetList(&list, false);
 
   size_t track_count = 0;
@@ -520,10 +570,9 @@ void PointerData::LogLeaks() {
 }
 
 void PointerData::GetAllocList(std::vector<ListInfoType>* list) {
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
+  ScopedAllShardsLock shards_lock;
 
-  if (pointers_.empty()) {
+  if (Empty()) {
     return;
   }
 
@@ -532,10 +581,9 @@ void PointerData::GetAllocList(std::vector<ListInfoType>* list) {
 
 void PointerData::GetInfo(uint8_t** info, size_t* overall_size, size_t* info_size,
                           size_t* total_memory, size_t* backtrace_size) {
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
+  ScopedAllShardsLock shards_lock;
 
-  if (pointers_.empty()) {
+  if (Empty()) {
     return;
   }
 
@@ -571,16 +619,16 @@ void PointerData::GetInfo(uint8_t** info, size_t* overall_size, size_t* info_siz
 }
 
 bool PointerData::Exists(const void* ptr) {
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
   uintptr_t mangled_ptr = ManglePointer(reinterpret_cast<uintptr_t>(ptr));
-  return pointers_.count(mangled_ptr) != 0;
+  PointerShard& shard = GetPointerShard(mangled_ptr);
+  std::lock_guard<std::mutex> pointer_guard(shard.mutex);
+  return shard.pointers.Find(mangled_ptr) != nullptr;
 }
 
 void PointerData::DumpLiveToFile(int fd) {
   std::vector<ListInfoType> list;
 
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
+  ScopedAllShardsLock shards_lock;
   GetUniqueList(&list, false);
 
   size_t total_memory = 0;
@@ -638,30 +686,34 @@ void PointerData::DumpLiveToFile(int fd) {
 
 void PointerData::PrepareFork() NO_THREAD_SAFETY_ANALYSIS {
   free_pointer_mutex_.lock();
-  pointer_mutex_.lock();
-  frame_mutex_.lock();
+  LockAllShards();
 }
 
 void PointerData::PostForkParent() NO_THREAD_SAFETY_ANALYSIS {
-  frame_mutex_.unlock();
-  pointer_mutex_.unlock();
+  UnlockAllShards();
   free_pointer_mutex_.unlock();
 }
 
 void PointerData::PostForkChild() __attribute__((no_thread_safety_analysis)) {
   // Make sure that any potential mutexes have been released and are back
   // to an initial state.
-  frame_mutex_.try_lock();
-  frame_mutex_.unlock();
-  pointer_mutex_.try_lock();
-  pointer_mutex_.unlock();
+  for (FrameShard& shard : frame_shards_) {
+    shard.mutex.try_lock();
+    shard.mutex.unlock();
+  }
+  for (PointerShard& shard : pointer_shards_) {
+    shard.mutex.try_lock();
+    shard.mutex.unlock();
+  }
   free_pointer_mutex_.try_lock();
   free_pointer_mutex_.unlock();
 }
 
-void PointerData::IteratePointers(std::function<void(uintptr_t pointer)> fn) {
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
-  for (const auto entry : pointers_) {
-    fn(DemanglePointer(entry.first));
+void PointerData::IteratePointers(std::function<void(uintptr_t pointer)> fn)
+    NO_THREAD_SAFETY_ANALYSIS {
+  ScopedAllShardsLock shards_lock;
+  for (PointerShard& shard : pointer_shards_) {
+    shard.pointers.ForEach(
+        [&fn](uintptr_t mangled_ptr, const PointerInfoType&) { fn(DemanglePointer(mangled_ptr)); });
   }
 }
@@ -39,10 +39,12 @@
 #include <unordered_map>
 #include <vector>
 
+#include <android-base/thread_annotations.h>
 #include <platform/bionic/macros.h>
 #include <unwindstack/Unwinder.h>
 
 #include "OptionData.h"
+#include "PointerMap.h"
 #include "UnwindBacktrace.h"
 
 extern bool* g_zygote_child;
@@ -167,11 +169,52 @@ class PointerData : public OptionData {
   static inline uintptr_t ManglePointer(uintptr_t pointer) { return pointer ^ UINTPTR_MAX; }
   static inline uintptr_t DemanglePointer(uintptr_t pointer) { return pointer ^ UINTPTR_MAX; }
 
+  // The tracked pointers and the backtraces are each split into shards with
+  // their own lock, so that threads allocating at the same time rarely wait for
+  // each other. A pointer's shard is picked by its hash, and a backtrace's
+  // shard is encoded in its hash_index.
+  static constexpr size_t kPointerShardBits = 5;
+  static constexpr size_t kPointerShards = 1 << kPointerShardBits;
+  static constexpr size_t kFrameShards = 32;
+
+  struct alignas(64) PointerShard {
+    std::mutex mutex;
+    // The low hash bits pick the shard, so the table uses the ones above them.
+    PointerMap<PointerInfoType, kPointerShardBits> pointers GUARDED_BY(mutex);
+  };
+
+  struct alignas(64) FrameShard {
+    std::mutex mutex;
+    std::unordered_map<FrameKeyType, size_t> key_to_index GUARDED_BY(mutex);
+    std::unordered_map<size_t, FrameInfoType> frames GUARDED_BY(mutex);
+    std::unordered_map<size_t, std::vector<unwindstack::FrameData>> backtraces_info
+        GUARDED_BY(mutex);
+    size_t next_index GUARDED_BY(mutex);
+  };
+
+  // Locks all of the shards, for the functions that need to look at every
+  // tracked pointer.
+  class ScopedAllShardsLock;
+
+  static PointerShard& GetPointerShard(uintptr_t mangled_ptr) {
+    return pointer_shards_[HashPointer(mangled_ptr) % kPointerShards];
+  }
+  static FrameShard& GetFrameShard(size_t hash_index) {
+    return frame_shards_[hash_index % kFrameShards];
+  }
+
+  static void LockAllShards();
+  static void UnlockAllShards();
+
   static std::string GetHashString(uintptr_t* frames, size_t num_frames);
   static void LogBacktrace(size_t hash_index);
 
+  // These require all of the shards to be locked.
+  static void AddToList(std::vector<ListInfoType>* list, uintptr_t mangled_ptr,
+                        const PointerInfoType& info, bool only_with_backtrace);
   static void GetList(std::vector<ListInfoType>* list, bool only_with_backtrace);
   static void GetUniqueList(std::vector<ListInfoType>* list, bool only_with_backtrace);
+  static bool Empty();
 
   size_t alloc_offset_ = 0;
   std::vector<uint8_t> cmp_mem_;
@@ -180,14 +223,8 @@ class PointerData : public OptionData {
 
   static std::atomic_bool backtrace_dump_;
 
-  static std::mutex pointer_mutex_;
-  static std::unordered_map<uintptr_t, PointerInfoType> pointers_;
-
-  static std::mutex frame_mutex_;
-  static std::unordered_map<FrameKeyType, size_t> key_to_index_;
-  static std::unordered_map<size_t, FrameInfoType> frames_;
-  static std::unordered_map<size_t, std::vector<unwindstack::FrameData>> backtraces_info_;
-  static size_t cur_hash_index_;
+  static PointerShard pointer_shards_[kPointerShards];
+  static FrameShard frame_shards_[kFrameShards];
 
   static std::mutex free_pointer_mutex_;
   static std::deque<FreePointerInfoType> free_pointers_;
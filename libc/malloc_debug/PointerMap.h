@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <platform/bionic/macros.h>
+
+// Mixes all the bits of a pointer, so that any subset of the result can be
+// used as a hash. Allocations are aligned, so the low bits of the pointer
+// itself are nearly always the same.
+static inline uint64_t HashPointer(uintptr_t pointer) {
+  uint64_t hash = pointer;
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// An open addressing hash table, using linear probing, from a non-zero key to
+// a Value. All of the entries are stored in one array, so adding a key only
+// allocates when the table has to grow.
+//
+// The table is indexed by the hash bits above the lowest kSkipBits, leaving
+// those for the caller to pick a table with.
+template <typename Value, size_t kSkipBits = 0>
+class PointerMap {
+ public:
+  PointerMap() = default;
+
+  // Makes the table empty, with room for at least `capacity` keys.
+  void Reset(size_t capacity) {
+    size_t slots = kMinSlots;
+    while (slots * kMaxLoadPercent / 100 < capacity) {
+      slots *= 2;
+    }
+    entries_.clear();
+    entries_.resize(slots);
+    entries_.shrink_to_fit();
+    size_ = 0;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  Value* Find(uintptr_t key) {
+    if (entries_.empty()) {
+      return nullptr;
+    }
+    for (size_t i = Slot(key);; i = Next(i)) {
+      if (entries_[i].key == key) {
+        return &entries_[i].value;
+      }
+      if (entries_[i].key == 0) {
+        return nullptr;
+      }
+    }
+  }
+
+  // Adds the key, or replaces its value if it is already present.
+  void Insert(uintptr_t key, const Value& value) {
+    if ((size_ + 1) * 100 > entries_.size() * kMaxLoadPercent) {
+      Grow();
+    }
+    size_t i = Slot(key);
+    for (; entries_[i].key != 0; i = Next(i)) {
+      if (entries_[i].key == key) {
+        entries_[i].value = value;
+        return;
+      }
+    }
+    entries_[i].key = key;
+    entries_[i].value = value;
+    size_++;
+  }
+
+  // Removes the key, and returns its value in `value`. Returns false if the key
+  // isn't present.
+  bool Erase(uintptr_t key, Value* value) {
+    if (entries_.empty()) {
+      return false;
+    }
+    size_t i = Slot(key);
+    for (; entries_[i].key != key; i = Next(i)) {
+      if (entries_[i].key == 0) {
+        return false;
+      }
+    }
+    *value = entries_[i].value;
+
+    // Move later entries of the same probe sequence back, so that no tombstone
+    // is needed. An entry can move to the hole if the hole lies between its
+    // home slot and its current slot.
+    for (size_t j = Next(i); entries_[j].key != 0; j = Next(j)) {
+      size_t home = Slot(entries_[j].key);
+      if (((j - home) & Mask()) >= ((j - i) & Mask())) {
+        entries_[i] = entries_[j];
+        i = j;
+      }
+    }
+    entries_[i].key = 0;
+    size_--;
+    return true;
+  }
+
+  template <typename Function>
+  void ForEach(Function function) const {
+    for (const Entry& entry : entries_) {
+      if (entry.key != 0) {
+        function(entry.key, entry.value);
+      }
+    }
+  }
+
+ private:
+  struct Entry {
+    uintptr_t key = 0;
+    Value value;
+  };
+
+  static constexpr size_t kMinSlots = 16;
+  static constexpr size_t kMaxLoadPercent = 70;
+
+  size_t Mask() const { return entries_.size() - 1; }
+  size_t Slot(uintptr_t key) const { return (HashPointer(key) >> kSkipBits) & Mask(); }
+  size_t Next(size_t i) const { return (i + 1) & Mask(); }
+
+  void Grow() {
+    std::vector<Entry> old_entries;
+    old_entries.swap(entries_);
+    entries_.resize(old_entries.empty() ? kMinSlots : 2 * old_entries.size());
+    size_ = 0;
+    for (const Entry& entry : old_entries) {
+      if (entry.key != 0) {
+        Insert(entry.key, entry.value);
+      }
+    }
+  }
+
+  std::vector<Entry> entries_;
+  size_t size_ = 0;
+
+  BIONIC_DISALLOW_COPY_AND_ASSIGN(PointerMap);
+};
@@ -30,14 +30,18 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <mutex>
 
+#include <android-base/file.h>
 #include <android-base/stringprintf.h>
 
 #include "Config.h"
@@ -46,65 +50,77 @@
 #include "debug_disable.h"
 #include "debug_log.h"
 
-RecordEntry::RecordEntry() : tid_(gettid()) {
+ThreadCompleteEntry::ThreadCompleteEntry() {
+  type = RecordType::kThreadDone;
+  tid = gettid();
+  pointer = 0;
+  extra = 0;
+  size = 0;
+  start_ns = 0;
+  end_ns = 0;
 }
 
-bool ThreadCompleteEntry::Write(int fd) const {
-  return dprintf(fd, "%d: thread_done 0x0\n", tid_) > 0;
+MallocEntry::MallocEntry(void* pointer, size_t size, uint64_t start_ns, uint64_t end_ns) {
+  this->type = RecordType::kMalloc;
+  this->tid = gettid();
+  this->pointer = reinterpret_cast<uintptr_t>(pointer);
+  this->extra = 0;
+  this->size = size;
+  this->start_ns = start_ns;
+  this->end_ns = end_ns;
 }
 
-AllocEntry::AllocEntry(void* pointer, uint64_t start_ns, uint64_t end_ns)
-    : pointer_(pointer), start_ns_(start_ns), end_ns_(end_ns) {}
-
-MallocEntry::MallocEntry(void* pointer, size_t size, uint64_t start_ns, uint64_t end_ns)
-    : AllocEntry(pointer, start_ns, end_ns), size_(size) {}
-
-bool MallocEntry::Write(int fd) const {
-  return dprintf(fd, "%d: malloc %p %zu %" PRIu64 " %" PRIu64 "\n", tid_, pointer_, size_,
-                 start_ns_, end_ns_) > 0;
-}
-
-FreeEntry::FreeEntry(void* pointer, uint64_t start_ns, uint64_t end_ns)
-    : AllocEntry(pointer, start_ns, end_ns) {}
-
-bool FreeEntry::Write(int fd) const {
-  return dprintf(fd, "%d: free %p %" PRIu64 " %" PRIu64 "\n", tid_, pointer_, start_ns_, end_ns_) >
-         0;
+FreeEntry::FreeEntry(void* pointer, uint64_t start_ns, uint64_t end_ns) {
+  this->type = RecordType::kFree;
+  this->tid = gettid();
+  this->pointer = reinterpret_cast<uintptr_t>(pointer);
+  this->extra = 0;
+  this->size = 0;
+  this->start_ns = start_ns;
+  this->end_ns = end_ns;
 }
 
 CallocEntry::CallocEntry(void* pointer, size_t nmemb, size_t size, uint64_t start_ns,
-                         uint64_t end_ns)
-    : MallocEntry(pointer, size, start_ns, end_ns), nmemb_(nmemb) {}
-
-bool CallocEntry::Write(int fd) const {
-  return dprintf(fd, "%d: calloc %p %zu %zu %" PRIu64 " %" PRIu64 "\n", tid_, pointer_, nmemb_,
-                 size_, start_ns_, end_ns_) > 0;
+                         uint64_t end_ns) {
+  this->type = RecordType::kCalloc;
+  this->tid = gettid();
+  this->pointer = reinterpret_cast<uintptr_t>(pointer);
+  this->extra = nmemb;
+  this->size = size;
+  this->start_ns = start_ns;
+  this->end_ns = end_ns;
 }
 
 ReallocEntry::ReallocEntry(void* pointer, size_t size, void* old_pointer, uint64_t start_ns,
-                           uint64_t end_ns)
-    : MallocEntry(pointer, size, start_ns, end_ns), old_pointer_(old_pointer) {}
-
-bool ReallocEntry::Write(int fd) const {
-  return dprintf(fd, "%d: realloc %p %p %zu %" PRIu64 " %" PRIu64 "\n", tid_, pointer_,
-                 old_pointer_, size_, start_ns_, end_ns_) > 0;
+                           uint64_t end_ns) {
+  this->type = RecordType::kRealloc;
+  this->tid = gettid();
+  this->pointer = reinterpret_cast<uintptr_t>(pointer);
+  this->extra = reinterpret_cast<uintptr_t>(old_pointer);
+  this->size = size;
+  this->start_ns = start_ns;
+  this->end_ns = end_ns;
 }
 
 // aligned_alloc, posix_memalign, memalign, pvalloc, valloc all recorded with this class.
 MemalignEntry::MemalignEntry(void* pointer, size_t size, size_t alignment, uint64_t start_ns,
-                             uint64_t end_ns)
-    : MallocEntry(pointer, size, start_ns, end_ns), alignment_(alignment) {}
-
-bool MemalignEntry::Write(int fd) const {
-  return dprintf(fd, "%d: memalign %p %zu %zu %" PRIu64 " %" PRIu64 "\n", tid_, pointer_,
-                 alignment_, size_, start_ns_, end_ns_) > 0;
+                             uint64_t end_ns) {
+  this->type = RecordType::kMemalign;
+  this->tid = gettid();
+  this->pointer = reinterpret_cast<uintptr_t>(pointer);
+  this->extra = alignment;
+  this->size = size;
+  this->start_ns = start_ns;
+  this->end_ns = end_ns;
 }
 
 struct ThreadData {
-  ThreadData(RecordData* record_data, ThreadCompleteEntry* entry)
-      : record_data(record_data), entry(entry) {}
+  ThreadData(RecordData* record_data, RecordBuffer* buffer)
+      : record_data(record_data), buffer(buffer) {}
   RecordData* record_data;
-  ThreadCompleteEntry* entry;
+  // Only set when writing a binary record file.
+  RecordBuffer* buffer;
+  ThreadCompleteEntry entry;
   size_t count = 0;
 };
 
@@ -117,7 +133,7 @@ static void ThreadKeyDelete(void* data) {
   if (thread_data->count == 4) {
     ScopedDisableDebugCalls disable;
 
-    thread_data->record_data->AddEntryOnly(thread_data->entry);
+    thread_data->record_data->ThreadComplete(thread_data);
     delete thread_data;
   } else {
     pthread_setspecific(thread_data->record_data->key(), data);
@@ -128,7 +144,11 @@ RecordData* RecordData::record_obj_ = nullptr;
 
 void RecordData::WriteData(int, siginfo_t*, void*) {
   // Dump from here, the function must not allocate so this is safe.
-  record_obj_->WriteEntries();
+  if (record_obj_->binary_) {
+    record_obj_->Flush();
+  } else {
+    record_obj_->WriteEntries();
+  }
 }
 
 void RecordData::WriteEntries() {
@@ -177,36 +197,223 @@ bool RecordData::Initialize(const Config& config) {
              config.record_allocs_signal(), getpid());
   }
 
-  entries_.resize(config.record_allocs_num_entries());
+  binary_ = config.options() & RECORD_ALLOCS_BINARY;
+  if (binary_) {
+    max_entries_ = config.record_allocs_num_entries();
+  } else {
+    entries_.resize(config.record_allocs_num_entries());
+  }
   cur_index_ = 0U;
   dump_file_ = config.record_allocs_file();
 
+  if (binary_ && !CreateBinaryFile()) {
+    // Nothing could be written, so don't record anything.
+    full_.store(true, std::memory_order_relaxed);
+  }
+
   return true;
 }
 
 RecordData::~RecordData() {
   pthread_key_delete(key_);
+
+  RecordBuffer* buffer = buffers_.load(std::memory_order_acquire);
+  while (buffer != nullptr) {
+    RecordBuffer* next = buffer->next;
+    delete buffer;
+    buffer = next;
+  }
 }
 
-void RecordData::AddEntryOnly(const RecordEntry* entry) {
+void RecordData::AddEntryOnly(const RecordEntry& entry, RecordBuffer* buffer) {
+  if (buffer != nullptr) {
+    if (full_.load(std::memory_order_relaxed)) {
+      return;
+    }
+
+    size_t head = buffer->head.load(std::memory_order_relaxed);
+    size_t num_entries = head - buffer->tail.load(std::memory_order_acquire);
+    if (num_entries == RecordBuffer::kNumEntries) {
+      // The records are being added faster than they are written, so wait for
+      // any write in progress, and then write them from this thread.
+      while (writing_.load(std::memory_order_acquire)) {
+        sched_yield();
+      }
+      Flush();
+      num_entries = head - buffer->tail.load(std::memory_order_acquire);
+    }
+    if (num_entries < RecordBuffer::kNumEntries) {
+      buffer->entries[head % RecordBuffer::kNumEntries] = entry;
+      buffer->head.store(head + 1, std::memory_order_release);
+      num_entries++;
+    } else {
+      // The records could not be written.
+      dropped_entries_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (num_entries >= RecordBuffer::kFlushEntries) {
+      Flush();
+    }
+    return;
+  }
+
   std::lock_guard<std::mutex> entries_lock(entries_lock_);
   if (cur_index_ == entries_.size()) {
     // Maxed out, throw the entry away.
     return;
   }
 
-  entries_[cur_index_++].reset(entry);
+  entries_[cur_index_++].reset(new RecordEntry(entry));
   if (cur_index_ == entries_.size()) {
     info_log("Maximum number of records added, all new operations will be dropped.");
   }
 }
 
-void RecordData::AddEntry(const RecordEntry* entry) {
-  void* data = pthread_getspecific(key_);
-  if (data == nullptr) {
-    ThreadData* thread_data = new ThreadData(this, new ThreadCompleteEntry());
+void RecordData::AddEntry(const RecordEntry& entry) {
+  ThreadData* thread_data = reinterpret_cast<ThreadData*>(pthread_getspecific(key_));
+  if (thread_data == nullptr) {
+    thread_data = new ThreadData(this, binary_ ? AcquireBuffer() : nullptr);
     pthread_setspecific(key_, thread_data);
   }
 
-  AddEntryOnly(entry);
+  AddEntryOnly(entry, thread_data->buffer);
+}
+
+void RecordData::ThreadComplete(ThreadData* thread_data) {
+  AddEntryOnly(thread_data->entry, thread_data->buffer);
+  if (thread_data->buffer != nullptr) {
+    thread_data->buffer->in_use.store(false, std::memory_order_release);
+  }
+}
+
+RecordBuffer* RecordData::AcquireBuffer() {
+  // Reuse the buffer of a thread that has exited.
+  for (RecordBuffer* buffer = buffers_.load(std::memory_order_acquire); buffer != nullptr;
+       buffer = buffer->next) {
+    bool in_use = false;
+    if (buffer->in_use.compare_exchange_strong(in_use, true, std::memory_order_acquire)) {
+      return buffer;
+    }
+  }
+
+  RecordBuffer* buffer = new RecordBuffer;
+  buffer->next = buffers_.load(std::memory_order_relaxed);
+  while (!buffers_.compare_exchange_weak(buffer->next, buffer, std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+  }
+  return buffer;
+}
+
+void RecordData::Flush() {
+  if (writing_.exchange(true, std::memory_order_acquire)) {
+    // Any records not written by the other thread will be written by a
+    // later flush.
+    return;
+  }
+  WriteBuffers();
+  writing_.store(false, std::memory_order_release);
+}
+
+void RecordData::PrepareFork() {
+  // Wait for any write in progress, so that the child is not left with a
+  // write that will never finish.
+  while (writing_.exchange(true, std::memory_order_acquire)) {
+    sched_yield();
+  }
+}
+
+void RecordData::PostForkParent() {
+  writing_.store(false, std::memory_order_release);
+}
+
+void RecordData::PostForkChild() {
+  // The parent writes the records made before the fork, so throw away the
+  // copies in the child.
+  for (RecordBuffer* buffer = buffers_.load(std::memory_order_relaxed); buffer != nullptr;
+       buffer = buffer->next) {
+    buffer->tail.store(buffer->head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+  writing_.store(false, std::memory_order_release);
+}
+
+bool RecordData::CreateBinaryFile() {
+  // The file is created here, rather than by the first write, so that a
+  // process forked before that write appends to the file rather than
+  // truncating it.
+  int fd = open(dump_file_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0755);
+  if (fd == -1) {
+    error_log("Cannot create record alloc file %s: %s", dump_file_.c_str(), strerror(errno));
+    return false;
+  }
+  RecordFileHeader header = {};
+  memcpy(header.magic, kRecordFileMagic, sizeof(header.magic));
+  header.version = kRecordFileVersion;
+  header.entry_size = sizeof(RecordEntry);
+  bool written = android::base::WriteFully(fd, &header, sizeof(header));
+  if (!written) {
+    error_log("Failed to write record alloc information: %s", strerror(errno));
+  }
+  close(fd);
+  return written;
+}
+
+int RecordData::OpenBinaryFile() {
+  int fd = open(dump_file_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC | O_NOFOLLOW);
+  if (fd == -1) {
+    error_log("Cannot open record alloc file %s: %s", dump_file_.c_str(), strerror(errno));
+  }
+  return fd;
+}
+
+void RecordData::WriteBuffers() {
+  bool has_entries = false;
+  RecordBuffer* buffers = buffers_.load(std::memory_order_acquire);
+  for (RecordBuffer* buffer = buffers; buffer != nullptr; buffer = buffer->next) {
+    if (buffer->head.load(std::memory_order_acquire) !=
+        buffer->tail.load(std::memory_order_relaxed)) {
+      has_entries = true;
+      break;
+    }
+  }
+  if (!has_entries) {
+    return;
+  }
+
+  int dump_fd = OpenBinaryFile();
+  if (dump_fd == -1) {
+    return;
+  }
+
+  for (RecordBuffer* buffer = buffers; buffer != nullptr; buffer = buffer->next) {
+    size_t head = buffer->head.load(std::memory_order_acquire);
+    size_t tail = buffer->tail.load(std::memory_order_relaxed);
+    while (tail != head && written_entries_ < max_entries_) {
+      // Write up to the end of the ring, then wrap around.
+      size_t index = tail % RecordBuffer::kNumEntries;
+      size_t num_entries = std::min(head - tail, RecordBuffer::kNumEntries - index);
+      num_entries = std::min(num_entries, max_entries_ - written_entries_);
+      if (!android::base::WriteFully(dump_fd, &buffer->entries[index],
+                                     num_entries * sizeof(RecordEntry))) {
+        error_log("Failed to write record alloc information: %s", strerror(errno));
+        close(dump_fd);
+        return;
+      }
+      tail += num_entries;
+      written_entries_ += num_entries;
+      if (written_entries_ == max_entries_) {
+        full_.store(true, std::memory_order_relaxed);
+        info_log("Maximum number of records added, all new operations will be dropped.");
+      }
+    }
+    if (written_entries_ == max_entries_) {
+      // Throw away anything left.
+      tail = head;
+    }
+    buffer->tail.store(tail, std::memory_order_release);
+  }
+  close(dump_fd);
+
+  size_t dropped_entries = dropped_entries_.exchange(0, std::memory_order_relaxed);
+  if (dropped_entries != 0) {
+    error_log("%zu allocation records were dropped, they could not be written.", dropped_entries);
+  }
 }
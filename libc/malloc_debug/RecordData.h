@@ -41,115 +41,61 @@
 
 #include <platform/bionic/macros.h>
 
-class RecordEntry {
- public:
-  RecordEntry();
-  virtual ~RecordEntry() = default;
-
-  virtual bool Write(int fd) const = 0;
-
- protected:
-  pid_t tid_;
-
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(RecordEntry);
-};
+#include "RecordEntry.h"
 
+// These set up a RecordEntry for each kind of operation.
 class ThreadCompleteEntry : public RecordEntry {
  public:
-  ThreadCompleteEntry() = default;
-  virtual ~ThreadCompleteEntry() = default;
-
-  bool Write(int fd) const override;
-
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(ThreadCompleteEntry);
+  ThreadCompleteEntry();
 };
 
-class AllocEntry : public RecordEntry {
- public:
-  explicit AllocEntry(void* pointer, uint64_t st, uint64_t et);
-  virtual ~AllocEntry() = default;
-
- protected:
-  void* pointer_;
-
-  // The start/end time of this operation.
-  uint64_t start_ns_;
-  uint64_t end_ns_;
-
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(AllocEntry);
-};
-
-class MallocEntry : public AllocEntry {
+class MallocEntry : public RecordEntry {
  public:
   MallocEntry(void* pointer, size_t size, uint64_t st, uint64_t et);
-  virtual ~MallocEntry() = default;
-
-  bool Write(int fd) const override;
-
- protected:
-  size_t size_;
-
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(MallocEntry);
 };
 
-class FreeEntry : public AllocEntry {
+class FreeEntry : public RecordEntry {
  public:
-  explicit FreeEntry(void* pointer, uint64_t st, uint64_t et);
-  virtual ~FreeEntry() = default;
-
-  bool Write(int fd) const override;
-
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(FreeEntry);
+  FreeEntry(void* pointer, uint64_t st, uint64_t et);
 };
 
-class CallocEntry : public MallocEntry {
+class CallocEntry : public RecordEntry {
  public:
   CallocEntry(void* pointer, size_t nmemb, size_t size, uint64_t st, uint64_t et);
-  virtual ~CallocEntry() = default;
-
-  bool Write(int fd) const override;
-
- protected:
-  size_t nmemb_;
-
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(CallocEntry);
 };
 
-class ReallocEntry : public MallocEntry {
+class ReallocEntry : public RecordEntry {
  public:
   ReallocEntry(void* pointer, size_t size, void* old_pointer, uint64_t st, uint64_t et);
-  virtual ~ReallocEntry() = default;
-
-  bool Write(int fd) const override;
-
- protected:
-  void* old_pointer_;
-
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(ReallocEntry);
 };
 
 // aligned_alloc, posix_memalign, memalign, pvalloc, valloc all recorded with this class.
-class MemalignEntry : public MallocEntry {
+class MemalignEntry : public RecordEntry {
  public:
   MemalignEntry(void* pointer, size_t size, size_t alignment, uint64_t st, uint64_t et);
-  virtual ~MemalignEntry() = default;
-
-  bool Write(int fd) const override;
-
- protected:
-  size_t alignment_;
+};
 
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(MemalignEntry);
+// A ring of records used when writing a binary record file. Only the thread
+// using the buffer adds records, and only the thread writing the file removes
+// them, so neither needs a lock.
+struct RecordBuffer {
+  static constexpr size_t kNumEntries = 1024;
+  // Once a buffer holds this many records, its thread writes out all of the
+  // buffers.
+  static constexpr size_t kFlushEntries = kNumEntries / 2;
+
+  // When a thread exits, its buffer is kept with any records not written yet,
+  // and then used by the next new thread.
+  std::atomic_bool in_use{true};
+  RecordBuffer* next = nullptr;
+
+  std::atomic_size_t head{0};
+  std::atomic_size_t tail{0};
+  RecordEntry entries[kNumEntries];
 };
 
+struct ThreadData;
+
 class Config;
 
 class RecordData {
@@ -159,8 +105,17 @@ class RecordData {
 
   bool Initialize(const Config& config);
 
-  void AddEntry(const RecordEntry* entry);
-  void AddEntryOnly(const RecordEntry* entry);
+  void AddEntry(const RecordEntry& entry);
+
+  // Writes out the records in all of the buffers, unless another thread is
+  // already doing so. Only used for a binary record file.
+  void Flush();
+
+  void ThreadComplete(ThreadData* thread_data);
+
+  void PrepareFork();
+  void PostForkParent();
+  void PostForkChild();
 
   pthread_key_t key() { return key_; }
 
@@ -168,13 +123,28 @@ class RecordData {
   static void WriteData(int, siginfo_t*, void*);
   static RecordData* record_obj_;
 
+  void AddEntryOnly(const RecordEntry& entry, RecordBuffer* buffer);
   void WriteEntries();
 
+  RecordBuffer* AcquireBuffer();
+  bool CreateBinaryFile();
+  int OpenBinaryFile();
+  void WriteBuffers();
+
   std::mutex entries_lock_;
   pthread_key_t key_;
   std::vector<std::unique_ptr<const RecordEntry>> entries_;
   size_t cur_index_;
   std::string dump_file_;
 
+  bool binary_ = false;
+  std::atomic<RecordBuffer*> buffers_{nullptr};
+  std::atomic_bool writing_{false};
+  std::atomic_bool full_{false};
+  std::atomic_size_t dropped_entries_{0};
+  // These are only used by the thread writing the file.
+  size_t max_entries_ = 0;
+  size_t written_entries_ = 0;
+
   BIONIC_DISALLOW_COPY_AND_ASSIGN(RecordData);
 };
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "RecordEntry.h"
+
+bool RecordEntry::Write(int fd) const {
+  switch (type) {
+    case RecordType::kThreadDone:
+      return dprintf(fd, "%d: thread_done 0x0\n", tid) > 0;
+    case RecordType::kMalloc:
+      return dprintf(fd, "%d: malloc 0x%" PRIx64 " %" PRIu64 " %" PRIu64 " %" PRIu64 "\n", tid,
+                     pointer, size, start_ns, end_ns) > 0;
+    case RecordType::kFree:
+      return dprintf(fd, "%d: free 0x%" PRIx64 " %" PRIu64 " %" PRIu64 "\n", tid, pointer,
+                     start_ns, end_ns) > 0;
+    case RecordType::kCalloc:
+      return dprintf(fd, "%d: calloc 0x%" PRIx64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64
+                     "\n", tid, pointer, extra, size, start_ns, end_ns) > 0;
+    case RecordType::kRealloc:
+      return dprintf(fd, "%d: realloc 0x%" PRIx64 " 0x%" PRIx64 " %" PRIu64 " %" PRIu64 " %" PRIu64
+                     "\n", tid, pointer, extra, size, start_ns, end_ns) > 0;
+    case RecordType::kMemalign:
+      return dprintf(fd, "%d: memalign 0x%" PRIx64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64
+                     "\n", tid, pointer, extra, size, start_ns, end_ns) > 0;
+  }
+  return false;
+}
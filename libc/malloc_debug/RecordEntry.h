@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+
+enum class RecordType : uint32_t {
+  kThreadDone = 1,
+  kMalloc,
+  kFree,
+  kCalloc,
+  kRealloc,
+  kMemalign,
+};
+
+// A single allocation record. This is also the format of the records in a
+// binary record file, so the layout is the same for 32 bit and 64 bit
+// processes.
+struct RecordEntry {
+  RecordType type;
+  int32_t tid;
+  uint64_t pointer;
+  // The old pointer of a realloc, the nmemb of a calloc or the alignment
+  // of a memalign.
+  uint64_t extra;
+  uint64_t size;
+
+  // The start/end time of this operation.
+  uint64_t start_ns;
+  uint64_t end_ns;
+
+  // Writes the record in the text format.
+  bool Write(int fd) const;
+};
+static_assert(sizeof(RecordEntry) == 48, "RecordEntry is part of the binary record file format.");
+
+// A binary record file is this header followed by RecordEntry values.
+struct RecordFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t entry_size;
+};
+
+constexpr char kRecordFileMagic[8] = "MDRECRD";
+constexpr uint32_t kRecordFileVersion = 1;
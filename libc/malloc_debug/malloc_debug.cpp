@@ -188,6 +188,10 @@ void debug_free_malloc_leak_info(uint8_t* info);
 size_t debug_malloc_usable_size(void* pointer);
 void* debug_malloc(size_t size);
 void debug_free(void* pointer);
+size_t debug_malloc_batch(size_t size, void** pointers, size_t count);
+void debug_free_batch(void** pointers, size_t count);
+void debug_free_sized(void* pointer, size_t size);
+void debug_free_aligned_sized(void* pointer, size_t alignment, size_t size);
 void* debug_aligned_alloc(size_t alignment, size_t size);
 void* debug_memalign(size_t alignment, size_t bytes);
 void* debug_realloc(void* pointer, size_t bytes);
@@ -355,6 +359,28 @@ static bool VerifyPointer(const void* pointer, const char* function_name) {
   return true;
 }
 
+// Checks the size and alignment given to free_sized or free_aligned_sized. An
+// alignment of zero isn't checked.
+static void VerifySizeAndAlignment(const void* pointer, size_t size, size_t alignment,
+                                   const char* function_name) {
+  // realloc records the expanded size of the allocation, so it can't be checked.
+  if (g_debug->HeaderEnabled() && !(g_debug->config().options() & EXPAND_ALLOC)) {
+    size_t allocated_size = g_debug->GetHeader(pointer)->size;
+    // Zero byte allocations are made one byte long.
+    if (size != allocated_size && !(size == 0 && allocated_size == 1)) {
+      LogError(pointer, android::base::StringPrintf("HAS SIZE %zu BUT %zu WAS PASSED (%s)",
+                                                    allocated_size, size, function_name)
+                            .c_str());
+    }
+  }
+
+  if (alignment != 0 && reinterpret_cast<uintptr_t>(pointer) % alignment != 0) {
+    LogError(pointer, android::base::StringPrintf("IS NOT ALIGNED TO %zu (%s)", alignment,
+                                                  function_name)
+                          .c_str());
+  }
+}
+
 static size_t InternalMallocUsableSize(void* pointer) {
   if (g_debug->HeaderEnabled()) {
     return g_debug->GetHeader(pointer)->usable_size;
@@ -472,6 +498,11 @@ void debug_finalize() {
     PointerData::LogLeaks();
   }
 
+  if (g_debug->config().options() & RECORD_ALLOCS_BINARY) {
+    // Write out anything that has not been written yet.
+    g_debug->record->Flush();
+  }
+
   if ((g_debug->config().options() & BACKTRACE) && g_debug->config().backtrace_dump_on_exit()) {
     debug_dump_heap(android::base::StringPrintf("%s.%d.exit.txt",
                                                 g_debug->config().backtrace_dump_prefix().c_str(),
@@ -607,8 +638,8 @@ void* debug_malloc(size_t size) {
   TimedResult result = InternalMalloc(size);
 
   if (g_debug->config().options() & RECORD_ALLOCS) {
-    g_debug->record->AddEntry(new MallocEntry(result.getValue<void*>(), size,
-                                              result.GetStartTimeNS(), result.GetEndTimeNS()));
+    g_debug->record->AddEntry(MallocEntry(result.getValue<void*>(), size, result.GetStartTimeNS(),
+                                          result.GetEndTimeNS()));
   }
 
   return result.getValue<void*>();
@@ -692,9 +723,117 @@ void debug_free(void* pointer) {
   TimedResult result = InternalFree(pointer);
 
   if (g_debug->config().options() & RECORD_ALLOCS) {
-    g_debug->record->AddEntry(
-        new FreeEntry(pointer, result.GetStartTimeNS(), result.GetEndTimeNS()));
+    g_debug->record->AddEntry(FreeEntry(pointer, result.GetStartTimeNS(), result.GetEndTimeNS()));
+  }
+}
+
+size_t debug_malloc_batch(size_t size, void** pointers, size_t count) {
+  Unreachable::CheckIfRequested(g_debug->config());
+
+  if (DebugCallsDisabled()) {
+    if (g_dispatch->malloc_batch != nullptr) {
+      return g_dispatch->malloc_batch(size, pointers, count);
+    }
+    for (size_t i = 0; i < count; i++) {
+      pointers[i] = g_dispatch->malloc(size);
+      if (pointers[i] == nullptr) {
+        return i;
+      }
+    }
+    return count;
+  }
+  ScopedConcurrentLock lock;
+  ScopedDisableDebugCalls disable;
+  ScopedBacktraceSignalBlocker blocked;
+
+  // Every pointer needs its own header, so this allocates them one at a time,
+  // but only pays for the locking once.
+  for (size_t i = 0; i < count; i++) {
+    TimedResult result = InternalMalloc(size);
+    pointers[i] = result.getValue<void*>();
+
+    if (g_debug->config().options() & RECORD_ALLOCS) {
+      g_debug->record->AddEntry(
+          MallocEntry(pointers[i], size, result.GetStartTimeNS(), result.GetEndTimeNS()));
+    }
+
+    if (pointers[i] == nullptr) {
+      return i;
+    }
+  }
+  return count;
+}
+
+void debug_free_batch(void** pointers, size_t count) {
+  Unreachable::CheckIfRequested(g_debug->config());
+
+  if (DebugCallsDisabled()) {
+    if (g_dispatch->free_batch != nullptr) {
+      return g_dispatch->free_batch(pointers, count);
+    }
+    for (size_t i = 0; i < count; i++) {
+      g_dispatch->free(pointers[i]);
+    }
+    return;
+  }
+  ScopedConcurrentLock lock;
+  ScopedDisableDebugCalls disable;
+  ScopedBacktraceSignalBlocker blocked;
+
+  for (size_t i = 0; i < count; i++) {
+    void* pointer = pointers[i];
+    if (pointer == nullptr || !VerifyPointer(pointer, "free_batch")) {
+      continue;
+    }
+
+    TimedResult result = InternalFree(pointer);
+
+    if (g_debug->config().options() & RECORD_ALLOCS) {
+      g_debug->record->AddEntry(FreeEntry(pointer, result.GetStartTimeNS(), result.GetEndTimeNS()));
+    }
+  }
+}
+
+static void InternalFreeSized(void* pointer, size_t size, size_t alignment,
+                              const char* function_name) {
+  ScopedConcurrentLock lock;
+  ScopedDisableDebugCalls disable;
+  ScopedBacktraceSignalBlocker blocked;
+
+  if (!VerifyPointer(pointer, function_name)) {
+    return;
+  }
+  VerifySizeAndAlignment(pointer, size, alignment, function_name);
+
+  TimedResult result = InternalFree(pointer);
+
+  if (g_debug->config().options() & RECORD_ALLOCS) {
+    g_debug->record->AddEntry(FreeEntry(pointer, result.GetStartTimeNS(), result.GetEndTimeNS()));
+  }
+}
+
+void debug_free_sized(void* pointer, size_t size) {
+  Unreachable::CheckIfRequested(g_debug->config());
+
+  if (DebugCallsDisabled() || pointer == nullptr) {
+    if (g_dispatch->free_sized != nullptr) {
+      return g_dispatch->free_sized(pointer, size);
+    }
+    return g_dispatch->free(pointer);
+  }
+  InternalFreeSized(pointer, size, 0, "free_sized");
+}
+
+void debug_free_aligned_sized(void* pointer, size_t alignment, size_t size) {
+  Unreachable::CheckIfRequested(g_debug->config());
+
+  if (DebugCallsDisabled() || pointer == nullptr) {
+    if (g_dispatch->free_aligned_sized != nullptr) {
+      return g_dispatch->free_aligned_sized(pointer, alignment, size);
+    }
+    return g_dispatch->free(pointer);
   }
+  InternalFreeSized(pointer, size, alignment, "free_aligned_sized");
 }
 
 void* debug_memalign(size_t alignment, size_t bytes) {
@@ -776,8 +915,8 @@ void* debug_memalign(size_t alignment, size_t bytes) {
     }
 
     if (g_debug->config().options() & RECORD_ALLOCS) {
-      g_debug->record->AddEntry(new MemalignEntry(pointer, bytes, alignment,
-                                                  result.GetStartTimeNS(), result.GetEndTimeNS()));
+      g_debug->record->AddEntry(MemalignEntry(pointer, bytes, alignment, result.GetStartTimeNS(),
+                                              result.GetEndTimeNS()));
     }
   }
 
@@ -797,8 +936,8 @@ void* debug_realloc(void* pointer, size_t bytes) {
   if (pointer == nullptr) {
     TimedResult result = InternalMalloc(bytes);
     if (g_debug->config().options() & RECORD_ALLOCS) {
-      g_debug->record->AddEntry(new ReallocEntry(result.getValue<void*>(), bytes, nullptr,
-                                                 result.GetStartTimeNS(), result.GetEndTimeNS()));
+      g_debug->record->AddEntry(ReallocEntry(result.getValue<void*>(), bytes, nullptr,
+                                             result.GetStartTimeNS(), result.GetEndTimeNS()));
     }
     pointer = result.getValue<void*>();
     return pointer;
@@ -812,8 +951,8 @@ void* debug_realloc(void* pointer, size_t bytes) {
     TimedResult result = InternalFree(pointer);
 
     if (g_debug->config().options() & RECORD_ALLOCS) {
-      g_debug->record->AddEntry(new ReallocEntry(nullptr, bytes, pointer, result.GetStartTimeNS(),
-                                                 result.GetEndTimeNS()));
+      g_debug->record->AddEntry(ReallocEntry(nullptr, bytes, pointer, result.GetStartTimeNS(),
+                                             result.GetEndTimeNS()));
     }
 
     return nullptr;
@@ -910,8 +1049,8 @@ void* debug_realloc(void* pointer, size_t bytes) {
   }
 
   if (g_debug->config().options() & RECORD_ALLOCS) {
-    g_debug->record->AddEntry(new ReallocEntry(new_pointer, bytes, pointer, result.GetStartTimeNS(),
-                                               result.GetEndTimeNS()));
+    g_debug->record->AddEntry(ReallocEntry(new_pointer, bytes, pointer, result.GetStartTimeNS(),
+                                           result.GetEndTimeNS()));
   }
 
   return new_pointer;
@@ -968,7 +1107,7 @@ void* debug_calloc(size_t nmemb, size_t bytes) {
 
   if (g_debug->config().options() & RECORD_ALLOCS) {
     g_debug->record->AddEntry(
-        new CallocEntry(pointer, nmemb, bytes, result.GetStartTimeNS(), result.GetEndTimeNS()));
+        CallocEntry(pointer, nmemb, bytes, result.GetStartTimeNS(), result.GetEndTimeNS()));
   }
 
   if (pointer != nullptr && g_debug->TrackPointers()) {
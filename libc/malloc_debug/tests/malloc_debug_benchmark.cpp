@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+// Measures the cost malloc debug adds to malloc and free when every allocation
+// is tracked, as more threads allocate at the same time.
+
+#include <malloc.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <private/bionic_malloc_dispatch.h>
+
+__BEGIN_DECLS
+
+bool debug_initialize(const MallocDispatch*, bool*, const char*);
+void* debug_malloc(size_t);
+void debug_free(void*);
+
+__END_DECLS
+
+static MallocDispatch dispatch_table = {
+  calloc,
+  free,
+  mallinfo,
+  malloc,
+  malloc_usable_size,
+  memalign,
+  posix_memalign,
+#if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
+  nullptr,
+#endif
+  realloc,
+#if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
+  nullptr,
+#endif
+  nullptr,
+  nullptr,
+  nullptr,
+  mallopt,
+  aligned_alloc,
+  malloc_info,
+};
+
+static bool zygote_child = false;
+
+static void InitMallocDebug(benchmark::State& state) {
+  // Every thread of a benchmark calls this, only the first one to get here
+  // does the initialization.
+  static bool initialized = debug_initialize(&dispatch_table, &zygote_child, "backtrace");
+  if (!initialized) {
+    state.SkipWithError("Failed to initialize malloc debug.");
+  }
+}
+
+static void BM_debug_malloc_free(benchmark::State& state) {
+  InitMallocDebug(state);
+  for (auto _ : state) {
+    void* ptr = debug_malloc(64);
+    benchmark::DoNotOptimize(ptr);
+    debug_free(ptr);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_debug_malloc_free)->ThreadRange(1, 16)->UseRealTime();
+
+// Keeps a set of allocations alive on every thread, so that the tracking
+// tables are not nearly empty while they are being updated.
+static void BM_debug_malloc_free_with_live_allocations(benchmark::State& state) {
+  InitMallocDebug(state);
+  constexpr size_t kLiveAllocations = 1024;
+  std::vector<void*> live(kLiveAllocations);
+  for (size_t i = 0; i < kLiveAllocations; i++) {
+    live[i] = debug_malloc(16 + i % 256);
+  }
+
+  size_t index = 0;
+  for (auto _ : state) {
+    debug_free(live[index]);
+    live[index] = debug_malloc(16 + index % 256);
+    benchmark::DoNotOptimize(live[index]);
+    index = (index + 1) % kLiveAllocations;
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  for (void* ptr : live) {
+    debug_free(ptr);
+  }
+}
+BENCHMARK(BM_debug_malloc_free_with_live_allocations)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -559,6 +559,21 @@ TEST_F(MallocDebugConfigTest, record_allocs) {
   ASSERT_STREQ("", getFakeLogPrint().c_str());
 }
 
+TEST_F(MallocDebugConfigTest, record_allocs_binary) {
+  ASSERT_TRUE(InitConfig("record_allocs_binary=1234")) << getFakeLogPrint();
+  ASSERT_EQ(RECORD_ALLOCS | RECORD_ALLOCS_BINARY, config->options());
+  ASSERT_EQ(1234U, config->record_allocs_num_entries());
+  ASSERT_STREQ("/data/local/tmp/record_allocs.txt", config->record_allocs_file().c_str());
+
+  ASSERT_TRUE(InitConfig("record_allocs_binary")) << getFakeLogPrint();
+  ASSERT_EQ(RECORD_ALLOCS | RECORD_ALLOCS_BINARY, config->options());
+  ASSERT_EQ(8000000U, config->record_allocs_num_entries());
+  ASSERT_STREQ("/data/local/tmp/record_allocs.txt", config->record_allocs_file().c_str());
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
 TEST_F(MallocDebugConfigTest, record_allocs_file) {
   ASSERT_TRUE(InitConfig("record_allocs=1234 record_allocs_file=/fake/file")) << getFakeLogPrint();
   ASSERT_STREQ("/fake/file", config->record_allocs_file().c_str());
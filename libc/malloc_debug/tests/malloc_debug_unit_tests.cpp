@@ -48,6 +48,7 @@
 #include <unwindstack/Unwinder.h>
 
 #include "Config.h"
+#include "RecordData.h"
 #include "malloc_debug.h"
 
 #include "log_fake.h"
@@ -60,6 +61,10 @@ void debug_finalize();
 
 void* debug_malloc(size_t);
 void debug_free(void*);
+size_t debug_malloc_batch(size_t, void**, size_t);
+void debug_free_batch(void**, size_t);
+void debug_free_sized(void*, size_t);
+void debug_free_aligned_sized(void*, size_t, size_t);
 void* debug_calloc(size_t, size_t);
 void* debug_realloc(void*, size_t);
 int debug_posix_memalign(void**, size_t, size_t);
@@ -1329,6 +1334,114 @@ TEST_F(MallocDebugTest, get_malloc_leak_info_multi) {
   ASSERT_STREQ("", getFakeLogPrint().c_str());
 }
 
+TEST_F(MallocDebugTest, backtrace_multiple_thread) {
+  Init("backtrace=16");
+
+  // Every thread uses its own allocation size, and keeps every other
+  // allocation it makes.
+  constexpr size_t kNumThreads = 16;
+  constexpr size_t kNumAllocs = 1000;
+  std::vector<std::vector<void*>> kept(kNumThreads);
+  std::vector<std::thread*> threads(kNumThreads);
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i] = new std::thread([i, &kept]() {
+      for (size_t j = 0; j < kNumAllocs; j++) {
+        void* mem = debug_malloc(16 * (i + 1));
+        write(0, mem, 0);
+        if (j % 2 == 0) {
+          kept[i].push_back(mem);
+        } else {
+          debug_free(mem);
+        }
+      }
+    });
+  }
+  size_t expected_total = 0;
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i]->join();
+    delete threads[i];
+    expected_total += 16 * (i + 1) * kNumAllocs / 2;
+  }
+
+  uint8_t* info;
+  size_t overall_size;
+  size_t info_size;
+  size_t total_memory;
+  size_t backtrace_size;
+
+  debug_get_malloc_leak_info(&info, &overall_size, &info_size, &total_memory, &backtrace_size);
+  ASSERT_TRUE(info != nullptr);
+  ASSERT_EQ(GetInfoEntrySize(16), info_size);
+  ASSERT_EQ(info_size * kNumThreads, overall_size);
+  ASSERT_EQ(expected_total, total_memory);
+  for (size_t i = 0; i < kNumThreads; i++) {
+    InfoEntry* entry = reinterpret_cast<InfoEntry*>(&info[i * info_size]);
+    size_t size = entry->size;
+    size_t num_allocations = entry->num_allocations;
+    // The largest allocations come first.
+    ASSERT_EQ(16 * (kNumThreads - i), size);
+    ASSERT_EQ(kNumAllocs / 2, num_allocations);
+  }
+  debug_free_malloc_leak_info(info);
+
+  for (const auto& pointers : kept) {
+    for (void* pointer : pointers) {
+      debug_free(pointer);
+    }
+  }
+
+  // There should be no pointers that have leaked.
+  debug_finalize();
+  initialized = false;
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, get_malloc_leak_info_many_backtraces) {
+  Init("backtrace=16");
+
+  // Enough distinct backtraces to land in every backtrace shard.
+  constexpr size_t kNumBacktraces = 200;
+  std::vector<void*> pointers(kNumBacktraces);
+  for (size_t i = 0; i < kNumBacktraces; i++) {
+    backtrace_fake_add(std::vector<uintptr_t>{0x1000 + i, 0x2000 + i});
+    pointers[i] = debug_malloc(10 + i);
+    ASSERT_TRUE(pointers[i] != nullptr);
+  }
+
+  uint8_t* info;
+  size_t overall_size;
+  size_t info_size;
+  size_t total_memory;
+  size_t backtrace_size;
+
+  debug_get_malloc_leak_info(&info, &overall_size, &info_size, &total_memory, &backtrace_size);
+  ASSERT_TRUE(info != nullptr);
+  ASSERT_EQ(GetInfoEntrySize(16), info_size);
+  ASSERT_EQ(info_size * kNumBacktraces, overall_size);
+  for (size_t i = 0; i < kNumBacktraces; i++) {
+    InfoEntry* entry = reinterpret_cast<InfoEntry*>(&info[i * info_size]);
+    size_t size = entry->size;
+    size_t num_allocations = entry->num_allocations;
+    uintptr_t frames[3] = {entry->frames[0], entry->frames[1], entry->frames[2]};
+    size_t index = kNumBacktraces - i - 1;
+    ASSERT_EQ(10 + index, size);
+    ASSERT_EQ(1U, num_allocations);
+    ASSERT_EQ(0x1000 + index, frames[0]);
+    ASSERT_EQ(0x2000 + index, frames[1]);
+    ASSERT_EQ(0U, frames[2]);
+  }
+  debug_free_malloc_leak_info(info);
+
+  for (void* pointer : pointers) {
+    debug_free(pointer);
+  }
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
 TEST_F(MallocDebugTest, get_malloc_backtrace_with_header) {
   Init("backtrace=16 guard");
 
@@ -2161,6 +2274,55 @@ TEST_F(MallocDebugTest, debug_posix_memalign) {
   ASSERT_STREQ("", getFakeLogPrint().c_str());
 }
 
+TEST_F(MallocDebugTest, debug_malloc_batch) {
+  Init("guard verify_pointers");
+
+  void* pointers[10];
+  ASSERT_EQ(10U, debug_malloc_batch(100, pointers, 10));
+  for (size_t i = 0; i < 10; i++) {
+    ASSERT_TRUE(pointers[i] != nullptr);
+    ASSERT_LE(100U, debug_malloc_usable_size(pointers[i]));
+    memset(pointers[i], 0, 100);
+  }
+  pointers[5] = nullptr;
+  debug_free_batch(pointers, 10);
+
+  ASSERT_EQ(0U, debug_malloc_batch(SIZE_MAX, pointers, 10));
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, debug_free_sized) {
+  Init("guard");
+
+  debug_free_sized(debug_malloc(100), 100);
+  debug_free_sized(debug_malloc(0), 0);
+  debug_free_sized(debug_calloc(10, 10), 100);
+  debug_free_aligned_sized(debug_aligned_alloc(64, 128), 64, 128);
+  debug_free_sized(nullptr, 0);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, debug_free_sized_wrong_size) {
+  Init("guard");
+
+  void* pointer = debug_malloc(100);
+  ASSERT_TRUE(pointer != nullptr);
+  debug_free_sized(pointer, 50);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  std::string expected_log(DIVIDER);
+  expected_log += android::base::StringPrintf(
+      "6 malloc_debug +++ ALLOCATION %p HAS SIZE 100 BUT 50 WAS PASSED (free_sized)\n", pointer);
+  expected_log += "6 malloc_debug Backtrace at time of failure:\n";
+  expected_log += "6 malloc_debug   Backtrace failed to get any frames.\n";
+  expected_log += DIVIDER;
+  ASSERT_STREQ(expected_log.c_str(), getFakeLogPrint().c_str());
+}
+
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
 TEST_F(MallocDebugTest, debug_pvalloc) {
   Init("guard");
@@ -2187,7 +2349,28 @@ TEST_F(MallocDebugTest, debug_valloc) {
 }
 #endif
 
-void VerifyRecordAllocs(const std::string& record_filename) {
+static void ReadBinaryRecords(const std::string& record_filename, std::string* text) {
+  std::string data;
+  ASSERT_TRUE(android::base::ReadFileToString(record_filename, &data));
+  RecordFileHeader header;
+  ASSERT_LE(sizeof(header), data.size());
+  memcpy(&header, data.data(), sizeof(header));
+  ASSERT_EQ(0, memcmp(kRecordFileMagic, header.magic, sizeof(header.magic)));
+  ASSERT_EQ(kRecordFileVersion, header.version);
+  ASSERT_EQ(sizeof(RecordEntry), header.entry_size);
+  ASSERT_EQ(0U, (data.size() - sizeof(header)) % sizeof(RecordEntry));
+
+  // Convert the records to the text format.
+  TemporaryFile tf;
+  for (size_t offset = sizeof(header); offset < data.size(); offset += sizeof(RecordEntry)) {
+    RecordEntry entry;
+    memcpy(&entry, &data[offset], sizeof(entry));
+    ASSERT_TRUE(entry.Write(tf.fd));
+  }
+  ASSERT_TRUE(android::base::ReadFileToString(tf.path, text));
+}
+
+void VerifyRecordAllocs(const std::string& record_filename, bool binary = false) {
   std::vector<std::string> expected;
 
   void* pointer = debug_malloc(10);
@@ -2250,7 +2433,11 @@ void VerifyRecordAllocs(const std::string& record_filename) {
 
   // Read all of the contents.
   std::string actual;
-  ASSERT_TRUE(android::base::ReadFileToString(record_filename, &actual));
+  if (binary) {
+    ASSERT_NO_FATAL_FAILURE(ReadBinaryRecords(record_filename, &actual));
+  } else {
+    ASSERT_TRUE(android::base::ReadFileToString(record_filename, &actual));
+  }
 
   VerifyRecords(expected, actual);
 
@@ -2415,6 +2602,216 @@ TEST_F(MallocDebugTest, record_allocs_write_entries_does_not_allocate) {
   ASSERT_STREQ("", getFakeLogPrint().c_str());
 }
 
+TEST_F(MallocDebugTest, record_allocs_binary) {
+  InitRecordAllocs("record_allocs_binary");
+
+  VerifyRecordAllocs(record_filename, true);
+}
+
+TEST_F(MallocDebugTest, record_allocs_binary_with_header) {
+  InitRecordAllocs("record_allocs_binary front_guard");
+
+  VerifyRecordAllocs(record_filename, true);
+}
+
+TEST_F(MallocDebugTest, record_allocs_binary_max) {
+  InitRecordAllocs("record_allocs_binary=5");
+
+  std::vector<std::string> expected;
+
+  void* pointer = debug_malloc(10);
+  ASSERT_TRUE(pointer != nullptr);
+  expected.push_back(android::base::StringPrintf("%d: malloc %p 10", getpid(), pointer));
+  debug_free(pointer);
+  expected.push_back(android::base::StringPrintf("%d: free %p", getpid(), pointer));
+
+  pointer = debug_malloc(20);
+  ASSERT_TRUE(pointer != nullptr);
+  expected.push_back(android::base::StringPrintf("%d: malloc %p 20", getpid(), pointer));
+  debug_free(pointer);
+  expected.push_back(android::base::StringPrintf("%d: free %p", getpid(), pointer));
+
+  pointer = debug_malloc(1024);
+  ASSERT_TRUE(pointer != nullptr);
+  expected.push_back(android::base::StringPrintf("%d: malloc %p 1024", getpid(), pointer));
+  debug_free(pointer);
+
+  // Dump all of the data accumulated so far.
+  ASSERT_TRUE(kill(getpid(), SIGRTMAX - 18) == 0);
+
+  // Nothing is recorded after the maximum is reached.
+  pointer = debug_malloc(2048);
+  ASSERT_TRUE(pointer != nullptr);
+  debug_free(pointer);
+  ASSERT_TRUE(kill(getpid(), SIGRTMAX - 18) == 0);
+
+  std::string actual;
+  ASSERT_NO_FATAL_FAILURE(ReadBinaryRecords(record_filename, &actual));
+
+  VerifyRecords(expected, actual);
+  ASSERT_EQ(5, std::count(actual.begin(), actual.end(), '\n'));
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ(
+      "4 malloc_debug Maximum number of records added, all new operations will be dropped.\n",
+      getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, record_allocs_binary_thread_done) {
+  InitRecordAllocs("record_allocs_binary");
+
+  static pid_t tid = 0;
+  static void* pointer = nullptr;
+  std::thread thread([](){
+    tid = gettid();
+    pointer = debug_malloc(100);
+    write(0, pointer, 0);
+    debug_free(pointer);
+  });
+  thread.join();
+
+  std::vector<std::string> expected;
+  expected.push_back(android::base::StringPrintf("%d: malloc %p 100", tid, pointer));
+  expected.push_back(android::base::StringPrintf("%d: free %p", tid, pointer));
+  expected.push_back(android::base::StringPrintf("%d: thread_done 0x0", tid));
+
+  // The buffer of the thread is used by the next thread, after the records
+  // of the first thread.
+  static pid_t next_tid = 0;
+  static void* next_pointer = nullptr;
+  std::thread next_thread([](){
+    next_tid = gettid();
+    next_pointer = debug_malloc(200);
+    write(0, next_pointer, 0);
+    debug_free(next_pointer);
+  });
+  next_thread.join();
+
+  expected.push_back(android::base::StringPrintf("%d: malloc %p 200", next_tid, next_pointer));
+  expected.push_back(android::base::StringPrintf("%d: free %p", next_tid, next_pointer));
+  expected.push_back(android::base::StringPrintf("%d: thread_done 0x0", next_tid));
+
+  // Dump all of the data accumulated so far.
+  ASSERT_TRUE(kill(getpid(), SIGRTMAX - 18) == 0);
+
+  std::string actual;
+  ASSERT_NO_FATAL_FAILURE(ReadBinaryRecords(record_filename, &actual));
+
+  VerifyRecords(expected, actual);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, record_allocs_binary_flush_on_threshold) {
+  InitRecordAllocs("record_allocs_binary");
+
+  // No signal is sent, the records are written once enough of them are
+  // in the thread's buffer.
+  std::vector<std::string> expected;
+  for (size_t i = 0; i < RecordBuffer::kFlushEntries / 2; i++) {
+    void* pointer = debug_malloc(10 + i);
+    ASSERT_TRUE(pointer != nullptr);
+    expected.push_back(android::base::StringPrintf("%d: malloc %p %zu", getpid(), pointer, 10 + i));
+    debug_free(pointer);
+    expected.push_back(android::base::StringPrintf("%d: free %p", getpid(), pointer));
+  }
+
+  std::string actual;
+  ASSERT_NO_FATAL_FAILURE(ReadBinaryRecords(record_filename, &actual));
+
+  VerifyRecords(expected, actual);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, record_allocs_binary_flush_on_finalize) {
+  InitRecordAllocs("record_allocs_binary");
+
+  std::vector<std::string> expected;
+
+  void* pointer = debug_malloc(10);
+  ASSERT_TRUE(pointer != nullptr);
+  expected.push_back(android::base::StringPrintf("%d: malloc %p 10", getpid(), pointer));
+  debug_free(pointer);
+  expected.push_back(android::base::StringPrintf("%d: free %p", getpid(), pointer));
+
+  debug_finalize();
+  initialized = false;
+
+  std::string actual;
+  ASSERT_NO_FATAL_FAILURE(ReadBinaryRecords(record_filename, &actual));
+
+  VerifyRecords(expected, actual);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, record_allocs_binary_fork_before_flush) {
+  InitRecordAllocs("record_allocs_binary");
+
+  // Fork while the records are still in the parent's buffer, before anything
+  // has been written to the file.
+  void* pointer = debug_malloc(10);
+  ASSERT_TRUE(pointer != nullptr);
+  debug_free(pointer);
+
+  pid_t pid;
+  if ((pid = fork()) == 0) {
+    debug_free(debug_malloc(20));
+    debug_finalize();
+    _exit(0);
+  }
+  ASSERT_NE(-1, pid);
+  int status;
+  ASSERT_EQ(pid, TEMP_FAILURE_RETRY(waitpid(pid, &status, 0)));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+
+  // Dump the parent's records after the child's.
+  ASSERT_TRUE(kill(getpid(), SIGRTMAX - 18) == 0);
+
+  std::string actual;
+  ASSERT_NO_FATAL_FAILURE(ReadBinaryRecords(record_filename, &actual));
+
+  // The child appends its own records, and the records made before the fork
+  // are only written by the parent.
+  ASSERT_EQ(4, std::count(actual.begin(), actual.end(), '\n'));
+  std::string child_prefix = android::base::StringPrintf("%d: malloc ", pid);
+  ASSERT_EQ(0U, actual.find(child_prefix)) << actual;
+  std::string parent_malloc = android::base::StringPrintf("%d: malloc %p 10", getpid(), pointer);
+  ASSERT_NE(std::string::npos, actual.find(parent_malloc)) << actual;
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, record_allocs_binary_write_entries_does_not_allocate) {
+  InitRecordAllocs("record_allocs_binary");
+
+  std::vector<std::string> expected;
+
+  void* pointer = debug_malloc(10);
+  ASSERT_TRUE(pointer != nullptr);
+  expected.push_back(android::base::StringPrintf("%d: malloc %p 10", getpid(), pointer));
+  debug_free(pointer);
+  expected.push_back(android::base::StringPrintf("%d: free %p", getpid(), pointer));
+
+  malloc_disable();
+  kill(getpid(), SIGRTMAX - 18);
+  malloc_enable();
+
+  std::string actual;
+  ASSERT_NO_FATAL_FAILURE(ReadBinaryRecords(record_filename, &actual));
+
+  VerifyRecords(expected, actual);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
 TEST_F(MallocDebugTest, verify_pointers) {
   Init("verify_pointers");
 
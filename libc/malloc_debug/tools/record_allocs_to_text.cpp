@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+// Converts a file written by the malloc debug record_allocs_binary option
+// to the text format written by the record_allocs option.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <android-base/file.h>
+#include <android-base/unique_fd.h>
+
+#include "RecordEntry.h"
+
+static int Usage(const char* name) {
+  fprintf(stderr, "usage: %s BINARY_RECORD_FILE [TEXT_RECORD_FILE]\n", name);
+  fprintf(stderr, "  Writes to stdout if TEXT_RECORD_FILE is not given.\n");
+  return 1;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 2 && argc != 3) {
+    return Usage(argv[0]);
+  }
+
+  android::base::unique_fd in_fd(open(argv[1], O_RDONLY | O_CLOEXEC));
+  if (in_fd == -1) {
+    fprintf(stderr, "Cannot open %s: %s\n", argv[1], strerror(errno));
+    return 1;
+  }
+
+  RecordFileHeader header;
+  if (!android::base::ReadFully(in_fd, &header, sizeof(header))) {
+    fprintf(stderr, "Cannot read the header of %s\n", argv[1]);
+    return 1;
+  }
+  if (memcmp(header.magic, kRecordFileMagic, sizeof(header.magic)) != 0) {
+    fprintf(stderr, "%s is not a binary record file\n", argv[1]);
+    return 1;
+  }
+  if (header.version != kRecordFileVersion || header.entry_size != sizeof(RecordEntry)) {
+    fprintf(stderr, "%s has unsupported version %u, entry size %u\n", argv[1], header.version,
+            header.entry_size);
+    return 1;
+  }
+
+  android::base::unique_fd out_fd;
+  if (argc == 3) {
+    out_fd.reset(open(argv[2], O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if (out_fd == -1) {
+      fprintf(stderr, "Cannot create %s: %s\n", argv[2], strerror(errno));
+      return 1;
+    }
+  } else {
+    out_fd.reset(dup(STDOUT_FILENO));
+  }
+
+  std::vector<RecordEntry> entries;
+  std::string data;
+  if (!android::base::ReadFdToString(in_fd, &data)) {
+    fprintf(stderr, "Failed to read %s: %s\n", argv[1], strerror(errno));
+    return 1;
+  }
+  if (data.size() % sizeof(RecordEntry) != 0) {
+    fprintf(stderr, "%s ends with a partial record\n", argv[1]);
+    return 1;
+  }
+  entries.resize(data.size() / sizeof(RecordEntry));
+  memcpy(entries.data(), data.data(), data.size());
+
+  // The records of each thread are in order in the file, but the records of
+  // different threads are not. Put them in the order that the operations
+  // completed, which is the order the text format uses. A thread_done record
+  // has no times, so give it the time of the previous record of its thread.
+  std::unordered_map<int32_t, uint64_t> last_end_ns;
+  for (RecordEntry& entry : entries) {
+    if (entry.type == RecordType::kThreadDone) {
+      entry.start_ns = entry.end_ns = last_end_ns[entry.tid];
+    } else {
+      last_end_ns[entry.tid] = entry.end_ns;
+    }
+  }
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const RecordEntry& a, const RecordEntry& b) { return a.end_ns < b.end_ns; });
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (!entries[i].Write(out_fd)) {
+      fprintf(stderr, "Failed to write record %zu\n", i);
+      return 1;
+    }
+  }
+  return 0;
+}
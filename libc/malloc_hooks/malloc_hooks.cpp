@@ -60,6 +60,10 @@ size_t hooks_malloc_usable_size(void* pointer);
 void* hooks_malloc(size_t size);
 int hooks_malloc_info(int options, FILE* fp);
 void hooks_free(void* pointer);
+size_t hooks_malloc_batch(size_t size, void** pointers, size_t count);
+void hooks_free_batch(void** pointers, size_t count);
+void hooks_free_sized(void* pointer, size_t size);
+void hooks_free_aligned_sized(void* pointer, size_t alignment, size_t size);
 void* hooks_memalign(size_t alignment, size_t bytes);
 void* hooks_aligned_alloc(size_t alignment, size_t bytes);
 void* hooks_realloc(void* pointer, size_t bytes);
@@ -139,6 +143,48 @@ void hooks_free(void* pointer) {
   return g_dispatch->free(pointer);
 }
 
+size_t hooks_malloc_batch(size_t size, void** pointers, size_t count) {
+  if ((__malloc_hook != nullptr && __malloc_hook != default_malloc_hook) ||
+      g_dispatch->malloc_batch == nullptr) {
+    // The hook sees every allocation.
+    for (size_t i = 0; i < count; i++) {
+      pointers[i] = hooks_malloc(size);
+      if (pointers[i] == nullptr) {
+        return i;
+      }
+    }
+    return count;
+  }
+  return g_dispatch->malloc_batch(size, pointers, count);
+}
+
+void hooks_free_batch(void** pointers, size_t count) {
+  if ((__free_hook != nullptr && __free_hook != default_free_hook) ||
+      g_dispatch->free_batch == nullptr) {
+    for (size_t i = 0; i < count; i++) {
+      hooks_free(pointers[i]);
+    }
+    return;
+  }
+  return g_dispatch->free_batch(pointers, count);
+}
+
+void hooks_free_sized(void* pointer, size_t size) {
+  if ((__free_hook != nullptr && __free_hook != default_free_hook) ||
+      g_dispatch->free_sized == nullptr) {
+    return hooks_free(pointer);
+  }
+  return g_dispatch->free_sized(pointer, size);
+}
+
+void hooks_free_aligned_sized(void* pointer, size_t alignment, size_t size) {
+  if ((__free_hook != nullptr && __free_hook != default_free_hook) ||
+      g_dispatch->free_aligned_sized == nullptr) {
+    return hooks_free(pointer);
+  }
+  return g_dispatch->free_aligned_sized(pointer, alignment, size);
+}
+
 void* hooks_memalign(size_t alignment, size_t bytes) {
   if (__memalign_hook != nullptr && __memalign_hook != default_memalign_hook) {
     return __memalign_hook(alignment, bytes, __builtin_return_address(0));
@@ -255,6 +255,60 @@ TEST_F(MallocHooksTest, DISABLED_free_hook) {
   EXPECT_TRUE(void_arg_ != nullptr) << "The free hook was called with a nullptr.";
 }
 
+TEST_F(MallocHooksTest, malloc_batch_hook) {
+  RunTest("*.DISABLED_malloc_batch_hook");
+}
+
+TEST_F(MallocHooksTest, DISABLED_malloc_batch_hook) {
+  Init();
+  ASSERT_TRUE(__malloc_hook != nullptr);
+  __malloc_hook = test_malloc_hook;
+
+  void* ptrs[4];
+  ASSERT_EQ(4U, malloc_batch(1024, ptrs, 4));
+  write(0, ptrs[0], 0);
+  free_batch(ptrs, 4);
+
+  EXPECT_TRUE(malloc_hook_called_) << "The malloc hook was not called.";
+  EXPECT_TRUE(void_arg_ != nullptr) << "The malloc hook was called with a nullptr.";
+}
+
+TEST_F(MallocHooksTest, free_batch_hook) {
+  RunTest("*.DISABLED_free_batch_hook");
+}
+
+TEST_F(MallocHooksTest, DISABLED_free_batch_hook) {
+  Init();
+  ASSERT_TRUE(__free_hook != nullptr);
+  __free_hook = test_free_hook;
+
+  void* ptrs[4];
+  ASSERT_EQ(4U, malloc_batch(1024, ptrs, 4));
+  free_batch(ptrs, 4);
+  write(0, ptrs[0], 0);
+
+  EXPECT_TRUE(free_hook_called_) << "The free hook was not called.";
+  EXPECT_TRUE(void_arg_ != nullptr) << "The free hook was called with a nullptr.";
+}
+
+TEST_F(MallocHooksTest, free_sized_hook) {
+  RunTest("*.DISABLED_free_sized_hook");
+}
+
+TEST_F(MallocHooksTest, DISABLED_free_sized_hook) {
+  Init();
+  ASSERT_TRUE(__free_hook != nullptr);
+  __free_hook = test_free_hook;
+
+  void* ptr = malloc(1024);
+  ASSERT_TRUE(ptr != nullptr);
+  free_sized(ptr, 1024);
+  write(0, ptr, 0);
+
+  EXPECT_TRUE(free_hook_called_) << "The free hook was not called.";
+  EXPECT_TRUE(void_arg_ != nullptr) << "The free hook was called with a nullptr.";
+}
+
 TEST_F(MallocHooksTest, realloc_hook) {
   RunTest("*.DISABLED_realloc_hook");
 }
@@ -59,10 +59,12 @@ private:
   // Offsets to various Bionic TLS structs from the beginning of static TLS.
   size_t offset_bionic_tcb_ = SIZE_MAX;
   size_t offset_bionic_tls_ = SIZE_MAX;
+  size_t offset_rseq_ = SIZE_MAX;
 
 public:
   size_t offset_bionic_tcb() const { return offset_bionic_tcb_; }
   size_t offset_bionic_tls() const { return offset_bionic_tls_; }
+  size_t offset_rseq() const { return offset_rseq_; }
   size_t offset_thread_pointer() const;
 
   size_t size() const { return offset_; }
@@ -74,6 +76,11 @@ public:
   size_t reserve_solib_segment(const TlsSegment& segment) {
     return reserve(segment.size, segment.alignment);
   }
+  // Reserves space for the TLS segments of solibs that are loaded once threads
+  // can exist. Returns the offset of the reserved space.
+  size_t reserve_surplus(size_t size) {
+    return reserve(size, 1);
+  }
   void finish_layout();
 
 private:
@@ -134,7 +141,8 @@ struct TlsModules {
   _Atomic(size_t) generation = kTlsGenerationFirst;
   _Atomic(size_t) *generation_libc_so = nullptr;
 
-  // Access to the TlsModule[] table requires taking this lock.
+  // Access to the TlsModule[] table requires taking this lock. The linker and libc.so both
+  // lock it, so it can't be reader-biased (see pthread_rwlock.cpp).
   pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
 
   // Pointer to a block of TlsModule objects. The first module has ID 1 and
@@ -149,6 +157,11 @@ struct TlsModules {
   // Callback to be invoked before a dynamic TLS deallocation.
   dtls_listener_t on_destruction_cb = nullptr;
 
+  // Callback that initializes a module's memory in the static TLS of every
+  // existing thread. The dynamic linker uses it to place a dlopen'ed module in
+  // the static TLS surplus. Provided by libc.so.
+  void (*init_static_tls_module_cb)(const TlsModule& module) = nullptr;
+
   // The first thread-exit callback; inlined to avoid allocation.
   thread_exit_cb_t first_thread_exit_callback = nullptr;
 
@@ -157,6 +170,7 @@ struct TlsModules {
 };
 
 void __init_static_tls(void* static_tls);
+void __init_static_tls_module(void* static_tls, const TlsModule& module);
 
 // Dynamic Thread Vector. Each thread has a different DTV. For each module
 // (executable or solib), the DTV has a pointer to that module's TLS memory. The
@@ -199,6 +213,7 @@ struct TlsIndex {
 extern "C" void* TLS_GET_ADDR(const TlsIndex* ti) TLS_GET_ADDR_CCONV;
 
 struct bionic_tcb;
+bool __is_static_tls_block(bionic_tcb* tcb, const void* block);
 void __free_dynamic_tls(bionic_tcb* tcb);
 void __notify_thread_exit_callbacks();
 
@@ -70,6 +70,22 @@ static inline int __futex_wait_ex(volatile void* ftx, bool shared, int value) {
 __LIBC_HIDDEN__ int __futex_wait_ex(volatile void* ftx, bool shared, int value,
                                     bool use_realtime_clock, const timespec* abs_timeout);
 
+// Wakes up to wake_count waiters on ftx and moves up to requeue_count of the rest to wait on ftx2
+// instead, if ftx still holds value. Returns -EAGAIN if it doesn't.
+static inline int __futex_cmp_requeue_ex(volatile void* ftx, bool shared, int wake_count,
+                                         int requeue_count, volatile void* ftx2, int value) {
+  int saved_errno = errno;
+  // The kernel takes requeue_count in the timeout argument.
+  int result = syscall(__NR_futex, ftx, shared ? FUTEX_CMP_REQUEUE : FUTEX_CMP_REQUEUE_PRIVATE,
+                       wake_count, reinterpret_cast<void*>(static_cast<uintptr_t>(requeue_count)),
+                       ftx2, value);
+  if (__predict_false(result == -1)) {
+    result = -errno;
+    errno = saved_errno;
+  }
+  return result;
+}
+
 static inline int __futex_pi_unlock(volatile void* ftx, bool shared) {
   return __futex(ftx, shared ? FUTEX_UNLOCK_PI : FUTEX_UNLOCK_PI_PRIVATE, 0, nullptr, 0);
 }
@@ -32,6 +32,54 @@
 #include "private/bionic_futex.h"
 #include "platform/bionic/macros.h"
 
+static inline __always_inline void __spin_pause() {
+#if defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield" ::: "memory");
+#elif defined(__i386__) || defined(__x86_64__)
+  __asm__ __volatile__("pause" ::: "memory");
+#elif defined(__riscv)
+  // The Zihintpause "pause" instruction, which is a no-op fence on older cores.
+  __asm__ __volatile__(".insn i 0x0f, 0, x0, x0, 0x010" ::: "memory");
+#endif
+}
+
+// A contended lock is worth spinning on for a little while before sleeping,
+// because a futex wait and wake take far longer than a short critical section.
+// Locks only spin if they opt in, because spinning on a lock that is held for a
+// long time just burns CPU (and battery) before sleeping anyway.
+//
+// How long to spin adapts to how long the lock has recently been held: *estimate
+// is a moving average of the spins it took to get the lock, and we spin for up
+// to about twice that, but never more than kMaxAdaptiveSpins. A spin that gives
+// up counts as kMaxAdaptiveSpins, so the estimate decays toward what every
+// contended acquisition observed.
+//
+// Returns true if try_lock() succeeded.
+static constexpr uint16_t kMaxAdaptiveSpins = 100;
+
+template <typename TryLockFn>
+static inline bool __adaptive_spin(uint16_t* estimate, TryLockFn try_lock) {
+  int max_spins = *estimate * 2 + 10;
+  if (max_spins > kMaxAdaptiveSpins) max_spins = kMaxAdaptiveSpins;
+  int spins = 0;
+  bool acquired = false;
+  while (spins < max_spins) {
+    ++spins;
+    __spin_pause();
+    if (try_lock()) {
+      acquired = true;
+      break;
+    }
+  }
+
+  int observed = acquired ? spins : kMaxAdaptiveSpins;
+  int est = *estimate;
+  est += (observed - est) / 8;
+  if (est > kMaxAdaptiveSpins) est = kMaxAdaptiveSpins;
+  *estimate = est;
+  return acquired;
+}
+
 // Lock is used in places like pthread_rwlock_t, which can be initialized without calling
 // an initialization function. So make sure Lock can be initialized by setting its memory to 0.
 class Lock {
@@ -43,11 +91,18 @@ class Lock {
   };
   _Atomic(LockState) state;
   bool process_shared;
+  // kAdaptiveSpinFlag if the lock spins before sleeping, together with the estimate
+  // __adaptive_spin keeps. Zero, so not spinning, for a zero-initialized Lock.
+  _Atomic(uint16_t) spin_state;
+
+  static constexpr uint16_t kAdaptiveSpinFlag = 0x8000;
 
  public:
-  void init(bool process_shared) {
+  // Only pass adaptive_spin for locks whose critical sections are always short.
+  void init(bool process_shared, bool adaptive_spin = false) {
     atomic_init(&state, Unlocked);
     this->process_shared = process_shared;
+    atomic_init(&spin_state, adaptive_spin ? kAdaptiveSpinFlag : 0);
   }
 
   bool trylock() {
@@ -62,8 +117,18 @@ class Lock {
                          LockedWithoutWaiter, memory_order_acquire, memory_order_relaxed))) {
       return;
     }
+    uint16_t old_spin_state = atomic_load_explicit(&spin_state, memory_order_relaxed);
+    if (old_spin_state & kAdaptiveSpinFlag) {
+      uint16_t estimate = old_spin_state & ~kAdaptiveSpinFlag;
+      bool acquired = __adaptive_spin(&estimate, [this]() {
+        return atomic_load_explicit(&state, memory_order_relaxed) == Unlocked && trylock();
+      });
+      atomic_store_explicit(&spin_state, static_cast<uint16_t>(kAdaptiveSpinFlag | estimate),
+                            memory_order_relaxed);
+      if (acquired) return;
+    }
+
     while (atomic_exchange_explicit(&state, LockedWithWaiter, memory_order_acquire) != Unlocked) {
-      // TODO: As the critical section is brief, it is a better choice to spin a few times befor sleeping.
       __futex_wait_ex(&state, process_shared, LockedWithWaiter);
     }
     return;
@@ -49,6 +49,10 @@ typedef void (*MallocMallocDisable)();
 typedef void (*MallocMallocEnable)();
 typedef int (*MallocMallopt)(int, int);
 typedef void* (*MallocAlignedAlloc)(size_t, size_t);
+typedef size_t (*MallocMallocBatch)(size_t, void**, size_t);
+typedef void (*MallocFreeBatch)(void**, size_t);
+typedef void (*MallocFreeSized)(void*, size_t);
+typedef void (*MallocFreeAlignedSized)(void*, size_t, size_t);
 
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
 typedef void* (*MallocPvalloc)(size_t);
@@ -76,6 +80,12 @@ struct MallocDispatch {
   MallocMallopt mallopt;
   MallocAlignedAlloc aligned_alloc;
   MallocMallocInfo malloc_info;
+  // The functions below are optional, and may be null. Callers fall back on
+  // malloc and free when they are.
+  MallocMallocBatch malloc_batch;
+  MallocFreeBatch free_batch;
+  MallocFreeSized free_sized;
+  MallocFreeAlignedSized free_aligned_sized;
 } __attribute__((aligned(32)));
 
 #endif
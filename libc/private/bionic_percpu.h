@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#pragma once
+
+#include <linux/rseq.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+#include "bionic/pthread_internal.h"
+#include "platform/bionic/tls.h"
+#include "private/bionic_lock.h"
+
+// The current CPU, for libc internals.
+//
+// Unless LIBC_DISABLE_RSEQ=1 is set when the process starts, every thread registers an rseq area
+// with the kernel as it starts, and the kernel then keeps the area's cpu_id up to date whenever
+// the thread is scheduled, so finding the current CPU is a load rather than a getcpu() call.
+// The area is in static TLS, at __rseq_offset from the thread pointer, so code written for
+// glibc's rseq registration can share it rather than failing to register its own.
+//
+// The thread can migrate as soon as it has read its CPU, so callers must only use it to spread
+// work out, not to assume they have data to themselves. Only a restartable sequence (below) can
+// rely on staying on the CPU it read.
+
+// The kernel checks that the four bytes before the abort handler of a restartable sequence are the
+// signature the area was registered with. These are the values glibc uses: each is an instruction
+// that traps, so the signature itself can't be executed by mistake.
+#if defined(__aarch64__)
+#define RSEQ_SIG 0xd428bc00  // brk #0x45e0
+#elif defined(__arm__)
+#define RSEQ_SIG 0xe7f5def3  // udf #24035
+#elif defined(__i386__) || defined(__x86_64__)
+#define RSEQ_SIG 0x53053053
+#elif defined(__riscv)
+#define RSEQ_SIG 0xf1401073  // csrr mhartid, x0
+#endif
+
+// Exported from libc.so, and declared const in <sys/rseq.h>. The dynamic linker has its own copy.
+extern "C" ptrdiff_t __rseq_offset;
+extern "C" unsigned int __rseq_size;
+extern "C" unsigned int __rseq_flags;
+
+// Registers the main thread's rseq area, once the main thread is using its final static TLS.
+// This decides whether any thread registers an area.
+__LIBC_HIDDEN__ void __libc_init_rseq_main_thread();
+
+// Sets up libc.so's copy of the rseq globals, from the main thread's registration by the
+// dynamic linker.
+__LIBC_HIDDEN__ void __libc_init_rseq_from_linker();
+
+// Registers the calling thread's rseq area. Each new thread calls this as it starts.
+__LIBC_HIDDEN__ void __rseq_register_current_thread();
+
+// Unregisters the calling thread's rseq area. A thread that frees its own static TLS must call
+// this first.
+__LIBC_HIDDEN__ void __rseq_unregister_current_thread();
+
+static inline __always_inline struct rseq* __get_rseq_area() {
+  return reinterpret_cast<struct rseq*>(reinterpret_cast<char*>(__get_tls()) + __rseq_offset);
+}
+
+// Returns the CPU the calling thread was running on a moment ago, or a negative value if the
+// thread has no registered rseq area.
+static inline __always_inline int __get_rseq_cpu() {
+  if (__predict_false(__rseq_size == 0)) {
+    return -1;
+  }
+  // The kernel stores negative RSEQ_CPU_ID_* values until registration succeeds.
+  return static_cast<int>(__atomic_load_n(&__get_rseq_area()->cpu_id, __ATOMIC_RELAXED));
+}
+
+// Returns one of `shard_count` shards for the calling thread, so that threads on different CPUs
+// tend to use different shards. Without rseq, the thread id spreads threads out nearly as well,
+// without the cost of a getcpu() call.
+static inline __always_inline size_t __get_current_cpu_shard(size_t shard_count) {
+  int cpu = __get_rseq_cpu();
+  if (__predict_true(cpu >= 0)) {
+    return static_cast<size_t>(cpu) % shard_count;
+  }
+  return static_cast<unsigned>(__get_thread()->tid) % shard_count;
+}
+
+// Restartable sequences.
+//
+// A restartable sequence runs from label 1 to its final store at label 2, and the kernel jumps to
+// the abort handler at label 4 instead of letting it continue if the thread is preempted,
+// migrated or signalled in between. Data that only the current CPU's sequences write can
+// therefore be updated with plain loads and stores, as long as the sequence first checks that
+// it's still running on the CPU the data belongs to.
+//
+// Only 64-bit architectures have these, because a sequence commits with a single word-sized
+// store. Elsewhere, and for threads without a registered area, callers fall back to atomics.
+#if defined(__aarch64__) || defined(__x86_64__)
+#define __BIONIC_HAVE_RSEQ_CS 1
+
+// The struct rseq_cs describing the sequence, which the kernel finds through the area's rseq_cs.
+#define __RSEQ_ASM_DEFINE_CS        \
+  ".pushsection __rseq_cs, \"aw\"\n" \
+  ".balign 32\n"                     \
+  "3:\n"                             \
+  ".long 0, 0\n"                     \
+  ".quad 1f, (2f - 1f), 4f\n"        \
+  ".popsection\n"
+
+#if defined(__aarch64__)
+#define __RSEQ_ASM_START            \
+  __RSEQ_ASM_DEFINE_CS              \
+  "adrp x15, 3b\n"                  \
+  "add x15, x15, :lo12:3b\n"        \
+  "str x15, %[rseq_cs]\n"           \
+  "1:\n"                            \
+  "ldr w15, %[current_cpu]\n"       \
+  "cmp w15, %w[cpu]\n"              \
+  "bne 4f\n"
+#define __RSEQ_ASM_ABORT            \
+  "b 5f\n"                          \
+  ".inst " ___STRING(RSEQ_SIG) "\n" \
+  "4:\n"                            \
+  "b %l[abort]\n"                   \
+  "5:\n"
+#define __RSEQ_ASM_SCRATCH "x15"
+#else
+#define __RSEQ_ASM_START            \
+  __RSEQ_ASM_DEFINE_CS              \
+  "leaq 3b(%%rip), %%rax\n"         \
+  "movq %%rax, %[rseq_cs]\n"        \
+  "1:\n"                            \
+  "cmpl %[cpu], %[current_cpu]\n"   \
+  "jnz 4f\n"
+// The signature is the immediate of a ud1, so that disassemblers stay in step.
+#define __RSEQ_ASM_ABORT                      \
+  ".pushsection __rseq_failure, \"ax\"\n"     \
+  ".byte 0x0f, 0xb9, 0x3d\n"                  \
+  ".long " ___STRING(RSEQ_SIG) "\n"           \
+  "4:\n"                                      \
+  "jmp %l[abort]\n"                           \
+  ".popsection\n"
+#define __RSEQ_ASM_SCRATCH "rax"
+#endif
+
+// Stores `new_value` to `*p` if `*p` is still `expected` and the calling thread is running on
+// `cpu`. Returns 0 if it did, 1 if `*p` wasn't `expected`, and -1 if the thread wasn't on `cpu` or
+// was interrupted.
+static inline __always_inline int __rseq_cmpeqv_storev(intptr_t* p, intptr_t expected,
+                                                       intptr_t new_value, int cpu) {
+  struct rseq* area = __get_rseq_area();
+  __asm__ __volatile__ goto(
+      __RSEQ_ASM_START
+#if defined(__aarch64__)
+      "ldr x15, %[p]\n"
+      "cmp x15, %[expected]\n"
+      "bne %l[cmpfail]\n"
+      "str %[new_value], %[p]\n"
+#else
+      "cmpq %[p], %[expected]\n"
+      "jnz %l[cmpfail]\n"
+      "movq %[new_value], %[p]\n"
+#endif
+      "2:\n"
+      __RSEQ_ASM_ABORT
+      :
+      : [cpu] "r"(cpu), [current_cpu] "m"(area->cpu_id), [rseq_cs] "m"(area->rseq_cs),
+        [p] "m"(*p), [expected] "r"(expected), [new_value] "r"(new_value)
+      : "memory", "cc", __RSEQ_ASM_SCRATCH
+      : abort, cmpfail);
+  return 0;
+abort:
+  return -1;
+cmpfail:
+  return 1;
+}
+
+// Pops the first node from the list at `*head` if the calling thread is running on `cpu`: if
+// `*head` isn't null, sets `*node` to it and `*head` to the word `next_offset` bytes into it.
+// Returns 0 if it did, 1 if the list was empty, and -1 if the thread wasn't on `cpu` or was
+// interrupted. Both loads are inside the sequence, so a concurrent pop and push of the same
+// node on this CPU can't make it link in a stale next pointer.
+static inline __always_inline int __rseq_pop(intptr_t* head, ptrdiff_t next_offset, int cpu,
+                                             intptr_t* node) {
+  struct rseq* area = __get_rseq_area();
+  __asm__ __volatile__ goto(
+      __RSEQ_ASM_START
+#if defined(__aarch64__)
+      "ldr x15, %[head]\n"
+      "cbz x15, %l[empty]\n"
+      "str x15, %[node]\n"
+      "ldr x15, [x15, %[next_offset]]\n"
+      "str x15, %[head]\n"
+#else
+      "movq %[head], %%rax\n"
+      "testq %%rax, %%rax\n"
+      "jz %l[empty]\n"
+      "movq %%rax, %[node]\n"
+      "movq (%%rax, %[next_offset]), %%rax\n"
+      "movq %%rax, %[head]\n"
+#endif
+      "2:\n"
+      __RSEQ_ASM_ABORT
+      :
+      : [cpu] "r"(cpu), [current_cpu] "m"(area->cpu_id), [rseq_cs] "m"(area->rseq_cs),
+        [head] "m"(*head), [node] "m"(*node), [next_offset] "r"(next_offset)
+      : "memory", "cc", __RSEQ_ASM_SCRATCH
+      : abort, empty);
+  return 0;
+abort:
+  return -1;
+empty:
+  return 1;
+}
+#endif
+
+// Returns the CPU the calling thread can use a restartable sequence on, or -1 if it must use the
+// fallback instead: without rseq, or on a CPU numbered `cpu_count` or higher.
+static inline __always_inline int __get_rseq_cs_cpu(size_t cpu_count) {
+#if defined(__BIONIC_HAVE_RSEQ_CS)
+  int cpu = __get_rseq_cpu();
+  if (__predict_true(cpu >= 0 && static_cast<size_t>(cpu) < cpu_count)) {
+    return cpu;
+  }
+#else
+  (void)cpu_count;
+#endif
+  return -1;
+}
+
+// The shard of the fallback data for the calling thread, for use without a restartable sequence.
+static inline __always_inline size_t __get_fallback_shard(size_t shard_count) {
+  int cpu = sched_getcpu();
+  return cpu < 0 ? 0 : static_cast<size_t>(cpu) % shard_count;
+}
+
+// A counter that is cheap to update from many threads at once, but expensive to read.
+// Zero-initialized memory is a valid PerCpuCounter.
+//
+// With rseq, each of the first kCpuCount CPUs has a slot that only restartable sequences running
+// on that CPU update, without atomics. Other updates go to a separate set of atomic slots chosen
+// by sched_getcpu(): they can't share the per-CPU slots, because a plain store on one CPU would
+// lose an atomic increment made on another.
+template <size_t kCpuCount = 32>
+class PerCpuCounter {
+ public:
+  void add(int64_t delta) {
+#if defined(__BIONIC_HAVE_RSEQ_CS)
+    for (int cpu; (cpu = __get_rseq_cs_cpu(kCpuCount)) >= 0;) {
+      intptr_t* value = &cpu_slots_[cpu].value;
+      intptr_t old_value = __atomic_load_n(value, __ATOMIC_RELAXED);
+      if (__rseq_cmpeqv_storev(value, old_value, old_value + delta, cpu) == 0) return;
+    }
+#endif
+    atomic_fetch_add_explicit(&fallback_slots_[__get_fallback_shard(kCpuCount)].value, delta,
+                              memory_order_relaxed);
+  }
+
+  // Concurrent updates may or may not be included.
+  int64_t sum() const {
+    int64_t result = 0;
+#if defined(__BIONIC_HAVE_RSEQ_CS)
+    for (const CpuSlot& slot : cpu_slots_) {
+      result += __atomic_load_n(&slot.value, __ATOMIC_RELAXED);
+    }
+#endif
+    for (const FallbackSlot& slot : fallback_slots_) {
+      result += atomic_load_explicit(&slot.value, memory_order_relaxed);
+    }
+    return result;
+  }
+
+ private:
+#if defined(__BIONIC_HAVE_RSEQ_CS)
+  struct alignas(64) CpuSlot {
+    intptr_t value;
+  };
+  CpuSlot cpu_slots_[kCpuCount];
+#endif
+  struct alignas(64) FallbackSlot {
+    _Atomic(int64_t) value;
+  };
+  FallbackSlot fallback_slots_[kCpuCount];
+};
+
+// A free list of T, which must be a standard-layout type with a `T* next` member.
+// Zero-initialized memory is a valid PerCpuFreeList.
+//
+// With rseq, push() and pop() use a list that only restartable sequences on the current CPU
+// touch, so neither takes a lock. A node pushed there can only be popped by a thread on the same
+// CPU, as with any per-CPU cache: pop() returns null when that list is empty rather than taking
+// from other CPUs' lists. Threads that can't use rseq share a separate set of locked lists, and
+// pop() takes from any of those.
+template <typename T, size_t kCpuCount = 32>
+class PerCpuFreeList {
+ public:
+  void push(T* node) {
+#if defined(__BIONIC_HAVE_RSEQ_CS)
+    for (int cpu; (cpu = __get_rseq_cs_cpu(kCpuCount)) >= 0;) {
+      intptr_t* head = reinterpret_cast<intptr_t*>(&cpu_lists_[cpu].head);
+      T* old_head = reinterpret_cast<T*>(__atomic_load_n(head, __ATOMIC_RELAXED));
+      node->next = old_head;
+      if (__rseq_cmpeqv_storev(head, reinterpret_cast<intptr_t>(old_head),
+                               reinterpret_cast<intptr_t>(node), cpu) == 0) {
+        return;
+      }
+    }
+#endif
+    FallbackList& list = fallback_lists_[__get_fallback_shard(kCpuCount)];
+    LockGuard guard(list.lock);
+    node->next = atomic_load_explicit(&list.head, memory_order_relaxed);
+    atomic_store_explicit(&list.head, node, memory_order_relaxed);
+  }
+
+  T* pop() {
+#if defined(__BIONIC_HAVE_RSEQ_CS)
+    for (int cpu; (cpu = __get_rseq_cs_cpu(kCpuCount)) >= 0;) {
+      intptr_t node;
+      int result = __rseq_pop(reinterpret_cast<intptr_t*>(&cpu_lists_[cpu].head),
+                              offsetof(T, next), cpu, &node);
+      if (result == 0) return reinterpret_cast<T*>(node);
+      if (result == 1) break;
+    }
+#endif
+    size_t first = __get_fallback_shard(kCpuCount);
+    for (size_t i = 0; i < kCpuCount; ++i) {
+      FallbackList& list = fallback_lists_[(first + i) % kCpuCount];
+      // Don't take the locks of lists that look empty.
+      if (atomic_load_explicit(&list.head, memory_order_relaxed) == nullptr) continue;
+      LockGuard guard(list.lock);
+      T* node = atomic_load_explicit(&list.head, memory_order_relaxed);
+      if (node != nullptr) {
+        atomic_store_explicit(&list.head, node->next, memory_order_relaxed);
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+ private:
+#if defined(__BIONIC_HAVE_RSEQ_CS)
+  struct alignas(64) CpuList {
+    T* head;
+  };
+  CpuList cpu_lists_[kCpuCount];
+#endif
+  struct alignas(64) FallbackList {
+    Lock lock;
+    _Atomic(T*) head;
+  };
+  FallbackList fallback_lists_[kCpuCount];
+};
@@ -106,10 +106,14 @@ class pthread_key_data_t {
   void* data;
 };
 
+#define BIONIC_PTHREAD_KEY_LIVE_WORDS ((BIONIC_PTHREAD_KEY_COUNT + 31) / 32)
+
 // ~3 pages. This struct is allocated as static TLS memory (i.e. at a fixed
 // offset from the thread pointer).
 struct bionic_tls {
   pthread_key_data_t key_data[BIONIC_PTHREAD_KEY_COUNT];
+  // Bit i is set if key_data[i] may hold a non-null value, so thread exit only visits those keys.
+  uint32_t key_live[BIONIC_PTHREAD_KEY_LIVE_WORDS];
 
   locale_t locale;
 
@@ -31,6 +31,8 @@
 #include "linker_debuggerd.h"
 #include "linker_dlwarning.h"
 #include "linker_globals.h"
+#include "linker_lookup_lock.h"
+#include "linker_main.h"
 
 #include <link.h>
 #include <pthread.h>
@@ -39,10 +41,12 @@
 #include <string.h>
 #include <android/api-level.h>
 
+#include <atomic>
+
 #include <bionic/pthread_internal.h>
+#include "platform/bionic/macros.h"
 #include "private/bionic_globals.h"
 #include "private/bionic_tls.h"
-#include "private/ScopedPthreadMutexLocker.h"
 
 #define __LINKER_PUBLIC__ __attribute__((visibility("default")))
 
@@ -99,6 +103,67 @@ bool __loader_android_handle_signal(int signal_number, siginfo_t* info,
 
 static pthread_mutex_t g_dl_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 
+// Holders of g_dl_mutex also hold the write side of g_dl_lookup_lock, so that dlsym() and
+// dladdr() only need its read side. g_dl_mutex_owner is the tid of the thread holding
+// g_dl_mutex (or 0), and g_dl_mutex_depth counts its recursive acquisitions.
+static LookupLock g_dl_lookup_lock;
+static std::atomic<pid_t> g_dl_mutex_owner;
+static size_t g_dl_mutex_depth;
+
+// Holds g_dl_mutex, and the write side of g_dl_lookup_lock while it does.
+class ScopedLoaderLock {
+ public:
+  ScopedLoaderLock() {
+    pthread_mutex_lock(&g_dl_mutex);
+    if (g_dl_mutex_depth++ == 0) {
+      g_dl_lookup_lock.write_lock();
+      g_dl_mutex_owner.store(__get_thread()->tid, std::memory_order_relaxed);
+    }
+  }
+
+  ~ScopedLoaderLock() {
+    if (--g_dl_mutex_depth == 0) {
+      g_dl_mutex_owner.store(0, std::memory_order_relaxed);
+      g_dl_lookup_lock.write_unlock();
+    }
+    pthread_mutex_unlock(&g_dl_mutex);
+  }
+
+ private:
+  BIONIC_DISALLOW_COPY_AND_ASSIGN(ScopedLoaderLock);
+};
+
+// Holds the read side of g_dl_lookup_lock for a lookup that doesn't change the loader's state,
+// so lookups on different threads run concurrently. A thread that already holds g_dl_mutex
+// (e.g. a constructor calling dlsym()) or is already in a lookup (e.g. a signal handler) just
+// carries on.
+class ScopedLookupLock {
+ public:
+  ScopedLookupLock() : self_(__get_thread()) {
+    locked_ = g_dl_mutex_owner.load(std::memory_order_relaxed) != self_->tid &&
+              self_->dl_lookup_error_buffer == nullptr;
+    if (locked_) {
+      linker_enable_allocator_locking_for_lookups();
+      g_dl_lookup_lock.read_lock(self_->tid);
+      self_->dl_lookup_error_buffer = error_buffer_;
+    }
+  }
+
+  ~ScopedLookupLock() {
+    if (locked_) {
+      self_->dl_lookup_error_buffer = nullptr;
+      g_dl_lookup_lock.read_unlock(self_->tid);
+    }
+  }
+
+ private:
+  pthread_internal_t* self_;
+  bool locked_;
+  char error_buffer_[kLinkerErrorBufferSize];
+
+  BIONIC_DISALLOW_COPY_AND_ASSIGN(ScopedLookupLock);
+};
+
 static char* __bionic_set_dlerror(char* new_value) {
   char* old_value = __get_thread()->current_dlerror;
   __get_thread()->current_dlerror = new_value;
@@ -124,12 +189,12 @@ char* __loader_dlerror() {
 }
 
 void __loader_android_get_LD_LIBRARY_PATH(char* buffer, size_t buffer_size) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
   do_android_get_LD_LIBRARY_PATH(buffer, buffer_size);
 }
 
 void __loader_android_update_LD_LIBRARY_PATH(const char* ld_library_path) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
   do_android_update_LD_LIBRARY_PATH(ld_library_path);
 }
 
@@ -137,7 +202,7 @@ static void* dlopen_ext(const char* filename,
                         int flags,
                         const android_dlextinfo* extinfo,
                         const void* caller_addr) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
   g_linker_logger.ResetState();
   void* result = do_dlopen(filename, flags, extinfo, caller_addr);
   if (result == nullptr) {
@@ -159,7 +224,7 @@ void* __loader_dlopen(const char* filename, int flags, const void* caller_addr)
 }
 
 void* dlsym_impl(void* handle, const char* symbol, const char* version, const void* caller_addr) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLookupLock locker;
   g_linker_logger.ResetState();
   void* result;
   if (!do_dlsym(handle, symbol, version, caller_addr, &result)) {
@@ -179,12 +244,12 @@ void* __loader_dlvsym(void* handle, const char* symbol, const char* version, con
 }
 
 int __loader_dladdr(const void* addr, Dl_info* info) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLookupLock locker;
   return do_dladdr(addr, info);
 }
 
 int __loader_dlclose(void* handle) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
   int result = do_dlclose(handle);
   if (result != 0) {
     __bionic_format_dlerror("dlclose failed", linker_get_error_buffer());
@@ -193,20 +258,20 @@ int __loader_dlclose(void* handle) {
 }
 
 int __loader_dl_iterate_phdr(int (*cb)(dl_phdr_info* info, size_t size, void* data), void* data) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  // This reads a snapshot published by dlopen/dlclose, so it doesn't need g_dl_mutex.
   return do_dl_iterate_phdr(cb, data);
 }
 
 #if defined(__arm__)
 _Unwind_Ptr __loader_dl_unwind_find_exidx(_Unwind_Ptr pc, int* pcount) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLookupLock locker;
   return do_dl_unwind_find_exidx(pc, pcount);
 }
 #endif
 
 void __loader_android_set_application_target_sdk_version(int target) {
   // lock to avoid modification in the middle of dlopen.
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
   set_application_target_sdk_version(target);
 }
 
@@ -215,13 +280,13 @@ int __loader_android_get_application_target_sdk_version() {
 }
 
 void __loader_android_dlwarning(void* obj, void (*f)(void*, const char*)) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
   get_dlwarning(obj, f);
 }
 
 bool __loader_android_init_anonymous_namespace(const char* shared_libs_sonames,
                                                const char* library_search_path) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
   bool success = init_anonymous_namespace(shared_libs_sonames, library_search_path);
   if (!success) {
     __bionic_format_dlerror("android_init_anonymous_namespace failed", linker_get_error_buffer());
@@ -237,7 +302,7 @@ android_namespace_t* __loader_android_create_namespace(const char* name,
                                                 const char* permitted_when_isolated_path,
                                                 android_namespace_t* parent_namespace,
                                                 const void* caller_addr) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
 
   android_namespace_t* result = create_namespace(caller_addr,
                                                  name,
@@ -257,7 +322,7 @@ android_namespace_t* __loader_android_create_namespace(const char* name,
 bool __loader_android_link_namespaces(android_namespace_t* namespace_from,
                                       android_namespace_t* namespace_to,
                                       const char* shared_libs_sonames) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
 
   bool success = link_namespaces(namespace_from, namespace_to, shared_libs_sonames);
 
@@ -270,7 +335,7 @@ bool __loader_android_link_namespaces(android_namespace_t* namespace_from,
 
 bool __loader_android_link_namespaces_all_libs(android_namespace_t* namespace_from,
                                                android_namespace_t* namespace_to) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
 
   bool success = link_namespaces_all_libs(namespace_from, namespace_to);
 
@@ -282,22 +347,22 @@ bool __loader_android_link_namespaces_all_libs(android_namespace_t* namespace_fr
 }
 
 android_namespace_t* __loader_android_get_exported_namespace(const char* name) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
   return get_exported_namespace(name);
 }
 
 void __loader_cfi_fail(uint64_t CallSiteTypeId, void* Ptr, void *DiagData, void *CallerPc) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
   CFIShadowWriter::CfiFail(CallSiteTypeId, Ptr, DiagData, CallerPc);
 }
 
 void __loader_add_thread_local_dtor(void* dso_handle) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
   increment_dso_handle_reference_counter(dso_handle);
 }
 
 void __loader_remove_thread_local_dtor(void* dso_handle) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLoaderLock locker;
   decrement_dso_handle_reference_counter(dso_handle);
 }
 
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+// Compiles an ld.config.txt into the binary form the linker maps instead of
+// parsing the text. See ld.config.format.md.
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <android-base/file.h>
+
+#include "linker_config.h"
+
+static void usage(const char* progname) {
+  fprintf(stderr,
+          "usage: %s LD_CONFIG_FILE [OUTPUT_FILE]\n"
+          "\n"
+          "Compiles LD_CONFIG_FILE for the linker. OUTPUT_FILE defaults to the path the\n"
+          "linker looks for: LD_CONFIG_FILE with \".txt\" replaced by \".bin\".\n",
+          progname);
+}
+
+int main(int argc, char* argv[]) {
+  if (argc != 2 && argc != 3) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const char* config_path = argv[1];
+  std::string output_path = (argc == 3) ? argv[2] : Config::get_compiled_config_path(config_path);
+
+  std::string binary;
+  std::string error_msg;
+  if (!Config::compile_config(config_path, &binary, &error_msg)) {
+    fprintf(stderr, "%s: %s\n", argv[0], error_msg.c_str());
+    return EXIT_FAILURE;
+  }
+
+  // Write to a temporary file and rename it so that a linker running
+  // concurrently never sees a partially written config.
+  std::string tmp_path = output_path + ".tmp";
+  if (!android::base::WriteStringToFile(binary, tmp_path) ||
+      rename(tmp_path.c_str(), output_path.c_str()) == -1) {
+    fprintf(stderr, "%s: couldn't write \"%s\": %s\n", argv[0], output_path.c_str(),
+            strerror(errno));
+    unlink(tmp_path.c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
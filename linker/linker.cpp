@@ -40,6 +40,7 @@
 #include <sys/vfs.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <iterator>
 #include <new>
 #include <string>
@@ -54,18 +55,25 @@
 // Private C library headers.
 
 #include "linker.h"
+#include "linker_address_index.h"
 #include "linker_block_allocator.h"
 #include "linker_cfi.h"
 #include "linker_config.h"
 #include "linker_gdb_support.h"
 #include "linker_globals.h"
 #include "linker_debug.h"
+#include "linker_dlsym_cache.h"
 #include "linker_dlwarning.h"
+#include "linker_gnu_hash.h"
+#include "linker_loader_threads.h"
 #include "linker_main.h"
+#include "linker_mprotect_batch.h"
 #include "linker_namespaces.h"
 #include "linker_sleb128.h"
 #include "linker_phdr.h"
+#include "linker_phdr_snapshot.h"
 #include "linker_relocate.h"
+#include "linker_relro_cache.h"
 #include "linker_tls.h"
 #include "linker_translate_path.h"
 #include "linker_utils.h"
@@ -91,6 +99,17 @@ static LinkerTypeAllocator<LinkedListEntry<android_namespace_t>> g_namespace_lis
 
 static uint64_t g_module_load_counter = 0;
 static uint64_t g_module_unload_counter = 0;
+// Counts changes to namespace membership, which can change what a handle's dependencies can see.
+static uint64_t g_namespace_change_counter = 0;
+
+// The generation of cached dlsym() results. dlsym() on a handle gives the same result until a
+// library is loaded or unloaded, or a namespace gains libraries.
+static uint64_t dlsym_cache_generation() {
+  return g_module_load_counter + g_module_unload_counter + g_namespace_change_counter;
+}
+
+// Maps the reserved address range of every mapped soinfo back to the soinfo.
+static AddressRangeIndex<soinfo*> g_soinfo_address_index;
 
 static const char* const kLdConfigArchFilePath = "/system/etc/ld.config." ABI_STRING ".txt";
 
@@ -328,15 +347,34 @@ soinfo* soinfo_alloc(android_namespace_t* ns, const char* name,
   return si;
 }
 
-static void soinfo_free(soinfo* si) {
+void register_soinfo_address_range(soinfo* si) {
+  if (si->size == 0) {
+    return;
+  }
+  if (!g_soinfo_address_index.insert(si->base, si->size, si)) {
+    async_safe_fatal("soinfo=%p \"%s\" [%p-%p) overlaps an already loaded library",
+                     si, si->get_realpath(), reinterpret_cast<void*>(si->base),
+                     reinterpret_cast<void*>(si->base + si->size));
+  }
+}
+
+// `published` says whether the library has been in a snapshot published for dl_iterate_phdr(),
+// in which case a reader of an older snapshot may still be looking at its mapping.
+static void soinfo_free(soinfo* si, bool published = false) {
   if (si == nullptr) {
     return;
   }
 
   if (si->base != 0 && si->size != 0) {
     if (!si->is_mapped_by_caller()) {
-      munmap(reinterpret_cast<void*>(si->base), si->size);
+      if (published) {
+        unmap_after_phdr_readers(reinterpret_cast<void*>(si->base), si->size);
+      } else {
+        munmap(reinterpret_cast<void*>(si->base), si->size);
+      }
     } else {
+      // The caller owns this range and may reuse it as soon as dlclose() returns, so it can't
+      // be kept for dl_iterate_phdr() readers.
       // remap the region as PROT_NONE, MAP_ANONYMOUS | MAP_NORESERVE
       mmap(reinterpret_cast<void*>(si->base), si->size, PROT_NONE,
            MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
@@ -349,6 +387,8 @@ static void soinfo_free(soinfo* si) {
 
   TRACE("name %s: freeing soinfo @ %p", si->get_realpath(), si);
 
+  g_soinfo_address_index.erase(si->base, si);
+
   if (!solist_remove_soinfo(si)) {
     async_safe_fatal("soinfo=%p is not in soinfo_list (double unload?)", si);
   }
@@ -373,6 +413,16 @@ static void parse_LD_LIBRARY_PATH(const char* path) {
   g_default_namespace.set_ld_library_paths(std::move(ld_libary_paths));
 }
 
+static HugepageTextPolicy g_hugepage_text_policy_override = HugepageTextPolicy::kDefault;
+
+void set_hugepage_text_policy_override(HugepageTextPolicy policy) {
+  g_hugepage_text_policy_override = policy;
+}
+
+static HugepageTextPolicy get_hugepage_text_policy(const android_namespace_t* ns) {
+  return std::max(ns->hugepage_text_policy(), g_hugepage_text_policy_override);
+}
+
 static bool realpath_fd(int fd, std::string* realpath) {
   // proc_self_fd needs to be large enough to hold "/proc/self/fd/" plus an
   // integer, plus the NULL terminator.
@@ -431,32 +481,43 @@ _Unwind_Ptr do_dl_unwind_find_exidx(_Unwind_Ptr pc, int* pcount) {
 
 #endif
 
-// Here, we only have to provide a callback to iterate across all the
-// loaded libraries. gcc_eh does the rest.
-int do_dl_iterate_phdr(int (*cb)(dl_phdr_info* info, size_t size, void* data), void* data) {
-  int rv = 0;
+// Rebuilds the snapshot of loaded libraries read by dl_iterate_phdr() from solist, leaving out
+// any library for which `exclude` returns true. Must be called with the loader lock held.
+template <typename F>
+static void publish_loaded_libraries(F exclude) {
+  std::vector<PhdrSnapshotEntry> entries;
   for (soinfo* si = solist_get_head(); si != nullptr; si = si->next) {
-    dl_phdr_info dl_info;
-    dl_info.dlpi_addr = si->link_map_head.l_addr;
-    dl_info.dlpi_name = si->link_map_head.l_name;
-    dl_info.dlpi_phdr = si->phdr;
-    dl_info.dlpi_phnum = si->phnum;
-    dl_info.dlpi_adds = g_module_load_counter;
-    dl_info.dlpi_subs = g_module_unload_counter;
-    if (soinfo_tls* tls_module = si->get_tls()) {
-      dl_info.dlpi_tls_modid = tls_module->module_id;
-      dl_info.dlpi_tls_data = get_tls_block_for_this_thread(tls_module, /*should_alloc=*/false);
-    } else {
-      dl_info.dlpi_tls_modid = 0;
-      dl_info.dlpi_tls_data = nullptr;
+    if (exclude(si)) {
+      continue;
     }
-
-    rv = cb(&dl_info, sizeof(dl_phdr_info), data);
-    if (rv != 0) {
-      break;
+    PhdrSnapshotEntry entry = {};
+    entry.info.dlpi_addr = si->link_map_head.l_addr;
+    entry.info.dlpi_name = si->link_map_head.l_name;
+    entry.info.dlpi_phdr = si->phdr;
+    entry.info.dlpi_phnum = si->phnum;
+    entry.info.dlpi_adds = g_module_load_counter;
+    entry.info.dlpi_subs = g_module_unload_counter;
+    entry.tls_static_offset = SIZE_MAX;
+    soinfo_tls* tls_module = si->get_tls();
+    if (tls_module != nullptr && tls_module->module_id != kTlsUninitializedModuleId) {
+      const TlsModule& tls_mod = get_tls_module(tls_module->module_id);
+      entry.info.dlpi_tls_modid = tls_module->module_id;
+      entry.tls_static_offset = tls_mod.static_offset;
+      entry.tls_first_generation = tls_mod.first_generation;
     }
+    entries.push_back(entry);
   }
-  return rv;
+  publish_phdr_snapshot(std::move(entries));
+}
+
+static void publish_loaded_libraries() {
+  publish_loaded_libraries([](soinfo*) { return false; });
+}
+
+// Here, we only have to provide a callback to iterate across all the
+// loaded libraries. gcc_eh does the rest.
+int do_dl_iterate_phdr(int (*cb)(dl_phdr_info* info, size_t size, void* data), void* data) {
+  return iterate_phdr_snapshot(cb, data);
 }
 
 ProtectedDataGuard::ProtectedDataGuard() {
@@ -476,10 +537,18 @@ ProtectedDataGuard::~ProtectedDataGuard() {
 }
 
 void ProtectedDataGuard::protect_data(int protection) {
-  g_soinfo_allocator.protect_all(protection);
-  g_soinfo_links_allocator.protect_all(protection);
-  g_namespace_allocator.protect_all(protection);
-  g_namespace_list_allocator.protect_all(protection);
+  // The allocators' pages are usually mapped next to each other, so changing all of them
+  // together takes far fewer mprotect() calls than changing each allocator on its own.
+  MprotectBatch batch;
+  g_soinfo_allocator.protect_all(protection, &batch);
+  g_soinfo_links_allocator.protect_all(protection, &batch);
+  g_namespace_allocator.protect_all(protection, &batch);
+  g_namespace_list_allocator.protect_all(protection, &batch);
+  if (!batch.apply()) {
+    async_safe_fatal("mprotect(%d) of linker data failed: %m", protection);
+  }
+  count_protection(kProtectRange, batch.range_count());
+  count_protection(kProtectCall, batch.call_count());
 }
 
 size_t ProtectedDataGuard::ref_count_ = 0;
@@ -594,6 +663,25 @@ class LoadTask {
     is_dt_needed_ = is_dt_needed;
   }
 
+  // When set, load_library() stops after allocating the soinfo and leaves reading the ELF
+  // headers to find_libraries(), which reads them on loader threads.
+  bool is_read_deferred() const {
+    return read_deferred_;
+  }
+
+  void set_read_deferred(bool read_deferred) {
+    read_deferred_ = read_deferred;
+  }
+
+  // The namespace the library was found in, while its deferred read is pending.
+  android_namespace_t* get_pending_read_ns() const {
+    return pending_read_ns_;
+  }
+
+  void set_pending_read_ns(android_namespace_t* ns) {
+    pending_read_ns_ = ns;
+  }
+
   // returns the namespace from where we need to start loading this.
   const android_namespace_t* get_start_from() const {
     return start_from_;
@@ -623,9 +711,21 @@ class LoadTask {
     return elf_reader.Read(realpath, fd_, file_offset_, file_size);
   }
 
+  // Maps the library with `elf_reader` (this task's reader) unless it is already mapped. This
+  // doesn't touch the soinfo, so the loader threads can call it.
+  bool map(ElfReader* elf_reader, address_space_params* address_space) {
+    if (elf_reader->did_load()) {
+      return true;
+    }
+    if (is_relro_cache_enabled()) {
+      elf_reader->set_preferred_load_start(get_relro_cache_load_start(si_));
+    }
+    return elf_reader->Load(address_space, get_hugepage_text_policy(si_->get_primary_namespace()));
+  }
+
   bool load(address_space_params* address_space) {
     ElfReader& elf_reader = get_elf_reader();
-    if (!elf_reader.Load(address_space)) {
+    if (!map(&elf_reader, address_space)) {
       return false;
     }
 
@@ -637,6 +737,7 @@ class LoadTask {
     si_->phdr = elf_reader.loaded_phdr();
     si_->set_gap_start(elf_reader.gap_start());
     si_->set_gap_size(elf_reader.gap_size());
+    register_soinfo_address_range(si_);
 
     return true;
   }
@@ -648,7 +749,8 @@ class LoadTask {
            std::unordered_map<const soinfo*, ElfReader>* readers_map)
     : name_(name), needed_by_(needed_by), si_(nullptr),
       fd_(-1), close_fd_(false), file_offset_(0), elf_readers_map_(readers_map),
-      is_dt_needed_(false), start_from_(start_from) {}
+      is_dt_needed_(false), read_deferred_(false), pending_read_ns_(nullptr),
+      start_from_(start_from) {}
 
   ~LoadTask() {
     if (fd_ != -1 && close_fd_) {
@@ -667,6 +769,8 @@ class LoadTask {
   // TODO(dimitry): needed by workaround for http://b/26394120 (the exempt-list)
   bool is_dt_needed_;
   // END OF WORKAROUND
+  bool read_deferred_;
+  android_namespace_t* pending_read_ns_;
   const android_namespace_t* const start_from_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(LoadTask);
@@ -677,10 +781,48 @@ LoadTask::deleter_t LoadTask::deleter;
 template <typename T>
 using linked_list_t = LinkedList<T, TypeBasedAllocator<LinkedListEntry<T>>>;
 
-typedef linked_list_t<soinfo> SoinfoLinkedList;
 typedef linked_list_t<const char> StringLinkedList;
 typedef std::vector<LoadTask*> LoadTaskList;
 
+// The queue of a breadth-first walk, which visits each soinfo once. The walk used to keep its
+// lists in the linker's block allocators, which aren't thread-safe; dlsym() walks without the
+// loader lock, so the queue starts out on the stack and only moves to the (locked) heap for
+// unusually large dependency trees.
+class WalkQueue {
+ public:
+  WalkQueue() : nodes_(inline_nodes_), capacity_(arraysize(inline_nodes_)), head_(0), size_(0) {}
+
+  // Queues si unless it has already been queued.
+  void push(soinfo* si) {
+    if (std::find(nodes_, nodes_ + size_, si) != nodes_ + size_) {
+      return;
+    }
+    if (size_ == capacity_) {
+      if (heap_nodes_.empty()) {
+        heap_nodes_.assign(inline_nodes_, inline_nodes_ + size_);
+      }
+      capacity_ *= 2;
+      heap_nodes_.resize(capacity_);
+      nodes_ = heap_nodes_.data();
+    }
+    nodes_[size_++] = si;
+  }
+
+  soinfo* pop() {
+    return head_ < size_ ? nodes_[head_++] : nullptr;
+  }
+
+ private:
+  soinfo* inline_nodes_[64];
+  std::vector<soinfo*> heap_nodes_;
+  soinfo** nodes_;
+  size_t capacity_;
+  size_t head_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(WalkQueue);
+};
+
 enum walk_action_result_t : uint32_t {
   kWalkStop = 0,
   kWalkContinue = 1,
@@ -698,28 +840,21 @@ enum walk_action_result_t : uint32_t {
 // by the action and true otherwise.
 template<typename F>
 static bool walk_dependencies_tree(soinfo* root_soinfo, F action) {
-  SoinfoLinkedList visit_list;
-  SoinfoLinkedList visited;
+  WalkQueue visit_queue;
 
-  visit_list.push_back(root_soinfo);
+  visit_queue.push(root_soinfo);
 
   soinfo* si;
-  while ((si = visit_list.pop_front()) != nullptr) {
-    if (visited.contains(si)) {
-      continue;
-    }
-
+  while ((si = visit_queue.pop()) != nullptr) {
     walk_action_result_t result = action(si);
 
     if (result == kWalkStop) {
       return false;
     }
 
-    visited.push_back(si);
-
     if (result != kWalkSkip) {
       si->get_children().for_each([&](soinfo* child) {
-        visit_list.push_back(child);
+        visit_queue.push(child);
       });
     }
   }
@@ -847,23 +982,59 @@ static const ElfW(Sym)* dlsym_handle_lookup(soinfo* si,
   return dlsym_handle_lookup_impl(si->get_primary_namespace(), si, nullptr, found, symbol_name, vi);
 }
 
+static const char* find_verdef_name(const soinfo* si, const version_info* vi);
+
+// dlsym_handle_lookup() through the cache of earlier results on the handle, if it has one.
+static const ElfW(Sym)* dlsym_handle_lookup_cached(soinfo* si,
+                                                   soinfo** found,
+                                                   const char* name,
+                                                   const version_info* vi) {
+  DlsymCache* cache = si->get_dlsym_cache();
+  if (cache == nullptr) {
+    return dlsym_handle_lookup(si, found, name, vi);
+  }
+
+  uint32_t hash = calculate_gnu_hash(name).first;
+  uint64_t generation = dlsym_cache_generation();
+  const char* version = (vi != nullptr) ? vi->name : nullptr;
+  const ElfW(Sym)* sym = nullptr;
+  if (cache->find(generation, hash, name, version, found, &sym)) {
+    count_dlsym_cache_lookup(true);
+    return sym;
+  }
+  count_dlsym_cache_lookup(false);
+
+  sym = dlsym_handle_lookup(si, found, name, vi);
+  if (sym != nullptr) {
+    // The cache keeps the defining library's copy of the strings. A version that the library
+    // doesn't define (which matches its unversioned symbols) has no such copy.
+    const char* found_version = (vi != nullptr) ? find_verdef_name(*found, vi) : nullptr;
+    if (vi == nullptr || found_version != nullptr) {
+      cache->insert(generation, hash, (*found)->get_string(sym->st_name), found_version, *found,
+                    sym);
+    }
+  }
+  return sym;
+}
+
 soinfo* find_containing_library(const void* p) {
   // Addresses within a library may be tagged if they point to globals. Untag
   // them so that the bounds check succeeds.
   ElfW(Addr) address = reinterpret_cast<ElfW(Addr)>(untag_address(p));
-  for (soinfo* si = solist_get_head(); si != nullptr; si = si->next) {
-    if (address < si->base || address - si->base >= si->size) {
+  soinfo* si = g_soinfo_address_index.find(address, nullptr);
+  if (si == nullptr) {
+    return nullptr;
+  }
+  // The reserved range may include gaps between segments, so check that the
+  // address is actually inside one of the PT_LOAD segments.
+  ElfW(Addr) vaddr = address - si->load_bias;
+  for (size_t i = 0; i != si->phnum; ++i) {
+    const ElfW(Phdr)* phdr = &si->phdr[i];
+    if (phdr->p_type != PT_LOAD) {
       continue;
     }
-    ElfW(Addr) vaddr = address - si->load_bias;
-    for (size_t i = 0; i != si->phnum; ++i) {
-      const ElfW(Phdr)* phdr = &si->phdr[i];
-      if (phdr->p_type != PT_LOAD) {
-        continue;
-      }
-      if (vaddr >= phdr->p_vaddr && vaddr < phdr->p_vaddr + phdr->p_memsz) {
-        return si;
-      }
+    if (vaddr >= phdr->p_vaddr && vaddr < phdr->p_vaddr + phdr->p_memsz) {
+      return si;
     }
   }
   return nullptr;
@@ -1157,6 +1328,44 @@ static bool find_loaded_library_by_realpath(android_namespace_t* ns, const char*
   return *candidate != nullptr;
 }
 
+static void finish_load_library(android_namespace_t* ns, LoadTask* task,
+                                 LoadTaskList* load_tasks) {
+  soinfo* si = task->get_soinfo();
+
+  // Find and set DT_RUNPATH, DT_SONAME, and DT_FLAGS_1.
+  // Note that these field values are temporary and are
+  // going to be overwritten on soinfo::prelink_image
+  // with values from PT_LOAD segments.
+  const ElfReader& elf_reader = task->get_elf_reader();
+  for (const ElfW(Dyn)* d = elf_reader.dynamic(); d->d_tag != DT_NULL; ++d) {
+    if (d->d_tag == DT_RUNPATH) {
+      si->set_dt_runpath(elf_reader.get_string(d->d_un.d_val));
+    }
+    if (d->d_tag == DT_SONAME) {
+      si->set_soname(elf_reader.get_string(d->d_un.d_val));
+    }
+    // We need to identify a DF_1_GLOBAL library early so we can link it to namespaces.
+    if (d->d_tag == DT_FLAGS_1) {
+      si->set_dt_flags_1(d->d_un.d_val);
+    }
+  }
+
+#if !defined(__ANDROID__)
+  // Bionic on the host currently uses some Android prebuilts, which don't set
+  // DT_RUNPATH with any relative paths, so they can't find their dependencies.
+  // b/118058804
+  if (si->get_dt_runpath().empty()) {
+    si->set_dt_runpath("$ORIGIN/../lib64:$ORIGIN/lib64");
+  }
+#endif
+
+  for_each_dt_needed(task->get_elf_reader(), [&](const char* name) {
+    LD_LOG(kLogDlopen, "load_library(ns=%s, task=%s): Adding DT_NEEDED task: %s",
+           ns->get_name(), task->get_name(), name);
+    load_tasks->push_back(LoadTask::create(name, si, ns, task->get_readers_map()));
+  });
+}
+
 static bool load_library(android_namespace_t* ns,
                          LoadTask* task,
                          LoadTaskList* load_tasks,
@@ -1264,6 +1473,13 @@ static bool load_library(android_namespace_t* ns,
 
   task->set_soinfo(si);
 
+  if (task->is_read_deferred()) {
+    task->get_elf_reader().Prepare(realpath.c_str(), task->get_fd(), file_offset,
+                                   file_stat.st_size);
+    task->set_pending_read_ns(ns);
+    return true;
+  }
+
   // Read the ELF header and some of the segments.
   if (!task->read(realpath.c_str(), file_stat.st_size)) {
     task->remove_cached_elf_reader();
@@ -1272,39 +1488,7 @@ static bool load_library(android_namespace_t* ns,
     return false;
   }
 
-  // Find and set DT_RUNPATH, DT_SONAME, and DT_FLAGS_1.
-  // Note that these field values are temporary and are
-  // going to be overwritten on soinfo::prelink_image
-  // with values from PT_LOAD segments.
-  const ElfReader& elf_reader = task->get_elf_reader();
-  for (const ElfW(Dyn)* d = elf_reader.dynamic(); d->d_tag != DT_NULL; ++d) {
-    if (d->d_tag == DT_RUNPATH) {
-      si->set_dt_runpath(elf_reader.get_string(d->d_un.d_val));
-    }
-    if (d->d_tag == DT_SONAME) {
-      si->set_soname(elf_reader.get_string(d->d_un.d_val));
-    }
-    // We need to identify a DF_1_GLOBAL library early so we can link it to namespaces.
-    if (d->d_tag == DT_FLAGS_1) {
-      si->set_dt_flags_1(d->d_un.d_val);
-    }
-  }
-
-#if !defined(__ANDROID__)
-  // Bionic on the host currently uses some Android prebuilts, which don't set
-  // DT_RUNPATH with any relative paths, so they can't find their dependencies.
-  // b/118058804
-  if (si->get_dt_runpath().empty()) {
-    si->set_dt_runpath("$ORIGIN/../lib64:$ORIGIN/lib64");
-  }
-#endif
-
-  for_each_dt_needed(task->get_elf_reader(), [&](const char* name) {
-    LD_LOG(kLogDlopen, "load_library(ns=%s, task=%s): Adding DT_NEEDED task: %s",
-           ns->get_name(), task->get_name(), name);
-    load_tasks->push_back(LoadTask::create(name, si, ns, task->get_readers_map()));
-  });
-
+  finish_load_library(ns, task, load_tasks);
   return true;
 }
 
@@ -1539,6 +1723,68 @@ static void shuffle(std::vector<LoadTask*>* v) {
   }
 }
 
+static bool should_use_loader_threads() {
+  // Before API level 26 some malformed ELF files only produce a warning, and recording the
+  // warning (add_dlwarning) isn't thread-safe.
+  return get_loader_thread_count() > 0 && get_application_target_sdk_version() >= 26;
+}
+
+// Frees the soinfo allocated for a task whose ELF headers were going to be read on a loader
+// thread. Later tasks in [index, end) that found the same soinfo (by inode) are reset so that
+// they look for their library again.
+static void discard_pending_read(const LoadTaskList& load_tasks, size_t index, size_t end) {
+  LoadTask* task = load_tasks[index];
+  soinfo* si = task->get_soinfo();
+  for (size_t i = index + 1; i < end; ++i) {
+    if (load_tasks[i]->get_soinfo() == si && load_tasks[i]->get_pending_read_ns() == nullptr) {
+      load_tasks[i]->set_soinfo(nullptr);
+    }
+  }
+  task->set_pending_read_ns(nullptr);
+  task->remove_cached_elf_reader();
+  task->set_soinfo(nullptr);
+  soinfo_free(si);
+}
+
+// Completes a task of a breadth-first level whose ELF headers were read by
+// read_pending_load_tasks(). Anything that didn't go exactly as it would have with a serial
+// load (a failed read, or a library earlier in the level turning out to have this soname) is
+// redone here on the calling thread, so errors and fallbacks are the same as without loader
+// threads.
+static bool finish_pending_load_task(LoadTaskList* load_tasks, size_t index, size_t level_end,
+                                     ZipArchiveCache* zip_archive_cache, int rtld_flags) {
+  LoadTask* task = (*load_tasks)[index];
+  android_namespace_t* start_ns = const_cast<android_namespace_t*>(task->get_start_from());
+  task->set_read_deferred(false);
+
+  android_namespace_t* read_ns = task->get_pending_read_ns();
+  if (read_ns != nullptr) {
+    soinfo* candidate;
+    if (task->get_elf_reader().did_read() &&
+        !find_loaded_library_by_soname(start_ns, task->get_name(), true, &candidate)) {
+      task->set_pending_read_ns(nullptr);
+      finish_load_library(read_ns, task, load_tasks);
+      return true;
+    }
+    discard_pending_read(*load_tasks, index, level_end);
+  }
+
+  if (task->get_soinfo() != nullptr) {
+    return true;
+  }
+  return find_library_internal(start_ns, task, zip_archive_cache, load_tasks, rtld_flags);
+}
+
+static void read_pending_load_tasks(const LoadTaskList& load_tasks, size_t begin, size_t end) {
+  std::vector<ElfReader*> readers;
+  for (size_t i = begin; i < end; ++i) {
+    if (load_tasks[i]->get_pending_read_ns() != nullptr) {
+      readers.push_back(&load_tasks[i]->get_elf_reader());
+    }
+  }
+  loader_parallel_for(readers.size(), [&](size_t i) { readers[i]->ReadHeaders(); });
+}
+
 // add_as_children - add first-level loaded libraries (i.e. library_names[], but
 // not their transitive dependencies) as children of the start_with library.
 // This is false when find_libraries is called for dlopen(), when newly loaded
@@ -1590,61 +1836,96 @@ bool find_libraries(android_namespace_t* ns,
 
   // Step 1: expand the list of load_tasks to include
   // all DT_NEEDED libraries (do not load them just yet)
-  for (size_t i = 0; i<load_tasks.size(); ++i) {
-    LoadTask* task = load_tasks[i];
-    soinfo* needed_by = task->get_needed_by();
+  //
+  // With loader threads this is done one breadth-first level at a time: the libraries of a
+  // level are found in order, their ELF headers are read concurrently, and then each task is
+  // completed in order (adding its DT_NEEDED tasks for the next level), so load_tasks ends up
+  // in the same order as with a serial expansion.
+  const bool use_loader_threads = should_use_loader_threads();
+  auto pending_read_guard = android::base::make_scope_guard([&]() {
+    for (size_t i = 0; i < load_tasks.size(); ++i) {
+      if (load_tasks[i]->get_pending_read_ns() != nullptr) {
+        discard_pending_read(load_tasks, i, load_tasks.size());
+      }
+    }
+  });
 
-    bool is_dt_needed = needed_by != nullptr && (needed_by != start_with || add_as_children);
-    task->set_extinfo(is_dt_needed ? nullptr : extinfo);
-    task->set_dt_needed(is_dt_needed);
+  for (size_t level_start = 0; level_start < load_tasks.size();) {
+    size_t level_end = use_loader_threads ? load_tasks.size() : level_start + 1;
 
-    // Note: start from the namespace that is stored in the LoadTask. This namespace
-    // is different from the current namespace when the LoadTask is for a transitive
-    // dependency and the lib that created the LoadTask is not found in the
-    // current namespace but in one of the linked namespaces.
-    android_namespace_t* start_ns = const_cast<android_namespace_t*>(task->get_start_from());
+    for (size_t i = level_start; i < level_end; ++i) {
+      LoadTask* task = load_tasks[i];
+      soinfo* needed_by = task->get_needed_by();
 
-    LD_LOG(kLogDlopen, "find_library_internal(ns=%s@%p): task=%s, is_dt_needed=%d",
-           start_ns->get_name(), start_ns, task->get_name(), is_dt_needed);
+      bool is_dt_needed = needed_by != nullptr && (needed_by != start_with || add_as_children);
+      task->set_extinfo(is_dt_needed ? nullptr : extinfo);
+      task->set_dt_needed(is_dt_needed);
+      task->set_read_deferred(use_loader_threads);
 
-    if (!find_library_internal(start_ns, task, &zip_archive_cache, &load_tasks, rtld_flags)) {
-      return false;
-    }
+      // Note: start from the namespace that is stored in the LoadTask. This namespace
+      // is different from the current namespace when the LoadTask is for a transitive
+      // dependency and the lib that created the LoadTask is not found in the
+      // current namespace but in one of the linked namespaces.
+      android_namespace_t* start_ns = const_cast<android_namespace_t*>(task->get_start_from());
 
-    soinfo* si = task->get_soinfo();
+      LD_LOG(kLogDlopen, "find_library_internal(ns=%s@%p): task=%s, is_dt_needed=%d",
+             start_ns->get_name(), start_ns, task->get_name(), is_dt_needed);
 
-    if (is_dt_needed) {
-      needed_by->add_child(si);
+      if (!find_library_internal(start_ns, task, &zip_archive_cache, &load_tasks, rtld_flags)) {
+        return false;
+      }
     }
 
-    // When ld_preloads is not null, the first
-    // ld_preloads_count libs are in fact ld_preloads.
-    bool is_ld_preload = false;
-    if (ld_preloads != nullptr && soinfos_count < ld_preloads_count) {
-      ld_preloads->push_back(si);
-      is_ld_preload = true;
+    if (use_loader_threads) {
+      read_pending_load_tasks(load_tasks, level_start, level_end);
     }
 
-    if (soinfos_count < library_names_count) {
-      soinfos[soinfos_count++] = si;
-    }
+    for (size_t i = level_start; i < level_end; ++i) {
+      LoadTask* task = load_tasks[i];
+      if (use_loader_threads &&
+          !finish_pending_load_task(&load_tasks, i, level_end, &zip_archive_cache, rtld_flags)) {
+        return false;
+      }
 
-    // Add the new global group members to all initial namespaces. Do this secondary namespace setup
-    // at the same time that libraries are added to their primary namespace so that the order of
-    // global group members is the same in the every namespace. Only add a library to a namespace
-    // once, even if it appears multiple times in the dependency graph.
-    if (is_ld_preload || (si->get_dt_flags_1() & DF_1_GLOBAL) != 0) {
-      if (!si->is_linked() && namespaces != nullptr && !new_global_group_members.contains(si)) {
-        new_global_group_members.push_back(si);
-        for (auto linked_ns : *namespaces) {
-          if (si->get_primary_namespace() != linked_ns) {
-            linked_ns->add_soinfo(si);
-            si->add_secondary_namespace(linked_ns);
+      soinfo* si = task->get_soinfo();
+      soinfo* needed_by = task->get_needed_by();
+
+      if (task->is_dt_needed()) {
+        needed_by->add_child(si);
+      }
+
+      // When ld_preloads is not null, the first
+      // ld_preloads_count libs are in fact ld_preloads.
+      bool is_ld_preload = false;
+      if (ld_preloads != nullptr && soinfos_count < ld_preloads_count) {
+        ld_preloads->push_back(si);
+        is_ld_preload = true;
+      }
+
+      if (soinfos_count < library_names_count) {
+        soinfos[soinfos_count++] = si;
+      }
+
+      // Add the new global group members to all initial namespaces. Do this secondary namespace
+      // setup at the same time that libraries are added to their primary namespace so that the
+      // order of global group members is the same in the every namespace. Only add a library to
+      // a namespace once, even if it appears multiple times in the dependency graph.
+      if (is_ld_preload || (si->get_dt_flags_1() & DF_1_GLOBAL) != 0) {
+        if (!si->is_linked() && namespaces != nullptr && !new_global_group_members.contains(si)) {
+          new_global_group_members.push_back(si);
+          for (auto linked_ns : *namespaces) {
+            if (si->get_primary_namespace() != linked_ns) {
+              linked_ns->add_soinfo(si);
+              si->add_secondary_namespace(linked_ns);
+            }
           }
         }
       }
     }
+
+    level_start = level_end;
   }
+  pending_read_guard.Disable();
 
   // Step 2: Load libraries in random order (see b/24047022)
   LoadTaskList load_list;
@@ -1683,13 +1964,46 @@ bool find_libraries(android_namespace_t* ns,
     }
   }
 
+  auto get_address_space = [&](const LoadTask* task) {
+    return (reserved_address_recursive || !task->is_dt_needed()) ? &extinfo_params
+                                                                  : &default_params;
+  };
+
+  // Libraries that aren't placed in a caller-reserved region don't depend on each other's
+  // placement, so they can be mapped concurrently. The soinfos are still updated in load_list
+  // order below, and a failed mapping is retried there to report the error.
+  if (use_loader_threads) {
+    struct PendingMap {
+      LoadTask* task;
+      ElfReader* elf_reader;
+      address_space_params* address_space;
+    };
+    std::vector<PendingMap> pending;
+    for (auto&& task : load_list) {
+      address_space_params* address_space = get_address_space(task);
+      if (address_space->reserved_size == 0) {
+        pending.push_back({task, &task->get_elf_reader(), address_space});
+      }
+    }
+    loader_parallel_for(pending.size(), [&](size_t i) {
+      pending[i].task->map(pending[i].elf_reader, pending[i].address_space);
+    });
+  }
+
+  // After a failure keep going for the libraries that are already mapped, so that each of
+  // those mappings belongs to a soinfo and is unmapped when the load is rolled back.
+  bool loaded = true;
   for (auto&& task : load_list) {
-    address_space_params* address_space =
-        (reserved_address_recursive || !task->is_dt_needed()) ? &extinfo_params : &default_params;
-    if (!task->load(address_space)) {
-      return false;
+    if (!loaded && !task->get_elf_reader().did_load()) {
+      continue;
+    }
+    if (!task->load(get_address_space(task))) {
+      loaded = false;
     }
   }
+  if (!loaded) {
+    return false;
+  }
 
   // Step 3: pre-link all DT_NEEDED libraries in breadth first order.
   for (auto&& task : load_tasks) {
@@ -1700,6 +2014,23 @@ bool find_libraries(android_namespace_t* ns,
     register_soinfo_tls(si);
   }
 
+  // Relocating on the loader threads needs the static TLS layout to be final, because that sizes
+  // each helper's mapping. During the initial load every static TLS module has been registered by
+  // now, so the layout can be finalized early.
+  //
+  // This runs before __libc_init_main_thread_final(), which only moves the main thread onto its
+  // final static TLS. Nothing on a helper depends on that: a helper is a raw thread with its own
+  // TCB and stack guard (see run_on_loader_threads()), and the relocations applied concurrently
+  // only look up symbols and write to the libraries being relocated. TLS relocations and ifunc
+  // resolvers, which could reach the main thread's TLS, are left for soinfo::relocate() on the
+  // calling thread.
+  const bool use_concurrent_relocation = should_use_loader_threads() &&
+                                         __libc_shared_globals()->load_hook == nullptr &&
+                                         ConcurrentRelocation::is_supported();
+  if (use_concurrent_relocation) {
+    linker_finalize_static_tls();
+  }
+
   // Step 4: Construct the global group. DF_1_GLOBAL bit is force set for LD_PRELOADed libs because
   // they must be added to the global group. Note: The DF_1_GLOBAL bit for a library is normally set
   // in step 3.
@@ -1752,6 +2083,7 @@ bool find_libraries(android_namespace_t* ns,
   }
 
   // Step 6: Link all local groups
+  MprotectBatch relro_batch;
   for (auto root : local_group_roots) {
     soinfo_list_t local_group;
     android_namespace_t* local_group_ns = root->get_primary_namespace();
@@ -1770,6 +2102,22 @@ bool find_libraries(android_namespace_t* ns,
     SymbolLookupList lookup_list(global_group, local_group);
     soinfo* local_group_root = local_group.front();
 
+    // Roughly one symbol lookup is needed per symbol imported by the libraries linked below.
+    size_t lookup_count = 0;
+    ConcurrentRelocation concurrent_relocation;
+    local_group.for_each([&](soinfo* si) {
+      if (!si->is_linked() && si->get_primary_namespace() == local_group_ns) {
+        lookup_count += si->get_lookup_lib().gnu_symndx();
+        if (use_concurrent_relocation) {
+          concurrent_relocation.add(si);
+        }
+      }
+    });
+    lookup_list.build_provider_table(lookup_count);
+    if (use_concurrent_relocation) {
+      concurrent_relocation.run(lookup_list);
+    }
+
     bool linked = local_group.visit([&](soinfo* si) {
       // Even though local group may contain accessible soinfos from other namespaces
       // we should avoid linking them (because if they are not linked -> they
@@ -1785,7 +2133,8 @@ bool find_libraries(android_namespace_t* ns,
           __libc_shared_globals()->load_hook(si->load_bias, si->phdr, si->phnum);
         }
         lookup_list.set_dt_symbolic_lib(si->has_DT_SYMBOLIC ? si : nullptr);
-        if (!si->link_image(lookup_list, local_group_root, link_extinfo, &relro_fd_offset) ||
+        if (!si->link_image(lookup_list, local_group_root, link_extinfo, &relro_fd_offset,
+                            &concurrent_relocation, &relro_batch) ||
             !get_cfi_shadow()->AfterLoad(si, solist_get_head())) {
           return false;
         }
@@ -1795,10 +2144,21 @@ bool find_libraries(android_namespace_t* ns,
     });
 
     if (!linked) {
+      // The caller unloads what was loaded, but until then everything is still mapped.
+      relro_batch.apply();
       return false;
     }
   }
 
+  // Protect the RELRO of everything that was linked above, coalescing adjacent ranges.
+  bool relro_protected = relro_batch.apply();
+  count_protection(kProtectRange, relro_batch.range_count());
+  count_protection(kProtectCall, relro_batch.call_count());
+  if (!relro_protected) {
+    DL_ERR("can't enable GNU RELRO protection: %s", strerror(errno));
+    return false;
+  }
+
   // Step 7: Mark all load_tasks as linked and increment refcounts
   // for references between load_groups (at this point it does not matter if
   // referenced load_groups were loaded by previous dlopen or as part of this
@@ -1822,6 +2182,8 @@ bool find_libraries(android_namespace_t* ns,
     }
   }
 
+  // Make the new libraries visible to dl_iterate_phdr() before any of their constructors run.
+  publish_loaded_libraries();
 
   return true;
 }
@@ -1915,19 +2277,23 @@ static void soinfo_unload_impl(soinfo* root) {
            si);
   });
 
+  // Hide the libraries from dl_iterate_phdr(). A concurrent reader might still be looking at
+  // them, so soinfo_free() leaves them mapped until it has finished.
+  local_unload_list.for_each([](soinfo*) { ++g_module_unload_counter; });
+  publish_loaded_libraries([&](soinfo* si) { return local_unload_list.contains(si); });
+
   while ((si = local_unload_list.pop_front()) != nullptr) {
     LD_LOG(kLogDlopen,
            "... dlclose: unloading \"%s\"@%p ...",
            si->get_realpath(),
            si);
-    ++g_module_unload_counter;
     notify_gdb_of_unload(si);
     unregister_soinfo_tls(si);
     if (__libc_shared_globals()->unload_hook) {
       __libc_shared_globals()->unload_hook(si->load_bias, si->phdr, si->phnum);
     }
     get_cfi_shadow()->BeforeUnload(si);
-    soinfo_free(si);
+    soinfo_free(si, true);
   }
 
   if (is_linked) {
@@ -2211,6 +2577,7 @@ void* do_dlopen(const char* name, int flags,
 
   if (si != nullptr) {
     void* handle = si->to_handle();
+    si->create_dlsym_cache();
     LD_LOG(kLogDlopen,
            "... dlopen calling constructors: realpath=\"%s\", soname=\"%s\", handle=%p",
            si->get_realpath(), si->get_soname(), handle);
@@ -2317,7 +2684,7 @@ bool do_dlsym(void* handle,
       DL_SYM_ERR("dlsym failed: invalid handle: %p", handle);
       return false;
     }
-    sym = dlsym_handle_lookup(si, &found, sym_name, vi);
+    sym = dlsym_handle_lookup_cached(si, &found, sym_name, vi);
   }
 
   if (sym != nullptr) {
@@ -2423,6 +2790,7 @@ bool init_anonymous_namespace(const char* shared_lib_sonames, const char* librar
 }
 
 static void add_soinfos_to_namespace(const soinfo_list_t& soinfos, android_namespace_t* ns) {
+  ++g_namespace_change_counter;
   ns->add_soinfos(soinfos);
   for (auto si : soinfos) {
     si->add_secondary_namespace(ns);
@@ -2474,6 +2842,7 @@ android_namespace_t* create_namespace(const void* caller_addr,
   ns->set_isolated((type & ANDROID_NAMESPACE_TYPE_ISOLATED) != 0);
   ns->set_exempt_list_enabled((type & ANDROID_NAMESPACE_TYPE_EXEMPT_LIST_ENABLED) != 0);
   ns->set_also_used_as_anonymous((type & ANDROID_NAMESPACE_TYPE_ALSO_USED_AS_ANONYMOUS) != 0);
+  ns->set_hugepage_text_policy(parent_namespace->hugepage_text_policy());
 
   if ((type & ANDROID_NAMESPACE_TYPE_SHARED) != 0) {
     // append parent namespace paths.
@@ -2716,6 +3085,25 @@ ElfW(Versym) find_verdef_version_index(const soinfo* si, const version_info* vi)
   return result;
 }
 
+// Returns si's own copy of the name of the version vi, or nullptr if si doesn't define it.
+static const char* find_verdef_name(const soinfo* si, const version_info* vi) {
+  const char* result = nullptr;
+
+  for_each_verdef(si,
+    [&](size_t, const ElfW(Verdef)* verdef, const ElfW(Verdaux)* verdaux) {
+      const char* name = si->get_string(verdaux->vda_name);
+      if (verdef->vd_hash == vi->elf_hash && strcmp(vi->name, name) == 0) {
+        result = name;
+        return true;
+      }
+
+      return false;
+    }
+  );
+
+  return result;
+}
+
 // Validate the library's verdef section. On error, returns false and invokes DL_ERR.
 bool validate_verdef_section(const soinfo* si) {
   return for_each_verdef(si,
@@ -2769,6 +3157,10 @@ bool soinfo::lookup_version_info(const VersionTracker& version_tracker, ElfW(Wor
 
 void soinfo::apply_relr_reloc(ElfW(Addr) offset) {
   ElfW(Addr) address = offset + load_bias;
+  if (__predict_false(address - cached_relro_start_ < cached_relro_size_)) {
+    // Already applied in the RELRO cache.
+    return;
+  }
   *reinterpret_cast<ElfW(Addr)*>(address) += load_bias;
 }
 
@@ -2776,12 +3168,16 @@ void soinfo::apply_relr_reloc(ElfW(Addr) offset) {
 // Details of the encoding are described in this post:
 //   https://groups.google.com/d/msg/generic-abi/bX460iggiKg/Pi9aSwwABgAJ
 bool soinfo::relocate_relr() {
-  ElfW(Relr)* begin = relr_;
-  ElfW(Relr)* end = relr_ + relr_count_;
+  relocate_relr(relr_, relr_ + relr_count_);
+  return true;
+}
+
+// Applies the RELR entries in [begin, end), which must start with an address (even) entry.
+void soinfo::relocate_relr(const ElfW(Relr)* begin, const ElfW(Relr)* end) {
   constexpr size_t wordsize = sizeof(ElfW(Addr));
 
   ElfW(Addr) base = 0;
-  for (ElfW(Relr)* current = begin; current < end; ++current) {
+  for (const ElfW(Relr)* current = begin; current < end; ++current) {
     ElfW(Relr) entry = *current;
     ElfW(Addr) offset;
 
@@ -2808,7 +3204,6 @@ bool soinfo::relocate_relr() {
     // or 31 words for 32-bit platforms.
     base += (8*wordsize - 1) * wordsize;
   }
-  return true;
 }
 
 // An empty list of soinfos
@@ -2843,6 +3238,11 @@ bool soinfo::prelink_image() {
                                   &ARM_exidx, &ARM_exidx_count);
 #endif
 
+  if (!phdr_table_get_build_id(phdr, phnum, load_bias, &build_id_, &build_id_size_)) {
+    build_id_ = nullptr;
+    build_id_size_ = 0;
+  }
+
   TlsSegment tls_segment;
   if (__bionic_get_tls_segment(phdr, phnum, load_bias, &tls_segment)) {
     if (!__bionic_check_tls_alignment(&tls_segment.alignment)) {
@@ -3288,7 +3688,9 @@ bool soinfo::prelink_image() {
 }
 
 bool soinfo::link_image(const SymbolLookupList& lookup_list, soinfo* local_group_root,
-                        const android_dlextinfo* extinfo, size_t* relro_fd_offset) {
+                        const android_dlextinfo* extinfo, size_t* relro_fd_offset,
+                        const ConcurrentRelocation* concurrent_relocation,
+                        MprotectBatch* relro_batch) {
   if (is_image_linked()) {
     // already linked.
     return true;
@@ -3331,7 +3733,15 @@ bool soinfo::link_image(const SymbolLookupList& lookup_list, soinfo* local_group
   }
 #endif
 
-  if (!relocate(lookup_list)) {
+  // Libraries whose RELRO is managed by the caller through android_dlextinfo don't use the cache.
+  RelroCache relro_cache;
+  if (is_relro_cache_enabled() &&
+      !(extinfo && (extinfo->flags & (ANDROID_DLEXT_WRITE_RELRO | ANDROID_DLEXT_USE_RELRO)))) {
+    relro_cache.init(this, lookup_list);
+    relro_cache.map();
+  }
+
+  if (!relocate(lookup_list, concurrent_relocation, &relro_cache)) {
     return false;
   }
 
@@ -3350,8 +3760,15 @@ bool soinfo::link_image(const SymbolLookupList& lookup_list, soinfo* local_group
 
   // We can also turn on GNU RELRO protection if we're not linking the dynamic linker
   // itself --- it can't make system calls yet, and will have to call protect_relro later.
-  if (!is_linker() && !protect_relro()) {
-    return false;
+  // If the caller is linking a batch of libraries, it applies the protection for all of them
+  // at once, unless the RELRO is about to be shared and needs to be read-only already.
+  if (!is_linker()) {
+    if (relro_batch != nullptr &&
+        !(extinfo && (extinfo->flags & (ANDROID_DLEXT_WRITE_RELRO | ANDROID_DLEXT_USE_RELRO)))) {
+      phdr_table_protect_gnu_relro(phdr, phnum, load_bias, relro_batch);
+    } else if (!protect_relro()) {
+      return false;
+    }
   }
 
   /* Handle serializing/sharing the RELRO segment */
@@ -3547,6 +3964,7 @@ std::vector<android_namespace_t*> init_default_namespaces(const char* executable
   g_default_namespace.set_isolated(default_ns_config->isolated());
   g_default_namespace.set_default_library_paths(default_ns_config->search_paths());
   g_default_namespace.set_permitted_paths(default_ns_config->permitted_paths());
+  g_default_namespace.set_hugepage_text_policy(default_ns_config->hugepage_text_policy());
 
   namespaces[default_ns_config->name()] = &g_default_namespace;
   if (default_ns_config->visible()) {
@@ -3566,6 +3984,7 @@ std::vector<android_namespace_t*> init_default_namespaces(const char* executable
     ns->set_default_library_paths(ns_config->search_paths());
     ns->set_permitted_paths(ns_config->permitted_paths());
     ns->set_allowed_libs(ns_config->allowed_libs());
+    ns->set_hugepage_text_policy(ns_config->hugepage_text_policy());
 
     namespaces[ns_config->name()] = ns;
     if (ns_config->visible()) {
@@ -79,6 +79,9 @@ soinfo* get_libdl_info(const soinfo& linker_si);
 
 soinfo* find_containing_library(const void* p);
 
+// Makes the [base, base + size) range of a mapped soinfo visible to find_containing_library.
+void register_soinfo_address_range(soinfo* si);
+
 int open_executable(const char* path, off64_t* file_offset, std::string* realpath);
 
 void do_android_get_LD_LIBRARY_PATH(char*, size_t);
@@ -180,6 +183,8 @@ struct address_space_params {
   bool must_use_address = false;
 };
 
+void set_hugepage_text_policy_override(HugepageTextPolicy policy);
+
 int get_application_target_sdk_version();
 ElfW(Versym) find_verdef_version_index(const soinfo* si, const version_info* vi);
 bool validate_verdef_section(const soinfo* si);
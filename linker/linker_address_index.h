@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <link.h>
+#include <stddef.h>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include <android-base/macros.h>
+
+// A sorted table of non-overlapping [start, end) address ranges, each mapped to a value. This
+// is used to map an arbitrary address to the library containing it in O(log n) rather than
+// walking every loaded soinfo.
+//
+// Ranges are added when a library's address space is reserved and removed when it is unmapped,
+// so the table is maintained incrementally and never needs to be rebuilt. The caller is
+// responsible for synchronization.
+template <typename T>
+class AddressRangeIndex {
+ public:
+  AddressRangeIndex() = default;
+
+  // Adds [start, start + size). Returns false (and leaves the index unchanged) if the range is
+  // empty or overlaps a range already in the index.
+  bool insert(ElfW(Addr) start, size_t size, T value) {
+    if (size == 0 || start + size < start) {
+      return false;
+    }
+    ElfW(Addr) end = start + size;
+    auto it = upper_bound(start);
+    if (it != entries_.end() && it->start < end) {
+      return false;
+    }
+    if (it != entries_.begin() && std::prev(it)->end > start) {
+      return false;
+    }
+    entries_.insert(it, Entry{start, end, value});
+    return true;
+  }
+
+  // Removes the range starting at `start` if it maps to `value`.
+  bool erase(ElfW(Addr) start, T value) {
+    auto it = upper_bound(start);
+    if (it == entries_.begin()) {
+      return false;
+    }
+    --it;
+    if (it->start != start || it->value != value) {
+      return false;
+    }
+    entries_.erase(it);
+    return true;
+  }
+
+  // Returns the value of the range containing `address`, or `not_found` if there is none.
+  T find(ElfW(Addr) address, T not_found) const {
+    auto it = upper_bound(address);
+    if (it == entries_.begin()) {
+      return not_found;
+    }
+    --it;
+    return address < it->end ? it->value : not_found;
+  }
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    ElfW(Addr) start;
+    ElfW(Addr) end;
+    T value;
+  };
+
+  // Returns the first entry starting strictly after `address`.
+  typename std::vector<Entry>::iterator upper_bound(ElfW(Addr) address) {
+    return std::upper_bound(entries_.begin(), entries_.end(), address,
+                            [](ElfW(Addr) a, const Entry& e) { return a < e.start; });
+  }
+
+  typename std::vector<Entry>::const_iterator upper_bound(ElfW(Addr) address) const {
+    return std::upper_bound(entries_.begin(), entries_.end(), address,
+                            [](ElfW(Addr) a, const Entry& e) { return a < e.start; });
+  }
+
+  std::vector<Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(AddressRangeIndex);
+};
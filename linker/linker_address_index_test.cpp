@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "linker_address_index.h"
+
+TEST(linker_address_index, empty) {
+  AddressRangeIndex<int> index;
+  ASSERT_EQ(0U, index.size());
+  ASSERT_EQ(-1, index.find(0x1000, -1));
+  ASSERT_FALSE(index.erase(0x1000, 1));
+}
+
+TEST(linker_address_index, find) {
+  AddressRangeIndex<int> index;
+  // Insert out of order to make sure the table stays sorted.
+  ASSERT_TRUE(index.insert(0x5000, 0x1000, 2));
+  ASSERT_TRUE(index.insert(0x1000, 0x2000, 1));
+  ASSERT_TRUE(index.insert(0x8000, 0x1000, 3));
+  ASSERT_EQ(3U, index.size());
+
+  ASSERT_EQ(-1, index.find(0x0fff, -1));
+  ASSERT_EQ(1, index.find(0x1000, -1));
+  ASSERT_EQ(1, index.find(0x2fff, -1));
+  ASSERT_EQ(-1, index.find(0x3000, -1));
+  ASSERT_EQ(-1, index.find(0x4fff, -1));
+  ASSERT_EQ(2, index.find(0x5000, -1));
+  ASSERT_EQ(2, index.find(0x5fff, -1));
+  ASSERT_EQ(-1, index.find(0x6000, -1));
+  ASSERT_EQ(3, index.find(0x8800, -1));
+  ASSERT_EQ(-1, index.find(0x9000, -1));
+}
+
+TEST(linker_address_index, rejects_overlap) {
+  AddressRangeIndex<int> index;
+  ASSERT_TRUE(index.insert(0x2000, 0x2000, 1));
+
+  ASSERT_FALSE(index.insert(0x1000, 0x1001, 2));
+  ASSERT_FALSE(index.insert(0x3fff, 0x1000, 2));
+  ASSERT_FALSE(index.insert(0x2800, 0x100, 2));
+  ASSERT_FALSE(index.insert(0x1000, 0x4000, 2));
+  ASSERT_FALSE(index.insert(0x6000, 0, 2));
+  ASSERT_EQ(1U, index.size());
+
+  // Adjacent ranges are fine.
+  ASSERT_TRUE(index.insert(0x1000, 0x1000, 2));
+  ASSERT_TRUE(index.insert(0x4000, 0x1000, 3));
+  ASSERT_EQ(2, index.find(0x1fff, -1));
+  ASSERT_EQ(1, index.find(0x2000, -1));
+  ASSERT_EQ(3, index.find(0x4000, -1));
+}
+
+TEST(linker_address_index, erase) {
+  AddressRangeIndex<int> index;
+  ASSERT_TRUE(index.insert(0x1000, 0x1000, 1));
+  ASSERT_TRUE(index.insert(0x2000, 0x1000, 2));
+
+  // Both the start address and the value must match.
+  ASSERT_FALSE(index.erase(0x1800, 1));
+  ASSERT_FALSE(index.erase(0x1000, 2));
+
+  ASSERT_TRUE(index.erase(0x1000, 1));
+  ASSERT_EQ(1U, index.size());
+  ASSERT_EQ(-1, index.find(0x1000, -1));
+  ASSERT_EQ(2, index.find(0x2000, -1));
+
+  // The freed range can be reused.
+  ASSERT_TRUE(index.insert(0x1000, 0x800, 3));
+  ASSERT_EQ(3, index.find(0x1000, -1));
+  ASSERT_EQ(-1, index.find(0x1800, -1));
+}
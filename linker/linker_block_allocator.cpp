@@ -36,6 +36,7 @@
 #include <unistd.h>
 
 #include "linker_debug.h"
+#include "linker_mprotect_batch.h"
 
 static constexpr size_t kAllocateSize = PAGE_SIZE * 100;
 static_assert(kAllocateSize % PAGE_SIZE == 0, "Invalid kAllocateSize.");
@@ -106,10 +107,17 @@ void LinkerBlockAllocator::free(void* block) {
 }
 
 void LinkerBlockAllocator::protect_all(int prot) {
+  // Pages mapped one after another are usually adjacent, so this takes fewer calls than pages.
+  MprotectBatch batch;
+  protect_all(prot, &batch);
+  if (!batch.apply()) {
+    async_safe_fatal("mprotect(%d) of linker allocator pages failed: %m", prot);
+  }
+}
+
+void LinkerBlockAllocator::protect_all(int prot, MprotectBatch* batch) {
   for (LinkerBlockAllocatorPage* page = page_list_; page != nullptr; page = page->next) {
-    if (mprotect(page, kAllocateSize, prot) == -1) {
-      async_safe_fatal("mprotect(%p, %zu, %d) failed: %m", page, kAllocateSize, prot);
-    }
+    batch->add(page, kAllocateSize, prot);
   }
 }
 
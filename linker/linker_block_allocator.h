@@ -37,6 +37,7 @@ static constexpr size_t kBlockSizeAlign = sizeof(void*);
 static constexpr size_t kBlockSizeMin = sizeof(void*) * 2;
 
 struct LinkerBlockAllocatorPage;
+class MprotectBatch;
 
 /*
  * This class is a non-template version of the LinkerTypeAllocator
@@ -52,6 +53,8 @@ class LinkerBlockAllocator {
   void* alloc();
   void free(void* block);
   void protect_all(int prot);
+  // Adds all pages to `batch` to be changed to `prot` along with other memory.
+  void protect_all(int prot, MprotectBatch* batch);
 
   // Purge all pages if all previously allocated blocks have been freed.
   void purge();
@@ -92,6 +95,7 @@ class LinkerTypeAllocator {
   T* alloc() { return reinterpret_cast<T*>(block_allocator_.alloc()); }
   void free(T* t) { block_allocator_.free(t); }
   void protect_all(int prot) { block_allocator_.protect_all(prot); }
+  void protect_all(int prot, MprotectBatch* batch) { block_allocator_.protect_all(prot, batch); }
  private:
   LinkerBlockAllocator block_allocator_;
   DISALLOW_COPY_AND_ASSIGN(LinkerTypeAllocator);
@@ -39,12 +39,18 @@
 
 #include <async_safe/log.h>
 
+#include <fcntl.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <map>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
 #include <sys/_system_properties.h>
@@ -179,6 +185,139 @@ static std::string create_error_msg(const char* file,
   return std::string(buf);
 }
 
+// Checks a dir.<section_name> property from the mappings part of the config.
+// Returns false (after warning about it) if the line should be ignored,
+// otherwise strips the trailing '/' from *value.
+static bool get_dir_property_value(const char* ld_config_file_path,
+                                   size_t lineno,
+                                   const std::string& name,
+                                   std::string* value) {
+  if (!android::base::StartsWith(name, "dir.")) {
+    DL_WARN("%s:%zd: warning: unexpected property name \"%s\", "
+            "expected format dir.<section_name> (ignoring this line)",
+            ld_config_file_path,
+            lineno,
+            name.c_str());
+    return false;
+  }
+
+  // remove trailing '/'
+  while (!value->empty() && value->back() == '/') {
+    value->pop_back();
+  }
+
+  if (value->empty()) {
+    DL_WARN("%s:%zd: warning: property value is empty (ignoring this line)",
+            ld_config_file_path,
+            lineno);
+    return false;
+  }
+
+  return true;
+}
+
+static bool is_binary_under_config_dir(const char* ld_config_file_path,
+                                       size_t lineno,
+                                       const std::string& value,
+                                       const char* binary_realpath) {
+  // If the path can be resolved, resolve it
+  char buf[PATH_MAX];
+  std::string resolved_path;
+  if (access(value.c_str(), R_OK) != 0) {
+    if (errno == ENOENT) {
+      // no need to test for non-existing path. skip.
+      return false;
+    }
+    // If not accessible, don't call realpath as it will just cause
+    // SELinux denial spam. Use the path unresolved.
+    resolved_path = value;
+  } else if (realpath(value.c_str(), buf)) {
+    resolved_path = buf;
+  } else {
+    // realpath is expected to fail with EPERM in some situations, so log
+    // the failure with INFO rather than DL_WARN. e.g. A binary in
+    // /data/local/tmp may attempt to stat /postinstall. See
+    // http://b/120996057.
+    INFO("%s:%zd: warning: path \"%s\" couldn't be resolved: %s",
+         ld_config_file_path,
+         lineno,
+         value.c_str(),
+         strerror(errno));
+    resolved_path = value;
+  }
+
+  return file_is_under_dir(binary_realpath, resolved_path);
+}
+
+// Parses the properties of a section until the start of the next section or
+// the end of the file. Returns ConfigParser::kSection and sets
+// *next_section_name, or returns ConfigParser::kEndOfFile.
+static int parse_config_section(ConfigParser* cp,
+                                const char* ld_config_file_path,
+                                std::unordered_map<std::string, PropertyValue>* properties,
+                                std::string* next_section_name) {
+  while (true) {
+    std::string name;
+    std::string value;
+    std::string error;
+
+    int result = cp->next_token(&name, &value, &error);
+
+    if (result == ConfigParser::kEndOfFile) {
+      return result;
+    }
+
+    if (result == ConfigParser::kSection) {
+      *next_section_name = std::move(name);
+      return result;
+    }
+
+    if (result == ConfigParser::kPropertyAssign) {
+      if (properties->find(name) != properties->end()) {
+        DL_WARN("%s:%zd: warning: redefining property \"%s\" (overriding previous value)",
+                ld_config_file_path,
+                cp->lineno(),
+                name.c_str());
+      }
+
+      (*properties)[name] = PropertyValue(std::move(value), cp->lineno());
+    } else if (result == ConfigParser::kPropertyAppend) {
+      if (properties->find(name) == properties->end()) {
+        DL_WARN("%s:%zd: warning: appending to undefined property \"%s\" (treating as assignment)",
+                ld_config_file_path,
+                cp->lineno(),
+                name.c_str());
+        (*properties)[name] = PropertyValue(std::move(value), cp->lineno());
+      } else {
+        if (android::base::EndsWith(name, ".links") ||
+            android::base::EndsWith(name, ".namespaces")) {
+          value = "," + value;
+          (*properties)[name].append_value(std::move(value));
+        } else if (android::base::EndsWith(name, ".paths") ||
+                   android::base::EndsWith(name, ".shared_libs") ||
+                   android::base::EndsWith(name, ".whitelisted") ||
+                   android::base::EndsWith(name, ".allowed_libs")) {
+          value = ":" + value;
+          (*properties)[name].append_value(std::move(value));
+        } else {
+          DL_WARN("%s:%zd: warning: += isn't allowed for property \"%s\" (ignoring)",
+                  ld_config_file_path,
+                  cp->lineno(),
+                  name.c_str());
+        }
+      }
+    }
+
+    if (result == ConfigParser::kError) {
+      DL_WARN("%s:%zd: warning: couldn't parse %s (ignoring this line)",
+              ld_config_file_path,
+              cp->lineno(),
+              error.c_str());
+      continue;
+    }
+  }
+}
+
 static bool parse_config_file(const char* ld_config_file_path,
                               const char* binary_realpath,
                               std::unordered_map<std::string, PropertyValue>* properties,
@@ -215,54 +354,11 @@ static bool parse_config_file(const char* ld_config_file_path,
     }
 
     if (result == ConfigParser::kPropertyAssign) {
-      if (!android::base::StartsWith(name, "dir.")) {
-        DL_WARN("%s:%zd: warning: unexpected property name \"%s\", "
-                "expected format dir.<section_name> (ignoring this line)",
-                ld_config_file_path,
-                cp.lineno(),
-                name.c_str());
-        continue;
-      }
-
-      // remove trailing '/'
-      while (!value.empty() && value.back() == '/') {
-        value.pop_back();
-      }
-
-      if (value.empty()) {
-        DL_WARN("%s:%zd: warning: property value is empty (ignoring this line)",
-                ld_config_file_path,
-                cp.lineno());
+      if (!get_dir_property_value(ld_config_file_path, cp.lineno(), name, &value)) {
         continue;
       }
 
-      // If the path can be resolved, resolve it
-      char buf[PATH_MAX];
-      std::string resolved_path;
-      if (access(value.c_str(), R_OK) != 0) {
-        if (errno == ENOENT) {
-          // no need to test for non-existing path. skip.
-          continue;
-        }
-        // If not accessible, don't call realpath as it will just cause
-        // SELinux denial spam. Use the path unresolved.
-        resolved_path = value;
-      } else if (realpath(value.c_str(), buf)) {
-        resolved_path = buf;
-      } else {
-        // realpath is expected to fail with EPERM in some situations, so log
-        // the failure with INFO rather than DL_WARN. e.g. A binary in
-        // /data/local/tmp may attempt to stat /postinstall. See
-        // http://b/120996057.
-        INFO("%s:%zd: warning: path \"%s\" couldn't be resolved: %s",
-             ld_config_file_path,
-             cp.lineno(),
-             value.c_str(),
-             strerror(errno));
-        resolved_path = value;
-      }
-
-      if (file_is_under_dir(binary_realpath, resolved_path)) {
+      if (is_binary_under_config_dir(ld_config_file_path, cp.lineno(), value, binary_realpath)) {
         section_name = name.substr(4);
         break;
       }
@@ -292,65 +388,347 @@ static bool parse_config_file(const char* ld_config_file_path,
   }
 
   // found the section - parse it
-  while (true) {
-    std::string name;
-    std::string value;
-    std::string error;
+  std::string next_section_name;
+  parse_config_section(&cp, ld_config_file_path, properties, &next_section_name);
 
-    int result = cp.next_token(&name, &value, &error);
+  return true;
+}
 
-    if (result == ConfigParser::kEndOfFile || result == ConfigParser::kSection) {
-      break;
+// The compiled config is a precomputed form of ld.config.txt that the linker
+// maps instead of parsing the text. It contains the dir.<section_name>
+// mappings in file order and, for every section, the properties that
+// parse_config_section() would produce, sorted by name. Everything that
+// depends on the device at run time (resolving the mapped directories,
+// ${LIB}/${SDK_VER}/${VNDK_VER} expansion, resolving search paths) is still
+// done by the linker.
+//
+// Layout (native byte order):
+//   CompiledConfigHeader
+//   CompiledConfigDir[dir_count]
+//   CompiledConfigSection[section_count]
+//   CompiledConfigProperty[property_count]
+//   string table (string_table_size bytes of NUL-terminated strings)
+//
+// All strings are offsets into the string table. The header records the
+// size and checksum of the text it was compiled from, so a stale compiled
+// config is ignored and the text is parsed instead.
+static constexpr uint32_t kCompiledConfigMagic = 0x4342444c; // "LDBC"
+static constexpr uint32_t kCompiledConfigVersion = 1;
+
+struct CompiledConfigHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;
+  uint32_t line_count;
+  uint64_t checksum;
+  uint64_t source_size;
+  uint64_t source_checksum;
+  uint32_t dir_count;
+  uint32_t section_count;
+  uint32_t property_count;
+  uint32_t string_table_size;
+};
+
+struct CompiledConfigDir {
+  uint32_t section_name;
+  uint32_t path;
+  uint32_t lineno;
+};
+
+struct CompiledConfigSection {
+  uint32_t name;
+  uint32_t first_property;
+  uint32_t property_count;
+};
+
+struct CompiledConfigProperty {
+  uint32_t name;
+  uint32_t value;
+  uint32_t lineno;
+};
+
+// 64-bit FNV-1a, eight bytes at a time. This only needs to detect stale or
+// truncated files, not malicious ones: both files are as trusted as each other.
+static uint64_t compiled_config_checksum(const void* data, size_t size) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (; size >= sizeof(uint64_t); p += sizeof(uint64_t), size -= sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    h = (h ^ word) * 0x100000001b3ULL;
+  }
+  for (; size > 0; ++p, --size) {
+    h = (h ^ *p) * 0x100000001b3ULL;
+  }
+  return h;
+}
+
+class MappedConfigFile {
+ public:
+  MappedConfigFile() : data_(nullptr), size_(0) {}
+
+  ~MappedConfigFile() {
+    if (data_ != nullptr) {
+      munmap(data_, size_);
     }
+  }
 
-    if (result == ConfigParser::kPropertyAssign) {
-      if (properties->find(name) != properties->end()) {
-        DL_WARN("%s:%zd: warning: redefining property \"%s\" (overriding previous value)",
-                ld_config_file_path,
-                cp.lineno(),
-                name.c_str());
+  // Returns false and sets errno on failure.
+  bool map(const char* path) {
+    int fd = TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC));
+    if (fd == -1) {
+      return false;
+    }
+    auto fd_guard = android::base::make_scope_guard([fd] {
+      int saved_errno = errno;
+      close(fd);
+      errno = saved_errno;
+    });
+
+    struct stat sb;
+    if (fstat(fd, &sb) == -1) {
+      return false;
+    }
+
+    if (sb.st_size == 0) {
+      return true;
+    }
+
+    void* data = mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+
+    data_ = data;
+    size_ = sb.st_size;
+    return true;
+  }
+
+  const void* data() const {
+    return data_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  void* data_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedConfigFile);
+};
+
+class CompiledConfig {
+ public:
+  CompiledConfig()
+      : header_(nullptr), dirs_(nullptr), sections_(nullptr), properties_(nullptr),
+        strings_(nullptr) {}
+
+  // Maps the compiled config for ld_config_file_path. Returns false if there
+  // is none or it can't be used, in which case the text should be parsed.
+  bool load(const char* ld_config_file_path) {
+    std::string compiled_path = Config::get_compiled_config_path(ld_config_file_path);
+    auto ignore = [&compiled_path](const char* reason) {
+      INFO("[ Ignoring compiled linker config \"%s\": %s ]", compiled_path.c_str(), reason);
+      return false;
+    };
+
+    if (!file_.map(compiled_path.c_str())) {
+      return errno == ENOENT ? false : ignore(strerror(errno));
+    }
+
+    if (file_.size() < sizeof(CompiledConfigHeader)) {
+      return ignore("truncated file");
+    }
+
+    const char* base = static_cast<const char*>(file_.data());
+    const CompiledConfigHeader* header = reinterpret_cast<const CompiledConfigHeader*>(base);
+    if (header->magic != kCompiledConfigMagic || header->version != kCompiledConfigVersion) {
+      return ignore("unsupported format");
+    }
+
+    uint64_t dirs_offset = sizeof(CompiledConfigHeader);
+    uint64_t sections_offset = dirs_offset + uint64_t(header->dir_count) * sizeof(CompiledConfigDir);
+    uint64_t properties_offset =
+        sections_offset + uint64_t(header->section_count) * sizeof(CompiledConfigSection);
+    uint64_t strings_offset =
+        properties_offset + uint64_t(header->property_count) * sizeof(CompiledConfigProperty);
+    if (header->size != file_.size() ||
+        strings_offset + header->string_table_size != file_.size()) {
+      return ignore("truncated file");
+    }
+
+    if (compiled_config_checksum(base + sizeof(CompiledConfigHeader),
+                                 file_.size() - sizeof(CompiledConfigHeader)) != header->checksum) {
+      return ignore("checksum mismatch");
+    }
+
+    header_ = header;
+    dirs_ = reinterpret_cast<const CompiledConfigDir*>(base + dirs_offset);
+    sections_ = reinterpret_cast<const CompiledConfigSection*>(base + sections_offset);
+    properties_ = reinterpret_cast<const CompiledConfigProperty*>(base + properties_offset);
+    strings_ = base + strings_offset;
+
+    if (!is_well_formed()) {
+      header_ = nullptr;
+      return ignore("malformed file");
+    }
+
+    MappedConfigFile source;
+    if (!source.map(ld_config_file_path)) {
+      header_ = nullptr;
+      return ignore(strerror(errno));
+    }
+
+    if (source.size() != header_->source_size ||
+        compiled_config_checksum(source.data(), source.size()) != header_->source_checksum) {
+      header_ = nullptr;
+      return ignore("out of date");
+    }
+
+    return true;
+  }
+
+  size_t line_count() const {
+    return header_->line_count;
+  }
+
+  const CompiledConfigDir* dirs_begin() const {
+    return dirs_;
+  }
+
+  const CompiledConfigDir* dirs_end() const {
+    return dirs_ + header_->dir_count;
+  }
+
+  const CompiledConfigSection* find_section(const std::string& name) const {
+    for (uint32_t i = 0; i < header_->section_count; ++i) {
+      if (name == get_string(sections_[i].name)) {
+        return &sections_[i];
       }
+    }
+    return nullptr;
+  }
 
-      (*properties)[name] = PropertyValue(std::move(value), cp.lineno());
-    } else if (result == ConfigParser::kPropertyAppend) {
-      if (properties->find(name) == properties->end()) {
-        DL_WARN("%s:%zd: warning: appending to undefined property \"%s\" (treating as assignment)",
-                ld_config_file_path,
-                cp.lineno(),
-                name.c_str());
-        (*properties)[name] = PropertyValue(std::move(value), cp.lineno());
-      } else {
-        if (android::base::EndsWith(name, ".links") ||
-            android::base::EndsWith(name, ".namespaces")) {
-          value = "," + value;
-          (*properties)[name].append_value(std::move(value));
-        } else if (android::base::EndsWith(name, ".paths") ||
-                   android::base::EndsWith(name, ".shared_libs") ||
-                   android::base::EndsWith(name, ".whitelisted") ||
-                   android::base::EndsWith(name, ".allowed_libs")) {
-          value = ":" + value;
-          (*properties)[name].append_value(std::move(value));
-        } else {
-          DL_WARN("%s:%zd: warning: += isn't allowed for property \"%s\" (ignoring)",
-                  ld_config_file_path,
-                  cp.lineno(),
-                  name.c_str());
-        }
+  const CompiledConfigProperty* find_property(const CompiledConfigSection* section,
+                                              const std::string& name) const {
+    const CompiledConfigProperty* begin = properties_ + section->first_property;
+    const CompiledConfigProperty* end = begin + section->property_count;
+    const CompiledConfigProperty* it =
+        std::lower_bound(begin, end, name, [this](const CompiledConfigProperty& property,
+                                                  const std::string& name) {
+          return strcmp(get_string(property.name), name.c_str()) < 0;
+        });
+    return (it != end && name == get_string(it->name)) ? it : nullptr;
+  }
+
+  const char* get_string(uint32_t offset) const {
+    return strings_ + offset;
+  }
+
+ private:
+  bool is_well_formed() const {
+    uint32_t string_table_size = header_->string_table_size;
+    if (string_table_size == 0 || strings_[string_table_size - 1] != '\0') {
+      return false;
+    }
+
+    for (const CompiledConfigDir* dir = dirs_begin(); dir != dirs_end(); ++dir) {
+      if (dir->section_name >= string_table_size || dir->path >= string_table_size) {
+        return false;
       }
     }
 
-    if (result == ConfigParser::kError) {
-      DL_WARN("%s:%zd: warning: couldn't parse %s (ignoring this line)",
-              ld_config_file_path,
-              cp.lineno(),
-              error.c_str());
-      continue;
+    for (uint32_t i = 0; i < header_->section_count; ++i) {
+      const CompiledConfigSection& section = sections_[i];
+      if (section.name >= string_table_size ||
+          section.first_property > header_->property_count ||
+          section.property_count > header_->property_count - section.first_property) {
+        return false;
+      }
+    }
+
+    for (uint32_t i = 0; i < header_->property_count; ++i) {
+      const CompiledConfigProperty& property = properties_[i];
+      if (property.name >= string_table_size || property.value >= string_table_size) {
+        return false;
+      }
     }
+
+    return true;
+  }
+
+  MappedConfigFile file_;
+  const CompiledConfigHeader* header_;
+  const CompiledConfigDir* dirs_;
+  const CompiledConfigSection* sections_;
+  const CompiledConfigProperty* properties_;
+  const char* strings_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompiledConfig);
+};
+
+// The compiled equivalent of parse_config_file().
+static bool find_compiled_config_section(const CompiledConfig& compiled_config,
+                                         const char* ld_config_file_path,
+                                         const char* binary_realpath,
+                                         const CompiledConfigSection** section,
+                                         std::string* error_msg) {
+  const CompiledConfigDir* dir = compiled_config.dirs_begin();
+  for (; dir != compiled_config.dirs_end(); ++dir) {
+    if (is_binary_under_config_dir(ld_config_file_path, dir->lineno,
+                                   compiled_config.get_string(dir->path), binary_realpath)) {
+      break;
+    }
+  }
+
+  if (dir == compiled_config.dirs_end()) {
+    return false;
+  }
+
+  std::string section_name = compiled_config.get_string(dir->section_name);
+  INFO("[ Using config section \"%s\" ]", section_name.c_str());
+
+  *section = compiled_config.find_section(section_name);
+  if (*section == nullptr) {
+    *error_msg = create_error_msg(ld_config_file_path,
+                                  compiled_config.line_count(),
+                                  std::string("section \"") + section_name + "\" not found");
+    return false;
   }
 
   return true;
 }
 
+class CompiledConfigStringTable {
+ public:
+  uint32_t add(const std::string& s) {
+    auto it = offsets_.find(s);
+    if (it != offsets_.end()) {
+      return it->second;
+    }
+
+    uint32_t offset = data_.size();
+    data_.append(s.c_str(), s.size() + 1);
+    offsets_[s] = offset;
+    return offset;
+  }
+
+  const std::string& data() const {
+    return data_;
+  }
+
+ private:
+  std::string data_;
+  std::unordered_map<std::string, uint32_t> offsets_;
+};
+
+template <typename T>
+static void append_compiled_config_entries(std::string* binary, const std::vector<T>& entries) {
+  binary->append(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(T));
+}
+
 static Config g_config;
 
 static constexpr const char* kDefaultConfigName = "default";
@@ -359,16 +737,24 @@ static constexpr const char* kPropertyAdditionalNamespaces = "additional.namespa
 class Properties {
  public:
   explicit Properties(std::unordered_map<std::string, PropertyValue>&& properties)
-      : properties_(std::move(properties)), target_sdk_version_(__ANDROID_API__) {}
+      : properties_(std::move(properties)),
+        compiled_config_(nullptr),
+        compiled_section_(nullptr),
+        target_sdk_version_(__ANDROID_API__) {}
+
+  Properties(const CompiledConfig* compiled_config, const CompiledConfigSection* compiled_section)
+      : compiled_config_(compiled_config),
+        compiled_section_(compiled_section),
+        target_sdk_version_(__ANDROID_API__) {}
 
   std::vector<std::string> get_strings(const std::string& name, size_t* lineno = nullptr) const {
-    auto it = find_property(name, lineno);
-    if (it == properties_.end()) {
+    const char* value = find_property(name, lineno);
+    if (value == nullptr) {
       // return empty vector
       return std::vector<std::string>();
     }
 
-    std::vector<std::string> strings = android::base::Split(it->second.value(), ",");
+    std::vector<std::string> strings = android::base::Split(value, ",");
 
     for (size_t i = 0; i < strings.size(); ++i) {
       strings[i] = android::base::Trim(strings[i]);
@@ -378,17 +764,17 @@ class Properties {
   }
 
   bool get_bool(const std::string& name, size_t* lineno = nullptr) const {
-    auto it = find_property(name, lineno);
-    if (it == properties_.end()) {
+    const char* value = find_property(name, lineno);
+    if (value == nullptr) {
       return false;
     }
 
-    return it->second.value() == "true";
+    return strcmp(value, "true") == 0;
   }
 
   std::string get_string(const std::string& name, size_t* lineno = nullptr) const {
-    auto it = find_property(name, lineno);
-    return (it == properties_.end()) ? "" : it->second.value();
+    const char* value = find_property(name, lineno);
+    return (value == nullptr) ? "" : value;
   }
 
   std::vector<std::string> get_paths(const std::string& name, bool resolve, size_t* lineno = nullptr) {
@@ -444,16 +830,33 @@ class Properties {
   }
 
  private:
-  std::unordered_map<std::string, PropertyValue>::const_iterator
-  find_property(const std::string& name, size_t* lineno) const {
+  // Returns nullptr if the property is not defined.
+  const char* find_property(const std::string& name, size_t* lineno) const {
+    if (compiled_section_ != nullptr) {
+      const CompiledConfigProperty* property =
+          compiled_config_->find_property(compiled_section_, name);
+      if (property == nullptr) {
+        return nullptr;
+      }
+      if (lineno != nullptr) {
+        *lineno = property->lineno;
+      }
+      return compiled_config_->get_string(property->value);
+    }
+
     auto it = properties_.find(name);
-    if (it != properties_.end() && lineno != nullptr) {
+    if (it == properties_.end()) {
+      return nullptr;
+    }
+    if (lineno != nullptr) {
       *lineno = it->second.lineno();
     }
-
-    return it;
+    return it->second.value().c_str();
   }
+
   std::unordered_map<std::string, PropertyValue> properties_;
+  const CompiledConfig* compiled_config_;
+  const CompiledConfigSection* compiled_section_;
   std::unordered_map<std::string, std::string> resolved_paths_;
   int target_sdk_version_;
 
@@ -468,12 +871,22 @@ bool Config::read_binary_config(const char* ld_config_file_path,
                                       std::string* error_msg) {
   g_config.clear();
 
+  // Prefer the compiled config if there's an up to date one.
+  CompiledConfig compiled_config;
+  const CompiledConfigSection* compiled_section = nullptr;
   std::unordered_map<std::string, PropertyValue> property_map;
-  if (!parse_config_file(ld_config_file_path, binary_realpath, &property_map, error_msg)) {
+  if (compiled_config.load(ld_config_file_path)) {
+    if (!find_compiled_config_section(compiled_config, ld_config_file_path, binary_realpath,
+                                      &compiled_section, error_msg)) {
+      return false;
+    }
+  } else if (!parse_config_file(ld_config_file_path, binary_realpath, &property_map, error_msg)) {
     return false;
   }
 
-  Properties properties(std::move(property_map));
+  Properties properties = (compiled_section != nullptr)
+                              ? Properties(&compiled_config, compiled_section)
+                              : Properties(std::move(property_map));
 
   auto failure_guard = android::base::make_scope_guard([] { g_config.clear(); });
 
@@ -577,6 +990,21 @@ bool Config::read_binary_config(const char* ld_config_file_path,
       ns_config->set_allowed_libs(android::base::Split(allowed_libs, ":"));
     }
 
+    std::string hugepage_text = properties.get_string(property_name_prefix + ".hugepage.text",
+                                                      &lineno);
+    if (!hugepage_text.empty()) {
+      HugepageTextPolicy hugepage_text_policy;
+      if (parse_hugepage_text_policy(hugepage_text, &hugepage_text_policy)) {
+        ns_config->set_hugepage_text_policy(hugepage_text_policy);
+      } else {
+        DL_WARN("%s:%zd: warning: unknown hugepage.text value \"%s\", expected \"align\" or "
+                "\"collapse\" (ignoring)",
+                ld_config_file_path,
+                lineno,
+                hugepage_text.c_str());
+      }
+    }
+
     // these are affected by is_asan flag
     if (is_asan) {
       property_name_prefix += ".asan";
@@ -603,6 +1031,128 @@ bool Config::read_binary_config(const char* ld_config_file_path,
   return true;
 }
 
+bool parse_hugepage_text_policy(const std::string& value, HugepageTextPolicy* policy) {
+  if (value == "align") {
+    *policy = HugepageTextPolicy::kAlign;
+  } else if (value == "collapse") {
+    *policy = HugepageTextPolicy::kCollapse;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+std::string Config::get_compiled_config_path(const char* ld_config_file_path) {
+  std::string path = ld_config_file_path;
+  if (android::base::EndsWith(path, ".txt")) {
+    path.resize(path.size() - strlen(".txt"));
+  }
+  return path + ".bin";
+}
+
+bool Config::compile_config(const char* ld_config_file_path,
+                            std::string* binary,
+                            std::string* error_msg) {
+  std::string content;
+  if (!android::base::ReadFileToString(ld_config_file_path, &content)) {
+    *error_msg = std::string("error reading file \"") +
+                 ld_config_file_path + "\": " + strerror(errno);
+    return false;
+  }
+
+  CompiledConfigHeader header = {};
+  header.magic = kCompiledConfigMagic;
+  header.version = kCompiledConfigVersion;
+  header.source_size = content.size();
+  header.source_checksum = compiled_config_checksum(content.data(), content.size());
+
+  ConfigParser cp(std::move(content));
+  CompiledConfigStringTable strings;
+
+  // The mappings, in file order: the linker uses the first one that matches.
+  std::vector<CompiledConfigDir> dirs;
+  std::string section_name;
+  int result;
+  while (true) {
+    std::string name;
+    std::string value;
+    std::string error;
+
+    result = cp.next_token(&name, &value, &error);
+    if (result == ConfigParser::kError) {
+      DL_WARN("%s:%zd: warning: couldn't parse %s (ignoring this line)",
+              ld_config_file_path,
+              cp.lineno(),
+              error.c_str());
+      continue;
+    }
+
+    if (result == ConfigParser::kSection) {
+      section_name = std::move(name);
+      break;
+    }
+
+    if (result == ConfigParser::kEndOfFile) {
+      break;
+    }
+
+    if (result == ConfigParser::kPropertyAssign &&
+        get_dir_property_value(ld_config_file_path, cp.lineno(), name, &value)) {
+      uint32_t section_name_offset = strings.add(name.substr(4));
+      dirs.push_back({section_name_offset, strings.add(value), static_cast<uint32_t>(cp.lineno())});
+    }
+  }
+
+  // The sections. Only the first section with a given name is ever used.
+  std::map<std::string, std::map<std::string, PropertyValue>> sections;
+  while (result == ConfigParser::kSection) {
+    std::unordered_map<std::string, PropertyValue> properties;
+    std::string next_section_name;
+    result = parse_config_section(&cp, ld_config_file_path, &properties, &next_section_name);
+    sections.emplace(std::move(section_name),
+                     std::map<std::string, PropertyValue>(properties.begin(), properties.end()));
+    section_name = std::move(next_section_name);
+  }
+
+  header.line_count = cp.lineno();
+
+  std::vector<CompiledConfigSection> compiled_sections;
+  std::vector<CompiledConfigProperty> compiled_properties;
+  for (const auto& section : sections) {
+    compiled_sections.push_back({strings.add(section.first),
+                                 static_cast<uint32_t>(compiled_properties.size()),
+                                 static_cast<uint32_t>(section.second.size())});
+    // std::map keeps the properties sorted by name for CompiledConfig::find_property.
+    for (const auto& property : section.second) {
+      uint32_t name_offset = strings.add(property.first);
+      compiled_properties.push_back({name_offset,
+                                     strings.add(property.second.value()),
+                                     static_cast<uint32_t>(property.second.lineno())});
+    }
+  }
+
+  if (strings.data().empty()) {
+    strings.add("");
+  }
+
+  header.dir_count = dirs.size();
+  header.section_count = compiled_sections.size();
+  header.property_count = compiled_properties.size();
+  header.string_table_size = strings.data().size();
+
+  binary->assign(sizeof(header), '\0');
+  append_compiled_config_entries(binary, dirs);
+  append_compiled_config_entries(binary, compiled_sections);
+  append_compiled_config_entries(binary, compiled_properties);
+  binary->append(strings.data());
+
+  header.size = binary->size();
+  header.checksum = compiled_config_checksum(binary->data() + sizeof(header),
+                                             binary->size() - sizeof(header));
+  memcpy(binary->data(), &header, sizeof(header));
+  return true;
+}
+
 std::string Config::get_vndk_version_string(const char delimiter) {
   std::string version = android::base::GetProperty("ro.vndk.version", "");
   if (version != "" && version != "current") {
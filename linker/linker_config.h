@@ -40,6 +40,8 @@
 
 #include <android-base/macros.h>
 
+#include "linker_namespaces.h"
+
 #if defined(__LP64__)
 static constexpr const char* kLibPath = "lib64";
 #else
@@ -72,10 +74,14 @@ class NamespaceLinkConfig {
   bool allow_all_shared_libs_;
 };
 
+// "align" or "collapse". Returns false for anything else.
+bool parse_hugepage_text_policy(const std::string& value, HugepageTextPolicy* policy);
+
 class NamespaceConfig {
  public:
   explicit NamespaceConfig(const std::string& name)
-      : name_(name), isolated_(false), visible_(false)
+      : name_(name), isolated_(false), visible_(false),
+        hugepage_text_policy_(HugepageTextPolicy::kDefault)
   {}
 
   const char* name() const {
@@ -100,6 +106,10 @@ class NamespaceConfig {
 
   const std::vector<std::string>& allowed_libs() const { return allowed_libs_; }
 
+  HugepageTextPolicy hugepage_text_policy() const {
+    return hugepage_text_policy_;
+  }
+
   const std::vector<NamespaceLinkConfig>& links() const {
     return namespace_links_;
   }
@@ -129,10 +139,15 @@ class NamespaceConfig {
     allowed_libs_ = std::move(allowed_libs);
   }
 
+  void set_hugepage_text_policy(HugepageTextPolicy policy) {
+    hugepage_text_policy_ = policy;
+  }
+
  private:
   const std::string name_;
   bool isolated_;
   bool visible_;
+  HugepageTextPolicy hugepage_text_policy_;
   std::vector<std::string> search_paths_;
   std::vector<std::string> permitted_paths_;
   std::vector<std::string> allowed_libs_;
@@ -170,6 +185,17 @@ class Config {
                                  const Config** config,
                                  std::string* error_msg);
 
+  // Compiles the ld.config.txt at ld_config_file_path into the binary form
+  // that read_binary_config() maps instead of parsing the text, if it is
+  // found at get_compiled_config_path(ld_config_file_path) and is up to date.
+  // Returns false in case of an error.
+  static bool compile_config(const char* ld_config_file_path,
+                             std::string* binary,
+                             std::string* error_msg);
+
+  // "ld.config.txt" -> "ld.config.bin"
+  static std::string get_compiled_config_path(const char* ld_config_file_path);
+
   static std::string get_vndk_version_string(const char delimiter);
  private:
   void clear();
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <unistd.h>
+
+#include <string>
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+
+#include "linker_config.h"
+
+// Builds a config about the size of a generated /linkerconfig/ld.config.txt:
+// a handful of sections, each with a few dozen namespaces that link to each
+// other, one of which maps the directory of the benchmarked binary.
+static std::string make_config(const std::string& binary_dir) {
+  using android::base::StringAppendF;
+
+  static constexpr int kSectionCount = 6;
+  static constexpr int kNamespaceCount = 24;
+
+  std::string config;
+  for (int section = 0; section < kSectionCount; ++section) {
+    StringAppendF(&config, "dir.section%d = /nonexistent/section%d\n", section, section);
+  }
+  StringAppendF(&config, "dir.section%d = %s\n", kSectionCount - 1, binary_dir.c_str());
+
+  for (int section = 0; section < kSectionCount; ++section) {
+    StringAppendF(&config, "[section%d]\n", section);
+    config += "additional.namespaces = ";
+    for (int ns = 1; ns < kNamespaceCount; ++ns) {
+      StringAppendF(&config, "%sns%d", ns == 1 ? "" : ",", ns);
+    }
+    config += "\n";
+    for (int ns = 0; ns < kNamespaceCount; ++ns) {
+      std::string name = ns == 0 ? "default" : android::base::StringPrintf("ns%d", ns);
+      std::string next = android::base::StringPrintf("ns%d", (ns + 1) % kNamespaceCount);
+      if (next == "ns0") next = "default";
+      StringAppendF(&config, "namespace.%s.isolated = true\n", name.c_str());
+      StringAppendF(&config, "namespace.%s.visible = true\n", name.c_str());
+      StringAppendF(&config, "namespace.%s.search.paths = /apex/com.android.%s/${LIB}\n",
+                    name.c_str(), name.c_str());
+      StringAppendF(&config, "namespace.%s.permitted.paths = /apex/com.android.%s/${LIB}\n",
+                    name.c_str(), name.c_str());
+      StringAppendF(&config, "namespace.%s.permitted.paths += /system/${LIB}\n", name.c_str());
+      StringAppendF(&config, "namespace.%s.asan.search.paths = /data/asan/apex/%s/${LIB}\n",
+                    name.c_str(), name.c_str());
+      StringAppendF(&config, "namespace.%s.links = %s\n", name.c_str(), next.c_str());
+      StringAppendF(&config, "namespace.%s.link.%s.shared_libs = libc.so:libm.so:libdl.so\n",
+                    name.c_str(), next.c_str());
+      StringAppendF(&config, "namespace.%s.link.%s.shared_libs += liblog.so:libbinder_ndk.so\n",
+                    name.c_str(), next.c_str());
+    }
+  }
+  return config;
+}
+
+static void BM_linker_config_read(benchmark::State& state, bool compiled) {
+  TemporaryDir tmp_dir;
+  std::string config_path = std::string(tmp_dir.path) + "/ld.config.txt";
+  std::string compiled_path = Config::get_compiled_config_path(config_path.c_str());
+  std::string executable_path = std::string(tmp_dir.path) + "/some-binary";
+
+  if (!android::base::WriteStringToFile(make_config(tmp_dir.path), config_path)) {
+    state.SkipWithError("failed to write the config");
+    return;
+  }
+
+  if (compiled) {
+    std::string binary;
+    std::string error_msg;
+    if (!Config::compile_config(config_path.c_str(), &binary, &error_msg) ||
+        !android::base::WriteStringToFile(binary, compiled_path)) {
+      state.SkipWithError("failed to compile the config");
+      unlink(config_path.c_str());
+      return;
+    }
+  }
+
+  for (auto _ : state) {
+    const Config* config = nullptr;
+    std::string error_msg;
+    if (!Config::read_binary_config(config_path.c_str(), executable_path.c_str(), false, false,
+                                    &config, &error_msg)) {
+      state.SkipWithError(error_msg.c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(config);
+  }
+
+  unlink(compiled_path.c_str());
+  unlink(config_path.c_str());
+}
+
+static void BM_linker_config_read_text(benchmark::State& state) {
+  BM_linker_config_read(state, false);
+}
+BENCHMARK(BM_linker_config_read_text);
+
+static void BM_linker_config_read_compiled(benchmark::State& state) {
+  BM_linker_config_read(state, true);
+}
+BENCHMARK(BM_linker_config_read_compiled);
@@ -60,6 +60,7 @@ static const char* config_str =
   "additional.namespaces+=vndk\n"
   "additional.namespaces+=vndk_in_system\n"
   "namespace.default.isolated = true\n"
+  "namespace.default.hugepage.text = align\n"
   "namespace.default.search.paths = /vendor/${LIB}\n"
   "namespace.default.permitted.paths = /vendor/${LIB}\n"
   "namespace.default.asan.search.paths = /data\n"
@@ -78,6 +79,7 @@ static const char* config_str =
   "namespace.default.link.vndk.shared_libs = libcutils.so:libbase.so\n"
   "namespace.system.isolated = true\n"
   "namespace.system.visible = true\n"
+  "namespace.system.hugepage.text = collapse\n"
   "namespace.system.search.paths = /system/${LIB}\n"
   "namespace.system.permitted.paths = /system/${LIB}\n"
   "namespace.system.asan.search.paths = /data:/system/${LIB}\n"
@@ -88,6 +90,7 @@ static const char* config_str =
   "namespace.system.hwasan.permitted.paths += /system/${LIB}\n"
   "namespace.vndk.isolated = tr\n"
   "namespace.vndk.isolated += ue\n" // should be ignored and return as 'false'.
+  "namespace.vndk.hugepage.text = always\n" // should be ignored.
   "namespace.vndk.search.paths = /system/${LIB}/vndk\n"
   "namespace.vndk.asan.search.paths = /data\n"
   "namespace.vndk.asan.search.paths += /system/${LIB}/vndk\n"
@@ -124,7 +127,16 @@ enum class SmokeTestType {
   Hwasan,
 };
 
-static void run_linker_config_smoke_test(SmokeTestType type) {
+// Writes the compiled form of the config at path next to it, the way
+// read_binary_config() expects to find it.
+static bool write_compiled_config(const char* path) {
+  std::string binary;
+  std::string error_msg;
+  return Config::compile_config(path, &binary, &error_msg) &&
+         android::base::WriteStringToFile(binary, Config::get_compiled_config_path(path));
+}
+
+static void run_linker_config_smoke_test(SmokeTestType type, bool compiled = false) {
   std::vector<std::string> expected_default_search_path;
   std::vector<std::string> expected_default_permitted_path;
   std::vector<std::string> expected_system_search_path;
@@ -169,6 +181,13 @@ static void run_linker_config_smoke_test(SmokeTestType type) {
 
   android::base::WriteStringToFile(config_str, tmp_file.path);
 
+  std::string compiled_path = Config::get_compiled_config_path(tmp_file.path);
+  auto compiled_guard =
+      android::base::make_scope_guard([&compiled_path] { unlink(compiled_path.c_str()); });
+  if (compiled) {
+    ASSERT_TRUE(write_compiled_config(tmp_file.path));
+  }
+
   TemporaryDir tmp_dir;
 
   std::string executable_path = std::string(tmp_dir.path) + "/some-binary";
@@ -198,6 +217,7 @@ static void run_linker_config_smoke_test(SmokeTestType type) {
 
   ASSERT_TRUE(default_ns_config->isolated());
   ASSERT_FALSE(default_ns_config->visible());
+  ASSERT_EQ(HugepageTextPolicy::kAlign, default_ns_config->hugepage_text_policy());
   ASSERT_EQ(expected_default_search_path, default_ns_config->search_paths());
   ASSERT_EQ(expected_default_permitted_path, default_ns_config->permitted_paths());
 
@@ -238,6 +258,7 @@ static void run_linker_config_smoke_test(SmokeTestType type) {
 
   ASSERT_TRUE(ns_system->isolated());
   ASSERT_TRUE(ns_system->visible());
+  ASSERT_EQ(HugepageTextPolicy::kCollapse, ns_system->hugepage_text_policy());
   ASSERT_EQ(expected_system_search_path, ns_system->search_paths());
   ASSERT_EQ(expected_system_permitted_path, ns_system->permitted_paths());
 
@@ -245,6 +266,7 @@ static void run_linker_config_smoke_test(SmokeTestType type) {
 
   ASSERT_FALSE(ns_vndk->isolated()); // malformed bool property
   ASSERT_FALSE(ns_vndk->visible()); // undefined bool property
+  ASSERT_EQ(HugepageTextPolicy::kDefault, ns_vndk->hugepage_text_policy()); // malformed value
   ASSERT_EQ(expected_vndk_search_path, ns_vndk->search_paths());
 
   const auto& ns_vndk_links = ns_vndk->links();
@@ -270,6 +292,18 @@ TEST(linker_config, hwasan_smoke) {
   run_linker_config_smoke_test(SmokeTestType::Hwasan);
 }
 
+TEST(linker_config, compiled_smoke) {
+  run_linker_config_smoke_test(SmokeTestType::None, true);
+}
+
+TEST(linker_config, compiled_asan_smoke) {
+  run_linker_config_smoke_test(SmokeTestType::Asan, true);
+}
+
+TEST(linker_config, compiled_hwasan_smoke) {
+  run_linker_config_smoke_test(SmokeTestType::Hwasan, true);
+}
+
 TEST(linker_config, ns_link_shared_libs_invalid_settings) {
   // This unit test ensures an error is emitted when a namespace link in ld.config.txt specifies
   // both shared_libs and allow_all_shared_libs.
@@ -352,3 +386,112 @@ TEST(linker_config, dir_path_resolve) {
   ASSERT_TRUE(config != nullptr) << error_msg;
   ASSERT_TRUE(error_msg.empty()) << error_msg;
 }
+
+TEST(linker_config, compiled_config_path) {
+  ASSERT_EQ("/linkerconfig/ld.config.bin", Config::get_compiled_config_path("/linkerconfig/ld.config.txt"));
+  ASSERT_EQ("/data/local/tmp/config.bin", Config::get_compiled_config_path("/data/local/tmp/config"));
+}
+
+static void read_isolated(const char* config_path, const std::string& executable_path,
+                          bool* isolated) {
+  const Config* config = nullptr;
+  std::string error_msg;
+  ASSERT_TRUE(Config::read_binary_config(config_path,
+                                         executable_path.c_str(),
+                                         false,
+                                         false,
+                                         &config,
+                                         &error_msg)) << error_msg;
+  ASSERT_TRUE(config != nullptr);
+  *isolated = config->default_namespace_config()->isolated();
+}
+
+TEST(linker_config, compiled_fallback_to_text) {
+  // This unit test ensures the linker ignores a compiled config that doesn't
+  // match the text it was compiled from, or that has been corrupted.
+
+  TemporaryDir tmp_dir;
+
+  std::string config_str =
+      "dir.test = " + std::string(tmp_dir.path) + "\n"
+      "\n"
+      "[test]\n"
+      "namespace.default.isolated = true\n";
+
+  TemporaryFile tmp_file;
+  close(tmp_file.fd);
+  tmp_file.fd = -1;
+
+  android::base::WriteStringToFile(config_str, tmp_file.path);
+
+  std::string compiled_path = Config::get_compiled_config_path(tmp_file.path);
+  auto compiled_guard =
+      android::base::make_scope_guard([&compiled_path] { unlink(compiled_path.c_str()); });
+  ASSERT_TRUE(write_compiled_config(tmp_file.path));
+
+  std::string executable_path = std::string(tmp_dir.path) + "/some-binary";
+
+  bool isolated = false;
+  read_isolated(tmp_file.path, executable_path, &isolated);
+  ASSERT_TRUE(isolated);
+
+  // Same size, different content.
+  config_str.replace(config_str.find("true"), 4, "tru_");
+  android::base::WriteStringToFile(config_str, tmp_file.path);
+  read_isolated(tmp_file.path, executable_path, &isolated);
+  ASSERT_FALSE(isolated);
+
+  ASSERT_TRUE(write_compiled_config(tmp_file.path));
+  std::string binary;
+  ASSERT_TRUE(android::base::ReadFileToString(compiled_path, &binary));
+  binary.back() ^= 1;
+  ASSERT_TRUE(android::base::WriteStringToFile(binary, compiled_path));
+  read_isolated(tmp_file.path, executable_path, &isolated);
+  ASSERT_FALSE(isolated);
+
+  binary.resize(binary.size() / 2);
+  ASSERT_TRUE(android::base::WriteStringToFile(binary, compiled_path));
+  read_isolated(tmp_file.path, executable_path, &isolated);
+  ASSERT_FALSE(isolated);
+}
+
+TEST(linker_config, compiled_errors_match_text) {
+  // This unit test ensures errors reported from a compiled config refer to
+  // the same lines of the text config.
+
+  static const char config_str[] =
+    "dir.test = /data/local/tmp\n"
+    "dir.missing = /data\n"
+    "\n"
+    "[test]\n"
+    "additional.namespaces = system\n"
+    "namespace.default.links = system,vendor\n"
+    "namespace.default.link.system.shared_libs = libc.so:libm.so\n"
+    "\n";
+
+  TemporaryFile tmp_file;
+  close(tmp_file.fd);
+  tmp_file.fd = -1;
+
+  android::base::WriteStringToFile(config_str, tmp_file.path);
+
+  std::string compiled_path = Config::get_compiled_config_path(tmp_file.path);
+  auto compiled_guard =
+      android::base::make_scope_guard([&compiled_path] { unlink(compiled_path.c_str()); });
+
+  for (const char* executable_path : {"/data/local/tmp/some-binary", "/data/some-binary"}) {
+    unlink(compiled_path.c_str());
+
+    const Config* config = nullptr;
+    std::string text_error_msg;
+    ASSERT_FALSE(Config::read_binary_config(tmp_file.path, executable_path, false, false,
+                                            &config, &text_error_msg));
+    ASSERT_FALSE(text_error_msg.empty());
+
+    ASSERT_TRUE(write_compiled_config(tmp_file.path));
+    std::string compiled_error_msg;
+    ASSERT_FALSE(Config::read_binary_config(tmp_file.path, executable_path, false, false,
+                                            &config, &compiled_error_msg));
+    ASSERT_EQ(text_error_msg, compiled_error_msg);
+  }
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <link.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+
+#include <android-base/macros.h>
+
+struct soinfo;
+
+// Remembers the results of recent dlsym() calls on one handle, so that code that looks up the
+// same symbols over and over (JNI, plugin frameworks) doesn't walk the handle's dependency tree
+// every time.
+//
+// The cache is direct-mapped by the GNU hash of the symbol name and only holds symbols that were
+// found. Every entry is tagged with the generation of the loader's state (see
+// dlsym_cache_generation() in linker.cpp) it was found in, and only matches in that generation,
+// so loading or unloading a library invalidates the whole cache.
+//
+// dlsym() calls on different threads use the cache concurrently. Each entry is guarded by a
+// sequence count: a lookup that races with an update of the same entry just misses, and an
+// update that races with another update is dropped.
+class DlsymCache {
+ public:
+  static constexpr size_t kEntryCount = 16;
+
+  DlsymCache() = default;
+
+  // Looks up the symbol name@version (version is nullptr for dlsym()), where hash is the GNU
+  // hash of name.
+  bool find(uint64_t generation, uint32_t hash, const char* name, const char* version,
+            soinfo** found, const ElfW(Sym)** sym) const {
+    const Entry& entry = entries_[hash % kEntryCount];
+    uint32_t seq = entry.seq.load(std::memory_order_acquire);
+    if ((seq & 1) != 0) {
+      return false;
+    }
+    uint64_t entry_generation = entry.generation.load(std::memory_order_relaxed);
+    uint32_t entry_hash = entry.hash.load(std::memory_order_relaxed);
+    const char* entry_name = entry.name.load(std::memory_order_relaxed);
+    const char* entry_version = entry.version.load(std::memory_order_relaxed);
+    soinfo* entry_found = entry.found.load(std::memory_order_relaxed);
+    const ElfW(Sym)* entry_sym = entry.sym.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (entry.seq.load(std::memory_order_relaxed) != seq) {
+      return false;
+    }
+
+    // The strings belong to the library that defines the symbol, which is still loaded if the
+    // generation matches.
+    if (entry_name == nullptr || entry_generation != generation || entry_hash != hash ||
+        strcmp(entry_name, name) != 0 ||
+        (entry_version == nullptr) != (version == nullptr) ||
+        (version != nullptr && strcmp(entry_version, version) != 0)) {
+      return false;
+    }
+    *found = entry_found;
+    *sym = entry_sym;
+    return true;
+  }
+
+  // Remembers that name@version is sym in found. name and version must be the strings of found
+  // rather than the caller's, since they are kept until the generation changes.
+  void insert(uint64_t generation, uint32_t hash, const char* name, const char* version,
+              soinfo* found, const ElfW(Sym)* sym) {
+    Entry& entry = entries_[hash % kEntryCount];
+    uint32_t seq = entry.seq.load(std::memory_order_relaxed);
+    if ((seq & 1) != 0 ||
+        !entry.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_relaxed)) {
+      return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.generation.store(generation, std::memory_order_relaxed);
+    entry.hash.store(hash, std::memory_order_relaxed);
+    entry.name.store(name, std::memory_order_relaxed);
+    entry.version.store(version, std::memory_order_relaxed);
+    entry.found.store(found, std::memory_order_relaxed);
+    entry.sym.store(sym, std::memory_order_relaxed);
+    entry.seq.store(seq + 2, std::memory_order_release);
+  }
+
+ private:
+  struct Entry {
+    std::atomic<uint32_t> seq;
+    std::atomic<uint32_t> hash;
+    std::atomic<uint64_t> generation;
+    std::atomic<const char*> name;
+    std::atomic<const char*> version;
+    std::atomic<soinfo*> found;
+    std::atomic<const ElfW(Sym)*> sym;
+  };
+
+  Entry entries_[kEntryCount] = {};
+
+  DISALLOW_COPY_AND_ASSIGN(DlsymCache);
+};
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "linker_dlsym_cache.h"
+
+// The cache never dereferences these.
+static soinfo* fake_soinfo(uintptr_t i) {
+  return reinterpret_cast<soinfo*>(0x1000 * i);
+}
+
+static const ElfW(Sym)* fake_sym(uintptr_t i) {
+  return reinterpret_cast<const ElfW(Sym)*>(0x1000 * i + 0x10);
+}
+
+TEST(linker_dlsym_cache, empty) {
+  DlsymCache cache;
+  soinfo* found;
+  const ElfW(Sym)* sym;
+  ASSERT_FALSE(cache.find(0, 0, "foo", nullptr, &found, &sym));
+}
+
+TEST(linker_dlsym_cache, hit) {
+  DlsymCache cache;
+  cache.insert(1, 123, "foo", nullptr, fake_soinfo(1), fake_sym(1));
+
+  soinfo* found = nullptr;
+  const ElfW(Sym)* sym = nullptr;
+  ASSERT_TRUE(cache.find(1, 123, "foo", nullptr, &found, &sym));
+  ASSERT_EQ(fake_soinfo(1), found);
+  ASSERT_EQ(fake_sym(1), sym);
+
+  // The caller's string doesn't need to be the cached one.
+  std::string name = "foo";
+  ASSERT_TRUE(cache.find(1, 123, name.c_str(), nullptr, &found, &sym));
+}
+
+TEST(linker_dlsym_cache, generation) {
+  DlsymCache cache;
+  cache.insert(1, 123, "foo", nullptr, fake_soinfo(1), fake_sym(1));
+
+  soinfo* found;
+  const ElfW(Sym)* sym;
+  ASSERT_FALSE(cache.find(2, 123, "foo", nullptr, &found, &sym));
+
+  cache.insert(2, 123, "foo", nullptr, fake_soinfo(2), fake_sym(2));
+  ASSERT_TRUE(cache.find(2, 123, "foo", nullptr, &found, &sym));
+  ASSERT_EQ(fake_soinfo(2), found);
+}
+
+TEST(linker_dlsym_cache, collisions) {
+  DlsymCache cache;
+  cache.insert(1, 123, "foo", nullptr, fake_soinfo(1), fake_sym(1));
+
+  soinfo* found;
+  const ElfW(Sym)* sym;
+  // Same hash, different name.
+  ASSERT_FALSE(cache.find(1, 123, "bar", nullptr, &found, &sym));
+  // Same slot, different hash.
+  ASSERT_FALSE(cache.find(1, 123 + DlsymCache::kEntryCount, "foo", nullptr, &found, &sym));
+
+  // A later entry for the same slot replaces the earlier one.
+  cache.insert(1, 123 + DlsymCache::kEntryCount, "bar", nullptr, fake_soinfo(2), fake_sym(2));
+  ASSERT_FALSE(cache.find(1, 123, "foo", nullptr, &found, &sym));
+  ASSERT_TRUE(cache.find(1, 123 + DlsymCache::kEntryCount, "bar", nullptr, &found, &sym));
+}
+
+TEST(linker_dlsym_cache, versions) {
+  DlsymCache cache;
+  cache.insert(1, 123, "foo", "V1", fake_soinfo(1), fake_sym(1));
+
+  soinfo* found;
+  const ElfW(Sym)* sym;
+  ASSERT_TRUE(cache.find(1, 123, "foo", "V1", &found, &sym));
+  ASSERT_FALSE(cache.find(1, 123, "foo", "V2", &found, &sym));
+  ASSERT_FALSE(cache.find(1, 123, "foo", nullptr, &found, &sym));
+
+  cache.insert(1, 123, "foo", nullptr, fake_soinfo(2), fake_sym(2));
+  ASSERT_FALSE(cache.find(1, 123, "foo", "V1", &found, &sym));
+  ASSERT_TRUE(cache.find(1, 123, "foo", nullptr, &found, &sym));
+}
+
+TEST(linker_dlsym_cache, concurrent) {
+  DlsymCache cache;
+  static const char* kNames[] = { "a", "b", "c", "d" };
+  std::atomic<bool> done(false);
+
+  // Every thread inserts and looks up the same slot, and must only ever see matching fields.
+  std::vector<std::thread> threads;
+  for (uintptr_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t]() {
+      for (size_t i = 0; !done; ++i) {
+        uintptr_t n = (t + i) % 4;
+        cache.insert(1, 5, kNames[n], nullptr, fake_soinfo(n + 1), fake_sym(n + 1));
+        for (uintptr_t m = 0; m < 4; ++m) {
+          soinfo* found;
+          const ElfW(Sym)* sym;
+          if (cache.find(1, 5, kNames[m], nullptr, &found, &sym)) {
+            ASSERT_EQ(fake_soinfo(m + 1), found);
+            ASSERT_EQ(fake_sym(m + 1), sym);
+          }
+        }
+      }
+    });
+  }
+
+  usleep(100000);
+  done = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
@@ -28,10 +28,13 @@
 
 #include "linker.h"
 #include "linker_globals.h"
+#include "linker_loader_threads.h"
 #include "linker_namespaces.h"
 
 #include "android-base/stringprintf.h"
 
+#include <bionic/pthread_internal.h>
+
 int g_argc = 0;
 char** g_argv = nullptr;
 char** g_envp = nullptr;
@@ -42,9 +45,17 @@ std::unordered_map<uintptr_t, soinfo*> g_soinfo_handles_map;
 
 platform_properties g_platform_properties;
 
-static char __linker_dl_err_buf[768];
+static char __linker_dl_err_buf[kLinkerErrorBufferSize];
 
 char* linker_get_error_buffer() {
+  char* lookup_buffer = __get_thread()->dl_lookup_error_buffer;
+  if (__predict_false(lookup_buffer != nullptr)) {
+    return lookup_buffer;
+  }
+  char* loader_thread_buffer = get_loader_thread_error_buffer();
+  if (__predict_false(loader_thread_buffer != nullptr)) {
+    return loader_thread_buffer;
+  }
   return &__linker_dl_err_buf[0];
 }
 
@@ -88,6 +88,7 @@ extern std::unordered_map<uintptr_t, soinfo*> g_soinfo_handles_map;
 extern platform_properties g_platform_properties;
 
 // Error buffer "variable"
+constexpr size_t kLinkerErrorBufferSize = 768;
 char* linker_get_error_buffer();
 size_t linker_get_error_buffer_size();
 
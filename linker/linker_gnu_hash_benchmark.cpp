@@ -28,7 +28,12 @@
 
 #include <benchmark/benchmark.h>
 
+#include <link.h>
+
+#include <vector>
+
 #include "linker_gnu_hash.h"
+#include "linker_symbol_provider_table.h"
 
 // 250 symbols from the relocations of system/lib/libhwbinder.so in aosp/master, aosp_walleye.
 // ROT13-encoded so as not to pollute code search.
@@ -308,4 +313,91 @@ BENCHMARK(BM_gnu_hash_neon);
 
 #endif  // USE_GNU_HASH_NEON
 
+// A synthetic lookup list: each library has a GNU Bloom filter for kSymbolsPerLib symbols, and
+// the sample symbols are spread over the libraries.
+class SyntheticLookupList {
+ public:
+  static constexpr uint32_t kSymbolsPerLib = 1024;
+  static constexpr uint32_t kMaskWords = 256;
+  static constexpr uint32_t kShift2 = 6;
+  static constexpr uint32_t kBloomMaskBits = sizeof(ElfW(Addr)) * 8;
+
+  explicit SyntheticLookupList(size_t lib_count) : blooms_(lib_count * kMaskWords) {
+    for (const char* sym_name : kSampleSymbolList) {
+      const uint32_t hash = calculate_gnu_hash_simple(sym_name).first;
+      hashes_.push_back(hash);
+      providers_.push_back(hash % lib_count);
+    }
+    table_.reset(lib_count * kSymbolsPerLib + hashes_.size());
+    for (uint32_t lib = 0; lib < lib_count; ++lib) {
+      for (uint32_t i = 0; i < hashes_.size(); ++i) {
+        if (providers_[i] == lib) add(lib, hashes_[i]);
+      }
+      for (uint32_t i = 0; i < kSymbolsPerLib; ++i) {
+        add(lib, (lib * kSymbolsPerLib + i) * 0x9e3779b1u);
+      }
+    }
+  }
+
+  bool bloom_matches(uint32_t lib, uint32_t hash) const {
+    const ElfW(Addr) word = blooms_[lib * kMaskWords + (hash / kBloomMaskBits) % kMaskWords];
+    return (1 & (word >> (hash % kBloomMaskBits)) &
+            (word >> ((hash >> kShift2) % kBloomMaskBits))) == 1;
+  }
+
+  const std::vector<uint32_t>& hashes() const { return hashes_; }
+  const std::vector<uint32_t>& providers() const { return providers_; }
+  const SymbolProviderTable& table() const { return table_; }
+
+ private:
+  void add(uint32_t lib, uint32_t hash) {
+    ElfW(Addr)& word = blooms_[lib * kMaskWords + (hash / kBloomMaskBits) % kMaskWords];
+    word |= static_cast<ElfW(Addr)>(1) << (hash % kBloomMaskBits);
+    word |= static_cast<ElfW(Addr)>(1) << ((hash >> kShift2) % kBloomMaskBits);
+    table_.add(hash, lib);
+  }
+
+  std::vector<ElfW(Addr)> blooms_;
+  std::vector<uint32_t> hashes_;
+  std::vector<uint32_t> providers_;
+  SymbolProviderTable table_;
+};
+
+// Probes every library's Bloom filter in turn, as soinfo_do_lookup() does without a provider
+// table. A Bloom filter match in the wrong library stands for a failed hash chain walk.
+static void BM_symbol_lookup_bloom_walk(benchmark::State& state) {
+  const size_t lib_count = state.range(0);
+  SyntheticLookupList list(lib_count);
+  for (auto _ : state) {
+    for (size_t i = 0; i < list.hashes().size(); ++i) {
+      const uint32_t hash = list.hashes()[i];
+      uint32_t lib = 0;
+      while (lib < lib_count && !(list.bloom_matches(lib, hash) && lib == list.providers()[i])) {
+        ++lib;
+      }
+      benchmark::DoNotOptimize(lib);
+    }
+  }
+}
+
+BENCHMARK(BM_symbol_lookup_bloom_walk)->Arg(8)->Arg(40)->Arg(160);
+
+// Starts at the library found in the provider table.
+static void BM_symbol_lookup_provider_table(benchmark::State& state) {
+  const size_t lib_count = state.range(0);
+  SyntheticLookupList list(lib_count);
+  for (auto _ : state) {
+    for (size_t i = 0; i < list.hashes().size(); ++i) {
+      const uint32_t hash = list.hashes()[i];
+      uint32_t lib = list.table().find(hash);
+      while (lib < lib_count && !(list.bloom_matches(lib, hash) && lib == list.providers()[i])) {
+        ++lib;
+      }
+      benchmark::DoNotOptimize(lib);
+    }
+  }
+}
+
+BENCHMARK(BM_symbol_lookup_provider_table)->Arg(8)->Arg(40)->Arg(160);
+
 BENCHMARK_MAIN();
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "linker_loader_threads.h"
+
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include <bionic/pthread_internal.h>
+
+#include "linker_globals.h"
+#include "linker_tls.h"
+#include "platform/bionic/macros.h"
+#include "private/bionic_constants.h"
+#include "private/bionic_elf_tls.h"
+#include "private/bionic_futex.h"
+#include "private/bionic_globals.h"
+#include "private/bionic_percpu.h"
+#include "private/bionic_tls.h"
+
+// x86 uses segment descriptors rather than a direct pointer to TLS.
+#if defined(__i386__)
+#include <asm/ldt.h>
+void __init_user_desc(struct user_desc*, bool, void*);
+#endif
+
+extern "C" __noreturn void __exit(int status);
+extern "C" int __rt_sigprocmask(int, const sigset64_t*, sigset64_t*, size_t);
+
+static constexpr size_t kMaxLoaderThreads = 8;
+
+// Loading a library needs very little stack; dlerror formatting is the deepest path.
+static constexpr size_t kLoaderThreadStackSize = 128 * 1024;
+
+struct LoaderWork {
+  void (*fn)(void*, size_t);
+  void* arg;
+  size_t count;
+  std::atomic<size_t> next;
+};
+
+struct LoaderThread {
+  // Lives at the top of the helper's stack, like a pthread's.
+  pthread_internal_t* thread;
+  std::atomic<pid_t> tid;
+  LoaderWork* work;
+  char error_buffer[kLinkerErrorBufferSize];
+};
+
+static size_t g_loader_thread_count = 0;
+static LoaderThread g_loader_threads[kMaxLoaderThreads];
+static std::atomic<size_t> g_active_loader_threads(0);
+
+void set_loader_thread_count(size_t count) {
+  g_loader_thread_count = std::min(count, kMaxLoaderThreads);
+}
+
+size_t get_loader_thread_count() {
+  return g_loader_thread_count;
+}
+
+char* get_loader_thread_error_buffer() {
+  size_t active = g_active_loader_threads.load(std::memory_order_acquire);
+  if (__predict_true(active == 0)) {
+    return nullptr;
+  }
+  pid_t tid = gettid();
+  for (size_t i = 0; i < active; ++i) {
+    if (g_loader_threads[i].tid.load(std::memory_order_relaxed) == tid) {
+      return g_loader_threads[i].error_buffer;
+    }
+  }
+  return nullptr;
+}
+
+static void run_loader_work(LoaderWork* work) {
+  size_t i;
+  while ((i = work->next.fetch_add(1, std::memory_order_relaxed)) < work->count) {
+    work->fn(work->arg, i);
+  }
+}
+
+// Like __pthread_start, this never returns: the helper may have switched to its own shadow call
+// stack.
+static int loader_thread_main(void* arg) {
+  LoaderThread* self = static_cast<LoaderThread*>(arg);
+  __init_additional_stacks(self->thread);
+  __rseq_register_current_thread();
+  self->tid.store(gettid(), std::memory_order_relaxed);
+  run_loader_work(self->work);
+  __exit(0);
+}
+
+// The helpers are raw clone() threads rather than pthreads. The linker's pthread_create() would
+// put them on the linker's own copy of the thread list, which libc.so never sees, so a libc.so
+// function that acts on every thread would silently skip them. Instead, neither copy of libc
+// knows about them at all: they only run linker code, with every signal that isn't raised by a
+// fault blocked, and they have always exited by the time run_on_loader_threads() returns.
+//
+// A helper gets just enough of a thread for the linker's code: a stack, a TCB with a stack guard,
+// and a pthread_internal_t for errno and gettid(). It never uses ELF TLS, so its static TLS isn't
+// initialized, but the mapping is still sized by the static TLS layout, which therefore has to be
+// final.
+static bool start_loader_thread(LoaderThread* t) {
+  ThreadMapping mapping = __allocate_thread_mapping(kLoaderThreadStackSize, PTHREAD_GUARD_SIZE);
+  if (mapping.mmap_base == nullptr) {
+    return false;
+  }
+
+  char* stack_top = align_down(mapping.stack_top - sizeof(pthread_internal_t), 16);
+  pthread_internal_t* thread = reinterpret_cast<pthread_internal_t*>(stack_top);
+  thread->mmap_base = mapping.mmap_base;
+  thread->mmap_size = mapping.mmap_size;
+  thread->mmap_base_unguarded = mapping.mmap_base_unguarded;
+  thread->mmap_size_unguarded = mapping.mmap_size_unguarded;
+  thread->stack_top = reinterpret_cast<uintptr_t>(stack_top);
+  thread->set_cached_pid(getpid());
+
+  const StaticTlsLayout& layout = __libc_shared_globals()->static_tls_layout;
+  auto tcb = reinterpret_cast<bionic_tcb*>(mapping.static_tls + layout.offset_bionic_tcb());
+  auto tls = reinterpret_cast<bionic_tls*>(mapping.static_tls + layout.offset_bionic_tls());
+  __init_tcb(tcb, thread);
+  __init_tcb_dtv(tcb);
+  __init_tcb_stack_guard(tcb);
+  __init_bionic_tls_ptrs(tcb, tls);
+
+  int flags = CLONE_VM | CLONE_FS | CLONE_FILES | CLONE_SIGHAND | CLONE_THREAD | CLONE_SYSVSEM |
+      CLONE_SETTLS | CLONE_PARENT_SETTID | CLONE_CHILD_CLEARTID;
+  void* tls_ptr = &tcb->tls_slot(0);
+#if defined(__i386__)
+  user_desc tls_descriptor;
+  __init_user_desc(&tls_descriptor, false, tls_ptr);
+  tls_ptr = &tls_descriptor;
+#endif
+
+  t->thread = thread;
+  if (clone(loader_thread_main, stack_top, flags, t, &thread->tid, tls_ptr, &thread->tid) == -1) {
+    __free_thread_mapping(thread);
+    return false;
+  }
+  return true;
+}
+
+static void join_loader_thread(LoaderThread* t) {
+  pthread_internal_t* thread = t->thread;
+
+  // The kernel clears the tid and wakes us once the helper has exited (CLONE_CHILD_CLEARTID).
+  volatile int* tid_ptr = &thread->tid;
+  pid_t tid;
+  while ((tid = *tid_ptr) != 0) {
+    __futex_wait(tid_ptr, tid, nullptr);
+  }
+
+  if (thread->alternate_signal_stack != nullptr) {
+    munmap(thread->alternate_signal_stack, SIGNAL_STACK_SIZE);
+  }
+#if defined(__aarch64__) || defined(__riscv)
+  munmap(thread->shadow_call_stack_guard_region, SCS_GUARD_REGION_SIZE);
+#endif
+  __free_thread_mapping(thread);
+}
+
+void run_on_loader_threads(size_t count, void (*fn)(void* arg, size_t i), void* arg) {
+  LoaderWork work;
+  work.fn = fn;
+  work.arg = arg;
+  work.count = count;
+  work.next.store(0, std::memory_order_relaxed);
+
+  // The calling thread takes a share of the work too. Until the static TLS layout is final (i.e.
+  // early in the initial load), the helpers can't be created and all of the work runs here.
+  size_t thread_count = count > 1 ? std::min(g_loader_thread_count, count - 1) : 0;
+  if (!is_static_tls_finalized()) {
+    thread_count = 0;
+  }
+  if (thread_count == 0) {
+    run_loader_work(&work);
+    return;
+  }
+
+  linker_set_allocator_locking(true);
+  for (size_t i = 0; i < thread_count; ++i) {
+    g_loader_threads[i].tid.store(0, std::memory_order_relaxed);
+    g_loader_threads[i].work = &work;
+  }
+  g_active_loader_threads.store(thread_count, std::memory_order_release);
+
+  // The helpers inherit this mask. The application's signal handlers mustn't run on a thread that
+  // libc.so doesn't know about, but a crash on a helper should still be reported.
+  sigset64_t helper_mask;
+  sigset64_t old_mask;
+  sigfillset64(&helper_mask);
+  for (int sig : { SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGSEGV, SIGSYS, SIGTRAP }) {
+    sigdelset64(&helper_mask, sig);
+  }
+  __rt_sigprocmask(SIG_SETMASK, &helper_mask, &old_mask, sizeof(old_mask));
+
+  size_t started = 0;
+  for (; started < thread_count; ++started) {
+    if (!start_loader_thread(&g_loader_threads[started])) {
+      break;
+    }
+  }
+  __rt_sigprocmask(SIG_SETMASK, &old_mask, nullptr, sizeof(old_mask));
+
+  run_loader_work(&work);
+
+  for (size_t i = 0; i < started; ++i) {
+    join_loader_thread(&g_loader_threads[i]);
+  }
+
+  g_active_loader_threads.store(0, std::memory_order_release);
+  linker_set_allocator_locking(false);
+}
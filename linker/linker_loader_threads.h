@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+// find_libraries() can use a small pool of helper threads to read ELF headers, map segments
+// and apply relocations of independent libraries concurrently (LD_LOADER_THREADS). The helper
+// threads only exist for the duration of a single run_on_loader_threads() call.
+
+// Sets the number of helper threads; 0 (the default) disables them. The helpers are raw clone()
+// threads that no copy of libc knows about, and they are only started once static TLS is
+// finalized.
+void set_loader_thread_count(size_t count);
+size_t get_loader_thread_count();
+
+// Returns the private dlerror buffer of the calling thread if it is a loader helper thread,
+// or nullptr otherwise. Errors reported on a helper thread are discarded: callers redo failed
+// work on the calling thread to report it.
+char* get_loader_thread_error_buffer();
+
+// Serializes the linker's allocator while helper threads are running. Defined in
+// linker_memory.cpp.
+void linker_set_allocator_locking(bool enabled);
+
+// Calls fn(arg, i) for every i in [0, count), spread over the calling thread and up to
+// get_loader_thread_count() helper threads. Returns once every call has returned.
+void run_on_loader_threads(size_t count, void (*fn)(void* arg, size_t i), void* arg);
+
+template <typename F>
+void loader_parallel_for(size_t count, F fn) {
+  run_on_loader_threads(count, [](void* arg, size_t i) { (*static_cast<F*>(arg))(i); }, &fn);
+}
@@ -39,6 +39,7 @@
 
 #include "android-base/strings.h"
 #include "private/CachedProperty.h"
+#include "private/bionic_lock.h"
 
 LinkerLogger g_linker_logger;
 
@@ -90,22 +91,24 @@ void LinkerLogger::ResetState() {
     return;
   }
 
-  flags_ = 0;
+  // Concurrent dlsym() calls share the cached property.
+  static Lock lock;
+  LockGuard guard(lock);
 
   // For logging, check the flag applied to all processes first.
   static CachedProperty debug_ld_all("debug.ld.all");
-  flags_ |= ParseProperty(debug_ld_all.Get());
+  uint32_t flags = ParseProperty(debug_ld_all.Get());
 
   // Safeguard against a NULL g_argv. Ignore processes started without argv (http://b/33276926).
-  if (g_argv == nullptr || g_argv[0] == nullptr) {
-    return;
+  if (g_argv != nullptr && g_argv[0] != nullptr) {
+    // Otherwise check the app-specific property too.
+    // We can't easily cache the property here because argv[0] changes.
+    char debug_ld_app[PROP_VALUE_MAX] = {};
+    GetAppSpecificProperty(debug_ld_app);
+    flags |= ParseProperty(debug_ld_app);
   }
 
-  // Otherwise check the app-specific property too.
-  // We can't easily cache the property here because argv[0] changes.
-  char debug_ld_app[PROP_VALUE_MAX] = {};
-  GetAppSpecificProperty(debug_ld_app);
-  flags_ |= ParseProperty(debug_ld_app);
+  flags_.store(flags, std::memory_order_relaxed);
 }
 
 void LinkerLogger::Log(const char* format, ...) {
@@ -31,6 +31,8 @@
 #include <stdlib.h>
 #include <limits.h>
 
+#include <atomic>
+
 #include "private/bionic_systrace.h"
 
 #include <android-base/macros.h>
@@ -52,11 +54,12 @@ class LinkerLogger {
   void Log(const char* format, ...) __printflike(2, 3);
 
   uint32_t IsEnabled(uint32_t type) {
-    return flags_ & type;
+    return flags_.load(std::memory_order_relaxed) & type;
   }
 
  private:
-  uint32_t flags_;
+  // dlsym() resets the state without the loader lock, so this can change under other threads.
+  std::atomic<uint32_t> flags_;
 
   DISALLOW_COPY_AND_ASSIGN(LinkerLogger);
 };
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <limits.h>
+#include <sched.h>
+#include <stddef.h>
+
+#include <atomic>
+
+#include <android-base/macros.h>
+
+#include "private/bionic_futex.h"
+
+// A reader/writer lock for the linker's symbol lookups. dlsym() and dladdr() only read the
+// loaded libraries and namespaces, so they take the read side and run concurrently with each
+// other; anything that changes the loader's state takes the write side.
+//
+// Readers are counted in per-shard counters (selected by the caller, normally by tid) so that
+// readers on different threads don't bounce a single cache line, as in linker_phdr_snapshot.cpp.
+// A writer announces itself before waiting for the readers to drain, and readers that arrive
+// while a writer holds the lock sleep until it is released. Writers are expected to be
+// serialized by the caller.
+class LookupLock {
+ public:
+  LookupLock() = default;
+
+  void read_lock(size_t shard_hint) {
+    std::atomic<size_t>& readers = shards_[shard_hint % kShardCount].readers;
+    while (true) {
+      readers.fetch_add(1);
+      if (writer_.load() == kUnlocked) {
+        return;
+      }
+      readers.fetch_sub(1);
+
+      // Ask the writer to wake us up, unless it has already gone.
+      int state = kLocked;
+      if (writer_.compare_exchange_strong(state, kLockedWithWaiters) ||
+          state == kLockedWithWaiters) {
+        __futex_wait_ex(&writer_, false, kLockedWithWaiters);
+      }
+    }
+  }
+
+  void read_unlock(size_t shard_hint) {
+    shards_[shard_hint % kShardCount].readers.fetch_sub(1, std::memory_order_release);
+  }
+
+  void write_lock() {
+    writer_.store(kLocked);
+    for (Shard& shard : shards_) {
+      while (shard.readers.load() != 0) {
+        sched_yield();
+      }
+    }
+  }
+
+  void write_unlock() {
+    if (writer_.exchange(kUnlocked, std::memory_order_release) == kLockedWithWaiters) {
+      __futex_wake_ex(&writer_, false, INT_MAX);
+    }
+  }
+
+ private:
+  static constexpr size_t kShardCount = 16;
+
+  enum : int {
+    kUnlocked = 0,
+    kLocked,
+    kLockedWithWaiters,
+  };
+
+  struct alignas(64) Shard {
+    std::atomic<size_t> readers;
+  };
+
+  Shard shards_[kShardCount] = {};
+  std::atomic<int> writer_ = kUnlocked;
+
+  DISALLOW_COPY_AND_ASSIGN(LookupLock);
+};
+
+// Makes the linker's allocator serialize every call from now on, since readers of a LookupLock
+// may allocate concurrently. Defined in linker_memory.cpp.
+void linker_enable_allocator_locking_for_lookups();
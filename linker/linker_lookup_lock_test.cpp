@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "linker_lookup_lock.h"
+
+TEST(linker_lookup_lock, readers_share) {
+  LookupLock lock;
+  // 0 and 16 use the same shard.
+  lock.read_lock(0);
+  lock.read_lock(1);
+  lock.read_lock(16);
+  lock.read_unlock(16);
+  lock.read_unlock(1);
+  lock.read_unlock(0);
+
+  lock.write_lock();
+  lock.write_unlock();
+}
+
+TEST(linker_lookup_lock, writer_waits_for_readers) {
+  LookupLock lock;
+  std::atomic<bool> reading(true);
+  lock.read_lock(3);
+
+  std::thread writer([&]() {
+    lock.write_lock();
+    EXPECT_FALSE(reading.load());
+    lock.write_unlock();
+  });
+
+  usleep(10000);
+  reading = false;
+  lock.read_unlock(3);
+  writer.join();
+}
+
+TEST(linker_lookup_lock, readers_wait_for_writer) {
+  LookupLock lock;
+  std::atomic<bool> writing(true);
+  lock.write_lock();
+
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < 4; ++i) {
+    readers.emplace_back([&, i]() {
+      lock.read_lock(i);
+      EXPECT_FALSE(writing.load());
+      lock.read_unlock(i);
+    });
+  }
+
+  usleep(10000);
+  writing = false;
+  lock.write_unlock();
+  for (auto& reader : readers) {
+    reader.join();
+  }
+}
+
+TEST(linker_lookup_lock, stress) {
+  LookupLock lock;
+  size_t value = 0;
+  size_t copy = 0;
+  std::atomic<bool> done(false);
+
+  // Readers check that they never see a writer's update half done.
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < 4; ++i) {
+    readers.emplace_back([&, i]() {
+      while (!done.load()) {
+        lock.read_lock(i);
+        EXPECT_EQ(value, copy);
+        lock.read_unlock(i);
+      }
+    });
+  }
+
+  for (size_t i = 0; i < 100; ++i) {
+    lock.write_lock();
+    ++value;
+    sched_yield();
+    ++copy;
+    lock.write_unlock();
+  }
+
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  ASSERT_EQ(100U, value);
+}
@@ -33,13 +33,17 @@
 
 #include "linker.h"
 #include "linker_cfi.h"
+#include "linker_config.h"
 #include "linker_debug.h"
 #include "linker_debuggerd.h"
 #include "linker_gdb_support.h"
 #include "linker_globals.h"
+#include "linker_loader_threads.h"
 #include "linker_phdr.h"
 #include "linker_relocate.h"
 #include "linker_relocs.h"
+#include "linker_relro_cache.h"
+#include "linker_symbol_cache.h"
 #include "linker_tls.h"
 #include "linker_utils.h"
 
@@ -171,9 +175,10 @@ static void add_vdso() {
   si->base = reinterpret_cast<ElfW(Addr)>(ehdr_vdso);
   si->size = phdr_table_get_load_size(si->phdr, si->phnum);
   si->load_bias = get_elf_exec_load_bias(ehdr_vdso);
+  register_soinfo_address_range(si);
 
   si->prelink_image();
-  si->link_image(SymbolLookupList(si), si, nullptr, nullptr);
+  si->link_image(SymbolLookupList(si), si, nullptr, nullptr, nullptr, nullptr);
   // prevents accidental unloads...
   si->set_dt_flags_1(si->get_dt_flags_1() | DF_1_NODELETE);
   si->set_linked();
@@ -340,6 +345,7 @@ static ElfW(Addr) linker_main(KernelArgumentBlock& args, const char* exe_to_load
   // doesn't cost us anything.
   const char* ldpath_env = nullptr;
   const char* ldpreload_env = nullptr;
+  const char* loader_threads_env = nullptr;
   if (!getauxval(AT_SECURE)) {
     ldpath_env = getenv("LD_LIBRARY_PATH");
     if (ldpath_env != nullptr) {
@@ -349,6 +355,33 @@ static ElfW(Addr) linker_main(KernelArgumentBlock& args, const char* exe_to_load
     if (ldpreload_env != nullptr) {
       INFO("[ LD_PRELOAD set to \"%s\" ]", ldpreload_env);
     }
+    loader_threads_env = getenv("LD_LOADER_THREADS");
+    if (loader_threads_env != nullptr) {
+      INFO("[ LD_LOADER_THREADS set to \"%s\" ]", loader_threads_env);
+    }
+    const char* symbol_cache_env = getenv("LD_SYMBOL_CACHE_DIR");
+    if (symbol_cache_env != nullptr && symbol_cache_env[0] != '\0') {
+      INFO("[ LD_SYMBOL_CACHE_DIR set to \"%s\" ]", symbol_cache_env);
+      set_symbol_cache_dir(symbol_cache_env);
+    }
+    const char* relro_cache_env = getenv("LD_RELRO_CACHE_DIR");
+    if (relro_cache_env != nullptr && relro_cache_env[0] != '\0') {
+      INFO("[ LD_RELRO_CACHE_DIR set to \"%s\" ]", relro_cache_env);
+      set_relro_cache_dir(relro_cache_env);
+    }
+    const char* hugepage_text_env = getenv("LD_HUGEPAGE_TEXT");
+    if (hugepage_text_env != nullptr) {
+      INFO("[ LD_HUGEPAGE_TEXT set to \"%s\" ]", hugepage_text_env);
+      HugepageTextPolicy hugepage_text_policy;
+      if (parse_hugepage_text_policy(hugepage_text_env, &hugepage_text_policy)) {
+        set_hugepage_text_policy_override(hugepage_text_policy);
+      }
+    }
+    const char* static_tls_surplus_env = getenv("LD_STATIC_TLS_SURPLUS");
+    if (static_tls_surplus_env != nullptr) {
+      INFO("[ LD_STATIC_TLS_SURPLUS set to \"%s\" ]", static_tls_surplus_env);
+      set_static_tls_surplus_size(strtoul(static_tls_surplus_env, nullptr, 10));
+    }
   }
 
   const ExecutableInfo exe_info = exe_to_load ? load_executable(exe_to_load) :
@@ -367,6 +400,7 @@ static ElfW(Addr) linker_main(KernelArgumentBlock& args, const char* exe_to_load
   si->size = phdr_table_get_load_size(si->phdr, si->phnum);
   si->dynamic = nullptr;
   si->set_main_executable();
+  register_soinfo_address_range(si);
   init_link_map_head(*si);
 
   set_bss_vma_name(si);
@@ -457,6 +491,12 @@ static ElfW(Addr) linker_main(KernelArgumentBlock& args, const char* exe_to_load
 
   linker_setup_exe_static_tls(g_argv[0]);
 
+  // A loader thread's mapping is sized by the static TLS layout, so the initial load only starts
+  // them once every static TLS module has been registered (see find_libraries()).
+  if (loader_threads_env != nullptr) {
+    set_loader_thread_count(strtoul(loader_threads_env, nullptr, 10));
+  }
+
   // Load ld_preloads and dependencies.
   std::vector<const char*> needed_library_name_list;
   size_t ld_preloads_count = 0;
@@ -487,7 +527,7 @@ static ElfW(Addr) linker_main(KernelArgumentBlock& args, const char* exe_to_load
                       &namespaces)) {
     __linker_cannot_link(g_argv[0]);
   } else if (needed_libraries_count == 0) {
-    if (!si->link_image(SymbolLookupList(si), si, nullptr, nullptr)) {
+    if (!si->link_image(SymbolLookupList(si), si, nullptr, nullptr, nullptr, nullptr)) {
       __linker_cannot_link(g_argv[0]);
     }
     si->increment_ref_count();
@@ -726,7 +766,10 @@ extern "C" ElfW(Addr) __linker_init(void* raw_args) {
 
   // Prelink the linker so we can access linker globals.
   if (!tmp_linker_so.prelink_image()) __linker_cannot_link(args.argv[0]);
-  if (!tmp_linker_so.link_image(SymbolLookupList(&tmp_linker_so), &tmp_linker_so, nullptr, nullptr)) __linker_cannot_link(args.argv[0]);
+  if (!tmp_linker_so.link_image(SymbolLookupList(&tmp_linker_so), &tmp_linker_so, nullptr, nullptr,
+                                nullptr, nullptr)) {
+    __linker_cannot_link(args.argv[0]);
+  }
 
   return __linker_init_post_relocation(args, tmp_linker_so);
 }
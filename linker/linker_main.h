@@ -42,7 +42,7 @@ class ProtectedDataGuard {
   ~ProtectedDataGuard();
 
  private:
-  void protect_data(int protection);
+  static void protect_data(int protection);
   static size_t ref_count_;
 };
 
@@ -27,6 +27,7 @@
  */
 
 #include "private/bionic_allocator.h"
+#include "private/bionic_lock.h"
 
 #include <stdlib.h>
 #include <sys/cdefs.h>
@@ -36,6 +37,8 @@
 
 #include <async_safe/log.h>
 
+#include "linker_loader_threads.h"
+
 static BionicAllocator g_bionic_allocator;
 static std::atomic<pid_t> fallback_tid(0);
 
@@ -68,19 +71,55 @@ static BionicAllocator& get_allocator() {
   return g_bionic_allocator;
 }
 
+// The allocator is normally protected by the loader lock. While find_libraries() has helper
+// threads running (see linker_loader_threads.cpp) every call is also serialized by this lock,
+// and so is every call once lookups have started running concurrently (see dlfcn.cpp).
+static Lock g_allocator_lock;
+static std::atomic<bool> g_allocator_locking(false);
+static std::atomic<bool> g_allocator_locking_for_lookups(false);
+
+void linker_set_allocator_locking(bool enabled) {
+  g_allocator_locking.store(enabled, std::memory_order_release);
+}
+
+void linker_enable_allocator_locking_for_lookups() {
+  if (!g_allocator_locking_for_lookups.load(std::memory_order_relaxed)) {
+    g_allocator_locking_for_lookups.store(true, std::memory_order_release);
+  }
+}
+
+class AllocatorLockGuard {
+ public:
+  AllocatorLockGuard()
+      : locked_(g_allocator_locking.load(std::memory_order_acquire) ||
+                g_allocator_locking_for_lookups.load(std::memory_order_acquire)) {
+    if (__predict_false(locked_)) g_allocator_lock.lock();
+  }
+  ~AllocatorLockGuard() {
+    if (__predict_false(locked_)) g_allocator_lock.unlock();
+  }
+
+ private:
+  bool locked_;
+};
+
 void* malloc(size_t byte_count) {
+  AllocatorLockGuard guard;
   return get_allocator().alloc(byte_count);
 }
 
 void* memalign(size_t alignment, size_t byte_count) {
+  AllocatorLockGuard guard;
   return get_allocator().memalign(alignment, byte_count);
 }
 
 void* calloc(size_t item_count, size_t item_size) {
+  AllocatorLockGuard guard;
   return get_allocator().alloc(item_count*item_size);
 }
 
 void* realloc(void* p, size_t byte_count) {
+  AllocatorLockGuard guard;
   return get_allocator().realloc(p, byte_count);
 }
 
@@ -90,9 +129,11 @@ void* reallocarray(void* p, size_t item_count, size_t item_size) {
     errno = ENOMEM;
     return nullptr;
   }
+  AllocatorLockGuard guard;
   return get_allocator().realloc(p, byte_count);
 }
 
 void free(void* ptr) {
+  AllocatorLockGuard guard;
   get_allocator().free(ptr);
 }
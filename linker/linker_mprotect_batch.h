@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <android-base/macros.h>
+#include <async_safe/CHECK.h>
+
+// Collects protection changes and applies them together. Adjacent ranges that end up with the
+// same protection are changed with a single mprotect() call, which saves both the syscall and the
+// TLB shootdown that each call costs every other thread of the process.
+//
+// The caller is responsible for synchronization.
+class MprotectBatch {
+ public:
+  MprotectBatch() = default;
+
+  // Adds the page-aligned range [addr, addr + size) to be changed to `prot`. Ranges must not
+  // overlap.
+  void add(void* addr, size_t size, int prot) {
+    uintptr_t start = reinterpret_cast<uintptr_t>(addr);
+    ranges_.push_back(Range{start, start + size, prot});
+  }
+
+  // Changes the protection of every range added since the last call, in address order. Returns
+  // false (with errno set) if an mprotect() call failed; the remaining ranges are still changed.
+  bool apply() {
+    std::sort(ranges_.begin(), ranges_.end(),
+              [](const Range& a, const Range& b) { return a.start < b.start; });
+
+    bool success = true;
+    int saved_errno = 0;
+    for (size_t i = 0; i < ranges_.size();) {
+      Range run = ranges_[i++];
+      while (i < ranges_.size() && ranges_[i].start == run.end && ranges_[i].prot == run.prot) {
+        run.end = ranges_[i++].end;
+      }
+      CHECK(i == ranges_.size() || ranges_[i].start >= run.end);
+
+      ++call_count_;
+      if (mprotect(reinterpret_cast<void*>(run.start), run.end - run.start, run.prot) == -1) {
+        success = false;
+        saved_errno = errno;
+      }
+    }
+
+    range_count_ += ranges_.size();
+    ranges_.clear();
+    if (!success) {
+      errno = saved_errno;
+    }
+    return success;
+  }
+
+  bool empty() const { return ranges_.empty(); }
+
+  // The number of ranges applied, and the number of mprotect() calls it took.
+  size_t range_count() const { return range_count_; }
+  size_t call_count() const { return call_count_; }
+
+ private:
+  struct Range {
+    uintptr_t start;
+    uintptr_t end;
+    int prot;
+  };
+
+  std::vector<Range> ranges_;
+  size_t range_count_ = 0;
+  size_t call_count_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(MprotectBatch);
+};
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "linker_mprotect_batch.h"
+
+namespace {
+
+class MappedPages {
+ public:
+  explicit MappedPages(size_t count) : size_(count * page_size()) {
+    base_ = static_cast<char*>(
+        mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  }
+  ~MappedPages() { munmap(base_, size_); }
+
+  static size_t page_size() { return sysconf(_SC_PAGESIZE); }
+  char* page(size_t i) const { return base_ + i * page_size(); }
+
+ private:
+  char* base_;
+  size_t size_;
+};
+
+}  // anonymous namespace
+
+TEST(linker_mprotect_batch, empty) {
+  MprotectBatch batch;
+  ASSERT_TRUE(batch.empty());
+  ASSERT_TRUE(batch.apply());
+  ASSERT_EQ(0U, batch.range_count());
+  ASSERT_EQ(0U, batch.call_count());
+}
+
+TEST(linker_mprotect_batch, coalesce) {
+  MappedPages pages(5);
+  ASSERT_NE(MAP_FAILED, pages.page(0));
+  const size_t page_size = MappedPages::page_size();
+
+  // Add out of order to make sure the ranges are sorted before they're merged.
+  MprotectBatch batch;
+  batch.add(pages.page(1), page_size, PROT_READ);
+  batch.add(pages.page(4), page_size, PROT_READ);
+  batch.add(pages.page(0), page_size, PROT_READ);
+  batch.add(pages.page(2), page_size, PROT_NONE);
+  batch.add(pages.page(3), page_size, PROT_READ);
+  ASSERT_FALSE(batch.empty());
+  ASSERT_TRUE(batch.apply());
+  ASSERT_TRUE(batch.empty());
+
+  // [0, 2) and [3, 5) are read-only, but they're not adjacent, and [2, 3) isn't the same.
+  ASSERT_EQ(5U, batch.range_count());
+  ASSERT_EQ(3U, batch.call_count());
+
+  ASSERT_EQ(0, pages.page(0)[0]);
+  ASSERT_EQ(0, pages.page(4)[0]);
+  ASSERT_EXIT(pages.page(1)[0] = 1, testing::KilledBySignal(SIGSEGV), "");
+  ASSERT_EXIT(*static_cast<volatile char*>(pages.page(2)), testing::KilledBySignal(SIGSEGV), "");
+
+  batch.add(pages.page(0), 5 * page_size, PROT_READ | PROT_WRITE);
+  ASSERT_TRUE(batch.apply());
+  ASSERT_EQ(6U, batch.range_count());
+  ASSERT_EQ(4U, batch.call_count());
+  pages.page(2)[0] = 1;
+  ASSERT_EQ(1, pages.page(2)[0]);
+}
+
+TEST(linker_mprotect_batch, failure) {
+  MappedPages pages(3);
+  ASSERT_NE(MAP_FAILED, pages.page(0));
+  const size_t page_size = MappedPages::page_size();
+  ASSERT_EQ(0, munmap(pages.page(1), page_size));
+
+  MprotectBatch batch;
+  batch.add(pages.page(0), page_size, PROT_READ);
+  batch.add(pages.page(1), page_size, PROT_READ);
+  batch.add(pages.page(2), page_size, PROT_READ);
+  errno = 0;
+  ASSERT_FALSE(batch.apply());
+  ASSERT_EQ(ENOMEM, errno);
+  ASSERT_TRUE(batch.empty());
+}
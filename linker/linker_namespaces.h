@@ -38,6 +38,20 @@ std::vector<std::string> fix_lib_paths(std::vector<std::string> paths);
 
 struct android_namespace_t;
 
+// How hard the loader tries to back the executable segments of a namespace's
+// libraries with transparent huge pages. Set by namespace.<name>.hugepage.text
+// in ld.config.txt; LD_HUGEPAGE_TEXT raises it for every namespace.
+enum class HugepageTextPolicy {
+  // Only segments linked with 2MiB alignment are marked as eligible.
+  kDefault,
+  // Also choose the load address of a library with a large executable segment
+  // so that the segment can be mapped with file-backed 2MiB pages.
+  kAlign,
+  // As kAlign, but collapse the segment into huge pages when it is loaded
+  // rather than leaving it to khugepaged.
+  kCollapse,
+};
+
 struct android_namespace_link_t {
  public:
   android_namespace_link_t(android_namespace_t* linked_namespace,
@@ -74,7 +88,8 @@ struct android_namespace_t {
   android_namespace_t() :
     is_isolated_(false),
     is_exempt_list_enabled_(false),
-    is_also_used_as_anonymous_(false) {}
+    is_also_used_as_anonymous_(false),
+    hugepage_text_policy_(HugepageTextPolicy::kDefault) {}
 
   const char* get_name() const { return name_.c_str(); }
   void set_name(const char* name) { name_ = name; }
@@ -88,6 +103,9 @@ struct android_namespace_t {
   bool is_also_used_as_anonymous() const { return is_also_used_as_anonymous_; }
   void set_also_used_as_anonymous(bool yes) { is_also_used_as_anonymous_ = yes; }
 
+  HugepageTextPolicy hugepage_text_policy() const { return hugepage_text_policy_; }
+  void set_hugepage_text_policy(HugepageTextPolicy policy) { hugepage_text_policy_ = policy; }
+
   const std::vector<std::string>& get_ld_library_paths() const {
     return ld_library_paths_;
   }
@@ -168,6 +186,7 @@ struct android_namespace_t {
   bool is_isolated_;
   bool is_exempt_list_enabled_;
   bool is_also_used_as_anonymous_;
+  HugepageTextPolicy hugepage_text_policy_;
   std::vector<std::string> ld_library_paths_;
   std::vector<std::string> default_library_paths_;
   std::vector<std::string> permitted_paths_;
@@ -147,17 +147,29 @@ ElfReader::ElfReader()
     : did_read_(false), did_load_(false), fd_(-1), file_offset_(0), file_size_(0), phdr_num_(0),
       phdr_table_(nullptr), shdr_table_(nullptr), shdr_num_(0), dynamic_(nullptr), strtab_(nullptr),
       strtab_size_(0), load_start_(nullptr), load_size_(0), load_bias_(0), loaded_phdr_(nullptr),
-      mapped_by_caller_(false) {
+      mapped_by_caller_(false), preferred_load_start_(nullptr),
+      hugepage_text_policy_(HugepageTextPolicy::kDefault), hugepage_text_phdr_(nullptr) {
 }
 
 bool ElfReader::Read(const char* name, int fd, off64_t file_offset, off64_t file_size) {
   if (did_read_) {
     return true;
   }
+  Prepare(name, fd, file_offset, file_size);
+  return ReadHeaders();
+}
+
+void ElfReader::Prepare(const char* name, int fd, off64_t file_offset, off64_t file_size) {
   name_ = name;
   fd_ = fd;
   file_offset_ = file_offset;
   file_size_ = file_size;
+}
+
+bool ElfReader::ReadHeaders() {
+  if (did_read_) {
+    return true;
+  }
 
   if (ReadElfHeader() &&
       VerifyElfHeader() &&
@@ -170,11 +182,13 @@ bool ElfReader::Read(const char* name, int fd, off64_t file_offset, off64_t file
   return did_read_;
 }
 
-bool ElfReader::Load(address_space_params* address_space) {
+bool ElfReader::Load(address_space_params* address_space,
+                     HugepageTextPolicy hugepage_text_policy) {
   CHECK(did_read_);
   if (did_load_) {
     return true;
   }
+  hugepage_text_policy_ = hugepage_text_policy;
   bool reserveSuccess = ReserveAddressSpace(address_space);
   if (reserveSuccess && LoadSegments() && FindPhdr() &&
       FindGnuPropertySection()) {
@@ -657,7 +671,7 @@ bool ElfReader::ReserveAddressSpace(address_space_params* address_space) {
   }
 
   uint8_t* addr = reinterpret_cast<uint8_t*>(min_vaddr);
-  void* start;
+  void* start = nullptr;
 
   if (load_size_ > address_space->reserved_size) {
     if (address_space->must_use_address) {
@@ -672,11 +686,27 @@ bool ElfReader::ReserveAddressSpace(address_space_params* address_space) {
       // bits available for ASLR for no benefit.
       start_alignment = maximum_alignment == kPmdSize ? kPmdSize : PAGE_SIZE;
     }
-    start = ReserveWithAlignmentPadding(load_size_, kLibraryAlignment, start_alignment, &gap_start_,
-                                        &gap_size_);
+    // The start of the library is start_offset past a PMD boundary if it has
+    // a segment that should be backed by huge pages.
+    size_t start_offset = 0;
+    if (FindHugepageTextSegment(min_vaddr, &start_offset)) {
+      start_alignment = kPmdSize;
+    }
+    if (preferred_load_start_ != nullptr) {
+      start = ReservePreferredAddressSpace();
+    }
     if (start == nullptr) {
-      DL_ERR("couldn't reserve %zd bytes of address space for \"%s\"", load_size_, name_.c_str());
-      return false;
+      start = ReserveWithAlignmentPadding(load_size_ + start_offset, kLibraryAlignment,
+                                          start_alignment, &gap_start_, &gap_size_);
+      if (start == nullptr) {
+        DL_ERR("couldn't reserve %zd bytes of address space for \"%s\"", load_size_,
+               name_.c_str());
+        return false;
+      }
+      if (start_offset != 0) {
+        munmap(start, start_offset);
+        start = reinterpret_cast<uint8_t*>(start) + start_offset;
+      }
     }
   } else {
     start = address_space->start_addr;
@@ -694,6 +724,87 @@ bool ElfReader::ReserveAddressSpace(address_space_params* address_space) {
   return true;
 }
 
+// Reserves load_size_ bytes at preferred_load_start_, or returns nullptr if
+// anything is already mapped there. This is how the RELRO cache gets a library
+// loaded at the address its cached RELRO was relocated for.
+void* ElfReader::ReservePreferredAddressSpace() {
+  void* start = mmap(preferred_load_start_, load_size_, PROT_NONE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+  if (start == MAP_FAILED) {
+    return nullptr;
+  }
+  if (start != preferred_load_start_) {
+    // Kernels before 4.17 treat MAP_FIXED_NOREPLACE as a hint.
+    munmap(start, load_size_);
+    return nullptr;
+  }
+  gap_start_ = nullptr;
+  gap_size_ = 0;
+  return start;
+}
+
+// File-backed huge pages need the virtual address and the file offset of the
+// mapping to be congruent modulo the PMD size. The static linker only
+// guarantees that for segments aligned to the PMD size, so for other libraries
+// the load address has to be chosen to make it true for the segment that
+// matters: the largest executable one. Returns true (with the start address
+// offset from a PMD boundary that the library needs) if there is a segment
+// that covers at least one whole huge page.
+bool ElfReader::FindHugepageTextSegment(ElfW(Addr) min_vaddr __unused,
+                                        size_t* start_offset __unused) {
+#if !defined(__LP64__)
+  // Huge page alignment costs more address space than 32-bit processes can spare.
+  return false;
+#else
+  if (hugepage_text_policy_ == HugepageTextPolicy::kDefault ||
+      !get_transparent_hugepages_supported()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < phdr_num_; ++i) {
+    const ElfW(Phdr)* phdr = &phdr_table_[i];
+    if (phdr->p_type != PT_LOAD || (phdr->p_flags & PF_X) == 0) {
+      continue;
+    }
+
+    ElfW(Addr) file_start = file_offset_ + phdr->p_offset;
+    ElfW(Addr) file_end = file_start + phdr->p_filesz;
+    if (align_down(file_end, kPmdSize) <= align_up(file_start, kPmdSize)) {
+      continue;
+    }
+
+    if (hugepage_text_phdr_ == nullptr || phdr->p_filesz > hugepage_text_phdr_->p_filesz) {
+      hugepage_text_phdr_ = phdr;
+    }
+  }
+
+  if (hugepage_text_phdr_ == nullptr) {
+    return false;
+  }
+
+  // load_bias_ = start - min_vaddr, and the segment is mapped at p_vaddr + load_bias_.
+  *start_offset = (file_offset_ + hugepage_text_phdr_->p_offset - hugepage_text_phdr_->p_vaddr +
+                   min_vaddr) & (kPmdSize - 1);
+  return true;
+#endif
+}
+
+void ElfReader::AdviseHugepageText(void* seg_addr, size_t length) {
+  uint8_t* begin = reinterpret_cast<uint8_t*>(seg_addr);
+  madvise(begin, length, MADV_HUGEPAGE);
+
+  if (hugepage_text_policy_ == HugepageTextPolicy::kCollapse) {
+    uint8_t* huge_begin = align_up(begin, kPmdSize);
+    uint8_t* huge_end = align_down(begin + length, kPmdSize);
+    // MADV_COLLAPSE needs Linux 6.1 and CONFIG_READ_ONLY_THP_FOR_FS. Without
+    // them, khugepaged will still get to the segment eventually.
+    if (huge_end > huge_begin && madvise(huge_begin, huge_end - huge_begin, MADV_COLLAPSE) == -1) {
+      INFO("[ Couldn't collapse \"%s\" text into huge pages: %s ]", name_.c_str(),
+           strerror(errno));
+    }
+  }
+}
+
 bool ElfReader::LoadSegments() {
   for (size_t i = 0; i < phdr_num_; ++i) {
     const ElfW(Phdr)* phdr = &phdr_table_[i];
@@ -759,8 +870,10 @@ bool ElfReader::LoadSegments() {
       }
 
       // Mark segments as huge page eligible if they meet the requirements
-      // (executable and PMD aligned).
-      if ((phdr->p_flags & PF_X) && phdr->p_align == kPmdSize &&
+      // (executable and PMD aligned), or were placed to meet them.
+      if (phdr == hugepage_text_phdr_) {
+        AdviseHugepageText(seg_addr, file_length);
+      } else if ((phdr->p_flags & PF_X) && phdr->p_align == kPmdSize &&
           get_transparent_hugepages_supported()) {
         madvise(seg_addr, file_length, MADV_HUGEPAGE);
       }
@@ -887,7 +1000,8 @@ int phdr_table_unprotect_segments(const ElfW(Phdr)* phdr_table,
  * phdr_table_unprotect_gnu_relro.
  */
 static int _phdr_table_set_gnu_relro_prot(const ElfW(Phdr)* phdr_table, size_t phdr_count,
-                                          ElfW(Addr) load_bias, int prot_flags) {
+                                          ElfW(Addr) load_bias, int prot_flags,
+                                          MprotectBatch* batch) {
   const ElfW(Phdr)* phdr = phdr_table;
   const ElfW(Phdr)* phdr_limit = phdr + phdr_count;
 
@@ -915,6 +1029,12 @@ static int _phdr_table_set_gnu_relro_prot(const ElfW(Phdr)* phdr_table, size_t p
     ElfW(Addr) seg_page_start = PAGE_START(phdr->p_vaddr) + load_bias;
     ElfW(Addr) seg_page_end   = PAGE_END(phdr->p_vaddr + phdr->p_memsz) + load_bias;
 
+    if (batch != nullptr) {
+      batch->add(reinterpret_cast<void*>(seg_page_start), seg_page_end - seg_page_start,
+                 prot_flags);
+      continue;
+    }
+
     int ret = mprotect(reinterpret_cast<void*>(seg_page_start),
                        seg_page_end - seg_page_start,
                        prot_flags);
@@ -938,12 +1058,15 @@ static int _phdr_table_set_gnu_relro_prot(const ElfW(Phdr)* phdr_table, size_t p
  *   phdr_table  -> program header table
  *   phdr_count  -> number of entries in tables
  *   load_bias   -> load bias
+ *   batch       -> if not null, the change is added to it to be applied
+ *                  later instead (and this always succeeds)
  * Return:
  *   0 on error, -1 on failure (error code in errno).
  */
 int phdr_table_protect_gnu_relro(const ElfW(Phdr)* phdr_table,
-                                 size_t phdr_count, ElfW(Addr) load_bias) {
-  return _phdr_table_set_gnu_relro_prot(phdr_table, phdr_count, load_bias, PROT_READ);
+                                 size_t phdr_count, ElfW(Addr) load_bias,
+                                 MprotectBatch* batch) {
+  return _phdr_table_set_gnu_relro_prot(phdr_table, phdr_count, load_bias, PROT_READ, batch);
 }
 
 /* Serialize the GNU relro segments to the given file descriptor. This can be
@@ -1174,6 +1297,49 @@ const char* phdr_table_get_interpreter_name(const ElfW(Phdr)* phdr_table, size_t
   return nullptr;
 }
 
+/* Return the GNU build-id of a loaded ELF image, if it has one.
+ *
+ * Input:
+ *   phdr_table  -> program header table
+ *   phdr_count  -> number of entries in tables
+ *   load_bias   -> load bias
+ * Output:
+ *   build_id       -> address of the NT_GNU_BUILD_ID descriptor
+ *   build_id_size  -> size of the descriptor in bytes
+ * Return:
+ *   true if a build-id was found, false otherwise.
+ */
+bool phdr_table_get_build_id(const ElfW(Phdr)* phdr_table, size_t phdr_count,
+                             ElfW(Addr) load_bias, const uint8_t** build_id,
+                             size_t* build_id_size) {
+  for (size_t i = 0; i < phdr_count; ++i) {
+    const ElfW(Phdr)& phdr = phdr_table[i];
+    if (phdr.p_type != PT_NOTE) {
+      continue;
+    }
+    ElfW(Addr) p = load_bias + phdr.p_vaddr;
+    ElfW(Addr) note_end = load_bias + phdr.p_vaddr + phdr.p_memsz;
+    while (p + sizeof(ElfW(Nhdr)) <= note_end) {
+      const ElfW(Nhdr)* note = reinterpret_cast<const ElfW(Nhdr)*>(p);
+      p += sizeof(ElfW(Nhdr));
+      const char* name = reinterpret_cast<const char*>(p);
+      p += align_up(note->n_namesz, 4);
+      const uint8_t* desc = reinterpret_cast<const uint8_t*>(p);
+      p += align_up(note->n_descsz, 4);
+      if (p > note_end) {
+        break;
+      }
+      if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 &&
+          memcmp(name, "GNU", 4) == 0 && note->n_descsz > 0) {
+        *build_id = desc;
+        *build_id_size = note->n_descsz;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 // Sets loaded_phdr_ to the address of the program header table as it appears
 // in the loaded segments in memory. This is in contrast with phdr_table_,
 // which is temporary and will be released before the library is relocated.
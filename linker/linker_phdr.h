@@ -37,6 +37,7 @@
 
 #include "linker.h"
 #include "linker_mapped_file_fragment.h"
+#include "linker_mprotect_batch.h"
 #include "linker_note_gnu_property.h"
 
 class ElfReader {
@@ -44,7 +45,20 @@ class ElfReader {
   ElfReader();
 
   bool Read(const char* name, int fd, off64_t file_offset, off64_t file_size);
-  bool Load(address_space_params* address_space);
+  bool Load(address_space_params* address_space,
+            HugepageTextPolicy hugepage_text_policy = HugepageTextPolicy::kDefault);
+
+  // Read() in two steps, so that the headers can be read on a loader thread: Prepare() records
+  // the file to read, and ReadHeaders() does the I/O without allocating.
+  void Prepare(const char* name, int fd, off64_t file_offset, off64_t file_size);
+  bool ReadHeaders();
+
+  // Asks Load() to place the library at |start| if that address range is free, rather than at a
+  // random address. Ignored if the caller provides the address space.
+  void set_preferred_load_start(void* start) { preferred_load_start_ = start; }
+
+  bool did_read() const { return did_read_; }
+  bool did_load() const { return did_load_; }
 
   const char* name() const { return name_.c_str(); }
   size_t phdr_count() const { return phdr_num_; }
@@ -66,7 +80,10 @@ class ElfReader {
   bool ReadSectionHeaders();
   bool ReadDynamicSection();
   bool ReserveAddressSpace(address_space_params* address_space);
+  void* ReservePreferredAddressSpace();
+  bool FindHugepageTextSegment(ElfW(Addr) min_vaddr, size_t* start_offset);
   bool LoadSegments();
+  void AdviseHugepageText(void* seg_addr, size_t length);
   bool FindPhdr();
   bool FindGnuPropertySection();
   bool CheckPhdr(ElfW(Addr));
@@ -113,6 +130,14 @@ class ElfReader {
   // Is map owned by the caller
   bool mapped_by_caller_;
 
+  // Where Load() tries to place the library first, or nullptr.
+  void* preferred_load_start_;
+
+  HugepageTextPolicy hugepage_text_policy_;
+  // The executable segment that ReserveAddressSpace() placed so that it can be
+  // backed by huge pages, if any.
+  const ElfW(Phdr)* hugepage_text_phdr_;
+
   // Only used by AArch64 at the moment.
   GnuPropertySection note_gnu_property_ __unused;
 };
@@ -129,7 +154,7 @@ int phdr_table_unprotect_segments(const ElfW(Phdr)* phdr_table, size_t phdr_coun
                                   ElfW(Addr) load_bias);
 
 int phdr_table_protect_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count,
-                                 ElfW(Addr) load_bias);
+                                 ElfW(Addr) load_bias, MprotectBatch* batch = nullptr);
 
 int phdr_table_serialize_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count,
                                    ElfW(Addr) load_bias, int fd, size_t* file_offset);
@@ -148,3 +173,7 @@ void phdr_table_get_dynamic_section(const ElfW(Phdr)* phdr_table, size_t phdr_co
 
 const char* phdr_table_get_interpreter_name(const ElfW(Phdr)* phdr_table, size_t phdr_count,
                                             ElfW(Addr) load_bias);
+
+bool phdr_table_get_build_id(const ElfW(Phdr)* phdr_table, size_t phdr_count,
+                             ElfW(Addr) load_bias, const uint8_t** build_id,
+                             size_t* build_id_size);
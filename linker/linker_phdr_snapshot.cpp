@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include "linker_phdr_snapshot.h"
+
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include <atomic>
+#include <string>
+#include <utility>
+
+#include <bionic/pthread_internal.h>
+
+#include "private/bionic_elf_tls.h"
+#include "private/bionic_globals.h"
+
+// Readers are counted in per-shard counters (selected by tid) so that concurrent readers on
+// different threads don't bounce a single cache line. Each shard has one counter per epoch
+// parity, and new readers are counted on the side of the current epoch. The publisher only
+// moves to the next epoch once the side that new readers would move to has drained, so a
+// snapshot that was replaced in epoch E can't be in use any more once the epoch reaches E + 2.
+static constexpr size_t kReaderShardCount = 16;
+
+struct alignas(64) ReaderShard {
+  std::atomic<size_t> count[2];
+};
+
+static ReaderShard g_reader_shards[kReaderShardCount];
+static std::atomic<size_t> g_reader_epoch(0);
+
+struct PhdrSnapshot {
+  explicit PhdrSnapshot(std::vector<PhdrSnapshotEntry>&& entries) : entries(std::move(entries)) {
+    // The soinfo that owns a library's name is freed by dlclose() while older readers may still
+    // be looking at the entry, so the snapshot keeps its own copy.
+    names.reserve(this->entries.size());
+    for (PhdrSnapshotEntry& entry : this->entries) {
+      if (entry.info.dlpi_name != nullptr) {
+        names.emplace_back(entry.info.dlpi_name);
+        entry.info.dlpi_name = names.back().c_str();
+      }
+    }
+  }
+
+  ~PhdrSnapshot() {
+    for (const auto& [addr, size] : mappings) {
+      munmap(addr, size);
+    }
+  }
+
+  std::vector<PhdrSnapshotEntry> entries;
+  std::vector<std::string> names;
+
+  // The epoch in which this snapshot was replaced by a newer one.
+  size_t retired_epoch = 0;
+
+  // Libraries that were unloaded after this snapshot was replaced, but that it still lists.
+  // They stay mapped until the snapshot is freed.
+  std::vector<std::pair<void*, size_t>> mappings;
+};
+
+static std::atomic<PhdrSnapshot*> g_phdr_snapshot(nullptr);
+
+// Snapshots that have been replaced, oldest first, that a reader may still be walking. Only
+// accessed with the loader lock held.
+static std::vector<PhdrSnapshot*> g_retired_phdr_snapshots;
+
+static ReaderShard& reader_shard_for(pthread_internal_t* thread) {
+  return g_reader_shards[static_cast<size_t>(thread->tid) % kReaderShardCount];
+}
+
+static bool readers_drained(size_t parity) {
+  for (ReaderShard& shard : g_reader_shards) {
+    if (shard.count[parity].load() != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Frees the retired snapshots that no reader can still be walking. This never waits: if a
+// reader is still inside dl_iterate_phdr() (possibly the calling thread itself, from a
+// callback, or another thread whose callback is blocked on the loader lock), the snapshots
+// stay on the list until a later publish.
+static void reclaim_retired_snapshots() {
+  for (int i = 0; i < 2 && !g_retired_phdr_snapshots.empty(); ++i) {
+    size_t epoch = g_reader_epoch.load();
+    if (!readers_drained((epoch + 1) & 1)) {
+      break;
+    }
+    g_reader_epoch.store(epoch + 1);
+  }
+
+  size_t epoch = g_reader_epoch.load();
+  auto it = g_retired_phdr_snapshots.begin();
+  for (; it != g_retired_phdr_snapshots.end() && (*it)->retired_epoch + 2 <= epoch; ++it) {
+    delete *it;
+  }
+  g_retired_phdr_snapshots.erase(g_retired_phdr_snapshots.begin(), it);
+}
+
+void publish_phdr_snapshot(std::vector<PhdrSnapshotEntry>&& entries) {
+  PhdrSnapshot* snapshot = new PhdrSnapshot(std::move(entries));
+  PhdrSnapshot* old_snapshot = g_phdr_snapshot.exchange(snapshot);
+  if (old_snapshot != nullptr) {
+    old_snapshot->retired_epoch = g_reader_epoch.load();
+    g_retired_phdr_snapshots.push_back(old_snapshot);
+  }
+  reclaim_retired_snapshots();
+}
+
+void unmap_after_phdr_readers(void* addr, size_t size) {
+  // Snapshots are freed oldest first, so if the newest retired snapshot (the one that was
+  // replaced when this library was hidden) is gone, no reader can see the library any more.
+  if (g_retired_phdr_snapshots.empty()) {
+    munmap(addr, size);
+  } else {
+    g_retired_phdr_snapshots.back()->mappings.emplace_back(addr, size);
+  }
+}
+
+// Returns the calling thread's copy of an entry's TLS block, or nullptr if the TLS block
+// hasn't been allocated yet (or the library has no TLS segment).
+static void* get_tls_block_for_this_thread(const PhdrSnapshotEntry& entry) {
+  if (entry.info.dlpi_tls_modid == 0) {
+    return nullptr;
+  }
+  if (entry.tls_static_offset != SIZE_MAX) {
+    const StaticTlsLayout& layout = __libc_shared_globals()->static_tls_layout;
+    char* static_tls = reinterpret_cast<char*>(__get_bionic_tcb()) - layout.offset_bionic_tcb();
+    return static_tls + entry.tls_static_offset;
+  }
+  TlsDtv* dtv = __get_tcb_dtv(__get_bionic_tcb());
+  if (dtv->generation < entry.tls_first_generation) return nullptr;
+  return dtv->modules[__tls_module_id_to_idx(entry.info.dlpi_tls_modid)];
+}
+
+int iterate_phdr_snapshot(int (*cb)(dl_phdr_info* info, size_t size, void* data), void* data) {
+  pthread_internal_t* self = __get_thread();
+  ReaderShard& shard = reader_shard_for(self);
+
+  size_t parity = g_reader_epoch.load() & 1;
+  shard.count[parity].fetch_add(1);
+
+  int rv = 0;
+  if (PhdrSnapshot* snapshot = g_phdr_snapshot.load()) {
+    for (const PhdrSnapshotEntry& entry : snapshot->entries) {
+      dl_phdr_info dl_info = entry.info;
+      dl_info.dlpi_tls_data = get_tls_block_for_this_thread(entry);
+      rv = cb(&dl_info, sizeof(dl_phdr_info), data);
+      if (rv != 0) {
+        break;
+      }
+    }
+  }
+
+  shard.count[parity].fetch_sub(1);
+  return rv;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <link.h>
+#include <stddef.h>
+
+#include <vector>
+
+// A single library as seen by dl_iterate_phdr(). The thread-specific dlpi_tls_data field is
+// computed for the calling thread at iteration time from the TLS fields below.
+struct PhdrSnapshotEntry {
+  dl_phdr_info info;
+
+  // Offset into the static TLS block, or SIZE_MAX for a dynamic (or absent) TLS module.
+  size_t tls_static_offset;
+
+  // The generation in which the TLS module was registered, for dynamic TLS modules.
+  size_t tls_first_generation;
+};
+
+// dl_iterate_phdr() reads an immutable snapshot of the loaded libraries without taking the
+// loader lock, so concurrent unwinders never serialize against each other or against dlopen.
+//
+// The loader publishes a new snapshot (with the loader lock held) whenever the set of loaded
+// libraries changes. publish_phdr_snapshot() never waits for readers: a dl_iterate_phdr()
+// callback may itself be blocked on the loader lock. The replaced snapshot is freed by a later
+// publish, once no reader can still be walking it.
+void publish_phdr_snapshot(std::vector<PhdrSnapshotEntry>&& entries);
+
+// Unmaps a library that was hidden by the last publish_phdr_snapshot() call, once no reader of
+// an older snapshot can still be looking at it. Must be called with the loader lock held.
+void unmap_after_phdr_readers(void* addr, size_t size);
+
+int iterate_phdr_snapshot(int (*cb)(dl_phdr_info* info, size_t size, void* data), void* data);
@@ -30,18 +30,24 @@
 
 #include <elf.h>
 #include <link.h>
+#include <string.h>
 
+#include <algorithm>
+#include <atomic>
 #include <type_traits>
 
 #include "linker.h"
 #include "linker_debug.h"
 #include "linker_globals.h"
 #include "linker_gnu_hash.h"
+#include "linker_loader_threads.h"
 #include "linker_phdr.h"
 #include "linker_relocs.h"
 #include "linker_reloc_iterators.h"
 #include "linker_sleb128.h"
 #include "linker_soinfo.h"
+#include "linker_relro_cache.h"
+#include "linker_symbol_cache.h"
 #include "private/bionic_globals.h"
 
 static bool is_tls_reloc(ElfW(Word) type) {
@@ -78,6 +84,15 @@ class Relocator {
   const ElfW(Sym)* cache_sym = nullptr;
   soinfo* cache_si = nullptr;
 
+  // Persistent cache of previous runs' lookups, or nullptr if disabled.
+  SymbolResolutionCache* symbol_cache = nullptr;
+
+  // RELRO cache to record symbol providers in while writing it, or nullptr.
+  RelroCache* relro_cache = nullptr;
+  // RELRO pages mapped from the RELRO cache, whose relocations are skipped.
+  ElfW(Addr) cached_relro_start = 0;
+  size_t cached_relro_size = 0;
+
   std::vector<TlsDynamicResolverArg>* tlsdesc_args;
   std::vector<std::pair<TlsDescriptor*, size_t>> deferred_tlsdesc_relocs;
   size_t tls_tp_base = 0;
@@ -101,13 +116,26 @@ static inline bool lookup_symbol(Relocator& relocator, uint32_t r_sym, const cha
     *sym = relocator.cache_sym;
     count_relocation_if<DoLogging>(kRelocSymbolCached);
   } else {
-    const version_info* vi = nullptr;
-    if (!relocator.si->lookup_version_info(relocator.version_tracker, r_sym, sym_name, &vi)) {
-      return false;
-    }
-
     soinfo* local_found_in = nullptr;
-    const ElfW(Sym)* local_sym = soinfo_do_lookup(sym_name, vi, &local_found_in, relocator.lookup_list);
+    const ElfW(Sym)* local_sym = nullptr;
+
+    if (relocator.symbol_cache != nullptr &&
+        relocator.symbol_cache->find(r_sym, sym_name, &local_found_in, &local_sym)) {
+      count_relocation_if<DoLogging>(kRelocSymbolPersistent);
+    } else {
+      const version_info* vi = nullptr;
+      if (!relocator.si->lookup_version_info(relocator.version_tracker, r_sym, sym_name, &vi)) {
+        return false;
+      }
+
+      local_sym = soinfo_do_lookup(sym_name, vi, &local_found_in, relocator.lookup_list);
+      if (relocator.symbol_cache != nullptr) {
+        relocator.symbol_cache->record(r_sym, local_found_in, local_sym);
+      }
+    }
+    if (relocator.relro_cache != nullptr && local_found_in != nullptr) {
+      relocator.relro_cache->record_provider(local_found_in);
+    }
 
     relocator.cache_sym_val = r_sym;
     relocator.cache_si = local_found_in;
@@ -134,10 +162,16 @@ enum class RelocMode {
   Typical,
   // Handle all relocation types, relocations in text sections, and statistics/tracing.
   General,
+  // The JumpTable and Typical fast paths, for use on a loader thread. Anything that would need
+  // the General path is rejected instead, to be applied later on the calling thread.
+  Concurrent,
 };
 
 struct linker_stats_t {
   int count[kRelocMax];
+  int protection_count[kProtectMax];
+  std::atomic<int> dlsym_cache_hits;
+  std::atomic<int> dlsym_cache_misses;
 };
 
 static linker_stats_t linker_stats;
@@ -146,13 +180,32 @@ void count_relocation(RelocationKind kind) {
   ++linker_stats.count[kind];
 }
 
+void count_protection(ProtectionStat stat, size_t count) {
+  linker_stats.protection_count[stat] += count;
+}
+
+void count_dlsym_cache_lookup(bool hit) {
+  if (!STATS) return;
+  auto& counter = hit ? linker_stats.dlsym_cache_hits : linker_stats.dlsym_cache_misses;
+  counter.fetch_add(1, std::memory_order_relaxed);
+}
+
 void print_linker_stats() {
-  PRINT("RELO STATS: %s: %d abs, %d rel, %d symbol (%d cached)",
+  PRINT("RELO STATS: %s: %d abs, %d rel, %d symbol (%d cached, %d persistent)",
          g_argv[0],
          linker_stats.count[kRelocAbsolute],
          linker_stats.count[kRelocRelative],
          linker_stats.count[kRelocSymbol],
-         linker_stats.count[kRelocSymbolCached]);
+         linker_stats.count[kRelocSymbolCached],
+         linker_stats.count[kRelocSymbolPersistent]);
+  PRINT("PROT STATS: %s: %d ranges in %d mprotect calls",
+         g_argv[0],
+         linker_stats.protection_count[kProtectRange],
+         linker_stats.protection_count[kProtectCall]);
+  PRINT("DLSYM CACHE STATS: %s: %d hits, %d misses",
+         g_argv[0],
+         linker_stats.dlsym_cache_hits.load(std::memory_order_relaxed),
+         linker_stats.dlsym_cache_misses.load(std::memory_order_relaxed));
 }
 
 static bool process_relocation_general(Relocator& relocator, const rel_t& reloc);
@@ -161,11 +214,20 @@ template <RelocMode Mode>
 __attribute__((always_inline))
 static bool process_relocation_impl(Relocator& relocator, const rel_t& reloc) {
   constexpr bool IsGeneral = Mode == RelocMode::General;
+  constexpr bool IsConcurrent = Mode == RelocMode::Concurrent;
 
   void* const rel_target = reinterpret_cast<void*>(reloc.r_offset + relocator.si->load_bias);
   const uint32_t r_type = ELFW(R_TYPE)(reloc.r_info);
   const uint32_t r_sym = ELFW(R_SYM)(reloc.r_info);
 
+  // The RELRO cache already has the result of relocations in the pages it mapped. TLS relocations
+  // depend on this process's TLS layout, so those are applied again.
+  if (__predict_false(reinterpret_cast<ElfW(Addr)>(rel_target) - relocator.cached_relro_start <
+                      relocator.cached_relro_size) &&
+      !is_tls_reloc(r_type)) {
+    return true;
+  }
+
   soinfo* found_in = nullptr;
   const ElfW(Sym)* sym = nullptr;
   const char* sym_name = nullptr;
@@ -234,6 +296,7 @@ static bool process_relocation_impl(Relocator& relocator, const rel_t& reloc) {
   if (!IsGeneral && __predict_false(is_tls_reloc(r_type))) {
     // Always process TLS relocations using the slow code path, so that STB_LOCAL symbols are
     // diagnosed, and ifunc processing is skipped.
+    if constexpr (IsConcurrent) return false;
     return process_relocation_general(relocator, reloc);
   }
 
@@ -284,6 +347,8 @@ static bool process_relocation_impl(Relocator& relocator, const rel_t& reloc) {
     } else {
       if (!lookup_symbol<IsGeneral>(relocator, r_sym, sym_name, &found_in, &sym)) return false;
       if (sym != nullptr) {
+        // Call ifunc resolvers in relocation order, on the calling thread.
+        if (IsConcurrent && ELF_ST_TYPE(sym->st_info) == STT_GNU_IFUNC) return false;
         const bool should_protect_segments = handle_text_relocs &&
                                              found_in == relocator.si &&
                                              ELF_ST_TYPE(sym->st_info) == STT_GNU_IFUNC;
@@ -308,7 +373,7 @@ static bool process_relocation_impl(Relocator& relocator, const rel_t& reloc) {
     }
   }
 
-  if constexpr (IsGeneral || Mode == RelocMode::JumpTable) {
+  if constexpr (IsGeneral || IsConcurrent || Mode == RelocMode::JumpTable) {
     if (r_type == R_GENERIC_JUMP_SLOT) {
       count_relocation_if<IsGeneral>(kRelocAbsolute);
       const ElfW(Addr) result = sym_addr + get_addend_norel();
@@ -319,7 +384,7 @@ static bool process_relocation_impl(Relocator& relocator, const rel_t& reloc) {
     }
   }
 
-  if constexpr (IsGeneral || Mode == RelocMode::Typical) {
+  if constexpr (IsGeneral || IsConcurrent || Mode == RelocMode::Typical) {
     // Almost all dynamic relocations are of one of these types, and most will be
     // R_GENERIC_ABSOLUTE. The platform typically uses RELR instead, but R_GENERIC_RELATIVE is
     // common in non-platform binaries.
@@ -356,6 +421,7 @@ static bool process_relocation_impl(Relocator& relocator, const rel_t& reloc) {
     // Almost all relocations are handled above. Handle the remaining relocations below, in a
     // separate function call. The symbol lookup will be repeated, but the result should be served
     // from the 1-symbol lookup cache.
+    if constexpr (IsConcurrent) return false;
     return process_relocation_general(relocator, reloc);
   }
 
@@ -539,7 +605,7 @@ static inline bool process_relocation(Relocator& relocator, const rel_t& reloc)
 
 template <RelocMode Mode>
 __attribute__((noinline))
-static bool plain_relocate_impl(Relocator& relocator, rel_t* rels, size_t rel_count) {
+static bool plain_relocate_impl(Relocator& relocator, const rel_t* rels, size_t rel_count) {
   for (size_t i = 0; i < rel_count; ++i) {
     if (!process_relocation<Mode>(relocator, rels[i])) {
       return false;
@@ -585,7 +651,148 @@ static bool packed_relocate(Relocator& relocator, Args ...args) {
       packed_relocate_impl<OptMode>(relocator, args...);
 }
 
-bool soinfo::relocate(const SymbolLookupList& lookup_list) {
+// Relocations per chunk of a table applied on a loader thread. Small enough that a chunk stopped
+// early by an unusual relocation leaves little work for the calling thread.
+static constexpr size_t kConcurrentRelocationChunkSize = 2048;
+
+// RELR entries per chunk. Each entry applies up to 63 (or 31) relative relocations.
+static constexpr size_t kConcurrentRelrChunkSize = 512;
+
+// Applies relocations in order until one of them can't be applied on a loader thread. Returns the
+// number of relocations applied.
+__attribute__((noinline))
+static size_t concurrent_relocate(Relocator& relocator, const rel_t* rels, size_t rel_count) {
+  size_t i = 0;
+  while (i < rel_count && process_relocation_impl<RelocMode::Concurrent>(relocator, rels[i])) {
+    ++i;
+  }
+  return i;
+}
+
+// Applies the relocations of |table| that ConcurrentRelocation::run() left over.
+template <RelocMode OptMode>
+static bool relocate_remaining(Relocator& relocator, const ConcurrentRelocation::Library& lib,
+                               ConcurrentRelocation::Table table) {
+  for (const ConcurrentRelocation::Chunk& chunk : lib.chunks) {
+    if (chunk.table != table || chunk.applied == chunk.end) continue;
+    if (!plain_relocate<OptMode>(relocator, chunk.rels + chunk.applied,
+                                 chunk.end - chunk.applied)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ConcurrentRelocation::is_supported() {
+  // The relocation stats aren't thread-safe, traced relocations must be logged in order, and the
+  // persistent symbol and RELRO caches record lookups as they happen.
+  static_assert(STATS == 0 || STATS == 1, "STATS must be 0 or 1");
+  return !STATS && g_ld_debug_verbosity <= LINKER_VERBOSITY_TRACE && !is_symbol_cache_enabled() &&
+         !is_relro_cache_enabled();
+}
+
+void ConcurrentRelocation::add(soinfo* si) {
+  if (si->is_image_linked() || si->is_linker() || si->has_DT_SYMBOLIC) {
+    return;
+  }
+#if !defined(__LP64__)
+  if (si->has_text_relocations) {
+    return;
+  }
+#endif
+  if (si->android_relocs_ != nullptr &&
+      (si->android_relocs_size_ < 4 || memcmp(si->android_relocs_, "APS2", 4) != 0)) {
+    // Let soinfo::relocate() report the bad header.
+    return;
+  }
+
+  auto lib = std::make_unique<Library>();
+  lib->si = si;
+  if (!lib->version_tracker.init(si)) {
+    return;
+  }
+
+  if (si->android_relocs_ != nullptr) {
+    sleb128_decoder decoder(si->android_relocs_ + 4, si->android_relocs_size_ - 4);
+    for_all_packed_relocs(decoder, [&](const rel_t& reloc) {
+      lib->packed_relocs.push_back(reloc);
+      return true;
+    });
+  }
+
+  auto add_chunks = [&](Table table, const rel_t* rels, size_t rel_count) {
+    for (size_t begin = 0; begin < rel_count; begin += kConcurrentRelocationChunkSize) {
+      size_t end = std::min(begin + kConcurrentRelocationChunkSize, rel_count);
+      lib->chunks.push_back(Chunk { table, rels, begin, end, begin });
+    }
+  };
+
+  add_chunks(Table::Packed, lib->packed_relocs.data(), lib->packed_relocs.size());
+
+  if (si->relr_ != nullptr) {
+    // Each chunk starts with an address (even) entry, which sets the base for the bitmap entries
+    // after it.
+    for (size_t begin = 0; begin < si->relr_count_;) {
+      size_t end = std::min(begin + kConcurrentRelrChunkSize, si->relr_count_);
+      while (end < si->relr_count_ && (si->relr_[end] & 1) != 0) {
+        ++end;
+      }
+      lib->chunks.push_back(Chunk { Table::Relr, nullptr, begin, end, begin });
+      begin = end;
+    }
+  }
+
+#if defined(USE_RELA)
+  if (si->rela_ != nullptr) add_chunks(Table::Plain, si->rela_, si->rela_count_);
+  if (si->plt_rela_ != nullptr) add_chunks(Table::Plt, si->plt_rela_, si->plt_rela_count_);
+#else
+  if (si->rel_ != nullptr) add_chunks(Table::Plain, si->rel_, si->rel_count_);
+  if (si->plt_rel_ != nullptr) add_chunks(Table::Plt, si->plt_rel_, si->plt_rel_count_);
+#endif
+
+  libs_.push_back(std::move(lib));
+}
+
+void ConcurrentRelocation::run(const SymbolLookupList& lookup_list) {
+  std::vector<std::pair<Library*, Chunk*>> work;
+  for (const std::unique_ptr<Library>& lib : libs_) {
+    for (Chunk& chunk : lib->chunks) {
+      work.push_back({lib.get(), &chunk});
+    }
+  }
+
+  loader_parallel_for(work.size(), [&](size_t i) {
+    soinfo* si = work[i].first->si;
+    Chunk* chunk = work[i].second;
+
+    if (chunk->table == Table::Relr) {
+      si->relocate_relr(si->relr_ + chunk->begin, si->relr_ + chunk->end);
+      chunk->applied = chunk->end;
+      return;
+    }
+
+    Relocator relocator(work[i].first->version_tracker, lookup_list);
+    relocator.si = si;
+    relocator.si_strtab = si->strtab_;
+    relocator.si_strtab_size = si->has_min_version(1) ? si->strtab_size_ : SIZE_MAX;
+    relocator.si_symtab = si->symtab_;
+    relocator.tlsdesc_args = nullptr;
+
+    chunk->applied += concurrent_relocate(relocator, chunk->rels + chunk->begin,
+                                          chunk->end - chunk->begin);
+  });
+}
+
+const ConcurrentRelocation::Library* ConcurrentRelocation::find(const soinfo* si) const {
+  for (const std::unique_ptr<Library>& lib : libs_) {
+    if (lib->si == si) return lib.get();
+  }
+  return nullptr;
+}
+
+bool soinfo::relocate(const SymbolLookupList& lookup_list,
+                      const ConcurrentRelocation* concurrent_relocation,
+                      RelroCache* relro_cache) {
 
   VersionTracker version_tracker;
 
@@ -601,6 +808,24 @@ bool soinfo::relocate(const SymbolLookupList& lookup_list) {
   relocator.tlsdesc_args = &tlsdesc_args_;
   relocator.tls_tp_base = __libc_shared_globals()->static_tls_layout.offset_thread_pointer();
 
+  SymbolResolutionCache symbol_cache;
+  symbol_cache.init(this, lookup_list);
+  if (symbol_cache.enabled()) {
+    relocator.symbol_cache = &symbol_cache;
+  }
+
+  // Either skip the relocations of a RELRO mapped from the cache, or write it to the cache.
+  relocator.cached_relro_start = get_cached_relro_start();
+  relocator.cached_relro_size = get_cached_relro_size();
+  if (relocator.cached_relro_size == 0 && relro_cache != nullptr && relro_cache->enabled()) {
+    relocator.relro_cache = relro_cache;
+  }
+
+  // If the loader threads have already applied most relocations, only the rest are applied here.
+  using Table = ConcurrentRelocation::Table;
+  const ConcurrentRelocation::Library* concurrent =
+      concurrent_relocation != nullptr ? concurrent_relocation->find(this) : nullptr;
+
   if (android_relocs_ != nullptr) {
     // check signature
     if (android_relocs_size_ > 3 &&
@@ -613,7 +838,11 @@ bool soinfo::relocate(const SymbolLookupList& lookup_list) {
       const uint8_t* packed_relocs = android_relocs_ + 4;
       const size_t packed_relocs_size = android_relocs_size_ - 4;
 
-      if (!packed_relocate<RelocMode::Typical>(relocator, sleb128_decoder(packed_relocs, packed_relocs_size))) {
+      if (concurrent != nullptr) {
+        if (!relocate_remaining<RelocMode::Typical>(relocator, *concurrent, Table::Packed)) {
+          return false;
+        }
+      } else if (!packed_relocate<RelocMode::Typical>(relocator, sleb128_decoder(packed_relocs, packed_relocs_size))) {
         return false;
       }
     } else {
@@ -622,7 +851,7 @@ bool soinfo::relocate(const SymbolLookupList& lookup_list) {
     }
   }
 
-  if (relr_ != nullptr) {
+  if (relr_ != nullptr && concurrent == nullptr) {
     DEBUG("[ relocating %s relr ]", get_realpath());
     if (!relocate_relr()) {
       return false;
@@ -633,26 +862,42 @@ bool soinfo::relocate(const SymbolLookupList& lookup_list) {
   if (rela_ != nullptr) {
     DEBUG("[ relocating %s rela ]", get_realpath());
 
-    if (!plain_relocate<RelocMode::Typical>(relocator, rela_, rela_count_)) {
+    if (concurrent != nullptr) {
+      if (!relocate_remaining<RelocMode::Typical>(relocator, *concurrent, Table::Plain)) {
+        return false;
+      }
+    } else if (!plain_relocate<RelocMode::Typical>(relocator, rela_, rela_count_)) {
       return false;
     }
   }
   if (plt_rela_ != nullptr) {
     DEBUG("[ relocating %s plt rela ]", get_realpath());
-    if (!plain_relocate<RelocMode::JumpTable>(relocator, plt_rela_, plt_rela_count_)) {
+    if (concurrent != nullptr) {
+      if (!relocate_remaining<RelocMode::JumpTable>(relocator, *concurrent, Table::Plt)) {
+        return false;
+      }
+    } else if (!plain_relocate<RelocMode::JumpTable>(relocator, plt_rela_, plt_rela_count_)) {
       return false;
     }
   }
 #else
   if (rel_ != nullptr) {
     DEBUG("[ relocating %s rel ]", get_realpath());
-    if (!plain_relocate<RelocMode::Typical>(relocator, rel_, rel_count_)) {
+    if (concurrent != nullptr) {
+      if (!relocate_remaining<RelocMode::Typical>(relocator, *concurrent, Table::Plain)) {
+        return false;
+      }
+    } else if (!plain_relocate<RelocMode::Typical>(relocator, rel_, rel_count_)) {
       return false;
     }
   }
   if (plt_rel_ != nullptr) {
     DEBUG("[ relocating %s plt rel ]", get_realpath());
-    if (!plain_relocate<RelocMode::JumpTable>(relocator, plt_rel_, plt_rel_count_)) {
+    if (concurrent != nullptr) {
+      if (!relocate_remaining<RelocMode::JumpTable>(relocator, *concurrent, Table::Plt)) {
+        return false;
+      }
+    } else if (!plain_relocate<RelocMode::JumpTable>(relocator, plt_rel_, plt_rel_count_)) {
       return false;
     }
   }
@@ -669,5 +914,9 @@ bool soinfo::relocate(const SymbolLookupList& lookup_list) {
   }
 #endif
 
+  symbol_cache.save();
+  if (relocator.relro_cache != nullptr) {
+    relocator.relro_cache->save();
+  }
   return true;
 }
@@ -32,11 +32,14 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <memory>
 #include <utility>
 #include <vector>
 
+#include "linker.h"
 #include "linker_common_types.h"
 #include "linker_globals.h"
+#include "linker_reloc_iterators.h"
 #include "linker_soinfo.h"
 
 static constexpr ElfW(Versym) kVersymHiddenBit = 0x8000;
@@ -46,6 +49,7 @@ enum RelocationKind {
   kRelocRelative,
   kRelocSymbol,
   kRelocSymbolCached,
+  kRelocSymbolPersistent,
   kRelocMax
 };
 
@@ -55,8 +59,72 @@ template <bool Enabled> void count_relocation_if(RelocationKind kind) {
   if (Enabled) count_relocation(kind);
 }
 
+enum ProtectionStat {
+  kProtectRange = 0,  // Ranges whose protection was changed...
+  kProtectCall,       // ...and the mprotect() calls that took.
+  kProtectMax
+};
+
+void count_protection(ProtectionStat stat, size_t count = 1);
+
+// Counts a dlsym() lookup through a handle's result cache. Lookups can run concurrently, so
+// these are only counted in STATS builds.
+void count_dlsym_cache_lookup(bool hit);
+
 void print_linker_stats();
 
+// Applies the relocations of the libraries in a local group on the loader threads
+// (LD_LOADER_THREADS) before find_libraries() links them one at a time. Relocation tables are
+// split into chunks, so a single large library is spread over the threads too.
+//
+// Only relocations that need nothing but a symbol lookup are applied here. A chunk stops at the
+// first relocation that needs more (an ifunc, TLS, an unresolved symbol, ...), and
+// soinfo::relocate() later applies the rest of the chunk on the calling thread, in table order,
+// so errors and side effects are the same as when relocating serially.
+class ConcurrentRelocation {
+ public:
+  enum class Table { Packed, Plain, Plt, Relr };
+
+  struct Chunk {
+    Table table;
+    // The relocation table, or nullptr for the RELR table.
+    const rel_t* rels;
+    size_t begin;
+    size_t end;
+    // Relocations in [applied, end) are left for soinfo::relocate().
+    size_t applied;
+  };
+
+  struct Library {
+    soinfo* si;
+    VersionTracker version_tracker;
+    // The APS2 table, decoded so that it can be split into chunks.
+    std::vector<rel_t> packed_relocs;
+    std::vector<Chunk> chunks;
+  };
+
+  ConcurrentRelocation() = default;
+
+  // Returns false if relocations must be applied in order on one thread, e.g. because each one
+  // is traced or counted.
+  static bool is_supported();
+
+  // Queues the relocation tables of |si|. A library that can't be relocated concurrently isn't
+  // queued, and link_image() relocates it as usual.
+  void add(soinfo* si);
+
+  // Applies the queued relocations that can be applied concurrently.
+  void run(const SymbolLookupList& lookup_list);
+
+  // Returns the state of |si|, or nullptr if it wasn't queued.
+  const Library* find(const soinfo* si) const;
+
+ private:
+  std::vector<std::unique_ptr<Library>> libs_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConcurrentRelocation);
+};
+
 inline bool is_symbol_global_and_defined(const soinfo* si, const ElfW(Sym)* s) {
   if (__predict_true(ELF_ST_BIND(s->st_info) == STB_GLOBAL ||
                      ELF_ST_BIND(s->st_info) == STB_WEAK)) {
@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "linker_relro_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <android-base/unique_fd.h>
+
+#include "linker_common_types.h"
+#include "linker_debug.h"
+#include "linker_soinfo.h"
+#include "linker_symbol_cache.h"
+#include "linker_utils.h"
+#include "platform/bionic/page.h"
+
+static constexpr char kRelroCacheMagic[4] = { 'L', 'R', 'C', '1' };
+static constexpr uint32_t kRelroCacheVersion = 1;
+
+struct RelroCacheHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t key;
+  // Where the library was loaded, and where its RELRO pages are relative to that.
+  uint64_t load_start;
+  uint64_t relro_offset;
+  uint64_t relro_size;
+  // Offset of the page-aligned RELRO image in the file.
+  uint64_t image_offset;
+  uint32_t provider_count;
+  uint32_t reserved;
+  uint64_t checksum;
+};
+
+static std::string g_relro_cache_dir;
+
+void set_relro_cache_dir(const char* dir) {
+  g_relro_cache_dir = dir;
+}
+
+bool is_relro_cache_enabled() {
+  return !g_relro_cache_dir.empty();
+}
+
+static std::string get_relro_cache_path(const soinfo* si) {
+  return android::base::StringPrintf("%s/%" PRIx64 "-%" PRIx64 "-%" PRIx64 ".relro",
+                                     g_relro_cache_dir.c_str(),
+                                     static_cast<uint64_t>(si->get_st_dev()),
+                                     static_cast<uint64_t>(si->get_st_ino()),
+                                     static_cast<uint64_t>(si->get_file_offset()));
+}
+
+static uint64_t fnv1a(const void* data, size_t size) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= p[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// Opens a cache file and reads its header. Only files written by this user (or root) are trusted,
+// since their contents end up in the RELRO as is.
+static android::base::unique_fd open_relro_cache(const std::string& path,
+                                                 RelroCacheHeader* header, off64_t* file_size) {
+  android::base::unique_fd fd(TEMP_FAILURE_RETRY(open(path.c_str(), O_RDONLY | O_CLOEXEC)));
+  if (fd == -1) {
+    return fd;
+  }
+
+  struct stat file_stat;
+  if (TEMP_FAILURE_RETRY(fstat(fd.get(), &file_stat)) != 0 ||
+      (file_stat.st_uid != geteuid() && file_stat.st_uid != 0) ||
+      !android::base::ReadFully(fd.get(), header, sizeof(*header)) ||
+      memcmp(header->magic, kRelroCacheMagic, sizeof(kRelroCacheMagic)) != 0 ||
+      header->version != kRelroCacheVersion) {
+    DEBUG("[ ignoring RELRO cache \"%s\" ]", path.c_str());
+    return android::base::unique_fd();
+  }
+  *file_size = file_stat.st_size;
+  return fd;
+}
+
+void* get_relro_cache_load_start(const soinfo* si) {
+  if (g_relro_cache_dir.empty()) {
+    return nullptr;
+  }
+
+  RelroCacheHeader header;
+  off64_t file_size;
+  if (open_relro_cache(get_relro_cache_path(si), &header, &file_size) == -1 ||
+      header.load_start == 0 || page_offset(header.load_start) != 0) {
+    return nullptr;
+  }
+  return reinterpret_cast<void*>(header.load_start);
+}
+
+void RelroCache::init(soinfo* si, const SymbolLookupList& lookup_list) {
+#if defined(USE_RELA)
+  if (g_relro_cache_dir.empty() || si->is_main_executable() || si->is_linker()) {
+    return;
+  }
+
+  // The linker writes the address of _r_debug, which moves with the linker, into DT_DEBUG.
+  for (const ElfW(Dyn)* d = si->dynamic; d->d_tag != DT_NULL; ++d) {
+    if (d->d_tag == DT_DEBUG) {
+      return;
+    }
+  }
+
+  const ElfW(Phdr)* relro = nullptr;
+  for (size_t i = 0; i < si->phnum; ++i) {
+    if (si->phdr[i].p_type == PT_GNU_RELRO) {
+      if (relro != nullptr) {
+        return;
+      }
+      relro = &si->phdr[i];
+    }
+  }
+  if (relro == nullptr) {
+    return;
+  }
+
+  if (!hash_lookup_list_build_ids(si, lookup_list, &key_)) {
+    return;
+  }
+  for (const SymbolLookupLib* lib = lookup_list.begin(); lib != lookup_list.end(); ++lib) {
+    libs_.push_back(lib->si_);
+  }
+
+  si_ = si;
+  relro_start_ = PAGE_START(relro->p_vaddr) + si->load_bias;
+  relro_size_ = PAGE_END(relro->p_vaddr + relro->p_memsz) + si->load_bias - relro_start_;
+  path_ = get_relro_cache_path(si);
+#else
+  (void) si;
+  (void) lookup_list;
+#endif
+}
+
+bool RelroCache::map() {
+  if (!enabled()) {
+    return false;
+  }
+
+  RelroCacheHeader header;
+  off64_t file_size;
+  android::base::unique_fd fd(open_relro_cache(path_, &header, &file_size));
+  if (fd == -1) {
+    return false;
+  }
+
+  if (header.key != key_ ||
+      header.load_start != si_->base ||
+      header.relro_offset != relro_start_ - si_->base ||
+      header.relro_size != relro_size_) {
+    DEBUG("[ ignoring stale RELRO cache \"%s\" ]", path_.c_str());
+    return false;
+  }
+
+  std::vector<Provider> providers(header.provider_count);
+  if (header.provider_count > libs_.size() ||
+      !android::base::ReadFully(fd.get(), providers.data(), providers.size() * sizeof(Provider)) ||
+      fnv1a(providers.data(), providers.size() * sizeof(Provider)) != header.checksum ||
+      page_offset(header.image_offset) != 0 ||
+      header.image_offset < sizeof(header) + providers.size() * sizeof(Provider) ||
+      static_cast<uint64_t>(file_size) < header.image_offset + relro_size_) {
+    DEBUG("[ ignoring corrupt RELRO cache \"%s\" ]", path_.c_str());
+    return false;
+  }
+
+  // The cached RELRO holds the addresses the providers had in the process that wrote it.
+  for (const Provider& provider : providers) {
+    if (provider.lib_index >= libs_.size() ||
+        libs_[provider.lib_index]->load_bias != provider.load_bias) {
+      DEBUG("[ ignoring RELRO cache \"%s\": providers were loaded elsewhere ]", path_.c_str());
+      return false;
+    }
+  }
+
+  void* map = mmap(reinterpret_cast<void*>(relro_start_), relro_size_, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_FIXED, fd.get(), header.image_offset);
+  if (map == MAP_FAILED) {
+    DL_WARN("failed to map RELRO cache \"%s\" for \"%s\": %s", path_.c_str(),
+            si_->get_realpath(), strerror(errno));
+    return false;
+  }
+
+  si_->set_cached_relro(relro_start_, relro_size_);
+  INFO("[ using RELRO cache \"%s\" for \"%s\" ]", path_.c_str(), si_->get_realpath());
+  return true;
+}
+
+void RelroCache::record_provider_slow(const soinfo* provider) {
+  if (!enabled()) {
+    return;
+  }
+
+  auto it = std::find(libs_.begin(), libs_.end(), provider);
+  if (it == libs_.end()) {
+    path_.clear();
+    return;
+  }
+  uint32_t lib_index = it - libs_.begin();
+  if (std::none_of(providers_.begin(), providers_.end(),
+                   [&](const Provider& p) { return p.lib_index == lib_index; })) {
+    providers_.push_back(Provider { lib_index, 0, provider->load_bias });
+  }
+  last_provider_ = provider;
+}
+
+void RelroCache::save() {
+  if (!enabled()) {
+    return;
+  }
+
+  RelroCacheHeader header = {};
+  memcpy(header.magic, kRelroCacheMagic, sizeof(kRelroCacheMagic));
+  header.version = kRelroCacheVersion;
+  header.key = key_;
+  header.load_start = si_->base;
+  header.relro_offset = relro_start_ - si_->base;
+  header.relro_size = relro_size_;
+  header.image_offset = PAGE_END(sizeof(header) + providers_.size() * sizeof(Provider));
+  header.provider_count = providers_.size();
+  header.checksum = fnv1a(providers_.data(), providers_.size() * sizeof(Provider));
+
+  // Write to a private file and rename it into place so that concurrent readers (and
+  // writers) only ever see a complete cache file. The temporary file must be one we just
+  // created: if anything (such as a symlink) is already at that path, don't save at all.
+  std::string tmp_path = android::base::StringPrintf("%s.%d.tmp", path_.c_str(), getpid());
+  android::base::unique_fd fd(TEMP_FAILURE_RETRY(
+      open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600)));
+  if (fd == -1) {
+    DEBUG("[ unable to write RELRO cache \"%s\": %s ]", tmp_path.c_str(), strerror(errno));
+    return;
+  }
+
+  if (!android::base::WriteFully(fd.get(), &header, sizeof(header)) ||
+      !android::base::WriteFully(fd.get(), providers_.data(),
+                                 providers_.size() * sizeof(Provider)) ||
+      lseek64(fd.get(), header.image_offset, SEEK_SET) == -1 ||
+      !android::base::WriteFully(fd.get(), reinterpret_cast<void*>(relro_start_), relro_size_) ||
+      fsync(fd.get()) == -1 ||
+      rename(tmp_path.c_str(), path_.c_str()) == -1) {
+    DEBUG("[ unable to write RELRO cache \"%s\": %s ]", path_.c_str(), strerror(errno));
+    unlink(tmp_path.c_str());
+    return;
+  }
+  INFO("[ wrote RELRO cache \"%s\" for \"%s\" ]", path_.c_str(), si_->get_realpath());
+}
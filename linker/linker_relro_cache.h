@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <link.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <android-base/macros.h>
+
+struct soinfo;
+class SymbolLookupList;
+
+// Enables the shared RELRO cache (LD_RELRO_CACHE_DIR). Cache files are stored in |dir|, which
+// must already exist and be writable by the process.
+void set_relro_cache_dir(const char* dir);
+bool is_relro_cache_enabled();
+
+// Returns the address a previous process loaded |si| at, according to its RELRO cache file, or
+// nullptr. Loading the library there again is what makes the cached RELRO reusable.
+void* get_relro_cache_load_start(const soinfo* si);
+
+// Shares the relocated GNU RELRO segment of a library between processes, like
+// ANDROID_DLEXT_WRITE_RELRO and ANDROID_DLEXT_USE_RELRO do for callers that manage the file and
+// load address themselves.
+//
+// The first process to relocate a library writes its RELRO to <dir>/<dev>-<ino>-<offset>.relro,
+// along with the address it was loaded at and the address of every library that provided a
+// symbol to it. A later process loads the library at the same address if it can, and if the
+// library's build-id, the ordered build-ids of its lookup list, and the addresses of those
+// providers all match, it maps the file over the RELRO instead of relocating it. The pages stay
+// shared with every other process that mapped them.
+//
+// Relocations that target the mapped pages are skipped, except for TLS relocations, which depend
+// on the process's TLS layout. ifunc resolvers for skipped relocations aren't called again. Only
+// 64-bit libraries use the cache: the in-place addends of REL relocations are gone once the
+// pages are relocated.
+class RelroCache {
+ public:
+  RelroCache() = default;
+
+  // Finds the cache file for |si| linked against |lookup_list|. The cache stays disabled for
+  // libraries that can't share their RELRO.
+  void init(soinfo* si, const SymbolLookupList& lookup_list);
+
+  bool enabled() const { return !path_.empty(); }
+
+  // Maps the cached RELRO over the library's if the cache file matches, and records the mapped
+  // range with soinfo::set_cached_relro(). Returns false if the library must be relocated.
+  bool map();
+
+  // Notes that a symbol reference of the library resolved to |provider|.
+  void record_provider(const soinfo* provider) {
+    if (provider != last_provider_) {
+      record_provider_slow(provider);
+    }
+  }
+
+  // Writes the relocated RELRO to the cache file.
+  void save();
+
+ private:
+  struct Provider {
+    uint32_t lib_index;
+    uint32_t reserved;
+    uint64_t load_bias;
+  };
+
+  void record_provider_slow(const soinfo* provider);
+
+  std::string path_;
+  soinfo* si_ = nullptr;
+  uint64_t key_ = 0;
+  ElfW(Addr) relro_start_ = 0;
+  size_t relro_size_ = 0;
+  std::vector<const soinfo*> libs_;
+  std::vector<Provider> providers_;
+  const soinfo* last_provider_ = nullptr;
+
+  DISALLOW_COPY_AND_ASSIGN(RelroCache);
+};
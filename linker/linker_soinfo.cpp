@@ -34,11 +34,14 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include <async_safe/log.h>
 
 #include "linker.h"
 #include "linker_config.h"
 #include "linker_debug.h"
+#include "linker_dlsym_cache.h"
 #include "linker_globals.h"
 #include "linker_gnu_hash.h"
 #include "linker_logger.h"
@@ -78,6 +81,56 @@ SymbolLookupList::SymbolLookupList(const soinfo_list_t& global_group, const soin
   end_ = &libs_[0] + libs_.size();
 }
 
+// Returns the range of symbol indices in |lib|'s GNU hash table. The chains are stored one after
+// another, so the range ends with the last chain, which starts at the largest bucket value.
+static std::pair<uint32_t, uint32_t> get_gnu_hash_symbol_range(const SymbolLookupLib& lib) {
+  uint32_t first = UINT32_MAX;
+  uint32_t last = 0;
+  for (size_t i = 0; i < lib.gnu_nbucket_; ++i) {
+    const uint32_t sym_idx = lib.gnu_bucket_[i];
+    if (sym_idx != 0) {
+      first = std::min(first, sym_idx);
+      last = std::max(last, sym_idx);
+    }
+  }
+  if (last == 0) {
+    return {0, 0};
+  }
+  while ((lib.gnu_chain_[last] & 1) == 0) {
+    ++last;
+  }
+  return {first, last + 1};
+}
+
+void SymbolLookupList::build_provider_table(size_t lookup_count) {
+  // The table only covers GNU hash tables, and traced lookups should visit every library.
+  if (needs_slow_path() || libs_.size() < 3) {
+    return;
+  }
+
+  std::vector<std::pair<uint32_t, uint32_t>> ranges;
+  ranges.reserve(libs_.size() - 1);
+  size_t symbol_count = 0;
+  for (size_t i = 1; i < libs_.size(); ++i) {
+    ranges.push_back(get_gnu_hash_symbol_range(libs_[i]));
+    symbol_count += ranges.back().second - ranges.back().first;
+  }
+
+  // Without the table, a lookup probes the Bloom filters of about half of the libraries. Adding
+  // a symbol to the table costs about as much as one probe.
+  if (lookup_count * ((libs_.size() - 1) / 2) <= symbol_count) {
+    return;
+  }
+
+  provider_table_.reset(symbol_count);
+  for (size_t i = 1; i < libs_.size(); ++i) {
+    const uint32_t* chain = libs_[i].gnu_chain_;
+    for (uint32_t sym_idx = ranges[i - 1].first; sym_idx < ranges[i - 1].second; ++sym_idx) {
+      provider_table_.add(chain[sym_idx], i - 1);
+    }
+  }
+}
+
 /* "This element's presence in a shared object library alters the dynamic linker's
  * symbol resolution algorithm for references within the library. Instead of starting
  * a symbol search with the executable file, the dynamic linker starts from the shared
@@ -125,6 +178,11 @@ soinfo_do_lookup_impl(const char* name, const version_info* vi,
   const SymbolLookupLib* end = lookup_list.end();
   const SymbolLookupLib* it = lookup_list.begin();
 
+  // With a provider table, skip the libraries that have no symbol with this hash at all.
+  const SymbolLookupLib* const provider_table_begin = lookup_list.provider_table_begin();
+  const SymbolLookupLib* const first_provider =
+      provider_table_begin != nullptr ? lookup_list.find_first_provider(hash) : nullptr;
+
   while (true) {
     const SymbolLookupLib* lib;
     uint32_t sym_idx;
@@ -132,6 +190,7 @@ soinfo_do_lookup_impl(const char* name, const version_info* vi,
     // Iterate over libraries until we find one whose Bloom filter matches the symbol we're
     // searching for.
     while (true) {
+      if (it == provider_table_begin) it = first_provider;
       if (it == end) return nullptr;
       lib = it++;
 
@@ -235,6 +294,7 @@ soinfo::soinfo(android_namespace_t* ns, const char* realpath,
 
 soinfo::~soinfo() {
   g_soinfo_handles_map.erase(handle_);
+  delete dlsym_cache_;
 }
 
 void soinfo::set_dt_runpath(const char* path) {
@@ -915,6 +975,47 @@ size_t soinfo::get_gap_size() const {
   return gap_size_;
 }
 
+const ElfW(Sym)* soinfo::get_symtab() const {
+  return symtab_;
+}
+
+size_t soinfo::get_symbol_count() {
+  return is_gnu_hash() ? get_gnu_hash_symbol_range(get_lookup_lib()).second : nchain_;
+}
+
+bool soinfo::get_build_id(const uint8_t** build_id, size_t* build_id_size) const {
+  if (!has_min_version(7) || build_id_ == nullptr) {
+    return false;
+  }
+  *build_id = build_id_;
+  *build_id_size = build_id_size_;
+  return true;
+}
+
+void soinfo::set_cached_relro(ElfW(Addr) start, size_t size) {
+  CHECK(has_min_version(8));
+  cached_relro_start_ = start;
+  cached_relro_size_ = size;
+}
+
+ElfW(Addr) soinfo::get_cached_relro_start() const {
+  return has_min_version(8) ? cached_relro_start_ : 0;
+}
+
+size_t soinfo::get_cached_relro_size() const {
+  return has_min_version(8) ? cached_relro_size_ : 0;
+}
+
+void soinfo::create_dlsym_cache() {
+  if (has_min_version(9) && dlsym_cache_ == nullptr) {
+    dlsym_cache_ = new DlsymCache;
+  }
+}
+
+DlsymCache* soinfo::get_dlsym_cache() const {
+  return has_min_version(9) ? dlsym_cache_ : nullptr;
+}
+
 // TODO(dimitry): Move SymbolName methods to a separate file.
 
 uint32_t calculate_elf_hash(const char* name) {
@@ -36,6 +36,7 @@
 
 #include "private/bionic_elf_tls.h"
 #include "linker_namespaces.h"
+#include "linker_symbol_provider_table.h"
 #include "linker_tls.h"
 
 #define FLAG_LINKED           0x00000001
@@ -66,7 +67,7 @@
 #define FLAG_PRELINKED        0x00000400 // prelink_image has successfully processed this soinfo
 #define FLAG_NEW_SOINFO       0x40000000 // new soinfo format
 
-#define SOINFO_VERSION 6
+#define SOINFO_VERSION 9
 
 ElfW(Addr) call_ifunc_resolver(ElfW(Addr) resolver_addr);
 
@@ -91,6 +92,12 @@ struct SymbolLookupLib {
   soinfo* si_ = nullptr;
 
   bool needs_sysv_lookup() const { return si_ != nullptr && gnu_bloom_filter_ == nullptr; }
+
+  // The number of dynamic symbols in front of the GNU hash table's symbols. These are the
+  // undefined (imported) symbols, plus a few local ones.
+  size_t gnu_symndx() const {
+    return gnu_bloom_filter_ == nullptr ? 0 : gnu_bucket_ + gnu_nbucket_ - gnu_chain_;
+  }
 };
 
 // A list of libraries to search for a symbol.
@@ -100,15 +107,32 @@ class SymbolLookupList {
   const SymbolLookupLib* begin_;
   const SymbolLookupLib* end_;
   size_t slow_path_count_ = 0;
+  // Indexes libs_[1] onwards, i.e. everything but the DT_SYMBOLIC library.
+  SymbolProviderTable provider_table_;
 
  public:
   explicit SymbolLookupList(soinfo* si);
   SymbolLookupList(const soinfo_list_t& global_group, const soinfo_list_t& local_group);
   void set_dt_symbolic_lib(soinfo* symbolic_lib);
 
+  // Builds the provider table if |lookup_count| symbol lookups are expected to save more Bloom
+  // filter probes than indexing every symbol of the list costs.
+  void build_provider_table(size_t lookup_count);
+
   const SymbolLookupLib* begin() const { return begin_; }
   const SymbolLookupLib* end() const { return end_; }
   bool needs_slow_path() const { return slow_path_count_ > 0; }
+
+  // Returns the library a lookup of a symbol with GNU hash |hash| should continue with once it
+  // reaches provider_table_begin(), or end() if no further library can define the symbol.
+  // provider_table_begin() is nullptr if there is no provider table.
+  const SymbolLookupLib* provider_table_begin() const {
+    return provider_table_.empty() ? nullptr : &libs_[1];
+  }
+  const SymbolLookupLib* find_first_provider(uint32_t hash) const {
+    uint32_t index = provider_table_.find(hash);
+    return index == SymbolProviderTable::kNoProvider ? end_ : &libs_[1 + index];
+  }
 };
 
 class SymbolName {
@@ -144,6 +168,10 @@ struct version_info {
 
 // TODO(dimitry): remove reference from soinfo member functions to this class.
 class VersionTracker;
+class ConcurrentRelocation;
+class DlsymCache;
+class MprotectBatch;
+class RelroCache;
 
 struct soinfo_tls {
   TlsSegment segment;
@@ -252,7 +280,8 @@ struct soinfo {
   void call_pre_init_constructors();
   bool prelink_image();
   bool link_image(const SymbolLookupList& lookup_list, soinfo* local_group_root,
-                  const android_dlextinfo* extinfo, size_t* relro_fd_offset);
+                  const android_dlextinfo* extinfo, size_t* relro_fd_offset,
+                  const ConcurrentRelocation* concurrent_relocation, MprotectBatch* relro_batch);
   bool protect_relro();
 
   void add_child(soinfo* child);
@@ -351,6 +380,20 @@ struct soinfo {
   void set_gap_size(size_t gap_size);
   size_t get_gap_size() const;
 
+  const ElfW(Sym)* get_symtab() const;
+  // The number of entries in the dynamic symbol table, as implied by the hash table.
+  size_t get_symbol_count();
+  bool get_build_id(const uint8_t** build_id, size_t* build_id_size) const;
+
+  // The RELRO pages mapped from the RELRO cache, whose relocations are already applied.
+  void set_cached_relro(ElfW(Addr) start, size_t size);
+  ElfW(Addr) get_cached_relro_start() const;
+  size_t get_cached_relro_size() const;
+
+  // The cache of dlsym() results for this library's handle, created by dlopen().
+  void create_dlsym_cache();
+  DlsymCache* get_dlsym_cache() const;
+
  private:
   bool is_image_linked() const;
   void set_image_linked();
@@ -365,8 +408,10 @@ struct soinfo {
                            const char* sym_name, const version_info** vi);
 
  private:
-  bool relocate(const SymbolLookupList& lookup_list);
+  bool relocate(const SymbolLookupList& lookup_list,
+                const ConcurrentRelocation* concurrent_relocation, RelroCache* relro_cache);
   bool relocate_relr();
+  void relocate_relr(const ElfW(Relr)* begin, const ElfW(Relr)* end);
   void apply_relr_reloc(ElfW(Addr) offset);
 
   // This part of the structure is only available
@@ -421,6 +466,7 @@ struct soinfo {
   uintptr_t handle_;
 
   friend soinfo* get_libdl_info(const soinfo& linker_si);
+  friend class ConcurrentRelocation;
 
   // version >= 4
   ElfW(Relr)* relr_;
@@ -433,6 +479,17 @@ struct soinfo {
   // version >= 6
   ElfW(Addr) gap_start_;
   size_t gap_size_;
+
+  // version >= 7
+  const uint8_t* build_id_;
+  size_t build_id_size_;
+
+  // version >= 8
+  ElfW(Addr) cached_relro_start_;
+  size_t cached_relro_size_;
+
+  // version >= 9
+  DlsymCache* dlsym_cache_;
 };
 
 // This function is used by dlvsym() to calculate hash of sym_ver
@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "linker_symbol_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <android-base/stringprintf.h>
+#include <android-base/unique_fd.h>
+
+#include "linker_debug.h"
+#include "linker_soinfo.h"
+
+static constexpr char kSymbolCacheMagic[4] = { 'L', 'S', 'C', '1' };
+static constexpr uint32_t kSymbolCacheVersion = 2;
+
+// Sentinels for Entry::lib_index.
+static constexpr uint32_t kSymbolUnknown = UINT32_MAX;
+static constexpr uint32_t kSymbolNotFound = UINT32_MAX - 1;
+
+// A cache file is a SymbolCacheHeader, then the build-id hash of each of the |lib_count|
+// libraries in the lookup list as a uint64_t, then |entry_count| entries indexed by symbol.
+struct SymbolCacheHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t key;
+  uint32_t lib_count;
+  uint32_t entry_count;
+  uint64_t checksum;
+};
+
+static std::string g_symbol_cache_dir;
+
+void set_symbol_cache_dir(const char* dir) {
+  g_symbol_cache_dir = dir;
+}
+
+bool is_symbol_cache_enabled() {
+  return !g_symbol_cache_dir.empty();
+}
+
+static constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ULL;
+
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= p[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+static uint64_t hash_build_id(uint64_t hash, const soinfo* si) {
+  const uint8_t* build_id;
+  size_t build_id_size;
+  if (!si->get_build_id(&build_id, &build_id_size)) {
+    return hash;
+  }
+  uint32_t size = build_id_size;
+  hash = fnv1a(hash, &size, sizeof(size));
+  return fnv1a(hash, build_id, build_id_size);
+}
+
+static bool read_fully(int fd, void* buf, size_t size) {
+  uint8_t* p = static_cast<uint8_t*>(buf);
+  while (size > 0) {
+    ssize_t n = TEMP_FAILURE_RETRY(read(fd, p, size));
+    if (n <= 0) return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+static bool write_fully(int fd, const void* buf, size_t size) {
+  const uint8_t* p = static_cast<const uint8_t*>(buf);
+  while (size > 0) {
+    ssize_t n = TEMP_FAILURE_RETRY(write(fd, p, size));
+    if (n <= 0) return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool hash_lookup_list_build_ids(const soinfo* si, const SymbolLookupList& lookup_list,
+                                uint64_t* key) {
+  const uint8_t* build_id;
+  size_t build_id_size;
+  if (!si->get_build_id(&build_id, &build_id_size)) {
+    return false;
+  }
+
+  uint64_t hash = hash_build_id(kFnvOffsetBasis, si);
+  for (const SymbolLookupLib* lib = lookup_list.begin(); lib != lookup_list.end(); ++lib) {
+    if (!lib->si_->get_build_id(&build_id, &build_id_size)) {
+      return false;
+    }
+    hash = hash_build_id(hash, lib->si_);
+  }
+  *key = hash;
+  return true;
+}
+
+void SymbolResolutionCache::init(soinfo* si, const SymbolLookupList& lookup_list) {
+  if (g_symbol_cache_dir.empty()) {
+    return;
+  }
+
+  if (!hash_lookup_list_build_ids(si, lookup_list, &key_)) {
+    return;
+  }
+  for (const SymbolLookupLib* lib = lookup_list.begin(); lib != lookup_list.end(); ++lib) {
+    libs_.push_back(lib->si_);
+  }
+
+  const uint8_t* build_id;
+  size_t build_id_size;
+  si->get_build_id(&build_id, &build_id_size);
+
+  std::string path = g_symbol_cache_dir + "/";
+  for (size_t i = 0; i < build_id_size; ++i) {
+    android::base::StringAppendF(&path, "%02x", build_id[i]);
+  }
+  android::base::StringAppendF(&path, "-%016" PRIx64 ".symcache", key_);
+  path_ = std::move(path);
+
+  if (!read_file(si)) {
+    entries_.clear();
+  }
+}
+
+std::vector<uint64_t> SymbolResolutionCache::lib_hashes() const {
+  std::vector<uint64_t> hashes;
+  hashes.reserve(libs_.size());
+  for (const soinfo* lib : libs_) {
+    hashes.push_back(hash_build_id(kFnvOffsetBasis, lib));
+  }
+  return hashes;
+}
+
+bool SymbolResolutionCache::read_file(soinfo* si) {
+  android::base::unique_fd fd(TEMP_FAILURE_RETRY(open(path_.c_str(), O_RDONLY | O_CLOEXEC)));
+  if (fd == -1) {
+    return false;
+  }
+
+  SymbolCacheHeader header;
+  if (!read_fully(fd.get(), &header, sizeof(header)) ||
+      memcmp(header.magic, kSymbolCacheMagic, sizeof(kSymbolCacheMagic)) != 0 ||
+      header.version != kSymbolCacheVersion ||
+      header.key != key_ ||
+      header.lib_count != libs_.size()) {
+    DEBUG("[ ignoring stale symbol cache \"%s\" ]", path_.c_str());
+    return false;
+  }
+
+  // Don't trust |entry_count| until it's been checked against both the library (there's one
+  // entry per symbol at most) and the file, so that a bad file can't make us allocate for it.
+  struct stat sb;
+  if (header.entry_count > si->get_symbol_count() ||
+      fstat(fd.get(), &sb) == -1 ||
+      static_cast<uint64_t>(sb.st_size) != sizeof(header) +
+                                               uint64_t{header.lib_count} * sizeof(uint64_t) +
+                                               uint64_t{header.entry_count} * sizeof(Entry)) {
+    DEBUG("[ ignoring corrupt symbol cache \"%s\" ]", path_.c_str());
+    return false;
+  }
+
+  std::vector<uint64_t> file_lib_hashes(header.lib_count);
+  if (!read_fully(fd.get(), file_lib_hashes.data(), file_lib_hashes.size() * sizeof(uint64_t)) ||
+      file_lib_hashes != lib_hashes()) {
+    DEBUG("[ ignoring stale symbol cache \"%s\" ]", path_.c_str());
+    return false;
+  }
+
+  entries_.resize(header.entry_count);
+  if (!read_fully(fd.get(), entries_.data(), entries_.size() * sizeof(Entry)) ||
+      fnv1a(kFnvOffsetBasis, entries_.data(), entries_.size() * sizeof(Entry)) != header.checksum) {
+    DEBUG("[ ignoring corrupt symbol cache \"%s\" ]", path_.c_str());
+    return false;
+  }
+
+  std::vector<size_t> symbol_counts;
+  symbol_counts.reserve(libs_.size());
+  for (soinfo* lib : libs_) {
+    symbol_counts.push_back(lib->get_symbol_count());
+  }
+
+  for (const Entry& entry : entries_) {
+    if (entry.lib_index == kSymbolNotFound || entry.lib_index == kSymbolUnknown) {
+      continue;
+    }
+    if (entry.lib_index >= libs_.size() ||
+        entry.sym_index >= symbol_counts[entry.lib_index]) {
+      DEBUG("[ ignoring corrupt symbol cache \"%s\" ]", path_.c_str());
+      return false;
+    }
+  }
+
+  DEBUG("[ using symbol cache \"%s\" (%zu entries) ]", path_.c_str(), entries_.size());
+  return true;
+}
+
+bool SymbolResolutionCache::find(uint32_t r_sym, const char* sym_name, soinfo** found_in,
+                                 const ElfW(Sym)** sym) const {
+  if (r_sym >= entries_.size()) {
+    return false;
+  }
+
+  const Entry& entry = entries_[r_sym];
+  if (entry.lib_index == kSymbolUnknown) {
+    return false;
+  }
+  if (entry.lib_index == kSymbolNotFound) {
+    *found_in = nullptr;
+    *sym = nullptr;
+    return true;
+  }
+
+  soinfo* lib = libs_[entry.lib_index];
+  const ElfW(Sym)* s = lib->get_symtab() + entry.sym_index;
+  // The build-ids should pin down the symbol tables, but don't trust them to: a cached symbol
+  // that isn't the one |r_sym| refers to would silently bind the reference to the wrong code.
+  if (s->st_shndx == SHN_UNDEF || strcmp(lib->get_string(s->st_name), sym_name) != 0) {
+    return false;
+  }
+  *found_in = lib;
+  *sym = s;
+  return true;
+}
+
+void SymbolResolutionCache::record(uint32_t r_sym, soinfo* found_in, const ElfW(Sym)* sym) {
+  if (!enabled()) {
+    return;
+  }
+
+  Entry entry = { kSymbolNotFound, 0 };
+  if (sym != nullptr) {
+    auto it = std::find(libs_.begin(), libs_.end(), found_in);
+    if (it == libs_.end()) {
+      return;
+    }
+    entry.lib_index = it - libs_.begin();
+    entry.sym_index = sym - found_in->get_symtab();
+  }
+
+  if (r_sym >= entries_.size()) {
+    entries_.resize(r_sym + 1, Entry { kSymbolUnknown, 0 });
+  }
+  entries_[r_sym] = entry;
+  dirty_ = true;
+}
+
+void SymbolResolutionCache::save() {
+  if (!enabled() || !dirty_) {
+    return;
+  }
+
+  // Write to a private file and rename it into place so that concurrent readers (and
+  // writers) only ever see a complete cache file. The temporary file must be a new one we
+  // created ourselves: anything already at that path, such as a symlink planted in a shared
+  // cache directory, means we skip saving rather than write through it.
+  std::string tmp_path = android::base::StringPrintf("%s.%d.tmp", path_.c_str(), getpid());
+  android::base::unique_fd fd(TEMP_FAILURE_RETRY(
+      open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600)));
+  if (fd == -1) {
+    DEBUG("[ unable to write symbol cache \"%s\": %s ]", tmp_path.c_str(), strerror(errno));
+    return;
+  }
+
+  SymbolCacheHeader header = {};
+  memcpy(header.magic, kSymbolCacheMagic, sizeof(kSymbolCacheMagic));
+  header.version = kSymbolCacheVersion;
+  header.key = key_;
+  header.lib_count = libs_.size();
+  header.entry_count = entries_.size();
+  header.checksum = fnv1a(kFnvOffsetBasis, entries_.data(), entries_.size() * sizeof(Entry));
+
+  std::vector<uint64_t> hashes = lib_hashes();
+  if (!write_fully(fd.get(), &header, sizeof(header)) ||
+      !write_fully(fd.get(), hashes.data(), hashes.size() * sizeof(uint64_t)) ||
+      !write_fully(fd.get(), entries_.data(), entries_.size() * sizeof(Entry)) ||
+      rename(tmp_path.c_str(), path_.c_str()) == -1) {
+    DEBUG("[ unable to write symbol cache \"%s\": %s ]", path_.c_str(), strerror(errno));
+    unlink(tmp_path.c_str());
+    return;
+  }
+  dirty_ = false;
+}
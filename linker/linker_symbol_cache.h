@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <link.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <android-base/macros.h>
+
+struct soinfo;
+class SymbolLookupList;
+
+// Enables the persistent symbol resolution cache (LD_SYMBOL_CACHE_DIR). Cache files are
+// stored in |dir|, which must already exist and be writable by the process.
+void set_symbol_cache_dir(const char* dir);
+bool is_symbol_cache_enabled();
+
+// Hashes the build-id of |si| and the ordered build-ids of every library in |lookup_list|, which
+// together determine how the symbol references of |si| resolve. Returns false if any of them
+// doesn't have a build-id.
+bool hash_lookup_list_build_ids(const soinfo* si, const SymbolLookupList& lookup_list,
+                                uint64_t* key);
+
+// Remembers, across process runs, which library in the lookup list satisfied each
+// symbol reference of a library, so that a later run with the same set of libraries
+// can skip the hash table walk over the whole lookup list.
+//
+// A cache file is only used when the build-id of the library being relocated and the
+// ordered build-ids of every library in its lookup list are identical to the ones the
+// cache was written for. The cache is disabled for any lookup list containing a library
+// without a build-id.
+class SymbolResolutionCache {
+ public:
+  SymbolResolutionCache() = default;
+
+  // Loads the cache file (if any) for relocating |si| against |lookup_list|.
+  void init(soinfo* si, const SymbolLookupList& lookup_list);
+
+  bool enabled() const { return !path_.empty(); }
+
+  // Returns the cached resolution of |r_sym|, whose name is |sym_name|. Returns false if the
+  // reference isn't cached, or if the cached symbol isn't named |sym_name|.
+  bool find(uint32_t r_sym, const char* sym_name, soinfo** found_in,
+            const ElfW(Sym)** sym) const;
+  void record(uint32_t r_sym, soinfo* found_in, const ElfW(Sym)* sym);
+
+  // Writes the cache back to disk if lookups were recorded that it didn't already have.
+  void save();
+
+ private:
+  struct Entry {
+    uint32_t lib_index;
+    uint32_t sym_index;
+  };
+
+  bool read_file(soinfo* si);
+  std::vector<uint64_t> lib_hashes() const;
+
+  std::string path_;
+  uint64_t key_ = 0;
+  std::vector<soinfo*> libs_;
+  std::vector<Entry> entries_;
+  bool dirty_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(SymbolResolutionCache);
+};
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <android-base/macros.h>
+
+// Maps the GNU hash of every symbol defined by a list of libraries to the first library (in
+// lookup order) whose GNU hash table has a symbol with that hash.
+//
+// A symbol lookup can start at that library instead of probing the Bloom filter of every library
+// in front of it: none of them can define the symbol. The library found may still not define the
+// symbol (the hashes of two names can collide, or the version may not match), in which case the
+// lookup carries on with the following libraries as usual.
+//
+// GNU hash tables use the lowest bit of each hash value to mark the end of a chain, so only the
+// upper 31 bits of a hash are significant here.
+class SymbolProviderTable {
+ public:
+  static constexpr uint32_t kNoProvider = UINT32_MAX;
+
+  SymbolProviderTable() = default;
+
+  bool empty() const { return entries_.empty(); }
+
+  // Clears the table and sizes it for |hash_count| calls to add().
+  void reset(size_t hash_count) {
+    size_t capacity = 16;
+    int shift = 28;
+    // Keep the table at most half full so that probe sequences stay short.
+    while (capacity < hash_count * 2) {
+      capacity *= 2;
+      --shift;
+    }
+    entries_.assign(capacity, Entry{});
+    shift_ = shift;
+  }
+
+  // Records that library |lib_index| defines a symbol with the given hash (or GNU hash chain
+  // value). Libraries must be added in lookup order.
+  void add(uint32_t hash, uint32_t lib_index) {
+    const uint32_t key = hash | 1;
+    for (size_t i = slot(key);; i = (i + 1) & (entries_.size() - 1)) {
+      Entry& entry = entries_[i];
+      if (entry.key == key) return;
+      if (entry.key == 0) {
+        entry.key = key;
+        entry.lib_index = lib_index;
+        return;
+      }
+    }
+  }
+
+  // Returns the index of the first library defining a symbol with GNU hash |hash|, or
+  // kNoProvider if no library does. The table must not be empty.
+  uint32_t find(uint32_t hash) const {
+    const uint32_t key = hash | 1;
+    for (size_t i = slot(key);; i = (i + 1) & (entries_.size() - 1)) {
+      const Entry& entry = entries_[i];
+      if (entry.key == key) return entry.lib_index;
+      if (entry.key == 0) return kNoProvider;
+    }
+  }
+
+ private:
+  // An empty entry has a zero key, which no (hash | 1) can be.
+  struct Entry {
+    uint32_t key = 0;
+    uint32_t lib_index = 0;
+  };
+
+  size_t slot(uint32_t key) const {
+    // Fibonacci hashing spreads the upper bits of the GNU hash over the table.
+    return (key * 0x9e3779b1u) >> shift_;
+  }
+
+  std::vector<Entry> entries_;
+  int shift_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(SymbolProviderTable);
+};
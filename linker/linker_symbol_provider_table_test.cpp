@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "linker_gnu_hash.h"
+#include "linker_symbol_provider_table.h"
+
+static uint32_t gnu_hash(const char* name) {
+  return calculate_gnu_hash_simple(name).first;
+}
+
+TEST(linker_symbol_provider_table, empty) {
+  SymbolProviderTable table;
+  ASSERT_TRUE(table.empty());
+  table.reset(0);
+  ASSERT_FALSE(table.empty());
+  ASSERT_EQ(SymbolProviderTable::kNoProvider, table.find(gnu_hash("malloc")));
+}
+
+TEST(linker_symbol_provider_table, first_provider_wins) {
+  SymbolProviderTable table;
+  table.reset(4);
+  table.add(gnu_hash("malloc"), 1);
+  table.add(gnu_hash("free"), 1);
+  table.add(gnu_hash("malloc"), 3);
+  table.add(gnu_hash("strlen"), 3);
+
+  ASSERT_EQ(1U, table.find(gnu_hash("malloc")));
+  ASSERT_EQ(1U, table.find(gnu_hash("free")));
+  ASSERT_EQ(3U, table.find(gnu_hash("strlen")));
+  ASSERT_EQ(SymbolProviderTable::kNoProvider, table.find(gnu_hash("calloc")));
+}
+
+TEST(linker_symbol_provider_table, chain_end_bit_is_ignored) {
+  // GNU hash chains store the hash with the lowest bit replaced by an end-of-chain marker.
+  const uint32_t hash = gnu_hash("pthread_create");
+  SymbolProviderTable table;
+  table.reset(1);
+  table.add(hash ^ 1, 7);
+  ASSERT_EQ(7U, table.find(hash));
+  ASSERT_EQ(7U, table.find(hash ^ 1));
+}
+
+TEST(linker_symbol_provider_table, many) {
+  constexpr uint32_t kCount = 10000;
+  SymbolProviderTable table;
+  table.reset(kCount);
+  for (uint32_t i = 0; i < kCount; ++i) {
+    table.add(i << 1, i % 37);
+  }
+  for (uint32_t i = 0; i < kCount; ++i) {
+    ASSERT_EQ(i % 37, table.find(i << 1)) << i;
+  }
+  ASSERT_EQ(SymbolProviderTable::kNoProvider, table.find(kCount << 1));
+}
@@ -28,9 +28,11 @@
 
 #include "linker_tls.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "async_safe/CHECK.h"
+#include "platform/bionic/macros.h"
 #include "private/ScopedRWLock.h"
 #include "private/ScopedSignalBlocker.h"
 #include "private/bionic_defs.h"
@@ -43,6 +45,22 @@
 static bool g_static_tls_finished;
 static std::vector<TlsModule> g_tls_modules;
 
+// The space reserved at the end of static TLS for the TLS segments of dlopen'ed libraries
+// (LD_STATIC_TLS_SURPLUS), and the unused parts of it, sorted by offset. A module in the surplus
+// is accessed like one loaded at startup: TLSDESC and IE accesses resolve to a fixed offset from
+// the thread pointer, and __tls_get_addr never allocates memory for it.
+static size_t g_static_tls_surplus_size;
+
+struct StaticTlsRange {
+  size_t offset;
+  size_t size;
+};
+
+static std::vector<StaticTlsRange> g_static_tls_surplus_free;
+
+// Each thread's static TLS block is mapped separately, so the surplus can't be grown later.
+static constexpr size_t kMaxStaticTlsSurplusSize = 64 * 1024;
+
 static size_t get_unused_module_index() {
   for (size_t i = 0; i < g_tls_modules.size(); ++i) {
     if (g_tls_modules[i].soinfo_ptr == nullptr) {
@@ -55,6 +73,61 @@ static size_t get_unused_module_index() {
   return g_tls_modules.size() - 1;
 }
 
+// Returns the offset of space for segment in the static TLS surplus, or SIZE_MAX if there isn't
+// enough.
+static size_t allocate_static_tls_surplus(const TlsSegment& segment) {
+  // Threads' static TLS blocks are only aligned to the alignment of the layout.
+  if (segment.alignment > __libc_shared_globals()->static_tls_layout.alignment()) {
+    return SIZE_MAX;
+  }
+
+  for (auto it = g_static_tls_surplus_free.begin(); it != g_static_tls_surplus_free.end(); ++it) {
+    const size_t start = __BIONIC_ALIGN(it->offset, segment.alignment);
+    const size_t end = it->offset + it->size;
+    if (start > end || end - start < segment.size) {
+      continue;
+    }
+
+    // Keep the parts of the free range before and after the segment.
+    const StaticTlsRange before = { it->offset, start - it->offset };
+    const StaticTlsRange after = { start + segment.size, end - (start + segment.size) };
+    if (before.size != 0 && after.size != 0) {
+      *it = before;
+      g_static_tls_surplus_free.insert(it + 1, after);
+    } else if (before.size != 0) {
+      *it = before;
+    } else if (after.size != 0) {
+      *it = after;
+    } else {
+      g_static_tls_surplus_free.erase(it);
+    }
+    return start;
+  }
+  return SIZE_MAX;
+}
+
+static void free_static_tls_surplus(size_t offset, size_t size) {
+  auto it = std::lower_bound(g_static_tls_surplus_free.begin(), g_static_tls_surplus_free.end(),
+                             offset, [](const StaticTlsRange& range, size_t offset) {
+                               return range.offset < offset;
+                             });
+  it = g_static_tls_surplus_free.insert(it, { offset, size });
+
+  // Merge the range with its neighbors.
+  auto next = it + 1;
+  if (next != g_static_tls_surplus_free.end() && it->offset + it->size == next->offset) {
+    it->size += next->size;
+    g_static_tls_surplus_free.erase(next);
+  }
+  if (it != g_static_tls_surplus_free.begin()) {
+    auto prev = it - 1;
+    if (prev->offset + prev->size == it->offset) {
+      prev->size += it->size;
+      g_static_tls_surplus_free.erase(it);
+    }
+  }
+}
+
 static void register_tls_module(soinfo* si, size_t static_offset) {
   TlsModules& libc_modules = __libc_shared_globals()->tls_modules;
 
@@ -87,9 +160,13 @@ static void unregister_tls_module(soinfo* si) {
   ScopedWriteLock locker(&__libc_shared_globals()->tls_modules.rwlock);
 
   soinfo_tls* si_tls = si->get_tls();
-  TlsModule& mod = g_tls_modules[__tls_module_id_to_idx(si_tls->module_id)];
-  CHECK(mod.static_offset == SIZE_MAX);
+  const size_t module_idx = __tls_module_id_to_idx(si_tls->module_id);
+  TlsModule& mod = g_tls_modules[module_idx];
+  CHECK(module_idx >= __libc_shared_globals()->tls_modules.static_module_count);
   CHECK(mod.soinfo_ptr == si);
+  if (mod.static_offset != SIZE_MAX) {
+    free_static_tls_surplus(mod.static_offset, mod.segment.size);
+  }
   mod = {};
   si_tls->module_id = kTlsUninitializedModuleId;
 }
@@ -126,23 +203,48 @@ void linker_setup_exe_static_tls(const char* progname) {
 }
 
 void linker_finalize_static_tls() {
+  // find_libraries() finalizes the layout early if the initial load uses loader threads.
+  if (g_static_tls_finished) return;
   g_static_tls_finished = true;
-  __libc_shared_globals()->static_tls_layout.finish_layout();
+  StaticTlsLayout& layout = __libc_shared_globals()->static_tls_layout;
+  if (g_static_tls_surplus_size != 0) {
+    g_static_tls_surplus_free.push_back({
+      layout.reserve_surplus(g_static_tls_surplus_size), g_static_tls_surplus_size
+    });
+  }
+  layout.finish_layout();
   TlsModules& modules = __libc_shared_globals()->tls_modules;
   modules.static_module_count = modules.module_count;
 }
 
+bool is_static_tls_finalized() {
+  return g_static_tls_finished;
+}
+
+void set_static_tls_surplus_size(size_t size) {
+  g_static_tls_surplus_size = std::min(size, kMaxStaticTlsSurplusSize);
+}
+
 void register_soinfo_tls(soinfo* si) {
   soinfo_tls* si_tls = si->get_tls();
   if (si_tls == nullptr || si_tls->module_id != kTlsUninitializedModuleId) {
     return;
   }
   size_t static_offset = SIZE_MAX;
+  auto init_static_tls_module = __libc_shared_globals()->tls_modules.init_static_tls_module_cb;
   if (!g_static_tls_finished) {
     StaticTlsLayout& layout = __libc_shared_globals()->static_tls_layout;
     static_offset = layout.reserve_solib_segment(si_tls->segment);
+  } else if (init_static_tls_module != nullptr) {
+    static_offset = allocate_static_tls_surplus(si_tls->segment);
   }
   register_tls_module(si, static_offset);
+
+  // Threads that already exist need their copy of a module in the surplus initialized before the
+  // library is relocated. New threads copy it in __init_static_tls().
+  if (g_static_tls_finished && static_offset != SIZE_MAX) {
+    init_static_tls_module(get_tls_module(si_tls->module_id));
+  }
 }
 
 void unregister_soinfo_tls(soinfo* si) {
@@ -38,6 +38,13 @@ struct soinfo;
 void linker_setup_exe_static_tls(const char* progname);
 void linker_finalize_static_tls();
 
+// Returns true once no more modules can be added to static TLS, i.e. once threads can be created.
+bool is_static_tls_finalized();
+
+// Reserves `size` bytes of static TLS (LD_STATIC_TLS_SURPLUS) for the TLS segments of libraries
+// loaded by dlopen(). Must be called before the static TLS layout is finalized.
+void set_static_tls_surplus_size(size_t size);
+
 void register_soinfo_tls(soinfo* si);
 void unregister_soinfo_tls(soinfo* si);
 
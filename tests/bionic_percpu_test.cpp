@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <sched.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#if defined(__BIONIC__)
+#include "private/bionic_percpu.h"
+
+static constexpr size_t kThreadCount = 8;
+
+// Runs `fn` as if the process had been started with LIBC_DISABLE_RSEQ=1, so that the per-CPU
+// primitives take their fallback path. Threads that `fn` starts must have exited when it returns.
+template <typename Fn>
+static void WithoutRseq(Fn fn) {
+  unsigned int rseq_size = __rseq_size;
+  __rseq_size = 0;
+  fn();
+  __rseq_size = rseq_size;
+}
+
+static void AddFromThreads(PerCpuCounter<>* counter, size_t adds_per_thread) {
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([counter, adds_per_thread]() {
+      for (size_t j = 0; j < adds_per_thread; ++j) counter->add(1);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+}
+
+struct TestNode {
+  TestNode* next;
+  std::atomic<bool> in_use;
+};
+
+// Has the threads keep popping nodes, checking that no other thread has them at the same time,
+// and pushing them back. Then counts the nodes left on the lists of every CPU.
+static size_t CycleFreeList(PerCpuFreeList<TestNode>* list) {
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([list]() {
+      for (size_t j = 0; j < 10000; ++j) {
+        TestNode* nodes[4];
+        for (TestNode*& node : nodes) {
+          node = list->pop();
+          if (node != nullptr) EXPECT_FALSE(node->in_use.exchange(true));
+        }
+        for (TestNode* node : nodes) {
+          if (node == nullptr) continue;
+          node->in_use = false;
+          list->push(node);
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  // Nodes pushed on a CPU's own list can only be popped on that CPU.
+  cpu_set_t allowed;
+  EXPECT_EQ(0, sched_getaffinity(0, sizeof(allowed), &allowed));
+  size_t count = 0;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (!CPU_ISSET(cpu, &allowed)) continue;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) continue;
+    while (list->pop() != nullptr) ++count;
+  }
+  EXPECT_EQ(0, sched_setaffinity(0, sizeof(allowed), &allowed));
+  return count;
+}
+
+static void TestFreeList() {
+  static PerCpuFreeList<TestNode> list;
+  static TestNode nodes[64];
+  for (TestNode& node : nodes) list.push(&node);
+  ASSERT_EQ(64U, CycleFreeList(&list));
+}
+#endif
+
+TEST(bionic_percpu, PerCpuCounter) {
+#if defined(__BIONIC__)
+  if (__rseq_size == 0) GTEST_SKIP() << "rseq not registered";
+  static PerCpuCounter<> counter;
+  AddFromThreads(&counter, 100000);
+  ASSERT_EQ(static_cast<int64_t>(kThreadCount * 100000), counter.sum());
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+TEST(bionic_percpu, PerCpuCounter_without_rseq) {
+#if defined(__BIONIC__)
+  static PerCpuCounter<> counter;
+  WithoutRseq([]() { AddFromThreads(&counter, 100000); });
+  ASSERT_EQ(static_cast<int64_t>(kThreadCount * 100000), counter.sum());
+
+  // Updates from threads with and without rseq go to different slots, and are all counted.
+  counter.add(-1);
+  WithoutRseq([]() { counter.add(-1); });
+  ASSERT_EQ(static_cast<int64_t>(kThreadCount * 100000 - 2), counter.sum());
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+TEST(bionic_percpu, PerCpuFreeList) {
+#if defined(__BIONIC__)
+  if (__rseq_size == 0) GTEST_SKIP() << "rseq not registered";
+  TestFreeList();
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+TEST(bionic_percpu, PerCpuFreeList_without_rseq) {
+#if defined(__BIONIC__)
+  WithoutRseq([]() { TestFreeList(); });
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
@@ -211,6 +211,63 @@ TEST(dl, exec_with_ld_preload) {
 #endif
 }
 
+// With LD_LOADER_THREADS the DT_NEEDED libraries of a dlopen()ed library are read and mapped on
+// helper threads, but the load order (and so the symbol that dlsym() finds) must not change.
+TEST(dl, exec_with_loader_threads) {
+#if defined(__BIONIC__)
+  std::string helper = GetTestlibRoot() + "/loader_threads_test_helper";
+  std::string lib = GetTestlibRoot() + "/libtest_check_order_dlsym.so";
+  chmod(helper.c_str(), 0755);
+  ExecTestHelper eth;
+  eth.SetArgs({ helper.c_str(), lib.c_str(), "check_order_dlsym_get_answer", nullptr });
+  eth.SetEnv({ "LD_LOADER_THREADS=4", nullptr });
+  eth.Run([&]() { execve(helper.c_str(), eth.GetArgs(), eth.GetEnv()); }, 0, "^42$");
+#endif
+}
+
+TEST(dl, exec_with_loader_threads_invalid_elf) {
+#if defined(__BIONIC__)
+  std::string helper = GetTestlibRoot() + "/loader_threads_test_helper";
+  std::string lib = GetPrebuiltElfDir() + "/libtest_invalid-zero_shentsize.so";
+  chmod(helper.c_str(), 0755);
+  ExecTestHelper eth;
+  eth.SetArgs({ helper.c_str(), lib.c_str(), "foo", nullptr });
+  eth.SetEnv({ "LD_LOADER_THREADS=4", nullptr });
+  eth.Run([&]() { execve(helper.c_str(), eth.GetArgs(), eth.GetEnv()); }, 1,
+          "has unsupported e_shentsize: 0x0 \\(expected 0x");
+#endif
+}
+
+TEST(dl, exec_with_loader_threads_missing_symbol) {
+#if defined(__BIONIC__)
+  // Relocations that fail on a loader thread are redone on the calling thread, so the error is
+  // the same as without loader threads.
+  std::string helper = GetTestlibRoot() + "/loader_threads_test_helper";
+  std::string lib = GetTestlibRoot() + "/public_namespace_libs/libtest_missing_symbol.so";
+  chmod(helper.c_str(), 0755);
+  ExecTestHelper eth;
+  eth.SetArgs({ helper.c_str(), lib.c_str(), "foo", nullptr });
+  eth.SetEnv({ "LD_LOADER_THREADS=4", nullptr });
+  std::string expected_error =
+      "cannot locate symbol \"dlopen_testlib_missing_symbol\" referenced by \"" + lib + "\"";
+  eth.Run([&]() { execve(helper.c_str(), eth.GetArgs(), eth.GetEnv()); }, 1,
+          expected_error.c_str());
+#endif
+}
+
+// During the initial load with LD_LOADER_THREADS, the static TLS layout is finalized early and the
+// executable's DT_NEEDED libraries are relocated on loader threads, before the main thread moves
+// onto its final static TLS. Their static TLS must still be set up for every thread.
+TEST(dl, exec_with_loader_threads_static_tls) {
+#if defined(__BIONIC__)
+  std::string helper = GetTestlibRoot() + "/loader_threads_static_tls_helper";
+  chmod(helper.c_str(), 0755);
+  ExecTestHelper eth;
+  eth.SetArgs({ helper.c_str(), nullptr });
+  eth.SetEnv({ "LD_LOADER_THREADS=4", nullptr });
+  eth.Run([&]() { execve(helper.c_str(), eth.GetArgs(), eth.GetEnv()); }, 0, "^done$");
+#endif
+}
 
 // ld_config_test_helper must fail because it is depending on a lib which is not
 // in the search path
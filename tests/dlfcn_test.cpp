@@ -29,8 +29,10 @@
 #endif
 #include <sys/user.h>
 
+#include <atomic>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <android-base/file.h>
 #include <android-base/macros.h>
@@ -679,6 +681,39 @@ TEST(dlfcn, dlopen_check_rtld_local) {
   dlclose(handle);
 }
 
+// dlsym() and dladdr() don't take the loader lock, so check that concurrent lookups (including
+// ones that fail) don't see each other's errors or a half-loaded library.
+TEST(dlfcn, dlsym_concurrent_with_dlopen) {
+  std::atomic<bool> done(false);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 4; ++i) {
+    threads.emplace_back([&done, i]() {
+      std::string missing = "dlsym_concurrent_missing_" + std::to_string(i);
+      while (!done) {
+        ASSERT_TRUE(dlsym(RTLD_DEFAULT, "strlen") != nullptr) << dlerror();
+        ASSERT_TRUE(dlsym(RTLD_DEFAULT, missing.c_str()) == nullptr);
+        ASSERT_SUBSTR(("undefined symbol: " + missing).c_str(), dlerror());
+        Dl_info info;
+        ASSERT_NE(0, dladdr(reinterpret_cast<void*>(strlen), &info));
+      }
+    });
+  }
+
+  for (size_t i = 0; i < 100; ++i) {
+    void* handle = dlopen("libtest_simple.so", RTLD_NOW);
+    ASSERT_TRUE(handle != nullptr) << dlerror();
+    void* sym = dlsym(handle, "dlopen_testlib_simple_func");
+    ASSERT_TRUE(sym != nullptr) << dlerror();
+    ASSERT_TRUE(reinterpret_cast<bool (*)(void)>(sym)());
+    ASSERT_EQ(0, dlclose(handle));
+  }
+
+  done = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
 TEST(dlfcn, dlopen_check_rtld_global) {
   void* sym = dlsym(RTLD_DEFAULT, "dlopen_testlib_simple_func");
   ASSERT_TRUE(sym == nullptr);
@@ -87,6 +87,27 @@ TEST(elftls_dl, dlopen_ie_error) {
   eth.Run([&]() { execve(helper.c_str(), eth.GetArgs(), eth.GetEnv()); }, 0, error.c_str());
 }
 
+// With LD_STATIC_TLS_SURPLUS, the linker places libtest_elftls_shared_var.so in
+// static TLS when it is dlopen'ed, so the IE access succeeds, and initializes it
+// in the threads that already exist.
+TEST(elftls_dl, dlopen_ie_static_tls_surplus) {
+#if defined(__BIONIC__)
+  std::string helper = GetTestlibRoot() + "/elftls_static_tls_surplus_helper";
+  chmod(helper.c_str(), 0755); // TODO: "x" lost in CTS, b/34945607
+  ExecTestHelper eth;
+  eth.SetArgs({ helper.c_str(), nullptr });
+  eth.SetEnv({ "LD_STATIC_TLS_SURPLUS=1024", nullptr });
+  eth.Run([&]() { execve(helper.c_str(), eth.GetArgs(), eth.GetEnv()); }, 0,
+          "main thread: 21\n"
+          "main thread: 22\n"
+          "existing thread: 21\n"
+          "new thread: 21\n"
+          "reloaded: 21\n");
+#else
+  GTEST_SKIP() << "LD_STATIC_TLS_SURPLUS is only supported by bionic";
+#endif
+}
+
 // Use a GD access (__tls_get_addr or TLSDESC) to modify a variable in static
 // TLS memory.
 TEST(elftls_dl, access_static_tls) {
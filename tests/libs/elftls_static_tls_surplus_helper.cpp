@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <dlfcn.h>
+#include <stdio.h>
+
+#include <future>
+#include <thread>
+
+// This helper executable is run with LD_STATIC_TLS_SURPLUS set. It loads
+// libtest_elftls_shared_var_ie.so, whose IE access to a TLS variable in
+// libtest_elftls_shared_var.so only works if the linker placed that solib in
+// the static TLS surplus. Each thread, including one that existed before the
+// dlopen, should see the variable's initial value (20).
+
+typedef int (*bump_shared_var_t)();
+
+static void* load_lib(bump_shared_var_t* bump_shared_var) {
+  void* lib = dlopen("libtest_elftls_shared_var_ie.so", RTLD_LOCAL | RTLD_NOW);
+  if (lib == nullptr) {
+    printf("dlerror: %s\n", dlerror());
+    return nullptr;
+  }
+  *bump_shared_var = reinterpret_cast<bump_shared_var_t>(dlsym(lib, "bump_shared_var"));
+  return lib;
+}
+
+int main() {
+  std::promise<bump_shared_var_t> bump_promise;
+  std::thread existing_thread([&bump_promise] {
+    bump_shared_var_t bump_shared_var = bump_promise.get_future().get();
+    if (bump_shared_var != nullptr) {
+      printf("existing thread: %d\n", bump_shared_var());
+    }
+  });
+
+  bump_shared_var_t bump_shared_var = nullptr;
+  void* lib = load_lib(&bump_shared_var);
+  if (lib != nullptr) {
+    printf("main thread: %d\n", bump_shared_var());
+    printf("main thread: %d\n", bump_shared_var());
+  }
+  bump_promise.set_value(bump_shared_var);
+  existing_thread.join();
+  if (lib == nullptr) {
+    return 0;
+  }
+
+  std::thread([bump_shared_var] {
+    printf("new thread: %d\n", bump_shared_var());
+  }).join();
+
+  // Unloading the library returns its TLS memory to the surplus. Loading it
+  // again must reset the variable, even though the memory is reused.
+  dlclose(lib);
+  if (load_lib(&bump_shared_var) != nullptr) {
+    printf("reloaded: %d\n", bump_shared_var());
+  }
+  return 0;
+}
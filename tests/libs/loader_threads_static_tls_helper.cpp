@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+
+// Both libraries are DT_NEEDED and use initial-exec TLS, so they're in static TLS.
+extern "C" int bump_shared_var();        // libtest_elftls_shared_var_ie.so
+extern "C" int bump_static_tls_var_1();  // libtest_elftls_tprel.so
+extern "C" int bump_static_tls_var_2();  // libtest_elftls_tprel.so
+
+__attribute__((tls_model("initial-exec"))) static __thread int exe_tls_var = 11;
+
+// Returns whether the calling thread sees the initial value of every TLS variable.
+static bool CheckStaticTls() {
+  return bump_shared_var() == 21 && bump_static_tls_var_1() == 4 &&
+         bump_static_tls_var_2() == 8 && ++exe_tls_var == 12;
+}
+
+static void* CheckStaticTlsFn(void*) {
+  return reinterpret_cast<void*>(CheckStaticTls());
+}
+
+// Prints "done" if the main thread and a new thread both start with fresh static TLS.
+int main() {
+  if (!CheckStaticTls()) return 1;
+
+  pthread_t t;
+  void* result;
+  if (pthread_create(&t, nullptr, CheckStaticTlsFn, nullptr) != 0 ||
+      pthread_join(t, &result) != 0 || result == nullptr) {
+    return 1;
+  }
+  printf("done");
+  return 0;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <dlfcn.h>
+#include <stdio.h>
+
+// Usage: loader_threads_test_helper <library> <function>
+// dlopen()s the library and prints the result of calling the int-returning function, or the
+// dlerror() message.
+int main(int argc, char** argv) {
+  if (argc != 3) return 2;
+
+  void* handle = dlopen(argv[1], RTLD_NOW);
+  if (handle == nullptr) {
+    printf("%s", dlerror());
+    return 1;
+  }
+
+  auto fn = reinterpret_cast<int (*)()>(dlsym(handle, argv[2]));
+  if (fn == nullptr) {
+    printf("%s", dlerror());
+    return 1;
+  }
+  printf("%d", fn());
+  return 0;
+}
@@ -30,11 +30,14 @@
 
 #include <dlfcn.h>
 #include <link.h>
+#include <sched.h>
 #if __has_include(<sys/auxv.h>)
 #include <sys/auxv.h>
 #endif
 
+#include <atomic>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 TEST(link, dl_iterate_phdr_early_exit) {
@@ -127,6 +130,87 @@ TEST(link, dl_iterate_phdr_counters) {
   ASSERT_LT(before_dlclose.subs, after_dlclose.subs);
 }
 
+static int check_elf_header(dl_phdr_info* info, size_t, void*) {
+  for (ElfW(Half) i = 0; i < info->dlpi_phnum; ++i) {
+    if (info->dlpi_phdr[i].p_type == PT_LOAD) {
+      const void* ehdr = reinterpret_cast<const void*>(info->dlpi_addr + info->dlpi_phdr[i].p_vaddr);
+      EXPECT_EQ(0, memcmp(ehdr, ELFMAG, SELFMAG));
+      break;
+    }
+  }
+  return 0;
+}
+
+// dl_iterate_phdr doesn't take the loader lock, so make sure that a library being unloaded on
+// another thread stays mapped for as long as a callback can see it.
+TEST(link, dl_iterate_phdr_concurrent_dlclose) {
+  std::atomic<bool> done(false);
+  std::thread reader([&]() {
+    while (!done) {
+      dl_iterate_phdr(check_elf_header, nullptr);
+    }
+  });
+
+  for (size_t i = 0; i < 100; ++i) {
+    void* handle = dlopen("libtest_empty.so", RTLD_NOW);
+    ASSERT_NE(nullptr, handle) << dlerror();
+    ASSERT_EQ(0, dlclose(handle));
+  }
+
+  done = true;
+  reader.join();
+}
+
+TEST(link, dl_iterate_phdr_dlclose_from_callback) {
+  void* handle = dlopen("libtest_empty.so", RTLD_NOW);
+  ASSERT_NE(nullptr, handle) << dlerror();
+
+  // Closing a library from inside a callback must not wait for the callback to return.
+  auto callback = [](dl_phdr_info*, size_t, void* data) {
+    void** handle = static_cast<void**>(data);
+    if (*handle != nullptr) {
+      EXPECT_EQ(0, dlclose(*handle));
+      *handle = nullptr;
+    }
+    return 0;
+  };
+  ASSERT_EQ(0, dl_iterate_phdr(callback, &handle));
+  ASSERT_EQ(nullptr, handle);
+}
+
+// dlopen() and dlclose() on another thread must not wait for a dl_iterate_phdr() callback to
+// return, because the callback may itself be waiting for that thread.
+TEST(link, dl_iterate_phdr_callback_waits_for_dlopen) {
+  struct State {
+    std::atomic<bool> in_callback;
+    std::atomic<bool> dlopen_done;
+  } state = {};
+
+  std::thread reader([&state]() {
+    dl_iterate_phdr(
+        [](dl_phdr_info*, size_t, void* data) {
+          State* state = static_cast<State*>(data);
+          state->in_callback = true;
+          while (!state->dlopen_done) {
+            sched_yield();
+          }
+          return 1;
+        },
+        &state);
+  });
+  while (!state.in_callback) {
+    sched_yield();
+  }
+
+  void* handle = dlopen("libtest_empty.so", RTLD_NOW);
+  int dlclose_result = (handle != nullptr) ? dlclose(handle) : -1;
+  state.dlopen_done = true;
+  reader.join();
+
+  ASSERT_NE(nullptr, handle) << dlerror();
+  ASSERT_EQ(0, dlclose_result);
+}
+
 struct ProgHdr {
   const ElfW(Phdr)* table;
   size_t size;
@@ -36,6 +36,7 @@
 #include <algorithm>
 #include <atomic>
 #include <functional>
+#include <set>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -594,6 +595,75 @@ TEST(malloc, realloc_0) {
   ASSERT_TRUE(p2 == nullptr);
 }
 
+TEST(malloc, malloc_batch) {
+#if defined(__BIONIC__)
+  void* ptrs[64];
+  ASSERT_EQ(64U, malloc_batch(32, ptrs, 64));
+  std::set<void*> unique_ptrs;
+  for (void* ptr : ptrs) {
+    ASSERT_TRUE(ptr != nullptr);
+    ASSERT_LE(32U, malloc_usable_size(ptr));
+    memset(ptr, 0xeb, 32);
+    unique_ptrs.insert(ptr);
+  }
+  ASSERT_EQ(64U, unique_ptrs.size());
+  free_batch(ptrs, 64);
+
+  ASSERT_EQ(0U, malloc_batch(32, ptrs, 0));
+#else
+  GTEST_SKIP() << "bionic extension";
+#endif
+}
+
+TEST(malloc, malloc_batch_overflow) {
+#if defined(__BIONIC__)
+  SKIP_WITH_HWASAN;
+  void* ptrs[4];
+  errno = 0;
+  ASSERT_EQ(0U, malloc_batch(SIZE_MAX, ptrs, 4));
+  ASSERT_EQ(ENOMEM, errno);
+#else
+  GTEST_SKIP() << "bionic extension";
+#endif
+}
+
+TEST(malloc, free_batch_nullptr) {
+#if defined(__BIONIC__)
+  void* ptrs[3] = {nullptr, malloc(16), nullptr};
+  ASSERT_TRUE(ptrs[1] != nullptr);
+  free_batch(ptrs, 3);
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+  free_batch(nullptr, 0);
+#pragma clang diagnostic pop
+#else
+  GTEST_SKIP() << "bionic extension";
+#endif
+}
+
+TEST(malloc, free_sized) {
+#if defined(__BIONIC__)
+  free_sized(malloc(100), 100);
+  free_sized(calloc(10, 10), 100);
+  void* p = malloc(10);
+  free_sized(realloc(p, 200), 200);
+  free_sized(nullptr, 0);
+#else
+  GTEST_SKIP() << "C23 function";
+#endif
+}
+
+TEST(malloc, free_aligned_sized) {
+#if defined(__BIONIC__)
+  void* p = aligned_alloc(64, 256);
+  ASSERT_TRUE(p != nullptr);
+  free_aligned_sized(p, 64, 256);
+  free_aligned_sized(nullptr, 64, 0);
+#else
+  GTEST_SKIP() << "C23 function";
+#endif
+}
+
 constexpr size_t MAX_LOOPS = 200;
 
 // Make sure that memory returned by malloc is aligned to allow these data types.
@@ -1200,6 +1270,11 @@ TEST(android_mallopt, set_allocation_limit) {
                 return realloc(p, bytes) != nullptr;
               }),
               testing::ExitedWithCode(0), "");
+  EXPECT_EXIT(CheckAllocationFunction([](size_t bytes) {
+                void* ptrs[4];
+                return malloc_batch(bytes / 4, ptrs, 4) == 4;
+              }),
+              testing::ExitedWithCode(0), "");
 #if !defined(__LP64__)
   EXPECT_EXIT(CheckAllocationFunction([](size_t bytes) { return pvalloc(bytes) != nullptr; }),
               testing::ExitedWithCode(0), "");
@@ -1336,6 +1411,69 @@ TEST(android_mallopt, set_allocation_limit_realloc_free) {
 #endif
 }
 
+#if defined(__BIONIC__)
+static void* AllocateAndFreeSmall(void*) {
+  // Enough small allocations to leave part of the count unfolded wherever it's kept.
+  for (size_t i = 0; i < 1000; i++) {
+    void* ptrs[16];
+    for (size_t j = 0; j < 16; j++) {
+      ptrs[j] = malloc(100 + i % 1000);
+    }
+    for (size_t j = 0; j < 16; j++) {
+      free(ptrs[j]);
+    }
+  }
+  // Let another thread free this, so it's counted and uncounted by different threads.
+  return malloc(3000);
+}
+#endif
+
+TEST(android_mallopt, set_allocation_limit_batch_and_sized_free) {
+#if defined(__BIONIC__)
+  size_t limit = 128 * 1024 * 1024;
+  ASSERT_TRUE(android_mallopt(M_SET_ALLOCATION_LIMIT_BYTES, &limit, sizeof(limit)));
+
+  // If the frees weren't accounted for, the limit would be hit long before this finishes.
+  for (size_t i = 0; i < 100; i++) {
+    void* ptrs[4];
+    ASSERT_EQ(4U, malloc_batch(8 * 1024 * 1024, ptrs, 4)) << "Failed at iteration " << i;
+    free_sized(ptrs[0], 8 * 1024 * 1024);
+    free_batch(&ptrs[1], 3);
+  }
+#else
+  GTEST_SKIP() << "bionic extension";
+#endif
+}
+
+TEST(android_mallopt, set_allocation_limit_multiple_threads_small_allocations) {
+#if defined(__BIONIC__)
+  size_t limit = 128 * 1024 * 1024;
+  ASSERT_TRUE(android_mallopt(M_SET_ALLOCATION_LIMIT_BYTES, &limit, sizeof(limit)));
+
+  size_t max_pointers = GetMaxAllocations();
+  ASSERT_TRUE(max_pointers != 0) << "Limit never reached.";
+
+  static constexpr size_t kNumThreads = 8;
+  pthread_t threads[kNumThreads];
+  for (size_t i = 0; i < kNumThreads; i++) {
+    ASSERT_EQ(0, pthread_create(&threads[i], nullptr, AllocateAndFreeSmall, nullptr));
+  }
+  void* results[kNumThreads];
+  for (size_t i = 0; i < kNumThreads; i++) {
+    ASSERT_EQ(0, pthread_join(threads[i], &results[i]));
+    ASSERT_TRUE(results[i] != nullptr);
+  }
+  for (size_t i = 0; i < kNumThreads; i++) {
+    free(results[i]);
+  }
+
+  // Whatever is still counted per thread has to be taken into account when the limit is hit.
+  VerifyMaxPointers(max_pointers);
+#else
+  GTEST_SKIP() << "bionic extension";
+#endif
+}
+
 #if defined(__BIONIC__)
 static void* SetAllocationLimit(void* data) {
   std::atomic_bool* go = reinterpret_cast<std::atomic_bool*>(data);
@@ -21,6 +21,7 @@
 #include <limits.h>
 #include <malloc.h>
 #include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdio.h>
 #include <sys/cdefs.h>
@@ -185,6 +186,60 @@ TEST(pthread, pthread_key_dirty) {
   ASSERT_EQ(0, pthread_key_delete(key));
 }
 
+struct KeyDestructorTest {
+  std::vector<pthread_key_t> keys;
+  std::vector<int> destructor_calls;
+
+  static KeyDestructorTest* current;
+
+  static void Destructor(void* value) {
+    size_t i = reinterpret_cast<uintptr_t>(value) - 1;
+    ++current->destructor_calls[i];
+    // Setting a lower key from a destructor needs another round; a higher one doesn't.
+    if (i == 40 && current->destructor_calls[i] == 1) {
+      pthread_setspecific(current->keys[10], reinterpret_cast<void*>(10 + 1));
+    }
+    if (i == 10 && current->destructor_calls[i] == 1) {
+      pthread_setspecific(current->keys[60], reinterpret_cast<void*>(60 + 1));
+    }
+  }
+
+  static void* Fn(void*) {
+    for (size_t i : {5, 20, 40, 63}) {
+      pthread_setspecific(current->keys[i], reinterpret_cast<void*>(i + 1));
+    }
+    // A value that went back to null, and a value of a deleted key, aren't destroyed.
+    pthread_setspecific(current->keys[20], nullptr);
+    pthread_key_delete(current->keys[63]);
+    return nullptr;
+  }
+};
+
+KeyDestructorTest* KeyDestructorTest::current;
+
+TEST(pthread, pthread_key_destructors) {
+  KeyDestructorTest test;
+  KeyDestructorTest::current = &test;
+  test.keys.resize(64);
+  test.destructor_calls.resize(64);
+  for (pthread_key_t& key : test.keys) {
+    ASSERT_EQ(0, pthread_key_create(&key, KeyDestructorTest::Destructor));
+  }
+
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, nullptr, KeyDestructorTest::Fn, nullptr));
+  ASSERT_EQ(0, pthread_join(t, nullptr));
+
+  for (size_t i = 0; i < test.keys.size(); ++i) {
+    bool destroyed = (i == 5 || i == 10 || i == 40 || i == 60);
+    EXPECT_EQ(destroyed ? 1 : 0, test.destructor_calls[i]) << i;
+  }
+
+  for (size_t i = 0; i < test.keys.size(); ++i) {
+    if (i != 63) ASSERT_EQ(0, pthread_key_delete(test.keys[i]));
+  }
+}
+
 static void* FnWithStackFrame(void*) {
   int x;
   *const_cast<volatile int*>(&x) = 1;
@@ -745,6 +800,34 @@ TEST(pthread, pthread_join__race) {
   }
 }
 
+static thread_local int g_reuse_tls_initialized = 1234;
+static thread_local int g_reuse_tls_zeroed;
+
+static void* CheckAndDirtyThreadStateFn(void* arg) {
+  pthread_key_t key = *reinterpret_cast<pthread_key_t*>(arg);
+  bool clean = g_reuse_tls_initialized == 1234 && g_reuse_tls_zeroed == 0 &&
+               pthread_getspecific(key) == nullptr;
+  g_reuse_tls_initialized = 5678;
+  g_reuse_tls_zeroed = 5678;
+  pthread_setspecific(key, &key);
+  return reinterpret_cast<void*>(clean);
+}
+
+TEST(pthread, pthread_join__new_thread_state_is_clean) {
+  // libc may reuse a joined thread's stack and TLS for the next thread, but the new thread
+  // must not see anything the old one left behind.
+  pthread_key_t key;
+  ASSERT_EQ(0, pthread_key_create(&key, nullptr));
+  for (size_t i = 0; i < 64; ++i) {
+    pthread_t t;
+    ASSERT_EQ(0, pthread_create(&t, nullptr, CheckAndDirtyThreadStateFn, &key));
+    void* clean;
+    ASSERT_EQ(0, pthread_join(t, &clean));
+    ASSERT_TRUE(clean != nullptr) << i;
+  }
+  ASSERT_EQ(0, pthread_key_delete(key));
+}
+
 static void* GetActualGuardSizeFn(void* arg) {
   pthread_attr_t attributes;
   pthread_getattr_np(pthread_self(), &attributes);
@@ -873,7 +956,11 @@ TEST(pthread, pthread_rwlockattr_smoke) {
 #if !defined(ANDROID_HOST_MUSL)
   // musl doesn't have pthread_rwlockattr_setkind_np
   int kind_array[] = {PTHREAD_RWLOCK_PREFER_READER_NP,
-                      PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP};
+                      PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP,
+#if defined(__BIONIC__)
+                      PTHREAD_RWLOCK_READER_BIASED_NP,
+#endif
+  };
   for (size_t i = 0; i < sizeof(kind_array) / sizeof(kind_array[0]); ++i) {
     ASSERT_EQ(0, pthread_rwlockattr_setkind_np(&attr, kind_array[i]));
     int kind;
@@ -892,9 +979,24 @@ TEST(pthread, pthread_rwlock_init_same_as_PTHREAD_RWLOCK_INITIALIZER) {
   ASSERT_EQ(0, memcmp(&lock1, &lock2, sizeof(lock1)));
 }
 
-TEST(pthread, pthread_rwlock_smoke) {
+TEST(pthread, pthread_rwlock_init_same_as_PTHREAD_RWLOCK_READER_BIASED_INITIALIZER_NP) {
+#if defined(__BIONIC__)
+  pthread_rwlock_t lock1 = PTHREAD_RWLOCK_READER_BIASED_INITIALIZER_NP;
+  pthread_rwlockattr_t attr;
+  ASSERT_EQ(0, pthread_rwlockattr_init(&attr));
+  ASSERT_EQ(0, pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_READER_BIASED_NP));
+  pthread_rwlock_t lock2;
+  ASSERT_EQ(0, pthread_rwlock_init(&lock2, &attr));
+  ASSERT_EQ(0, memcmp(&lock1, &lock2, sizeof(lock1)));
+  ASSERT_EQ(0, pthread_rwlockattr_destroy(&attr));
+#else   // __BIONIC__
+  GTEST_SKIP() << "PTHREAD_RWLOCK_READER_BIASED_NP not available";
+#endif  // __BIONIC__
+}
+
+static void test_pthread_rwlock_smoke(const pthread_rwlockattr_t* attr) {
   pthread_rwlock_t l;
-  ASSERT_EQ(0, pthread_rwlock_init(&l, nullptr));
+  ASSERT_EQ(0, pthread_rwlock_init(&l, attr));
 
   // Single read lock
   ASSERT_EQ(0, pthread_rwlock_rdlock(&l));
@@ -940,6 +1042,53 @@ TEST(pthread, pthread_rwlock_smoke) {
   ASSERT_EQ(0, pthread_rwlock_destroy(&l));
 }
 
+TEST(pthread, pthread_rwlock_smoke) {
+  test_pthread_rwlock_smoke(nullptr);
+}
+
+TEST(pthread, pthread_rwlock_smoke_READER_BIASED_NP) {
+#if defined(__BIONIC__)
+  pthread_rwlockattr_t attr;
+  ASSERT_EQ(0, pthread_rwlockattr_init(&attr));
+  ASSERT_EQ(0, pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_READER_BIASED_NP));
+  test_pthread_rwlock_smoke(&attr);
+  ASSERT_EQ(0, pthread_rwlockattr_destroy(&attr));
+#else   // __BIONIC__
+  GTEST_SKIP() << "PTHREAD_RWLOCK_READER_BIASED_NP not available";
+#endif  // __BIONIC__
+}
+
+#if defined(__BIONIC__)
+static void* RwlockUnlockNotOwnerFn(void* arg) {
+  return reinterpret_cast<void*>(pthread_rwlock_unlock(reinterpret_cast<pthread_rwlock_t*>(arg)));
+}
+#endif
+
+TEST(pthread, pthread_rwlock_READER_BIASED_NP_unlock_not_owner) {
+#if defined(__BIONIC__)
+  pthread_rwlock_t lock = PTHREAD_RWLOCK_READER_BIASED_INITIALIZER_NP;
+  // Unlocking a lock nobody holds.
+  ASSERT_EQ(EPERM, pthread_rwlock_unlock(&lock));
+
+  // Unlocking a lock another thread holds for writing mustn't release it.
+  ASSERT_EQ(0, pthread_rwlock_wrlock(&lock));
+  pthread_t thread;
+  void* result;
+  ASSERT_EQ(0, pthread_create(&thread, nullptr, RwlockUnlockNotOwnerFn, &lock));
+  ASSERT_EQ(0, pthread_join(thread, &result));
+  ASSERT_EQ(EPERM, reinterpret_cast<intptr_t>(result));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&lock));
+
+  // A reader leaving through the reader table still works after a writer has come and gone.
+  ASSERT_EQ(0, pthread_rwlock_rdlock(&lock));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&lock));
+  ASSERT_EQ(EPERM, pthread_rwlock_unlock(&lock));
+  ASSERT_EQ(0, pthread_rwlock_destroy(&lock));
+#else   // __BIONIC__
+  GTEST_SKIP() << "PTHREAD_RWLOCK_READER_BIASED_NP not available";
+#endif  // __BIONIC__
+}
+
 struct RwlockWakeupHelperArg {
   pthread_rwlock_t lock;
   enum Progress {
@@ -1380,6 +1529,127 @@ TEST(pthread, pthread_rwlock_kind_PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP)
 #endif
 }
 
+TEST(pthread, pthread_rwlock_kind_PTHREAD_RWLOCK_READER_BIASED_NP) {
+#if defined(__BIONIC__)
+  RwlockKindTestHelper helper(PTHREAD_RWLOCK_READER_BIASED_NP);
+  ASSERT_EQ(0, pthread_rwlock_rdlock(&helper.lock));
+
+  pthread_t writer_thread;
+  std::atomic<pid_t> writer_tid;
+  helper.CreateWriterThread(writer_thread, writer_tid);
+  WaitUntilThreadSleep(writer_tid);
+
+  // Readers are still preferred, and a reader can take the lock again recursively.
+  ASSERT_EQ(0, pthread_rwlock_rdlock(&helper.lock));
+  pthread_t reader_thread;
+  std::atomic<pid_t> reader_tid;
+  helper.CreateReaderThread(reader_thread, reader_tid);
+  ASSERT_EQ(0, pthread_join(reader_thread, nullptr));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&helper.lock));
+
+  ASSERT_EQ(0, pthread_rwlock_unlock(&helper.lock));
+  ASSERT_EQ(0, pthread_join(writer_thread, nullptr));
+#else   // __BIONIC__
+  GTEST_SKIP() << "PTHREAD_RWLOCK_READER_BIASED_NP not available";
+#endif  // __BIONIC__
+}
+
+#if defined(__BIONIC__)
+static void* TimedWriterThreadFn(void* arg) {
+  pthread_rwlock_t* lock = reinterpret_cast<pthread_rwlock_t*>(arg);
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  ts.tv_nsec += 10 * 1000 * 1000;
+  if (ts.tv_nsec >= NS_PER_S) {
+    ts.tv_sec++;
+    ts.tv_nsec -= NS_PER_S;
+  }
+  EXPECT_EQ(ETIMEDOUT, pthread_rwlock_timedwrlock_monotonic_np(lock, &ts));
+  // A writer that gave up mustn't keep readers out.
+  EXPECT_EQ(0, pthread_rwlock_tryrdlock(lock));
+  EXPECT_EQ(0, pthread_rwlock_unlock(lock));
+  return nullptr;
+}
+#endif
+
+TEST(pthread, pthread_rwlock_READER_BIASED_NP_timedwrlock_timeout) {
+#if defined(__BIONIC__)
+  pthread_rwlock_t lock = PTHREAD_RWLOCK_READER_BIASED_INITIALIZER_NP;
+  ASSERT_EQ(0, pthread_rwlock_rdlock(&lock));
+
+  pthread_t thread;
+  ASSERT_EQ(0, pthread_create(&thread, nullptr, TimedWriterThreadFn, &lock));
+  ASSERT_EQ(0, pthread_join(thread, nullptr));
+
+  ASSERT_EQ(0, pthread_rwlock_unlock(&lock));
+  ASSERT_EQ(0, pthread_rwlock_trywrlock(&lock));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&lock));
+  ASSERT_EQ(0, pthread_rwlock_destroy(&lock));
+#else   // __BIONIC__
+  GTEST_SKIP() << "PTHREAD_RWLOCK_READER_BIASED_NP not available";
+#endif  // __BIONIC__
+}
+
+#if defined(__BIONIC__)
+struct ReaderBiasedStress {
+  pthread_rwlock_t lock = PTHREAD_RWLOCK_READER_BIASED_INITIALIZER_NP;
+  std::atomic<int> reader_count = 0;
+  std::atomic<int> writer_count = 0;
+  std::atomic<bool> done = false;
+  int value = 0;
+};
+
+static void* ReaderBiasedStressReaderFn(void* arg) {
+  ReaderBiasedStress* stress = reinterpret_cast<ReaderBiasedStress*>(arg);
+  while (!stress->done) {
+    EXPECT_EQ(0, pthread_rwlock_rdlock(&stress->lock));
+    stress->reader_count++;
+    EXPECT_EQ(0, stress->writer_count);
+    stress->reader_count--;
+    EXPECT_EQ(0, pthread_rwlock_unlock(&stress->lock));
+  }
+  return nullptr;
+}
+
+static void* ReaderBiasedStressWriterFn(void* arg) {
+  ReaderBiasedStress* stress = reinterpret_cast<ReaderBiasedStress*>(arg);
+  for (size_t i = 0; i < 1000; ++i) {
+    EXPECT_EQ(0, pthread_rwlock_wrlock(&stress->lock));
+    EXPECT_EQ(1, ++stress->writer_count);
+    EXPECT_EQ(0, stress->reader_count);
+    stress->value++;
+    stress->writer_count--;
+    EXPECT_EQ(0, pthread_rwlock_unlock(&stress->lock));
+  }
+  return nullptr;
+}
+#endif
+
+TEST(pthread, pthread_rwlock_READER_BIASED_NP_readers_and_writers) {
+#if defined(__BIONIC__)
+  ReaderBiasedStress stress;
+  pthread_t readers[4];
+  for (pthread_t& reader : readers) {
+    ASSERT_EQ(0, pthread_create(&reader, nullptr, ReaderBiasedStressReaderFn, &stress));
+  }
+  pthread_t writers[2];
+  for (pthread_t& writer : writers) {
+    ASSERT_EQ(0, pthread_create(&writer, nullptr, ReaderBiasedStressWriterFn, &stress));
+  }
+  for (pthread_t& writer : writers) {
+    ASSERT_EQ(0, pthread_join(writer, nullptr));
+  }
+  stress.done = true;
+  for (pthread_t& reader : readers) {
+    ASSERT_EQ(0, pthread_join(reader, nullptr));
+  }
+  ASSERT_EQ(2000, stress.value);
+  ASSERT_EQ(0, pthread_rwlock_destroy(&stress.lock));
+#else   // __BIONIC__
+  GTEST_SKIP() << "PTHREAD_RWLOCK_READER_BIASED_NP not available";
+#endif  // __BIONIC__
+}
+
 static int g_once_fn_call_count = 0;
 static void OnceFn() {
   ++g_once_fn_call_count;
@@ -1973,6 +2243,63 @@ TEST(pthread, pthread_gettid_np) {
 #endif
 }
 
+#if defined(__BIONIC__)
+struct ManyThreadsState {
+  pthread_mutex_t exit_mutex = PTHREAD_MUTEX_INITIALIZER;
+  std::atomic<size_t> started = 0;
+};
+
+struct ManyThreadsArg {
+  ManyThreadsState* state;
+  pid_t tid;
+};
+
+static void* ManyThreadsFn(void* arg) {
+  ManyThreadsArg* a = reinterpret_cast<ManyThreadsArg*>(arg);
+  a->tid = gettid();
+  a->state->started++;
+  pthread_mutex_lock(&a->state->exit_mutex);
+  pthread_mutex_unlock(&a->state->exit_mutex);
+  return nullptr;
+}
+#endif
+
+TEST(pthread, pthread_gettid_np__many_threads) {
+#if defined(__BIONIC__)
+  // Enough threads for libc's table of threads to grow a few times while they're all alive.
+  constexpr size_t kThreadCount = 1500;
+  pthread_attr_t attr;
+  ASSERT_EQ(0, pthread_attr_init(&attr));
+  ASSERT_EQ(0, pthread_attr_setstacksize(&attr, PTHREAD_STACK_MIN));
+
+  ManyThreadsState state;
+  std::vector<ManyThreadsArg> args(kThreadCount, ManyThreadsArg{&state, 0});
+  std::vector<pthread_t> threads;
+  pthread_mutex_lock(&state.exit_mutex);
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    pthread_t t;
+    int result = pthread_create(&t, &attr, ManyThreadsFn, &args[i]);
+    // Running out of memory or threads is fine, but must be reported, not fatal.
+    if (result == EAGAIN) break;
+    ASSERT_EQ(0, result);
+    threads.push_back(t);
+  }
+  while (state.started < threads.size()) sched_yield();
+
+  for (size_t i = 0; i < threads.size(); ++i) {
+    ASSERT_EQ(args[i].tid, pthread_gettid_np(threads[i]));
+  }
+
+  pthread_mutex_unlock(&state.exit_mutex);
+  for (pthread_t t : threads) {
+    ASSERT_EQ(0, pthread_join(t, nullptr));
+  }
+  ASSERT_EQ(0, pthread_attr_destroy(&attr));
+#else
+  GTEST_SKIP() << "pthread_gettid_np not available";
+#endif
+}
+
 static size_t cleanup_counter = 0;
 
 static void AbortCleanupRoutine(void*) {
@@ -2032,6 +2359,13 @@ TEST(pthread, pthread_mutexattr_gettype) {
   ASSERT_EQ(0, pthread_mutexattr_gettype(&attr, &attr_type));
   ASSERT_EQ(PTHREAD_MUTEX_RECURSIVE, attr_type);
 
+#if !defined(ANDROID_HOST_MUSL)
+  // musl doesn't support PTHREAD_MUTEX_ADAPTIVE_NP.
+  ASSERT_EQ(0, pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP));
+  ASSERT_EQ(0, pthread_mutexattr_gettype(&attr, &attr_type));
+  ASSERT_EQ(PTHREAD_MUTEX_ADAPTIVE_NP, attr_type);
+#endif
+
   ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
 }
 
@@ -2149,6 +2483,57 @@ TEST(pthread, pthread_mutex_lock_RECURSIVE) {
   TestPthreadMutexLockRecursive(PTHREAD_PRIO_NONE);
 }
 
+TEST(pthread, pthread_mutex_lock_ADAPTIVE) {
+#if !defined(ANDROID_HOST_MUSL)
+  PthreadMutex m(PTHREAD_MUTEX_ADAPTIVE_NP);
+
+  ASSERT_EQ(0, pthread_mutex_lock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_trylock(&m.lock));
+  ASSERT_EQ(EBUSY, pthread_mutex_trylock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+#else
+  GTEST_SKIP() << "musl doesn't support PTHREAD_MUTEX_ADAPTIVE_NP";
+#endif
+}
+
+struct ContendedCounter {
+  pthread_mutex_t* lock;
+  size_t iterations;
+  size_t count;
+};
+
+static void* IncrementContendedCounterFn(void* arg) {
+  ContendedCounter* counter = reinterpret_cast<ContendedCounter*>(arg);
+  for (size_t i = 0; i < counter->iterations; ++i) {
+    pthread_mutex_lock(counter->lock);
+    // Hold the lock for a while now and then, so that waiters give up spinning and sleep.
+    size_t count = counter->count;
+    if (i % 64 == 0) sched_yield();
+    counter->count = count + 1;
+    pthread_mutex_unlock(counter->lock);
+  }
+  return nullptr;
+}
+
+TEST(pthread, pthread_mutex_ADAPTIVE_contended) {
+#if !defined(ANDROID_HOST_MUSL)
+  PthreadMutex m(PTHREAD_MUTEX_ADAPTIVE_NP);
+  ContendedCounter counter = {.lock = &m.lock, .iterations = 100000, .count = 0};
+
+  std::vector<pthread_t> threads(4);
+  for (auto& thread : threads) {
+    ASSERT_EQ(0, pthread_create(&thread, nullptr, IncrementContendedCounterFn, &counter));
+  }
+  for (auto& thread : threads) {
+    ASSERT_EQ(0, pthread_join(thread, nullptr));
+  }
+  ASSERT_EQ(threads.size() * counter.iterations, counter.count);
+#else
+  GTEST_SKIP() << "musl doesn't support PTHREAD_MUTEX_ADAPTIVE_NP";
+#endif
+}
+
 TEST(pthread, pthread_mutex_lock_pi) {
   TestPthreadMutexLockNormal(PTHREAD_PRIO_INHERIT);
   TestPthreadMutexLockErrorCheck(PTHREAD_PRIO_INHERIT);
@@ -2270,6 +2655,175 @@ TEST(pthread, pthread_mutex_RECURSIVE_wakeup) {
   helper.test();
 }
 
+TEST(pthread, pthread_mutex_ADAPTIVE_wakeup) {
+#if !defined(ANDROID_HOST_MUSL)
+  MutexWakeupHelper helper(PTHREAD_MUTEX_ADAPTIVE_NP);
+  helper.test();
+#else
+  GTEST_SKIP() << "musl doesn't support PTHREAD_MUTEX_ADAPTIVE_NP";
+#endif
+}
+
+struct CondBroadcastRounds {
+  pthread_mutex_t* mutex;
+  pthread_cond_t* go_cond;
+  pthread_cond_t arrived_cond;
+  size_t thread_count;
+  size_t round_count;
+  size_t arrived;
+  size_t round;
+};
+
+static void* CondBroadcastRoundsFn(void* arg) {
+  CondBroadcastRounds* r = reinterpret_cast<CondBroadcastRounds*>(arg);
+  for (size_t round = 0; round < r->round_count; ++round) {
+    pthread_mutex_lock(r->mutex);
+    if (++r->arrived == r->thread_count * (round + 1)) pthread_cond_signal(&r->arrived_cond);
+    while (r->round == round) pthread_cond_wait(r->go_cond, r->mutex);
+    pthread_mutex_unlock(r->mutex);
+  }
+  return nullptr;
+}
+
+// Every waiter has to get the mutex after every broadcast, however the waiters are woken.
+static void RunCondBroadcastRounds(pthread_mutex_t* mutex, pthread_cond_t* go_cond,
+                                   size_t thread_count, size_t round_count) {
+  CondBroadcastRounds r = {.mutex = mutex, .go_cond = go_cond, .thread_count = thread_count,
+                           .round_count = round_count};
+  ASSERT_EQ(0, pthread_cond_init(&r.arrived_cond, nullptr));
+
+  std::vector<pthread_t> threads(thread_count);
+  for (auto& thread : threads) {
+    ASSERT_EQ(0, pthread_create(&thread, nullptr, CondBroadcastRoundsFn, &r));
+  }
+  for (size_t round = 0; round < round_count; ++round) {
+    ASSERT_EQ(0, pthread_mutex_lock(mutex));
+    while (r.arrived < thread_count * (round + 1)) {
+      ASSERT_EQ(0, pthread_cond_wait(&r.arrived_cond, mutex));
+    }
+    r.round = round + 1;
+    ASSERT_EQ(0, pthread_cond_broadcast(go_cond));
+    ASSERT_EQ(0, pthread_mutex_unlock(mutex));
+  }
+  for (auto& thread : threads) {
+    ASSERT_EQ(0, pthread_join(thread, nullptr));
+  }
+  ASSERT_EQ(0, pthread_cond_destroy(&r.arrived_cond));
+}
+
+TEST(pthread, pthread_cond_broadcast__wakes_all_waiters_NORMAL) {
+  PthreadMutex m(PTHREAD_MUTEX_NORMAL);
+  pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+  RunCondBroadcastRounds(&m.lock, &cond, 8, 200);
+  ASSERT_EQ(0, pthread_cond_destroy(&cond));
+}
+
+TEST(pthread, pthread_cond_broadcast__wakes_all_waiters_RECURSIVE) {
+  PthreadMutex m(PTHREAD_MUTEX_RECURSIVE);
+  pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+  RunCondBroadcastRounds(&m.lock, &cond, 8, 200);
+  ASSERT_EQ(0, pthread_cond_destroy(&cond));
+}
+
+TEST(pthread, pthread_cond_broadcast__after_changing_mutex) {
+  // A condition variable can be used with another mutex once nobody waits with the first one.
+  pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+  {
+    PthreadMutex m(PTHREAD_MUTEX_NORMAL);
+    RunCondBroadcastRounds(&m.lock, &cond, 4, 20);
+  }
+  {
+    PthreadMutex m(PTHREAD_MUTEX_NORMAL);
+    RunCondBroadcastRounds(&m.lock, &cond, 4, 20);
+  }
+  ASSERT_EQ(0, pthread_cond_destroy(&cond));
+}
+
+struct CondBroadcastBeforeTimeout {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  pthread_cond_t arrived_cond;
+  timespec deadline;
+  size_t arrived;
+  bool go;
+};
+
+static void* CondBroadcastBeforeTimeoutFn(void* arg) {
+  CondBroadcastBeforeTimeout* b = reinterpret_cast<CondBroadcastBeforeTimeout*>(arg);
+  pthread_mutex_lock(&b->mutex);
+  ++b->arrived;
+  pthread_cond_signal(&b->arrived_cond);
+  int result = 0;
+  while (!b->go && result == 0) result = pthread_cond_timedwait(&b->cond, &b->mutex, &b->deadline);
+  pthread_mutex_unlock(&b->mutex);
+  return reinterpret_cast<void*>(static_cast<intptr_t>(result));
+}
+
+TEST(pthread, pthread_cond_timedwait__broadcast_before_timeout) {
+  // Waiters that a broadcast moves to the mutex keep waiting with their timeout. If the mutex
+  // isn't released until after the deadline, they were still woken before it.
+  constexpr size_t kThreadCount = 4;
+  CondBroadcastBeforeTimeout b = {};
+  ASSERT_EQ(0, pthread_mutex_init(&b.mutex, nullptr));
+  pthread_condattr_t attr;
+  ASSERT_EQ(0, pthread_condattr_init(&attr));
+  ASSERT_EQ(0, pthread_condattr_setclock(&attr, CLOCK_MONOTONIC));
+  ASSERT_EQ(0, pthread_cond_init(&b.cond, &attr));
+  ASSERT_EQ(0, pthread_cond_init(&b.arrived_cond, nullptr));
+  ASSERT_EQ(0, clock_gettime(CLOCK_MONOTONIC, &b.deadline));
+  b.deadline.tv_sec += 1;
+
+  std::vector<pthread_t> threads(kThreadCount);
+  for (auto& thread : threads) {
+    ASSERT_EQ(0, pthread_create(&thread, nullptr, CondBroadcastBeforeTimeoutFn, &b));
+  }
+  ASSERT_EQ(0, pthread_mutex_lock(&b.mutex));
+  while (b.arrived < kThreadCount) ASSERT_EQ(0, pthread_cond_wait(&b.arrived_cond, &b.mutex));
+
+  // Broadcast shortly before the deadline, and hold the mutex until well after it.
+  timespec broadcast_time = b.deadline;
+  broadcast_time.tv_nsec -= 50 * 1000000;
+  if (broadcast_time.tv_nsec < 0) {
+    broadcast_time.tv_nsec += NS_PER_S;
+    --broadcast_time.tv_sec;
+  }
+  ASSERT_EQ(0, clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &broadcast_time, nullptr));
+  b.go = true;
+  ASSERT_EQ(0, pthread_cond_broadcast(&b.cond));
+  timespec release_time = b.deadline;
+  release_time.tv_sec += 1;
+  ASSERT_EQ(0, clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &release_time, nullptr));
+  ASSERT_EQ(0, pthread_mutex_unlock(&b.mutex));
+
+  for (auto& thread : threads) {
+    void* result;
+    ASSERT_EQ(0, pthread_join(thread, &result));
+    ASSERT_EQ(0, static_cast<int>(reinterpret_cast<intptr_t>(result)));
+  }
+  ASSERT_EQ(0, pthread_cond_destroy(&b.cond));
+  ASSERT_EQ(0, pthread_cond_destroy(&b.arrived_cond));
+  ASSERT_EQ(0, pthread_mutex_destroy(&b.mutex));
+}
+
+TEST(pthread, pthread_cond_broadcast__after_reinitializing_mutex) {
+  // The same mutex storage may be destroyed and reinitialized as a type that waiters can't be
+  // requeued to.
+  pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+  pthread_mutex_t mutex;
+  ASSERT_EQ(0, pthread_mutex_init(&mutex, nullptr));
+  RunCondBroadcastRounds(&mutex, &cond, 4, 20);
+  ASSERT_EQ(0, pthread_mutex_destroy(&mutex));
+
+  pthread_mutexattr_t attr;
+  ASSERT_EQ(0, pthread_mutexattr_init(&attr));
+  ASSERT_EQ(0, pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE));
+  ASSERT_EQ(0, pthread_mutex_init(&mutex, &attr));
+  ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
+  RunCondBroadcastRounds(&mutex, &cond, 4, 20);
+  ASSERT_EQ(0, pthread_mutex_destroy(&mutex));
+  ASSERT_EQ(0, pthread_cond_destroy(&cond));
+}
+
 static int GetThreadPriority(pid_t tid) {
   // sched_getparam() returns the static priority of a thread, which can't reflect a thread's
   // priority after priority inheritance. So read /proc/<pid>/stat to get the dynamic priority.
@@ -2873,6 +3427,10 @@ TEST(pthread, pthread_create__mmap_failures) {
 
   const auto kPageSize = sysconf(_SC_PAGE_SIZE);
 
+  // Use a stack size no other test uses, so there's no cached mapping from a
+  // joined thread that pthread_create could reuse without calling mmap.
+  ASSERT_EQ(0, pthread_attr_setstacksize(&attr, 123 * kPageSize));
+
   // Use up all the VMAs. By default this is 64Ki (though some will already be in use).
   std::vector<void*> pages;
   pages.reserve(64 * 1024);
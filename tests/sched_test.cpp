@@ -20,6 +20,11 @@
 #include <sched.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include "utils.h"
 
 static int child_fn(void* i_ptr) {
   *reinterpret_cast<int*>(i_ptr) = 42;
@@ -308,3 +313,40 @@ TEST(sched, sched_getaffinity_failure) {
   ASSERT_EQ(-1, sched_getaffinity(getpid(), 0, nullptr));
 #pragma clang diagnostic pop
 }
+
+static void AssertRunsOnAllowedCpus() {
+  cpu_set_t allowed;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(allowed), &allowed));
+  for (int i = 0; i < CPU_SETSIZE; ++i) {
+    if (!CPU_ISSET(i, &allowed)) continue;
+
+    // Pin ourselves to each allowed CPU in turn; the CPU must be reported as soon as we're on it.
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(i, &set);
+    ASSERT_EQ(0, sched_setaffinity(0, sizeof(set), &set));
+    ASSERT_EQ(i, sched_getcpu());
+  }
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(allowed), &allowed));
+}
+
+TEST(sched, sched_getcpu) {
+  AssertRunsOnAllowedCpus();
+}
+
+TEST(sched, sched_getcpu_new_thread) {
+  std::thread t([]() { AssertRunsOnAllowedCpus(); });
+  t.join();
+}
+
+TEST(sched, sched_getcpu_fork) {
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) _exit(1);
+    int cpu = sched_getcpu();
+    _exit(cpu >= 0 && CPU_ISSET(cpu, &allowed) ? 0 : 1);
+  }
+  AssertChildExited(pid, 0);
+}
@@ -30,7 +30,7 @@ void tests(CheckSize check_size, CheckOffset check_offset) {
 #define CHECK_OFFSET(name, field, offset) \
     check_offset(#name, #field, offsetof(name, field), offset);
 #ifdef __LP64__
-  CHECK_SIZE(pthread_internal_t, 784);
+  CHECK_SIZE(pthread_internal_t, 792);
   CHECK_OFFSET(pthread_internal_t, next, 0);
   CHECK_OFFSET(pthread_internal_t, prev, 8);
   CHECK_OFFSET(pthread_internal_t, tid, 16);
@@ -56,24 +56,26 @@ void tests(CheckSize check_size, CheckOffset check_offset) {
   CHECK_OFFSET(pthread_internal_t, bionic_tls, 760);
   CHECK_OFFSET(pthread_internal_t, errno_value, 768);
   CHECK_OFFSET(pthread_internal_t, vfork_child_stack_bottom, 776);
-  CHECK_SIZE(bionic_tls, 12200);
+  CHECK_OFFSET(pthread_internal_t, dl_lookup_error_buffer, 784);
+  CHECK_SIZE(bionic_tls, 12224);
   CHECK_OFFSET(bionic_tls, key_data, 0);
-  CHECK_OFFSET(bionic_tls, locale, 2080);
-  CHECK_OFFSET(bionic_tls, basename_buf, 2088);
-  CHECK_OFFSET(bionic_tls, dirname_buf, 6184);
-  CHECK_OFFSET(bionic_tls, mntent_buf, 10280);
-  CHECK_OFFSET(bionic_tls, mntent_strings, 10320);
-  CHECK_OFFSET(bionic_tls, ptsname_buf, 11344);
-  CHECK_OFFSET(bionic_tls, ttyname_buf, 11376);
-  CHECK_OFFSET(bionic_tls, strerror_buf, 11440);
-  CHECK_OFFSET(bionic_tls, strsignal_buf, 11695);
-  CHECK_OFFSET(bionic_tls, group, 11952);
-  CHECK_OFFSET(bionic_tls, passwd, 12040);
-  CHECK_OFFSET(bionic_tls, fdtrack_disabled, 12192);
-  CHECK_OFFSET(bionic_tls, bionic_systrace_disabled, 12193);
-  CHECK_OFFSET(bionic_tls, padding, 12194);
+  CHECK_OFFSET(bionic_tls, key_live, 2080);
+  CHECK_OFFSET(bionic_tls, locale, 2104);
+  CHECK_OFFSET(bionic_tls, basename_buf, 2112);
+  CHECK_OFFSET(bionic_tls, dirname_buf, 6208);
+  CHECK_OFFSET(bionic_tls, mntent_buf, 10304);
+  CHECK_OFFSET(bionic_tls, mntent_strings, 10344);
+  CHECK_OFFSET(bionic_tls, ptsname_buf, 11368);
+  CHECK_OFFSET(bionic_tls, ttyname_buf, 11400);
+  CHECK_OFFSET(bionic_tls, strerror_buf, 11464);
+  CHECK_OFFSET(bionic_tls, strsignal_buf, 11719);
+  CHECK_OFFSET(bionic_tls, group, 11976);
+  CHECK_OFFSET(bionic_tls, passwd, 12064);
+  CHECK_OFFSET(bionic_tls, fdtrack_disabled, 12216);
+  CHECK_OFFSET(bionic_tls, bionic_systrace_disabled, 12217);
+  CHECK_OFFSET(bionic_tls, padding, 12218);
 #else
-  CHECK_SIZE(pthread_internal_t, 672);
+  CHECK_SIZE(pthread_internal_t, 676);
   CHECK_OFFSET(pthread_internal_t, next, 0);
   CHECK_OFFSET(pthread_internal_t, prev, 4);
   CHECK_OFFSET(pthread_internal_t, tid, 8);
@@ -99,22 +101,24 @@ void tests(CheckSize check_size, CheckOffset check_offset) {
   CHECK_OFFSET(pthread_internal_t, bionic_tls, 660);
   CHECK_OFFSET(pthread_internal_t, errno_value, 664);
   CHECK_OFFSET(pthread_internal_t, vfork_child_stack_bottom, 668);
-  CHECK_SIZE(bionic_tls, 11080);
+  CHECK_OFFSET(pthread_internal_t, dl_lookup_error_buffer, 672);
+  CHECK_SIZE(bionic_tls, 11100);
   CHECK_OFFSET(bionic_tls, key_data, 0);
-  CHECK_OFFSET(bionic_tls, locale, 1040);
-  CHECK_OFFSET(bionic_tls, basename_buf, 1044);
-  CHECK_OFFSET(bionic_tls, dirname_buf, 5140);
-  CHECK_OFFSET(bionic_tls, mntent_buf, 9236);
-  CHECK_OFFSET(bionic_tls, mntent_strings, 9260);
-  CHECK_OFFSET(bionic_tls, ptsname_buf, 10284);
-  CHECK_OFFSET(bionic_tls, ttyname_buf, 10316);
-  CHECK_OFFSET(bionic_tls, strerror_buf, 10380);
-  CHECK_OFFSET(bionic_tls, strsignal_buf, 10635);
-  CHECK_OFFSET(bionic_tls, group, 10892);
-  CHECK_OFFSET(bionic_tls, passwd, 10952);
-  CHECK_OFFSET(bionic_tls, fdtrack_disabled, 11076);
-  CHECK_OFFSET(bionic_tls, bionic_systrace_disabled, 11077);
-  CHECK_OFFSET(bionic_tls, padding, 11078);
+  CHECK_OFFSET(bionic_tls, key_live, 1040);
+  CHECK_OFFSET(bionic_tls, locale, 1060);
+  CHECK_OFFSET(bionic_tls, basename_buf, 1064);
+  CHECK_OFFSET(bionic_tls, dirname_buf, 5160);
+  CHECK_OFFSET(bionic_tls, mntent_buf, 9256);
+  CHECK_OFFSET(bionic_tls, mntent_strings, 9280);
+  CHECK_OFFSET(bionic_tls, ptsname_buf, 10304);
+  CHECK_OFFSET(bionic_tls, ttyname_buf, 10336);
+  CHECK_OFFSET(bionic_tls, strerror_buf, 10400);
+  CHECK_OFFSET(bionic_tls, strsignal_buf, 10655);
+  CHECK_OFFSET(bionic_tls, group, 10912);
+  CHECK_OFFSET(bionic_tls, passwd, 10972);
+  CHECK_OFFSET(bionic_tls, fdtrack_disabled, 11096);
+  CHECK_OFFSET(bionic_tls, bionic_systrace_disabled, 11097);
+  CHECK_OFFSET(bionic_tls, padding, 11098);
 #endif  // __LP64__
 #undef CHECK_SIZE
 #undef CHECK_OFFSET
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if __has_include(<sys/rseq.h>)
+#include <sys/rseq.h>
+#define HAVE_SYS_RSEQ 1
+#endif
+
+#include <errno.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <thread>
+
+#if defined(HAVE_SYS_RSEQ)
+static struct rseq* GetRseqArea() {
+  return reinterpret_cast<struct rseq*>(static_cast<char*>(__builtin_thread_pointer()) +
+                                        __rseq_offset);
+}
+
+static void AssertRseqAreaRegistered() {
+  if (__rseq_size == 0) GTEST_SKIP() << "rseq not registered";
+
+  // Pin ourselves so that the CPU in the area can't change under us.
+  cpu_set_t allowed;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(allowed), &allowed));
+  int cpu = sched_getcpu();
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(set), &set));
+  EXPECT_EQ(static_cast<uint32_t>(sched_getcpu()), GetRseqArea()->cpu_id);
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(allowed), &allowed));
+
+  // The kernel only allows one area per thread, which is why libc's has to be shared.
+  alignas(32) static thread_local struct rseq other_area = {};
+  errno = 0;
+  ASSERT_EQ(-1, syscall(__NR_rseq, &other_area, sizeof(other_area), 0, 0));
+  ASSERT_NE(0, errno);
+}
+#endif
+
+TEST(sys_rseq, main_thread) {
+#if defined(HAVE_SYS_RSEQ)
+  AssertRseqAreaRegistered();
+#else
+  GTEST_SKIP() << "<sys/rseq.h> not available";
+#endif
+}
+
+TEST(sys_rseq, new_thread) {
+#if defined(HAVE_SYS_RSEQ)
+  struct rseq* main_area = GetRseqArea();
+  struct rseq* thread_area = nullptr;
+  std::thread t([&thread_area]() {
+    thread_area = GetRseqArea();
+    AssertRseqAreaRegistered();
+  });
+  t.join();
+  ASSERT_NE(main_area, thread_area);
+#else
+  GTEST_SKIP() << "<sys/rseq.h> not available";
+#endif
+}